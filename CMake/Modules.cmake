@@ -78,6 +78,16 @@ register_module(
   "ReG_Steer_Sockets_Common.c"
 )
 
+# POSIX shared memory is only for co-located emitters and consumers
+if(UNIX)
+register_module(
+  Samples
+  shm
+  "ReG_Steer_Samples_Transport_Shm.c"
+  ""
+)
+endif(UNIX)
+
 register_module(
   Steering
   sockets
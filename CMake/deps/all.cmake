@@ -55,10 +55,18 @@ if(NOT MALLOC_IN_STDLIB)
   CHECK_INCLUDE_FILES(malloc.h REG_NEED_MALLOC_H)
 endif(NOT MALLOC_IN_STDLIB)
 
+# IOType buffers are page-aligned and may be backed by huge pages
+CHECK_FUNCTION_EXISTS(posix_memalign REG_HAS_POSIX_MEMALIGN)
+CHECK_SYMBOL_EXISTS(MADV_HUGEPAGE sys/mman.h REG_HAS_MADV_HUGEPAGE)
+
 # check for supported signals
 CHECK_SYMBOL_EXISTS(SIGXCPU signal.h REG_HAS_SIGXCPU)
 CHECK_SYMBOL_EXISTS(SIGUSR2 signal.h REG_HAS_SIGUSR2)
 
+# check the byte order of the platform - XDR is big-endian
+include(TestBigEndian)
+TEST_BIG_ENDIAN(REG_BIG_ENDIAN)
+
 #
 # find the required external libraries and
 # keep a track of them to help with configuring
@@ -81,6 +89,16 @@ set(CMAKE_REQUIRED_INCLUDES ${LIBXML2_INCLUDE_DIR})
 set(CMAKE_REQUIRED_LIBRARIES ${LIBXML2_LIBRARIES})
 CHECK_FUNCTION_EXISTS(xmlReadMemory REG_HAS_XMLREADMEMORY)
 
+# threads are needed for asynchronous emission of samples and are
+# used to reorder large arrays
+find_package(Threads)
+if(CMAKE_USE_PTHREADS_INIT)
+  set(REG_HAS_PTHREADS 1)
+  set(REG_EXTERNAL_LIBS ${REG_EXTERNAL_LIBS} ${CMAKE_THREAD_LIBS_INIT})
+  set(CMAKE_REQUIRED_LIBRARIES ${CMAKE_REQUIRED_LIBRARIES} ${CMAKE_THREAD_LIBS_INIT})
+  CHECK_FUNCTION_EXISTS(pthread_setaffinity_np REG_HAS_PTHREAD_SETAFFINITY_NP)
+endif(CMAKE_USE_PTHREADS_INIT)
+
 if(REG_DYNAMIC_MOD_LOADING)
   find_library(LIBDL_LIB dl)
   mark_as_advanced(LIBDL_LIB)
@@ -49,3 +49,16 @@ if(REG_USE_MODULE_Steering STREQUAL "Files")
   option(REG_KEEP_XML_MESSAGES "Keep file-based xml messages for debugging purposes. Default is OFF." OFF)
   mark_as_advanced(REG_KEEP_XML_MESSAGES)
 endif(REG_USE_MODULE_Steering STREQUAL "Files")
+
+# inotify lets blocking calls sleep until a file turns up rather than
+# polling the directory
+CHECK_SYMBOL_EXISTS(inotify_init1 "sys/inotify.h" REG_HAS_INOTIFY)
+
+# data files can be memory-mapped, and sized up front before they
+# are written
+CHECK_SYMBOL_EXISTS(mmap "sys/mman.h" REG_HAS_MMAP)
+CHECK_FUNCTION_EXISTS(posix_fallocate REG_HAS_POSIX_FALLOCATE)
+
+# the background writer flushes each data file to disk before it is
+# handed over
+CHECK_FUNCTION_EXISTS(fdatasync REG_HAS_FDATASYNC)
@@ -0,0 +1,62 @@
+#
+#  The RealityGrid Steering Library
+#
+#  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+#  All rights reserved.
+#
+#  This software is produced by Research Computing Services, University
+#  of Manchester as part of the RealityGrid project and associated
+#  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+#  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+#  EP/F00561X/1.
+#
+#  LICENCE TERMS
+#
+#  Redistribution and use in source and binary forms, with or without
+#  modification, are permitted provided that the following conditions
+#  are met:
+#
+#    * Redistributions of source code must retain the above copyright
+#       notice, this list of conditions and the following disclaimer.
+#
+#    * Redistributions in binary form must reproduce the above
+#      copyright notice, this list of conditions and the following
+#      disclaimer in the documentation and/or other materials provided
+#      with the distribution.
+#
+#    * Neither the name of The University of Manchester nor the names
+#      of its contributors may be used to endorse or promote products
+#      derived from this software without specific prior written
+#      permission.
+#
+#  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+#  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+#  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+#  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+#  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+#  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+#  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+#  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+#  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+#  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+#  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+#  POSSIBILITY OF SUCH DAMAGE.
+#
+#  Author: Robert Haines
+
+# shm_open lives in librt on older glibc
+CHECK_FUNCTION_EXISTS(shm_open REG_HAS_SHM_OPEN)
+if(NOT REG_HAS_SHM_OPEN)
+  CHECK_LIBRARY_EXISTS(rt shm_open "" REG_SHM_OPEN_IN_LIBRT)
+  if(REG_SHM_OPEN_IN_LIBRT)
+    find_library(LIBRT_LIB rt)
+    mark_as_advanced(LIBRT_LIB)
+    set(REG_EXTERNAL_LIBS ${REG_EXTERNAL_LIBS} ${LIBRT_LIB})
+  endif(REG_SHM_OPEN_IN_LIBRT)
+endif(NOT REG_HAS_SHM_OPEN)
+
+# use futexes to wake a waiting peer if we can, otherwise poll
+CHECK_INCLUDE_FILES("linux/futex.h" REG_HAS_LINUX_FUTEX_H)
+if(REG_HAS_LINUX_FUTEX_H)
+  CHECK_SYMBOL_EXISTS(SYS_futex "sys/syscall.h" REG_HAS_FUTEX)
+endif(REG_HAS_LINUX_FUTEX_H)
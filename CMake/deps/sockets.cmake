@@ -62,4 +62,8 @@ if(REG_TEST_SOCKETS_H)
   CHECK_SYMBOL_EXISTS(MSG_NOSIGNAL ${REG_TEST_SOCKETS_H} REG_HAS_MSG_NOSIGNAL)
   CHECK_SYMBOL_EXISTS(MSG_DONTWAIT ${REG_TEST_SOCKETS_H} REG_HAS_MSG_DONTWAIT)
   CHECK_SYMBOL_EXISTS(MSG_WAITALL  ${REG_TEST_SOCKETS_H} REG_HAS_MSG_WAITALL)
+  CHECK_SYMBOL_EXISTS(MSG_MORE     ${REG_TEST_SOCKETS_H} REG_HAS_MSG_MORE)
 endif(REG_TEST_SOCKETS_H)
+
+# one epoll set can watch all of our sockets
+CHECK_SYMBOL_EXISTS(epoll_create1 "sys/epoll.h" REG_HAS_EPOLL)
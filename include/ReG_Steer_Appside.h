@@ -211,6 +211,435 @@ extern PREFIX int Enable_IOType_acks(int IOType);
  */
 extern PREFIX int Disable_IOType_acks(int IOType);
 
+/**
+   @param IOType Handle of the IOType to query
+   @param NumNativeSlices On return, the no. of numeric data slices
+   emitted or consumed on this IOType without XDR encoding
+   @param NumXDRSlices On return, the no. of numeric data slices
+   emitted or consumed on this IOType as XDR
+   @return REG_SUCCESS, REG_FAILURE
+
+   Reports which path numeric data has taken on the specified IOType.
+   When an emitter learns (from the consumer's acknowledgements) that
+   the consumer has the same byte order and type sizes as itself, it
+   sends arrays in their native form straight from the caller's
+   buffer.  Otherwise data is XDR-encoded.
+ */
+extern PREFIX int Get_IOType_slice_counts(int  IOType,
+					  int *NumNativeSlices,
+					  int *NumXDRSlices);
+
+/**
+   @param IOType Handle of the IOType to query
+   @param NumSamples On return, the no. of samples successfully
+   emitted on this IOType
+   @param NumSyscalls On return, the no. of system calls made by the
+   samples transport in emitting them
+   @return REG_SUCCESS, REG_FAILURE
+
+   Reports how much work the transport has done to emit samples on
+   the specified IOType, so that the cost per sample can be measured.
+   Only the sockets-based transports count system calls; for others
+   @p NumSyscalls is always zero.
+ */
+extern PREFIX int Get_IOType_emit_stats(int  IOType,
+					int *NumSamples,
+					int *NumSyscalls);
+
+/**
+   @param IOType Handle of the IOType (direction REG_IO_OUT)
+   @param Policy What Emit_start() does when both snapshot buffers are
+   busy: REG_ASYNC_BLOCK waits for one to be freed, REG_ASYNC_DROP
+   returns REG_NOT_READY and REG_ASYNC_OVERWRITE replaces the oldest
+   sample that is still waiting to be sent
+   @return REG_SUCCESS, REG_FAILURE
+
+   Switch the specified IOType to asynchronous emission.  In this
+   mode Emit_data_slice() and Emit_data_slices() copy the data into
+   one of two library-owned snapshot buffers and return at once.
+   Emit_stop() queues the snapshot and a background I/O thread sends
+   it, so a slow consumer no longer holds up the application.
+   Acknowledgements work as before except that the I/O thread, rather
+   than Emit_start(), waits for them: a snapshot stays queued until
+   the previous sample has been acknowledged, or until a consumer
+   connects.  If both buffers are queued then @p Policy applies,
+   except that while there is no consumer REG_ASYNC_BLOCK behaves as
+   REG_ASYNC_DROP (so Emit_start_blocking() waits for a consumer just
+   as it does for synchronous IOTypes).  May be called again to change
+   the policy.  Only available where POSIX threads are.
+   @see Disable_IOType_async(), Set_async_emit_cpu()
+ */
+extern PREFIX int Enable_IOType_async(int IOType,
+				      int Policy);
+
+/**
+   @param IOType Handle of the IOType
+   @return REG_SUCCESS, REG_FAILURE
+
+   Switch the specified IOType back to synchronous emission.  Waits
+   up to REG_ASYNC_DRAIN_TIMEOUT seconds for queued samples to be sent
+   and discards any that remain.
+   @see Enable_IOType_async()
+ */
+extern PREFIX int Disable_IOType_async(int IOType);
+
+/**
+   @param IOType Handle of the IOType
+   @param Codec Codec to compress with: REG_COMPRESS_NONE or
+   REG_COMPRESS_ZLIB
+   @return REG_SUCCESS, REG_FAILURE
+
+   Compress the data slices of the specified (output) IOType before
+   they are sent.  Call straight after Register_IOType() to compress
+   from the first sample.  The codec is also registered as the
+   steerable parameter "<IOLabel> compression" so can be changed at
+   run time, and "<IOLabel> compression ratio" is monitored on both
+   the emitting and consuming sides.  Slices of fewer than
+   REG_COMPRESS_MIN_BYTES bytes, slices that do not shrink and
+   slices for consumers that predate compression are sent as they
+   are.  Consume_data_slice() decompresses transparently.
+ */
+extern PREFIX int Set_IOType_compression(int IOType,
+					 int Codec);
+
+/**
+   @param IOType Handle of the IOType
+   @param Mode Lossy encoding of float and double slices:
+   REG_LOSSY_NONE, REG_LOSSY_TRUNCATE, REG_LOSSY_QUANT16 or
+   REG_LOSSY_HALF
+   @param BoundType REG_ERROR_ABS if @p Bound is the largest absolute
+   error allowed in any element, REG_ERROR_REL if it is relative to
+   the largest magnitude in each slice
+   @param Bound The error bound - must be greater than zero
+   @return REG_SUCCESS, REG_FAILURE
+
+   Trade accuracy for size on an (output) IOType whose samples are
+   only to be visualised.  REG_LOSSY_TRUNCATE rounds away the
+   mantissa bits that @p Bound does not need; the data is no smaller
+   but compresses far better (see Set_IOType_compression()).
+   REG_LOSSY_QUANT16 sends each element as 16 bits with a per-slice
+   offset and scale and REG_LOSSY_HALF sends it in IEEE half precision.
+   A slice that cannot be encoded within @p Bound (or, for the last two,
+   whose consumer predates them or that holds NaN, infinity or values
+   too large for half precision) is sent exactly.
+   Consume_data_slice() hands back the reconstructed float or double
+   values.  "<IOLabel> lossy bytes saved" and "<IOLabel> lossy max
+   error" are monitored for each sample.
+ */
+extern PREFIX int Set_IOType_lossy(int    IOType,
+				   int    Mode,
+				   int    BoundType,
+				   double Bound);
+
+/**
+   @param IOType Handle of the IOType
+   @param KeyInterval Send every slice whole once in this many
+   samples, or zero to always send them whole
+   @return REG_SUCCESS, REG_FAILURE
+
+   Send only what has changed since the last sample on an (output)
+   IOType whose samples change little from one to the next.  In
+   between key frames each slice is sent as the XOR of its encoded
+   bytes with the same slice of the previous sample.  The result is
+   mostly zeros so this is meant to be used with
+   Set_IOType_compression().  A slice whose type or size has changed
+   is sent whole, and a key frame is sent to a consumer that has
+   only just connected or predates deltas.  Consume_data_slice()
+   rebuilds the data transparently; if it has lost track of the
+   emitter it returns REG_FAILURE for deltas until the next key
+   frame.
+ */
+extern PREFIX int Set_IOType_delta(int IOType,
+				   int KeyInterval);
+
+/**
+   @param IOType Handle of the IOType (direction REG_IO_OUT)
+   @param MaxConsumers Max. no. of consumers to send samples to at
+   once (the default is one)
+   @return REG_SUCCESS, REG_FAILURE
+
+   Let more than one consumer connect to an output IOType at a time.
+   Each sample is encoded once and the same bytes are sent to every
+   consumer.  Consumers acknowledge samples separately so one that is
+   still busy with the last sample when the next is emitted misses
+   it rather than holding up the others, and one that stops reading
+   altogether is disconnected.  Data goes in the form that all of
+   the consumers understand.  Lowering the limit does not disconnect
+   consumers that are already connected.  Only the sockets samples
+   transport can feed more than one consumer; for the others this
+   has no effect.
+ */
+extern PREFIX int Set_IOType_max_consumers(int IOType,
+					   int MaxConsumers);
+
+/**
+   @param IOType Handle of the IOType to query
+   @param Consumer Which of the connected consumers to report on,
+   numbered from zero in the order that they connected
+   @param NumConsumers On return, the no. of consumers connected
+   @param NumBytes On return, the no. of bytes sent to that consumer
+   since it connected
+   @param BytesPerSec On return, the average rate at which they were
+   sent (only measured if the library was built with REG_USE_TIMING)
+   @param NumSamples On return, the no. of samples sent to it
+   @param NumSkipped On return, the no. of samples that it missed
+   because it was still busy with an earlier one
+   @return REG_SUCCESS, REG_FAILURE
+
+   Reports how well each of the consumers of an output IOType is
+   keeping up.  If @p Consumer is out of range then only
+   @p NumConsumers is set.  Only the sockets samples transport keeps
+   these figures.
+ */
+extern PREFIX int Get_IOType_consumer_stats(int     IOType,
+					    int     Consumer,
+					    int    *NumConsumers,
+					    double *NumBytes,
+					    double *BytesPerSec,
+					    int    *NumSamples,
+					    int    *NumSkipped);
+
+/**
+   @param IOType Handle of the IOType
+   @param NumStreams No. of parallel streams to send large slices
+   over, from one (the default, just the main connection) to
+   REG_MAX_STREAMS
+   @return REG_SUCCESS, REG_FAILURE
+
+   Send the data of large slices over several connections at once.
+   A single TCP connection cannot always keep a fast link full with
+   very large samples so, when both ends of an IOType ask for more
+   than one stream, the consumer opens that many extra connections to
+   the emitter (from the same range of ports as the main one).  The
+   data of each slice of at least REG_STRIPE_MIN_BYTES is dealt out
+   between them in REG_STRIPE_CHUNK_SIZE pieces which are sent and
+   received by a thread per stream, and put back together in order
+   by Consume_data_slice().  Headers and small slices still go over
+   the main connection.  The two ends use the smaller of the two
+   numbers of streams.  Only the sockets samples transport has
+   parallel streams; for the others this has no effect.
+ */
+extern PREFIX int Set_IOType_streams(int IOType,
+				     int NumStreams);
+
+/**
+   @param IOType Handle of the IOType (direction REG_IO_OUT)
+   @param Checksum REG_TRUE to send checksums, REG_FALSE (the default)
+   not to
+   @return REG_SUCCESS, REG_FAILURE
+
+   Let consumers check that the samples emitted on an IOType arrive
+   intact.  Consumers that understand them are sent samples in
+   frames, each with a header giving its length and the sequence no.
+   of its sample, so that a consumer can skip what it doesn't read of
+   a sample without looking at it.  With this set each frame also
+   carries an Adler-32 checksum of its contents, which the consumer
+   checks as it reads.  A frame is whatever is sent in one go
+   (usually a whole sample, or a large slice with the small ones
+   before it) so the read that reaches the end of a frame that
+   doesn't match returns REG_FAILURE, and so does Consume_stop() for
+   that sample.  Data sent over parallel streams (see
+   Set_IOType_streams()) is not covered.  Only the sockets samples
+   transport sends frames; for the others this has no effect.
+ */
+extern PREFIX int Set_IOType_checksum(int IOType,
+				      int Checksum);
+
+/**
+   @param IOType Handle of the (input) IOType
+   @param Sx, Sy, Sz Origin of the box wanted within the whole array
+   @param Nx, Ny, Nz Extent of the box, or zero for as far as the
+   array goes along that axis
+   @param StrideX, StrideY, StrideZ Take every this many elements
+   along each axis, starting with the first in the box
+   @return REG_SUCCESS, REG_FAILURE
+
+   Ask the emitter to send only part of each array: every so many
+   elements of a box within it, e.g. an overview at a quarter of the
+   resolution or one area at full resolution.  All positions are in
+   the terms of the chunk headers (see Make_chunk_header()) that the
+   emitter puts before each block of the array - blocks that are
+   emitted without one are always sent whole.  Each block is cut down
+   by the emitter before it is encoded and arrives with a chunk
+   header that places it in the smaller array made up of the wanted
+   elements, @e i.e. @c ceil(Nx/StrideX) elements along x and so on.
+   Blocks with nothing wanted in them are not sent.
+
+   The region goes to the emitter in the acknowledgement of each
+   sample, so takes effect from the sample after the next one to be
+   consumed, and only if the emitter can cut arrays down (this
+   version of the library or later, sending to just the one
+   consumer).  Pass a zero origin, zero extents and unit strides to
+   have whole arrays sent again.
+ */
+extern PREFIX int Set_IOType_region(int IOType,
+				    int Sx,      int Sy,      int Sz,
+				    int Nx,      int Ny,      int Nz,
+				    int StrideX, int StrideY, int StrideZ);
+
+/**
+   @param IOType Handle of the (output) IOType
+   @param NumLevels No. of levels of detail to send each array at,
+   from 1 (just full resolution, the default) to REG_MAX_LEVELS
+   @return REG_SUCCESS, REG_FAILURE
+
+   Send each array coarsest first so that a consumer can show
+   something before the whole of it has arrived.  Only arrays emitted
+   just after a chunk header (see Make_chunk_header()) are sent this
+   way, and each is sent as it is emitted, so the gain is within each
+   array: emit a field as one array, or a few large blocks, to see
+   the whole of it early.  The coarsest level is every 2^(n-1)th
+   element along each axis, for @p NumLevels n.  Each finer level
+   adds the planes half way between those already sent, then the
+   rows half way between them in the other planes, then the elements
+   half way between them in the other rows, so every element is sent
+   once and a sample is no bigger than without levels.  Each part of
+   a level goes after its own chunk header, which says where its
+   elements lie, a few planes at a time (see REG_LEVEL_PART_SIZE).
+   Fewer levels are used for blocks too small for them.  The buffer
+   that parts are gathered in counts towards any limit from
+   Set_IOType_buffer_limit().
+
+   The consumer reads each part into the same buffer, of the size
+   of the whole block, as Consume_data_slice_header() gives the count
+   of the whole block for each, and must read the chunk headers
+   somewhere else.  Once a level is complete the buffer holds the
+   whole block at that level of detail, the elements still to come
+   being copies of their nearest neighbours.  It can call
+   Get_IOType_level() as it reads to find out how much detail it has
+   so far and Consume_stop() once it has enough.  A consumer needs
+   this version of the library or later.
+
+   Putting each part in place and filling in the rest of the block
+   costs the consumer time, so the whole sample arrives later.  On
+   loopback, with 128^3 doubles emitted as one array, four levels
+   give a first picture in 5.3 ms rather than 8.9 ms but the whole
+   array in 34 ms rather than 12.5 ms; at 256^3, 28 ms rather than
+   63 ms and 256 ms rather than 87 ms (see progressive_bench).  The
+   slower the link, the more of the array the coarsest level saves
+   waiting for.
+ */
+extern PREFIX int Set_IOType_levels(int IOType,
+				    int NumLevels);
+
+/**
+   @param IOType Handle of the (input) IOType
+   @param NumSamples No. of samples that the emitter may send ahead of
+   our acknowledgements, from 1 (the default) to REG_MAX_WINDOW
+   @return REG_SUCCESS, REG_FAILURE
+
+   Let the emitter keep more than one sample in flight.  By default
+   an emitter that uses acknowledgements (see Disable_IOType_acks())
+   waits for each sample to be acknowledged before it sends the next,
+   so it waits for the consumer at least once per sample.  With a
+   larger window the emitter sends up to @p NumSamples samples that
+   have not been acknowledged and the consumer acknowledges them in
+   batches of about half the window, or at once when it has read all
+   that there is.  Each acknowledgement says how many samples it
+   covers.  Samples that the consumer has not yet read wait in the
+   connection, so a large window uses more memory there and delays
+   the effect of any region asked for (see Set_IOType_region()).
+
+   The window goes to the emitter in our next acknowledgement and can
+   be changed while samples are being consumed, also by steering the
+   parameter "<IOLabel> window" that is registered for the IOType.
+   It is only used if the emitter can keep samples in flight (this
+   version of the library or later, sending to just the one consumer
+   over the sockets samples transport).
+ */
+extern PREFIX int Set_IOType_window(int IOType,
+				    int NumSamples);
+
+/**
+   @param IOType Handle of the IOType
+   @param MaxBytes Most bytes of buffers that the IOType may hold, or
+   zero (the default) for no limit
+   @return REG_SUCCESS, REG_FAILURE
+
+   Cap the memory that the library uses to encode, compress or decode
+   the samples of an IOType.  The buffers are taken from a pool of
+   page-aligned buffers in size classes, so are rounded up, and are
+   kept from one sample to the next until the IOType is disabled.  A
+   slice that would need more than @p MaxBytes makes the call to emit
+   or consume it return REG_FAILURE instead.  Buffers already held are
+   not given up.  See Get_IOType_buffer_stats().
+ */
+extern PREFIX int Set_IOType_buffer_limit(int    IOType,
+					  double MaxBytes);
+
+/**
+   @param IOType Handle of the IOType
+   @param HeldBytes On return, no. of bytes of buffers held now
+   @param HighWater On return, the most bytes of buffers held at once
+   since the IOType was registered
+   @return REG_SUCCESS, REG_FAILURE
+
+   Find out how much memory the library uses for the samples of an
+   IOType (see Set_IOType_buffer_limit()).
+ */
+extern PREFIX int Get_IOType_buffer_stats(int     IOType,
+					  double *HeldBytes,
+					  double *HighWater);
+
+/**
+   @param IOType Handle of the IOType (direction REG_IO_OUT)
+   @param QueuedBytes On return, no. of bytes still waiting to be
+   written when the last sample was stopped
+   @param HighWater On return, the most bytes that have been waiting
+   to be written at once
+   @param MeanSeconds On return, the average time taken by a write
+   (the closing of each data file, which waits for its data to reach
+   the disk, counts as one)
+   @param MaxSeconds On return, the longest time taken by a write
+   @param NumStalls On return, the no. of times that emitting had to
+   wait for room in the writer's queue
+   @return REG_SUCCESS, REG_FAILURE
+
+   Reports how the background writer of the files samples transport
+   is keeping up with an IOType.  The writer is used when the
+   REG_DATA_WRITE_QUEUE environment variable gives the most bytes that
+   may wait to be written; if stalls are frequent then it is too
+   small for the filesystem.  The figures are brought up to date by
+   each Emit_stop().  For the other transports, or without the
+   writer, all are zero.
+ */
+extern PREFIX int Get_IOType_write_stats(int     IOType,
+					 double *QueuedBytes,
+					 double *HighWater,
+					 double *MeanSeconds,
+					 double *MaxSeconds,
+					 int    *NumStalls);
+
+/**
+   @param Cpu No. of the CPU to run the I/O thread on, or -1 to leave
+   the choice to the operating system
+   @return REG_SUCCESS, REG_FAILURE
+
+   Pin the thread that sends samples for asynchronous IOTypes to a
+   (spare) CPU.  Takes effect immediately if the thread is running or
+   else when it is started by Enable_IOType_async().  The CPU can also
+   be given with the REG_ASYNC_EMIT_CPU environment variable.
+   Setting -1 does not undo an earlier pinning.
+   @see Enable_IOType_async()
+ */
+extern PREFIX int Set_async_emit_cpu(int Cpu);
+
+/**
+   @param IOType Handle of the IOType to query
+   @param NumDropped On return, the no. of times Emit_start()
+   returned REG_NOT_READY because no snapshot buffer was free, plus
+   the no. of snapshots that the I/O thread failed to send
+   @param NumOverwritten On return, the no. of queued samples that
+   were replaced by newer ones under REG_ASYNC_OVERWRITE
+   @return REG_SUCCESS, REG_FAILURE
+
+   Reports how many samples of an asynchronous IOType never reached
+   the consumer.
+ */
+extern PREFIX int Get_IOType_async_stats(int  IOType,
+					 int *NumDropped,
+					 int *NumOverwritten);
+
 /**
    @param NumTypes No. of checkpoint types to register
    @param ChkLabel Unique label for each Chk type
@@ -546,7 +975,10 @@ extern PREFIX int Emit_start(int  IOType,
 
 /**
    Blocking version of Emit_start().  Blocks until IOType is ready to
-   send data OR the specified @p TimeOut (seconds) is exceeded. */
+   send data OR the specified @p TimeOut (seconds) is exceeded.  Sleeps
+   until the transport has something for the IOType (a consumer
+   connecting or acknowledging the last sample) rather than polling,
+   where the transport allows. */
 extern PREFIX int Emit_start_blocking(int    IOType,
 				      int    SeqNum,
 				      int   *IOTypeIndex,
@@ -647,6 +1079,37 @@ extern PREFIX int Emit_data_slice(int	            IOTypeIndex,
 				  int               Count,
 				  const void       *pData);
 
+/**
+   Describes one 'slice' of data for Emit_data_slices() and
+   Consume_data_slices().
+*/
+struct reg_data_slice {
+  /** The type of the data, as encoded in ReG_Steer_types.h */
+  int   type;
+  /** The number of objects of type @p type in the slice */
+  int   count;
+  /** Pointer to the slice's data */
+  void *data;
+};
+
+/**
+   @param IOTypeIndex Index of the IOType (as returned by Emit_start())
+   @param NumSlices The number of slices in @p Slices
+   @param Slices Array of slice descriptors giving the type, count and
+   location of the data for each slice
+   @return REG_SUCCESS, REG_FAILURE
+
+   Equivalent to calling Emit_data_slice() once for each of the
+   @p NumSlices slices in turn but the checks on the IOType are done
+   once for the whole batch and the slice headers and data are handed
+   to the transport together, so that a sample made up of many small
+   slices can be sent with far fewer system calls.  Every descriptor is
+   checked before anything is sent.
+*/
+extern PREFIX int Emit_data_slices(int                          IOTypeIndex,
+				   int                          NumSlices,
+				   const struct reg_data_slice *Slices);
+
 /**
    Signal the end of the emission of the sample/data set referred to by
    IOHandle.   This signals the receiving end that the
@@ -686,7 +1149,9 @@ extern PREFIX int Consume_start(int               IOType,
 /**
    @return REG_SUCCESS, REG_TIMED_OUT
    Blocking version of Consume_start().  Blocks until data is available to
-   read OR @p TimeOut (seconds) is exceeded
+   read OR @p TimeOut (seconds) is exceeded.  Returns as soon as the
+   transport says that data has arrived rather than polling for it,
+   where the transport allows.
 */
 extern PREFIX int Consume_start_blocking(int   IOType,
 					 int  *IOTypeIndex,
@@ -733,6 +1198,101 @@ extern PREFIX int Consume_data_slice(int     IOTypeIndex,
 		                     int     Count,
 		                     void   *pData);
 
+/**
+   @param IOTypeIndex The index returned from call to
+   Consume_start() - identifies the IO channel to be read.
+   @param DataType The type of the data to read
+   @param Count The number of objects of type @p DataType to read
+   @param pData On successful return, points to the data
+   @return REG_SUCCESS, REG_FAILURE
+
+   As Consume_data_slice() but the library provides the memory that
+   the data ends up in.  If the slice needs no decoding (no XDR,
+   reordering, compression, lossy encoding or deltas) and the samples
+   transport allows it then @p pData points at the data where it
+   lies, without it being copied.  Only the files samples transport
+   with REG_DATA_MMAP set does so at present; otherwise the data is
+   decoded into a buffer belonging to the IOType.  The data must not
+   be changed and is only valid until the next call to this routine
+   or to Consume_stop() for the channel.
+*/
+extern PREFIX int Consume_data_slice_ptr(int     IOTypeIndex,
+		                         int     DataType,
+		                         int     Count,
+		                         void  **pData);
+
+/**
+   @param IOTypeIndex The index returned from call to
+   Consume_start() - identifies the IO channel to be read.
+   @param NumSlices On successful return, the no. of slices in the
+   sample being consumed
+   @return REG_SUCCESS, REG_FAILURE
+
+   Find out how many slices there are in the sample being consumed.
+   Only possible where the samples transport keeps an index of them -
+   at present the files transport, for files written by this version
+   of the library or later.  Must be called between Consume_start()
+   and Consume_stop().
+*/
+extern PREFIX int Get_consumed_slice_count(int  IOTypeIndex,
+					   int *NumSlices);
+
+/**
+   @param IOTypeIndex The index returned from call to
+   Consume_start() - identifies the IO channel to be read.
+   @param Level On successful return, the finest level of detail at
+   which the block being consumed has arrived in full (zero being
+   full resolution), or -1 if it has not arrived at any yet
+   @param NumLevels On successful return, the no. of levels of detail
+   that the block is being sent at, or zero if it is not being sent
+   a level at a time (see Set_IOType_levels())
+   @return REG_SUCCESS, REG_FAILURE
+
+   Find out how much detail the sample being consumed has delivered.
+   A level is complete once the array that follows the last of its
+   chunk headers has been consumed.  Levels of a block arrive
+   coarsest first, so the consumer may call Consume_stop() as soon
+   as @p Level is fine enough for it and the rest of the sample is
+   skipped.
+*/
+extern PREFIX int Get_IOType_level(int  IOTypeIndex,
+				   int *Level,
+				   int *NumLevels);
+
+/**
+   @param IOTypeIndex The index returned from call to
+   Consume_start() - identifies the IO channel to be read.
+   @param Slice The slice to move to, numbered from zero in the order
+   that the slices were emitted
+   @return REG_SUCCESS, REG_FAILURE
+
+   Move straight to a slice of the sample being consumed, forwards or
+   back, so that the next call to Consume_data_slice_header() reads
+   its header.  Slices that aren't wanted need not be read at all.
+   Only possible where Get_consumed_slice_count() is.
+*/
+extern PREFIX int Consume_seek_slice(int IOTypeIndex,
+				     int Slice);
+
+/**
+   @param IOTypeIndex The index returned from call to
+   Consume_start() - identifies the IO channel to be read.
+   @param NumSlices The number of slices to read
+   @param Slices Array of slice descriptors.  On entry, the @c type of
+   each slice must match the type of the incoming data and @c count must
+   hold the number of objects that @c data has room for.  On successful
+   return, @c count holds the number of objects actually read.
+   @return REG_SUCCESS, REG_FAILURE
+
+   Reads the next @p NumSlices slices of the current data set, as if
+   by a call to Consume_data_slice_header() and Consume_data_slice()
+   for each.  Fails if there are fewer than @p NumSlices slices left in
+   the data set or if a slice does not match its descriptor.
+*/
+extern PREFIX int Consume_data_slices(int                    IOTypeIndex,
+				      int                    NumSlices,
+				      struct reg_data_slice *Slices);
+
 /**
    @param IOTypeIndex Index of the open IOType channel to close.  Not
    valid once this call has completed.
@@ -742,9 +1302,11 @@ extern PREFIX int Consume_data_slice(int     IOTypeIndex,
    returned @c REG_FAILURE indicating that there are no more 'slices'
    to read for the current data set.  It signals the end of the
    consumption of the sample/data set referred to by @p
-   IOTypeIndex. Frees any memory used during the consumption. This
+   IOTypeIndex. The buffers used are kept for the next sample. This
    routine should be called by the same thread that made the
-   corresponding call to Consume_start.
+   corresponding call to Consume_start.  Returns REG_FAILURE if the
+   sample was found not to have arrived intact (see
+   Set_IOType_checksum()).
 */
 extern PREFIX int Consume_stop(int	       *IOTypeIndex);
 
@@ -826,7 +1388,12 @@ extern PREFIX int Make_vtk_header(char  *header,
 
 /**
    Create a simple header for a data chunk - simply gives origin and
-   extent of a 3D chunk of a larger data set */
+   extent of a 3D chunk of a larger data set.  @p header must have
+   room for REG_CHUNK_HDR_SIZE chars.  Emitting the header as a
+   REG_CHAR slice just before the chunk itself lets the chunk be cut
+   down to the region that the consumer wants (see
+   Set_IOType_region()) or sent a level of detail at a time (see
+   Set_IOType_levels()) */
 extern PREFIX int Make_chunk_header(char *header,
 				    int   IOindex,
 				    int   totx, int toty, int totz,
@@ -845,8 +1412,12 @@ extern PREFIX int Called_from_f90(int flag);
 
 /**
    Reorder array pointed to by pInData into array pointed to by
-   pOutData (must be of dimension tot_extent[0]*tot_extent[1]*tot_extent[2])
-   If to_f90 == 1 then reorders from C to F90, otherwise, F90 to C */
+   pOutData (must be of dimension tot_extent[0]*...*tot_extent[ndims-1]).
+   pInData holds a block of extent sub_extent that is placed at origin
+   within pOutData.  Arrays of 1 to REG_REORDER_MAX_DIMS dimensions and
+   of type REG_INT, REG_LONG, REG_FLOAT, REG_DBL or REG_CHAR are
+   supported.  If to_f90 == 1 then reorders from C to F90, otherwise,
+   F90 to C */
 extern PREFIX int Reorder_array(int          ndims,
 				int         *tot_extent,
 				int         *sub_extent,
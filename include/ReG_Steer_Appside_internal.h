@@ -65,6 +65,9 @@
 
 /*----------------------- Data structures -----------------------*/
 
+/* Defined in ReG_Steer_Appside.h */
+struct reg_data_slice;
+
 /** @internal
     Structure to hold details of open IO channels */
 typedef struct {
@@ -287,6 +290,18 @@ int Consume_ack(const int index);
     ready for the next */
 int Emit_ack(const int index);
 
+/** @internal
+    @param index The index of the IOType being used
+    @param TimeOut Longest time to wait (seconds)
+    @return REG_SUCCESS if something has happened, REG_TIMED_OUT if
+    not, REG_FAILURE if there was nothing to wait on and we polled
+
+    Sleep until the transport (or, for an asynchronous IOType, the I/O
+    thread) might let Emit_start() or Consume_start() succeed, or
+    until @p TimeOut has passed.  Sleeps for REG_BLOCKING_POLL_INTERVAL
+    instead if there is nothing to wait on. */
+int Wait_for_IOType(const int index, const double TimeOut);
+
 /** @internal
     @param index The index of the IOType being used
     @return REG_SUCCESS if data available, REG_FAILURE otherwise
@@ -311,6 +326,18 @@ int Consume_data_read(const int		index,
 		      const size_t	num_bytes_to_read,
 		      void		*pData);
 
+/** @internal
+    @param index The index of the IOType being used
+    @param num_bytes No. of bytes of data in the slice
+    @param pData On successful return, points to the data
+    @return REG_SUCCESS, or REG_FAILURE if the transport can't hand
+    over the data where it lies
+
+    Consume the data of a slice without copying it */
+int Consume_data_map(const int     index,
+		     const size_t  num_bytes,
+		     void        **pData);
+
 /** @internal
     @param index The index of the IOType being used
 
@@ -370,6 +397,9 @@ int Consume_iotype_msg_header(int IOTypeIndex,
     @param NumBytes No. of bytes to specify
     @param IsFortranArray Whether this header is for data from a FORTRAN
     array (REG_TRUE or REG_FALSE)
+    @param Codec The codec the data is compressed with
+    @param RawBytes No. of bytes of data before compression
+    @param Flags REG_SLICE_FLAG_* flags from Delta_encode_slice()
     @return REG_SUCCESS, REG_FAILURE
 
     Construct and send ReG-specific header for iotype*/
@@ -377,7 +407,292 @@ int Emit_iotype_msg_header(int IOTypeIndex,
 			   int DataType,
 			   int Count,
 			   int NumBytes,
-			   int IsFortranArray);
+			   int IsFortranArray,
+			   int Codec,
+			   int RawBytes,
+			   int Flags);
+
+/** @internal
+    @param IOTypeIndex Index of IOType being used
+    @param DataType Type of data to specify
+    @param Count No. of data elements to specify
+    @param NumBytes No. of bytes to specify
+    @param IsFortranArray Whether this header is for data from a FORTRAN
+    array (REG_TRUE or REG_FALSE)
+    @param Codec The codec the data is compressed with - must be
+    REG_COMPRESS_NONE unless the consumer understands version
+    REG_SLICE_HDR_COMPRESS_VERSION slice headers
+    @param RawBytes No. of bytes of data before compression
+    @param Flags REG_SLICE_FLAG_* flags from Delta_encode_slice() -
+    must be zero unless the consumer understands version
+    REG_SLICE_HDR_DELTA_VERSION slice headers
+    @param buffer Buffer to write the header into - must have room for
+    at least 7*REG_PACKET_SIZE bytes
+    @return The number of bytes of header written to @p buffer
+
+    Construct ReG-specific header for iotype without sending it */
+int Pack_iotype_msg_header(int   IOTypeIndex,
+			   int   DataType,
+			   int   Count,
+			   int   NumBytes,
+			   int   IsFortranArray,
+			   int   Codec,
+			   int   RawBytes,
+			   int   Flags,
+			   char *buffer);
+
+/** @internal
+    @param IOTypeIndex Index of IOType being used
+    @param DataType Type of data in slice
+    @param Count No. of data elements in slice
+    @param pData Pointer to the slice's data
+    @param pXdrBuf Buffer to XDR-encode into if the IOType uses XDR -
+    must have room for @p Count elements of encoded data
+    @param EmitType On return, the type the data is to be sent as
+    @param NumBytes On return, the no. of bytes to send
+    @param pOut On return, pointer to the data to send (either @p pData
+    or @p pXdrBuf)
+    @return REG_SUCCESS, REG_FAILURE
+
+    Prepare a single data slice for emission, converting to XDR
+    if required */
+int Encode_data_slice(int          IOTypeIndex,
+		      int          DataType,
+		      int          Count,
+		      const void  *pData,
+		      void        *pXdrBuf,
+		      int         *EmitType,
+		      size_t      *NumBytes,
+		      void       **pOut);
+
+/** @internal
+    @param IOTypeIndex Index of IOType being used
+    @param NumSlices No. of slices to send
+    @param Slices The slices to send - already checked
+    @param IsFortranArray Whether the slices hold data from FORTRAN
+    arrays (REG_TRUE or REG_FALSE)
+    @param HdrBuffer Buffer to build slice headers in - must have room
+    for REG_SLICE_BATCH_SIZE*7*REG_PACKET_SIZE bytes
+    @return REG_SUCCESS, REG_FAILURE
+
+    Encode and send a set of data slices, handing them to the
+    transport REG_SLICE_BATCH_SIZE at a time.  If the consumer has
+    asked for part of each array, arrays that follow a chunk header
+    are cut down to it first.  If the IOType sends arrays a level of
+    detail at a time (Set_IOType_levels()), arrays that follow a chunk
+    header are sent that way, so each chunk header is held back until
+    we know whether an array follows it. */
+int Send_data_slices(int                          IOTypeIndex,
+		     int                          NumSlices,
+		     const struct reg_data_slice *Slices,
+		     int                          IsFortranArray,
+		     char                        *HdrBuffer);
+
+/** @internal
+    @param IOTypeIndex Index of IOType being used
+    @param HdrBuffer As for Send_data_slices()
+    @return REG_SUCCESS, REG_FAILURE
+
+    Send anything that Send_data_slices() has held back in this
+    sample, which can only be a chunk header emitted last.  Called
+    just before the footer of the sample is sent. */
+int Flush_data_slices(int   IOTypeIndex,
+		      char *HdrBuffer);
+
+/** @internal
+    @param IOTypeIndex Index of IOType being used
+    @param DataType Type of the (native) data, e.g. REG_INT
+    @param Count No. of elements in the slice
+    @param pData Pointer to the whole array to reorder the slice into
+    @return REG_SUCCESS, REG_FAILURE
+
+    Read a slice whose array ordering must be converted.  The slice
+    is read a few planes at a time and each piece is decoded (if it is
+    XDR) and reordered straight into its place in @p pData, so that no
+    copy of the whole slice is needed. */
+int Consume_reordered_data(int    IOTypeIndex,
+			   int    DataType,
+			   int    Count,
+			   void  *pData);
+
+/** @internal
+    @param IOTypeIndex Index of IOType being used
+    @return The codec to compress the slices of the current sample
+    with - REG_COMPRESS_NONE unless compression has been asked for and
+    the consumer understands compressed slices */
+int Get_slice_codec(int IOTypeIndex);
+
+/** @internal
+    @param IOTypeIndex Index of IOType being used
+    @param Codec The codec to use, from Get_slice_codec()
+    @param pIn Pointer to the (encoded) slice data
+    @param NumBytes No. of bytes of slice data
+    @param pCompBuf Buffer of at least Compress_bound(@p Codec,
+    @p NumBytes) bytes to hold the compressed data
+    @param EmitCodec On return, the codec actually used
+    @param SendBytes On return, the no. of bytes to send
+    @param pOut On return, pointer to the data to send
+    @return REG_SUCCESS
+
+    Compress a slice ready to send.  Small slices, and those that
+    will not compress, are sent as they are (with @p EmitCodec set to
+    REG_COMPRESS_NONE).  Updates the IOType's compression
+    statistics. */
+int Compress_data_slice(int          IOTypeIndex,
+			int          Codec,
+			void        *pIn,
+			size_t       NumBytes,
+			void        *pCompBuf,
+			int         *EmitCodec,
+			size_t      *SendBytes,
+			void       **pOut);
+
+/** @internal
+    @param IOTypeIndex Index of IOType being used
+    @param DataType Type of the (native) data, e.g. REG_INT
+    @param NumBytes No. of bytes the slice decompresses to
+    @param pOut Pointer to room for @p NumBytes bytes
+    @return REG_SUCCESS, REG_FAILURE
+
+    Read a compressed slice and decompress it into @p pOut, ready to
+    be decoded as an uncompressed slice would be. */
+int Consume_compressed_data(int     IOTypeIndex,
+			    int     DataType,
+			    size_t  NumBytes,
+			    void   *pOut);
+
+/** @internal
+    @param IOTypeIndex Index of IOType being used
+    @param DataType Type of data in slice
+    @param Count No. of data elements in slice
+    @return The largest no. of bytes that Encode_data_slice() may
+    write into its @p pXdrBuf for this slice
+
+    Work out how much buffer space encoding a slice needs - for XDR
+    or a lossy encoding - before any of a batch is encoded. */
+size_t Encoded_size_bound(int IOTypeIndex,
+			  int DataType,
+			  int Count);
+
+/** @internal
+    @param IOTypeIndex Index of IOType being used
+    @param DataType Type of the (native) data, REG_FLOAT or REG_DBL
+    @param Count No. of elements in the slice
+    @param NumBytes No. of bytes of encoded data (once decompressed)
+    @param pData Pointer to buffer to put the data in
+    @return REG_SUCCESS, REG_FAILURE
+
+    Read a slice that was sent with a lossy encoding (after
+    decompressing it if need be) and reconstruct the float or double
+    values. */
+int Consume_lossy_data(int     IOTypeIndex,
+		       int     DataType,
+		       int     Count,
+		       size_t  NumBytes,
+		       void   *pData);
+
+/** @internal
+    @param IOTypeIndex Index of IOType being used
+
+    Decide whether the sample about to be emitted is a key frame or
+    made of deltas against the last one. */
+void Emit_delta_start(int IOTypeIndex);
+
+/** @internal
+    @param IOTypeIndex Index of IOType being used
+    @param EmitType The type of the slice as it will be sent
+    @param pIn Pointer to the (encoded) slice data
+    @param NumBytes No. of bytes of slice data
+    @param pDeltaBuf Buffer of at least @p NumBytes bytes to hold the
+    delta - may be @p pIn
+    @param pOut On return, pointer to the data to send
+    @param Flags On return, the REG_SLICE_FLAG_* flags to send in the
+    slice header
+    @return REG_SUCCESS, REG_FAILURE
+
+    Replace a slice with its XOR against the same slice of the last
+    sample if the IOType sends deltas and this is not a key frame.
+    Slices that are sent whole are kept for the next sample. */
+int Delta_encode_slice(int     IOTypeIndex,
+		       int     EmitType,
+		       void   *pIn,
+		       size_t  NumBytes,
+		       void   *pDeltaBuf,
+		       void  **pOut,
+		       int    *Flags);
+
+/** @internal
+    @param IOTypeIndex Index of IOType being used
+
+    Move on to the next sample for the purpose of applying deltas,
+    forgetting the slices of the last one if we have lost track of
+    the emitter since. */
+void Consume_delta_start(int IOTypeIndex);
+
+/** @internal
+    @param IOTypeIndex Index of IOType being used
+    @param DataType Type of the (native) data
+    @param Count No. of elements in the slice
+    @param NumBytes No. of bytes of data as sent (once decompressed)
+    @param pData Pointer to buffer to put the data in
+    @return REG_SUCCESS, REG_FAILURE
+
+    Read a key frame or delta slice, keep it or apply it to the same
+    slice of the last sample and decode the result into @p pData.  A
+    delta with nothing to apply it to is read but REG_FAILURE is
+    returned until the next key frame arrives. */
+int Consume_delta_data(int     IOTypeIndex,
+		       int     DataType,
+		       int     Count,
+		       size_t  NumBytes,
+		       void   *pData);
+
+/** @internal
+    @param index Index of IOType
+    @param num_bytes Minimum size (in bytes) of the buffer
+
+    Make sure that the IOType's buffer for compressed data is at least
+    @p num_bytes long */
+int Realloc_iotype_comp_buffer(int    index,
+			       size_t num_bytes);
+
+/** @internal
+    @param iodef Pointer to an IOdef_entry
+    @param buf Pointer to the buffer to grow
+    @param max_bytes Pointer to the size of @p buf
+    @param num_bytes Minimum size (in bytes) of the buffer
+    @param func Name of the calling function, for error messages
+    @return REG_SUCCESS, REG_FAILURE
+
+    Make sure that one of the IOdef_entry's buffers whose contents
+    are only needed for one slice is at least @p num_bytes long. */
+int Realloc_scratch_buffer(IOdef_entry *iodef,
+			   void       **buf,
+			   size_t      *max_bytes,
+			   size_t       num_bytes,
+			   const char  *func);
+
+/** @internal
+    @param index Index of IOType
+
+    Register the parameters used to steer and monitor the compression
+    of the IOType's samples */
+int Register_IOType_comp_params(int index);
+
+/** @internal
+    @param index Index of IOType
+
+    Register the parameter used to steer the no. of samples that the
+    emitter of an (input) IOType may send ahead of our
+    acknowledgements (see Set_IOType_window()) */
+int Register_IOType_window_param(int index);
+
+/** @internal
+    @param num Number of entries in the table of IOTypes to update
+
+    Point the parameters registered for each IOType at the right
+    place after the table of IOTypes has moved */
+void Update_IOType_param_ptrs(int num);
 
 /** @internal
     @param index Index of IOType
@@ -399,13 +714,46 @@ int Realloc_chktype_buffer(int index,
     @param iodef Pointer to an IOdef_entry
     @param num_bytes No. of bytes to specify in realloc
 
-    Attempt to realloc the buffer associated with the IOdef_entry to
-    @p num_bytes.  If this fails, the buffer is free'd and iodef's @p
-    buffer_max_bytes is zeroed, otherwise @p buffer_max_bytes is set
-    to @p num_bytes. */
+    Make sure that the buffer associated with the IOdef_entry holds
+    at least @p num_bytes.  A bigger buffer is taken from the pool
+    (see ReG_Steer_Buffers.h), the @p buffer_bytes already in the old
+    one are copied over and the old one is given back.  On success
+    @p buffer_max_bytes is set to the size of the buffer, which may be
+    more than @p num_bytes.  If this fails, or would take the
+    IOdef_entry over its @p buffer_limit, the old buffer is left as it
+    was. */
 int Realloc_IOdef_entry_buffer(IOdef_entry *iodef,
 			       int num_bytes);
 
+/** @internal
+    @param iodef Pointer to an IOdef_entry
+    @param old_bytes Size of the buffer that is to be replaced
+    @param new_bytes Size of the buffer that is to replace it
+    @param func Name of the calling function, for the error message
+    @return REG_SUCCESS, or REG_FAILURE if the swap would take the
+    IOdef_entry over its @p buffer_limit */
+int Check_buffer_limit(IOdef_entry *iodef,
+		       size_t       old_bytes,
+		       size_t       new_bytes,
+		       const char  *func);
+
+/** @internal
+    @param iodef Pointer to an IOdef_entry
+    @param old_bytes Size of the buffer that was replaced
+    @param new_bytes Size of the buffer that replaced it
+
+    Keep count of the bytes of buffers held by the IOdef_entry and the
+    most that it has held */
+void Account_buffer(IOdef_entry *iodef,
+		    size_t       old_bytes,
+		    size_t       new_bytes);
+
+/** @internal
+    @param iodef Pointer to an IOdef_entry
+
+    Give the buffers of the IOdef_entry back to the pool */
+void Release_IOdef_entry_buffers(IOdef_entry *iodef);
+
 /** @internal
     @param ParamLabel Label identifying parameter to edit
     @param toggle REG_TRUE to enable logging, REG_FALSE to disable it.
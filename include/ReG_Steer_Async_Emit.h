@@ -0,0 +1,161 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+
+#ifndef __REG_STEER_ASYNC_EMIT_H__
+#define __REG_STEER_ASYNC_EMIT_H__
+
+/** @file ReG_Steer_Async_Emit.h
+ *  @brief Asynchronous (background) emission of samples.
+ *
+ *  An IOType in asynchronous mode has two library-owned snapshot
+ *  buffers.  Emit_start() claims a free one, Emit_data_slice() copies
+ *  the caller's data into it and Emit_stop() queues it.  A single
+ *  I/O thread, shared by all asynchronous IOTypes, then waits for the
+ *  consumer's acknowledgement of the previous sample and sends the
+ *  snapshot through the samples transport.
+ *
+ *  @author Robert Haines
+ */
+
+#include "ReG_Steer_types.h"
+
+/** @internal
+    @param index Index of the IOType
+    @param policy What to do when both snapshot buffers are busy -
+    REG_ASYNC_BLOCK, REG_ASYNC_DROP or REG_ASYNC_OVERWRITE
+    @return REG_SUCCESS, REG_FAILURE
+
+    Switch an IOType to asynchronous emission, starting the I/O thread
+    if it is not already running.  May be called again to change the
+    policy. */
+int Async_emit_enable(const int index, const int policy);
+
+/** @internal
+    @param index Index of the IOType
+    @return REG_SUCCESS, REG_FAILURE
+
+    Switch an IOType back to synchronous emission.  Waits (for up to
+    REG_ASYNC_DRAIN_TIMEOUT seconds) for queued snapshots to be sent
+    and discards any that are left. */
+int Async_emit_disable(const int index);
+
+/** @internal
+    @param index Index of the IOType
+    @param seqnum Sequence number of the sample
+    @return REG_SUCCESS, or REG_NOT_READY if no snapshot buffer is
+    free and either the policy is REG_ASYNC_DROP or there is no
+    consumer to send the queued snapshots to
+
+    Claim a snapshot buffer for a new sample. */
+int Async_emit_start(const int index, const int seqnum);
+
+/** @internal
+    @param index Index of the IOType
+    @param timeout_ms Longest time to wait (milliseconds)
+    @return REG_SUCCESS once a snapshot buffer is free, REG_TIMED_OUT
+    if none is, REG_FAILURE if we can't wait
+
+    Sleep until the I/O thread frees a snapshot buffer. */
+int Async_emit_wait(const int index, const int timeout_ms);
+
+/** @internal
+    @param index Index of the IOType
+    @param type Type of the data
+    @param count No. of elements of @p type in the slice
+    @param pData Pointer to the data
+    @param is_fortran Whether the data is from a FORTRAN array
+    @return REG_SUCCESS, REG_FAILURE
+
+    Copy a slice into the snapshot claimed by Async_emit_start(). */
+int Async_emit_slice(const int   index,
+		     const int   type,
+		     const int   count,
+		     const void *pData,
+		     const int   is_fortran);
+
+/** @internal
+    @param index Index of the IOType
+    @return REG_SUCCESS, REG_FAILURE
+
+    Hand the current snapshot to the I/O thread to send. */
+int Async_emit_stop(const int index);
+
+/** @internal
+    @param cpu No. of the CPU to run the I/O thread on, or -1 to leave
+    it to the operating system
+    @return REG_SUCCESS, REG_FAILURE
+
+    Pin the I/O thread to a CPU, now if it is running or else when it
+    is started. */
+int Async_emit_set_cpu(const int cpu);
+
+/** @internal
+    @param index Index of the IOType
+    @param num_dropped On return, the no. of times no snapshot buffer
+    was free plus the no. of snapshots that could not be sent
+    @param num_overwritten On return, the no. of queued samples that
+    were overwritten by newer ones
+    @return REG_SUCCESS, REG_FAILURE */
+int Async_emit_stats(const int index, int *num_dropped,
+		     int *num_overwritten);
+
+/** @internal
+    Take the lock that the I/O thread holds while it uses the samples
+    transport.  Must be held by any other thread that changes the
+    state of an IOType's transport or grows the table of IOTypes. */
+void Async_emit_lock();
+
+/** @internal
+    Release the lock taken by Async_emit_lock(). */
+void Async_emit_unlock();
+
+/** @internal
+    Drain and disable all asynchronous IOTypes and stop the I/O
+    thread. */
+void Async_emit_finalize();
+
+#endif /* __REG_STEER_ASYNC_EMIT_H__ */
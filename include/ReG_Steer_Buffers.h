@@ -0,0 +1,92 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+
+#ifndef __REG_STEER_BUFFERS_H__
+#define __REG_STEER_BUFFERS_H__
+
+/** @file ReG_Steer_Buffers.h
+ *  @brief Pool of the buffers that IOTypes keep their data in.
+ *
+ *  Buffers come in size classes and are page-aligned.  A buffer that
+ *  is given back is kept for the next request of the same class so
+ *  that samples of a similar size do not go back to the heap each
+ *  time.
+ *
+ *  @author Robert Haines
+ */
+
+#include "ReG_Steer_types.h"
+
+/** @internal
+    @param num_bytes Minimum no. of bytes needed
+    @return The no. of bytes in the size class that a buffer of
+    @p num_bytes would be taken from, or zero if there is none */
+size_t Buffer_class_bytes(const size_t num_bytes);
+
+/** @internal
+    @param num_bytes Minimum no. of bytes needed
+    @param class_bytes On successful return, the size of the buffer,
+    as given by Buffer_class_bytes()
+    @return Pointer to the buffer, or NULL if it could not be allocated
+
+    Take a page-aligned buffer from the pool, allocating a new one if
+    there is none of the right size class to reuse. */
+void *Buffer_get(const size_t num_bytes, size_t *class_bytes);
+
+/** @internal
+    @param buf Buffer from Buffer_get(), or NULL
+    @param class_bytes Size of @p buf, as returned by Buffer_get()
+
+    Give a buffer back to the pool.  It is kept for reuse if there is
+    room for it, otherwise it is freed. */
+void Buffer_put(void *buf, const size_t class_bytes);
+
+/** @internal
+    Free all of the buffers held by the pool. */
+void Buffer_pool_finalize();
+
+#endif /* __REG_STEER_BUFFERS_H__ */
@@ -62,6 +62,8 @@
 
 #include "ReG_Steer_types.h"
 
+#include <stdint.h>
+
 #ifdef __cplusplus
   #define PREFIX "C"
 #else
@@ -238,6 +240,39 @@ typedef struct {
 
 } param_entry;
 
+/** @internal
+    A slice from the previous sample, kept by both ends of an IOType
+    that sends deltas */
+typedef struct {
+  /** The type of the slice as sent (e.g. REG_XDR_FLOAT) */
+  int     type;
+  /** No. of bytes in the slice (before any compression) */
+  size_t  nbytes;
+  /** Size of @p data */
+  size_t  max_bytes;
+  /** Copy of the slice */
+  void   *data;
+  /** The no. of the sample it came from (consumer only) - deltas
+      only apply to the sample straight after */
+  int     sample;
+
+} Delta_ref_type;
+
+/** @internal
+    Traffic sent to one of the consumers of an output IOType */
+typedef struct {
+  /** When (in seconds) the consumer connected */
+  double  connect_time;
+  /** No. of bytes sent to it */
+  double  num_bytes;
+  /** No. of samples sent to it */
+  int     num_samples;
+  /** No. of samples it missed because it was still busy with an
+      earlier one */
+  int     num_skipped;
+
+} Consumer_stats_type;
+
 /** @internal
     Holds information on all registered parameters */
 typedef struct {
@@ -293,6 +328,67 @@ typedef struct {
 
 } Array_type;
 
+/** @internal
+    Type definition for variable describing the part of an array that
+    a consumer wants to be sent - every so many elements of a box
+    within the whole array */
+typedef struct {
+
+  /** Origin of the box within the whole array */
+  int sx, sy, sz;
+  /** Extent of the box (zero for as far as the array goes) */
+  int nx, ny, nz;
+  /** Take every this many elements along each axis */
+  int dx, dy, dz;
+
+} Region_type;
+
+/** @internal
+    Which elements of a block of an array (see Make_chunk_header()) a
+    slice holds when the block is sent a level of detail at a time.
+    Each level is sent as one or more parts, each a region of the
+    block */
+typedef struct {
+
+  /** Level of detail of the part, zero being full resolution, and
+      the no. of levels that the block is sent at */
+  int level, num_levels;
+  /** Position of the part among those of its level and their no. */
+  int part, num_parts;
+  /** The elements of the block in the part, with the origin of the
+      region relative to the origin of the block */
+  Region_type region;
+
+} Chunk_level_type;
+
+/** @internal
+    Where a slice lies in a data file and what it holds - one entry
+    in the index at the end of the file (files transport) */
+typedef struct {
+
+  /** Offsets (bytes from the start of the file) of the slice header
+      and of the data that follows it */
+  uint64_t header_offset;
+  uint64_t data_offset;
+  /** Type of data as sent (e.g. REG_XDR_DOUBLE) and no. of objects */
+  int      type;
+  int      count;
+  /** No. of bytes of data as stored and once decompressed */
+  int      num_bytes;
+  int      raw_bytes;
+  /** Codec the data is compressed with and its REG_SLICE_FLAG_*
+      flags */
+  int      codec;
+  int      flags;
+  /** Whether the slice holds an array in Fortran order */
+  int      is_fortran;
+  /** Whether (REG_TRUE) or not @p array describes the slice - taken
+      from a chunk header (Make_chunk_header()) emitted just before it */
+  int      has_array;
+  Array_type array;
+
+} Slice_index_entry;
+
 /** @internal
     Description of a single IOType */
 typedef struct {
@@ -336,10 +432,197 @@ typedef struct {
      attempting to emit the next data set. Setting @p use_ack to REG_FALSE
      OVERRIDES this flag. */
   int                           ack_needed;
+  /** Most samples that may be sent ahead of the consumer's
+      acknowledgements: on a REG_IO_IN IOType what we grant
+      (steerable, see Set_IOType_window()), on a REG_IO_OUT IOType
+      what the current consumer granted */
+  int                           window;
+  /** No. of samples emitted that the consumer has not yet
+      acknowledged (REG_IO_OUT only) */
+  int                           samples_in_flight;
+  /** Whether (REG_TRUE) or not the transport can send the current
+      consumer several samples ahead of its acknowledgements, and so
+      tells it with REG_SLICE_FLAG_CREDITS (REG_IO_OUT only, set by
+      the transport) */
+  int                           credit_capable;
+  /** Whether (REG_TRUE) or not the emitter of the slice last consumed
+      takes credit for more than one sample (REG_IO_IN only) */
+  int                           peer_credits;
+  /** No. of samples consumed since our last acknowledgement
+      (REG_IO_IN only) */
+  int                           acks_owed;
+  /** Handle of the window parameter in the parameter table */
+  int                           window_param_handle;
   /** Whether (REG_TRUE) or not (REG_FALSE) we are in the process of
       consuming data.  For use with ioProxy in event of unexpected
       shut down */
   int                           consuming;
+  /** The version of slice header to send on this IOType (REG_IO_OUT
+      only).  Negotiated from the acknowledgements sent by the consumer
+      and reset to REG_SLICE_HDR_TEXT whenever we have not heard from
+      the current consumer */
+  int                           slice_hdr_version;
+  /** Whether (REG_TRUE) or not the consumer stores numeric data
+      exactly as we do so that XDR encoding can be skipped (REG_IO_OUT
+      only).  Negotiated along with @p slice_hdr_version */
+  int                           use_native;
+  /** Codec to compress slices with (REG_IO_OUT only).  Steerable;
+      only used if the consumer's slice header version is at least
+      REG_SLICE_HDR_COMPRESS_VERSION */
+  int                           compression;
+  /** Buffer to hold compressed data */
+  void                         *comp_buffer;
+  /** Size of @p comp_buffer */
+  size_t                        comp_buffer_max_bytes;
+  /** Buffer that slices are decoded into for Consume_data_slice_ptr()
+      when they can't be handed over where they lie, or (REG_IO_OUT)
+      that arrays are cut down to the consumer's region in */
+  void                         *slice_buffer;
+  /** Size of @p slice_buffer */
+  size_t                        slice_buffer_max_bytes;
+  /** No. of bytes of buffers (@p buffer, @p comp_buffer and
+      @p slice_buffer) held from the pool now and at the most so far */
+  size_t                        buffer_held_bytes;
+  size_t                        buffer_high_water;
+  /** Most bytes of buffers that may be held, zero for no limit */
+  size_t                        buffer_limit;
+  /** The codec that the slice being consumed is compressed with,
+      its size as sent and its size once decompressed (REG_IO_IN
+      only, set per slice) */
+  int                           slice_codec;
+  int                           slice_bytes;
+  int                           slice_raw_bytes;
+  /** Bytes of data before and after compression so far in the
+      current sample */
+  double                        comp_raw_bytes;
+  double                        comp_bytes;
+  /** Compression ratio of the current (or last) sample and the time
+      (seconds) spent compressing or decompressing it.  Monitored
+      parameters */
+  float                         comp_ratio;
+  float                         comp_time;
+  /** Handles of the compression parameters in the parameter table */
+  int                           comp_param_handle;
+  int                           comp_ratio_param_handle;
+  int                           comp_time_param_handle;
+  /** Lossy encoding of float and double slices (REG_IO_OUT only) and
+      the error that it must stay within */
+  int                           lossy_mode;
+  int                           lossy_bound_type;
+  double                        lossy_bound;
+  /** The lossy type (e.g. REG_Q16_FLOAT) that the slice being
+      consumed was sent as, or zero if it was sent exactly (REG_IO_IN
+      only, set per slice) */
+  int                           slice_lossy_type;
+  /** Bytes saved by, and the largest error introduced by, the lossy
+      encoding in the current (or last) sample.  Monitored
+      parameters */
+  double                        lossy_bytes_saved;
+  double                        lossy_max_error;
+  /** Handles of the lossy encoding parameters in the parameter
+      table */
+  int                           lossy_saved_param_handle;
+  int                           lossy_err_param_handle;
+  /** Send a key frame every this many samples and XOR deltas against
+      the previous sample in between (0 to always send whole
+      samples) */
+  int                           delta_interval;
+  /** No. of samples emitted since the last key frame */
+  int                           delta_count;
+  /** Whether (REG_TRUE) or not the slices kept for deltas can no
+      longer be trusted, e.g. because the peer has changed */
+  int                           delta_key_needed;
+  /** Whether (REG_TRUE) or not the sample being emitted is a key
+      frame */
+  int                           delta_is_key;
+  /** Index of the next slice within the current sample */
+  int                           delta_slice;
+  /** No. of samples consumed (REG_IO_IN only) */
+  int                           delta_sample;
+  /** The slices of the previous sample, indexed by position in it */
+  Delta_ref_type               *delta_refs;
+  int                           num_delta_refs;
+  /** Flags (REG_SLICE_FLAG_*) and type as sent of the slice being
+      consumed (REG_IO_IN only, set per slice) */
+  int                           slice_flags;
+  int                           slice_wire_type;
+  /** The part of each array to be sent: on a REG_IO_IN IOType what
+      we ask for (Set_IOType_region()), on a REG_IO_OUT IOType what
+      the current consumer asked for.  Only used if @p use_region is
+      REG_TRUE */
+  Region_type                   region;
+  int                           use_region;
+  /** Whether (REG_TRUE) or not the emitter of the slice last consumed
+      can cut arrays down to a region (REG_IO_IN only) */
+  int                           peer_regions;
+  /** What to do with the next numeric slice emitted (REG_REGION_*),
+      according to the chunk header emitted before it, which is kept
+      in @p region_chunk (REG_IO_OUT only) */
+  int                           region_next;
+  Array_type                    region_chunk;
+  /** No. of levels of detail to send arrays at, one meaning just
+      full resolution (REG_IO_OUT only, see Set_IOType_levels()) */
+  int                           num_levels;
+  /** Buffer that each part of a block being sent a level of detail
+      at a time is gathered into (REG_IO_OUT) or read into (REG_IO_IN)
+      and its size.  Kept from one sample to the next */
+  void                         *level_buffer;
+  size_t                        level_buffer_max_bytes;
+  /** Whether (REG_TRUE) or not the last slice emitted was a chunk
+      header, held back in @p level_header until we know whether an
+      array follows it (REG_IO_OUT only) */
+  int                           level_pending;
+  Array_type                    level_header;
+  /** The finest level of detail at which the block being consumed
+      has arrived in full (-1 if none yet) and the no. of levels it is
+      being sent at (zero if it is not being sent in levels).  The
+      block and the part of it that the next numeric slice holds, if
+      any, according to the chunk header consumed before it, and the
+      no. of elements in that part (REG_IO_IN only) */
+  int                           level_done;
+  int                           level_count;
+  Array_type                    level_block;
+  Chunk_level_type              level_part;
+  int                           level_part_count;
+  /** No. of numeric slices emitted or consumed in native format */
+  int                           num_native_slices;
+  /** No. of numeric slices emitted or consumed as XDR */
+  int                           num_xdr_slices;
+  /** No. of samples successfully emitted */
+  int                           num_samples_emitted;
+  /** No. of system calls made by the transport in emitting those
+      samples (sockets-based transports only) */
+  int                           num_emit_syscalls;
+  /** How the background writer of data files is keeping up (files
+      transport only, as of the last Emit_stop()): bytes waiting to be
+      written, the most there have been, no. of writes made, their
+      total and longest duration (seconds) and no. of times the
+      emitter had to wait for room in the writer's queue */
+  double                        write_queue_bytes;
+  double                        write_queue_high;
+  int                           num_writes;
+  double                        write_seconds;
+  double                        max_write_seconds;
+  int                           num_write_stalls;
+  /** Max. no. of consumers that may be sent samples at once (sockets
+      transport only) */
+  int                           max_consumers;
+  /** Traffic sent to each of the consumers currently connected, in
+      the order that they connected */
+  Consumer_stats_type          *consumers;
+  int                           num_consumers;
+  /** No. of parallel streams to send large slices over, one meaning
+      just the main connection (sockets transport only) */
+  int                           num_streams;
+  /** Whether (REG_TRUE) or not large slices of the sample being
+      emitted go over parallel streams - set by the transport */
+  int                           stripe_slices;
+  /** Whether (REG_TRUE) or not the frames of samples emitted carry
+      checksums (sockets transport only) */
+  int                           frame_checksum;
+  /** Whether (REG_TRUE) or not (REG_FALSE) samples of this IOType are
+      snapshotted by Emit_data_slice() and sent by a background thread */
+  int                           is_async;
   /** For use with IOProxy - specifies label by which proxy knows the data
       that we want to read - for REG_IO_IN channels only */
   char                          proxySourceLabel[REG_MAX_STRING_LENGTH];
@@ -614,4 +897,197 @@ int Get_file_list(const char* dir, int num_tags, char** tags,
     to sort the filenames returned by Get_file_list */
 int cmpstrs(const void* str1, const void* str2);
 
+/** @internal
+    @param buf Buffer of at least REG_SLICE_HDR_SIZE bytes to fill
+    @param Version The header version to write (as negotiated with
+    the consumer)
+    @param DataType Type of data in the slice
+    @param Count No. of objects in the slice
+    @param NumBytes No. of bytes of data in the slice as sent
+    @param IsFortranArray Whether (REG_TRUE) or not the slice holds
+    an array in Fortran (column-major) order
+    @param Codec The codec the data is compressed with, e.g.
+    REG_COMPRESS_NONE
+    @param RawBytes No. of bytes of data before compression
+    @param Flags Whether the slice is a key frame or a delta
+    (REG_SLICE_FLAG_*) or zero
+
+    Packs a binary slice header into @p buf.  All fields are written
+    in network byte order. */
+void Pack_slice_header(char *buf, int Version, int DataType, int Count,
+		       int NumBytes, int IsFortranArray, int Codec,
+		       int RawBytes, int Flags);
+
+/** @internal
+    @param buf Buffer of REG_SLICE_HDR_SIZE bytes holding the header
+    @param DataType On successful return, the type of data in the slice
+    @param Count On successful return, the no. of objects in the slice
+    @param NumBytes On successful return, the no. of bytes in the slice
+    as sent
+    @param IsFortranArray On successful return, whether or not the
+    slice holds an array in Fortran order
+    @param Codec On successful return, the codec the data is
+    compressed with (REG_COMPRESS_NONE for older headers)
+    @param RawBytes On successful return, the no. of bytes of data
+    once decompressed
+    @param Flags On successful return, the REG_SLICE_FLAG_* flags of
+    the slice (zero for older headers)
+    @return REG_SUCCESS or REG_FAILURE if @p buf is not a binary slice
+    header of a version that we understand or uses a codec that we
+    do not have
+
+    Unpacks a binary slice header created by Pack_slice_header(). */
+int Unpack_slice_header(const char *buf, int *DataType, int *Count,
+			int *NumBytes, int *IsFortranArray, int *Codec,
+			int *RawBytes, int *Flags);
+
+/** @internal
+    @param buf The first bytes of a slice header
+    @return REG_TRUE if @p buf starts with REG_SLICE_HDR_MAGIC,
+    REG_FALSE otherwise */
+int Is_binary_slice_header(const char *buf);
+
+/** @internal
+    @param buf Buffer of at least REG_INDEX_ENTRY_SIZE bytes to fill
+    @param entry The index entry
+
+    Packs an entry of the index of a data file into @p buf in network
+    byte order. */
+void Pack_index_entry(char *buf, const Slice_index_entry *entry);
+
+/** @internal
+    @param buf Buffer of REG_INDEX_ENTRY_SIZE bytes holding the entry
+    @param entry On return, the index entry
+
+    Unpacks an entry created by Pack_index_entry(). */
+void Unpack_index_entry(const char *buf, Slice_index_entry *entry);
+
+/** @internal
+    @param buf Buffer of at least REG_PACKET_SIZE bytes to fill
+    @param num_entries No. of entries in the index
+    @param offset Offset (bytes) of the index from the start of the file
+
+    Packs the packet that ends a data file with an index.  As well as
+    locating the index it records how we store numeric data, which is
+    how any slice not sent as XDR is stored. */
+void Pack_index_trailer(char *buf, int num_entries, uint64_t offset);
+
+/** @internal
+    @param buf The last REG_PACKET_SIZE bytes of a data file
+    @param num_entries On successful return, no. of entries in the index
+    @param offset On successful return, offset (bytes) of the index
+    @param format If not NULL, on successful return holds how the
+    emitter stored numeric data, e.g. "L4844" (at least 16 chars)
+    @return REG_SUCCESS or REG_FAILURE if @p buf is not an index
+    trailer */
+int Unpack_index_trailer(const char *buf, int *num_entries,
+			 uint64_t *offset, char *format);
+
+/** @internal
+    @param buf Buffer of at least REG_CHUNK_HDR_SIZE bytes to fill
+    @param array The block of an array to describe
+    @param level If not NULL, the part of @p array that the slice
+    after the header holds, when it is sent a level of detail at a
+    time
+
+    Writes the chunk header (see Make_chunk_header()) that describes
+    @p array as a null-terminated string. */
+void Pack_chunk_header(char *buf, const Array_type *array,
+		       const Chunk_level_type *level);
+
+/** @internal
+    @param buf The data of a character slice
+    @param num_bytes Size of the data
+    @param array On successful return, the block of an array that
+    @p buf describes
+    @param level If not NULL, on successful return the part of
+    @p array that the slice after the header holds, when it is sent a
+    level of detail at a time, or @p level->num_levels is zero if it
+    is not
+    @return REG_SUCCESS or REG_FAILURE if @p buf is not a chunk
+    header */
+int Unpack_chunk_header(const char *buf, const size_t num_bytes,
+			Array_type *array, Chunk_level_type *level);
+
+/** @internal
+    @param type The type of data, e.g. REG_INT
+    @return The size (in bytes) of one native element of @p type or
+    zero if @p type is not recognised */
+int Sizeof_type(const int type);
+
+/** @internal
+    @param io Pointer to entry describing the (input) IOType, or NULL
+    @param ack_msg Buffer of at least REG_ACK_MAX_SIZE + 1 bytes
+    @return The length of the message
+
+    Fills @p ack_msg with the acknowledgement that a consumer sends
+    to an emitter.  After the REG_ACK_TAG the message advertises the
+    highest slice header version that we understand and how we store
+    numeric data (byte order and type sizes).  If @p io has a region
+    and its emitter can cut arrays down to it, the version tag ends
+    "+>" and the region follows in REG_ACK_REGION_SIZE more bytes.  If
+    its emitter takes credit for samples, the version tag ends "*>"
+    and the space for a region (which may be blank) is followed by
+    REG_ACK_CREDIT_SIZE bytes giving the no. of samples acknowledged
+    (@p acks_owed) and the window that we grant. */
+int Get_ack_msg(const IOdef_entry *io, char *ack_msg);
+
+/** @internal
+    @param io Pointer to entry describing the (output) IOType
+    @param ack_msg Null-terminated acknowledgement received from the
+    consumer or NULL if we have not heard from the current consumer
+
+    Sets the slice header version and whether or not XDR encoding
+    can be skipped when emitting data on @p io, based on what the
+    consumer advertised in @p ack_msg.  Acknowledgements from
+    consumers that advertise nothing (or a NULL @p ack_msg) result
+    in text slice headers and XDR-encoded data.  Also takes any region
+    that the consumer wants arrays cut down to and any credit that it
+    gives: the samples acknowledged come off @p samples_in_flight and
+    the window granted replaces @p window.  Without a credit the
+    acknowledgement is of every sample sent and the window is one.  A
+    NULL @p ack_msg also leaves no samples in flight. */
+void Set_peer_capabilities(IOdef_entry *io, const char *ack_msg);
+
+/** @internal
+    @param in Pointer to the slice data
+    @param out Pointer to room for @p nbytes bytes (may be @p in)
+    @param ref Pointer to the same slice from the previous sample
+    @param nbytes No. of bytes in the slice
+    @param encode REG_TRUE to turn data into a delta, REG_FALSE to
+    turn a delta back into data
+
+    XORs a slice with its predecessor in @p ref, which is then updated
+    to hold the data from this sample. */
+void Delta_xor(const void *in, void *out, void *ref, size_t nbytes,
+	       int encode);
+
+/** @internal
+    @param io The IOType
+    @param index Position of the slice within a sample
+    @return Pointer to the reference slice or NULL if memory could
+    not be allocated
+
+    Gets the reference slice kept for deltas at @p index, making room
+    for it if necessary.  New references hold no data. */
+Delta_ref_type *Get_delta_ref(IOdef_entry *io, int index);
+
+/** @internal
+    @param ref The reference slice
+    @param type The type of the slice as sent
+    @param data The slice
+    @param nbytes No. of bytes in the slice
+    @return REG_SUCCESS or REG_FAILURE if memory could not be
+    allocated
+
+    Keeps a copy of a (key frame) slice for later deltas. */
+int Set_delta_ref(Delta_ref_type *ref, int type, const void *data,
+		  size_t nbytes);
+
+/** @internal
+    @param io The IOType
+
+    Frees all of the reference slices kept for deltas. */
+void Free_delta_refs(IOdef_entry *io);
+
 #endif
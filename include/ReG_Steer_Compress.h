@@ -0,0 +1,102 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+
+#ifndef __REG_STEER_COMPRESS_H__
+#define __REG_STEER_COMPRESS_H__
+
+/** @file ReG_Steer_Compress.h
+ *  @brief Lossless compression of sample data.
+ *
+ *  Wraps the codecs that may be used to compress the payload of a
+ *  data slice (see Set_IOType_compression()).
+ *
+ *  @author Robert Haines
+ */
+
+#include "ReG_Steer_types.h"
+
+/** @internal
+    @param codec The codec, e.g. REG_COMPRESS_ZLIB
+    @return REG_TRUE if @p codec is known and was built in, REG_FALSE
+    otherwise. REG_COMPRESS_NONE is always supported */
+int Compress_codec_supported(const int codec);
+
+/** @internal
+    @param codec The codec, e.g. REG_COMPRESS_ZLIB
+    @param nbytes No. of bytes to be compressed
+    @return The largest no. of bytes that compressing @p nbytes bytes
+    with @p codec can produce */
+size_t Compress_bound(const int codec, const size_t nbytes);
+
+/** @internal
+    @param codec The codec to use, e.g. REG_COMPRESS_ZLIB
+    @param in Pointer to the data to compress
+    @param nbytes No. of bytes to compress
+    @param out Pointer to a buffer of at least
+    Compress_bound(@p codec, @p nbytes) bytes
+    @param out_bytes On successful return, the no. of bytes written
+    @return REG_SUCCESS, or REG_FAILURE if @p codec is not supported
+    or the codec failed
+
+    Compresses a block of data. */
+int Compress_data(const int codec, const void *in, const size_t nbytes,
+		  void *out, size_t *out_bytes);
+
+/** @internal
+    @param codec The codec that the data was compressed with
+    @param in Pointer to the compressed data
+    @param nbytes No. of bytes of compressed data
+    @param out Pointer to a buffer of @p raw_bytes bytes
+    @param raw_bytes No. of bytes that the data decompresses to
+    @return REG_SUCCESS, or REG_FAILURE if @p codec is not supported
+    or the data did not decompress to exactly @p raw_bytes bytes
+
+    Decompresses a block of data compressed by Compress_data(). */
+int Decompress_data(const int codec, const void *in, const size_t nbytes,
+		    void *out, const size_t raw_bytes);
+
+#endif /* __REG_STEER_COMPRESS_H__ */
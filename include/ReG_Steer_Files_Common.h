@@ -55,6 +55,7 @@
  */
 
 #include "ReG_Steer_types.h"
+#include "ReG_Steer_Common.h"
 
 typedef struct {
   /** Base filename - for file-based IO */
@@ -63,6 +64,54 @@ typedef struct {
   char  directory[REG_MAX_STRING_LENGTH];
   /** Pointer to open file - for file-based IO */
   FILE* fp;
+  /** Descriptor that tells us when @p directory changes, -1 if we
+      haven't started watching it yet, -2 if we can't */
+  int   watch_fd;
+  /** The file open on @p fp mapped into memory, or NULL if it is
+      being read and written through @p fp */
+  char*  map;
+  /** Size of @p map */
+  size_t map_bytes;
+  /** Offset in @p map of the next byte to write or read */
+  size_t map_pos;
+  /** Index of the slices in the data file being emitted or consumed,
+      its no. of entries and the room there is for them */
+  Slice_index_entry* index;
+  int    num_index;
+  int    max_index;
+  /** Whether (REG_TRUE) or not the index of the data file being
+      consumed has been read in */
+  int    index_loaded;
+  /** Whether (REG_TRUE) or not the next bytes emitted are the data of
+      the slice last added to @p index */
+  int    index_data_next;
+  /** The array described by the last chunk header emitted, which
+      goes in the index entry of the next slice */
+  Array_type chunk;
+  int    has_chunk;
+  /** Whether (REG_TRUE) or not the data file open on @p fp is being
+      written by the background writer, and the no. of bytes that
+      have been handed to it for that file so far */
+  int    async_write;
+  uint64_t write_pos;
+  /** Bytes gathered up to be handed to the writer in one go, the
+      no. of them and the size of @p stage */
+  char*  stage;
+  size_t stage_bytes;
+  size_t stage_max;
+  /** Whether (REG_TRUE) or not the writer has failed to write some of
+      the file it is working on for this IOType */
+  int    write_failed;
+  /** How the writer is getting on with this IOType (guarded by the
+      writer's lock): bytes waiting to be written, the most there have
+      been, no. of writes made, their total and longest duration
+      (seconds) and no. of times the emitter had to wait for room */
+  size_t queued_bytes;
+  size_t queue_high_water;
+  int    num_writes;
+  double write_seconds;
+  double max_write_seconds;
+  int    num_stalls;
 } file_info_type;
 
 typedef struct {
@@ -74,16 +123,40 @@ typedef struct {
 #ifdef _MSC_VER
 #define REG_LOCK_FLAGS (_O_CREAT|_O_WRONLY|_O_TRUNC)
 #define REG_LOCK_PERMS (_S_IREAD|_S_IWRITE)
+#define REG_MANIFEST_FLAGS (_O_CREAT|_O_WRONLY|_O_APPEND)
 #else
 #define REG_LOCK_FLAGS (O_CREAT|O_WRONLY|O_TRUNC)
 #define REG_LOCK_PERMS (S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH)
+#define REG_MANIFEST_FLAGS (O_CREAT|O_WRONLY|O_APPEND)
 #endif
 
+/** Appended to the root of a sequence of filenames to give the
+    manifest that lists, one index per line, the files in the
+    sequence as they are made ready.  Consumers read on through it
+    rather than having to go looking for the next file. */
+#define REG_MANIFEST_SUFFIX ".manifest"
+
+/** Size beyond which a producer starts a fresh manifest */
+#define REG_MANIFEST_MAX_BYTES 65536
+
 /* Function Prototypes */
 
 int file_info_table_init(file_info_table_type* table,
 			 const int max_entries);
 
+/** @internal
+    @param base_name Root of the filename to search for, on success
+    the name of the file found
+    @return REG_SUCCESS if a file is ready, REG_FAILURE if not
+
+    Finds the next file that is ready in a numbered sequence
+    (<base_name>_<n>) with the specified root name.  This reads on
+    through the manifest of the sequence when there is one, so that
+    polling costs a single stat(); the directory is only listed when
+    there's no manifest (and then only if the directory has changed)
+    or when the manifest may not tell the whole story. */
+int find_next_file(char* base_name);
+
 /** @internal
     @param base_name Root of the filename to search for
 
@@ -95,7 +168,8 @@ FILE* open_next_file(char* base_name);
     @param filename Base name of lock file
 
     Creates a lock file with name consisting of ".lock"
-    appended to supplied name */
+    appended to supplied name, and adds the file to the manifest of
+    its sequence if the name ends in _<n> */
 int create_lock_file(char* filename);
 
 /** @internal
@@ -112,4 +186,22 @@ int delete_file(char* filename);
  */
 int remove_files(char* base_name);
 
+/** @internal
+    @param file_info File information holding the directory to watch
+    @param timeout_ms Longest time to wait (milliseconds)
+    @return REG_SUCCESS if a file has been written or moved into the
+    directory, REG_TIMED_OUT if not, REG_FAILURE if there is no way
+    to tell
+
+    Sleep until a file turns up in the directory or @p timeout_ms has
+    passed.  The first call only starts watching the directory and
+    returns straight away, as anything already there won't wake us. */
+int wait_for_directory(file_info_type* file_info, const int timeout_ms);
+
+/** @internal
+    @param file_info File information holding the directory
+
+    Stop watching a directory. */
+void stop_watching_directory(file_info_type* file_info);
+
 #endif /* __REG_STEER_FILES_COMMON_H__ */
@@ -0,0 +1,124 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+
+#ifndef __REG_STEER_LOSSY_H__
+#define __REG_STEER_LOSSY_H__
+
+/** @file ReG_Steer_Lossy.h
+ *  @brief Error-bounded lossy encoding of float and double data.
+ *
+ *  Used to cut the size of samples that are only going to be
+ *  visualised (see Set_IOType_lossy()).
+ *
+ *  @author Robert Haines
+ */
+
+#include "ReG_Steer_types.h"
+
+/** @internal
+    @param mode The lossy encoding, e.g. REG_LOSSY_QUANT16
+    @param type The type of the data, REG_FLOAT or REG_DBL
+    @param count No. of elements
+    @return The no. of bytes that Lossy_encode() writes for @p count
+    elements of @p type, or 0 if @p mode does not apply to @p type */
+size_t Lossy_encoded_size(const int mode, const int type,
+			  const size_t count);
+
+/** @internal
+    @param mode The lossy encoding, e.g. REG_LOSSY_QUANT16
+    @param type The type of the data, REG_FLOAT or REG_DBL
+    @return The type to put in the slice header for data of @p type
+    encoded with @p mode.  REG_LOSSY_TRUNCATE leaves the type as it
+    is */
+int Lossy_wire_type(const int mode, const int type);
+
+/** @internal
+    @param wire_type A type from a slice header
+    @return The type (REG_FLOAT or REG_DBL) that data sent as
+    @p wire_type decodes to, or -1 if @p wire_type is not one of the
+    lossy encodings */
+int Lossy_native_type(const int wire_type);
+
+/** @internal
+    @param mode The lossy encoding, e.g. REG_LOSSY_QUANT16
+    @param type The type of the data, REG_FLOAT or REG_DBL
+    @param bound_type How to interpret @p bound: REG_ERROR_ABS or
+    REG_ERROR_REL (relative to the largest magnitude in the data)
+    @param bound The largest error allowed in any element
+    @param count No. of elements to encode
+    @param in Pointer to the data to encode
+    @param out Pointer to a buffer of at least
+    Lossy_encoded_size(@p mode, @p type, @p count) bytes
+    @param out_bytes On successful return, the no. of bytes written
+    @param max_err On successful return, the largest absolute error
+    in any (finite) element once decoded
+    @return REG_SUCCESS, or REG_FAILURE if @p bound cannot be met by
+    @p mode for this data (in which case it should be sent exactly)
+
+    Encodes data within an error bound.  REG_LOSSY_TRUNCATE writes
+    values of @p type in native format with surplus mantissa bits
+    rounded away; the other modes write a portable format for
+    Lossy_decode(). */
+int Lossy_encode(const int mode, const int type, const int bound_type,
+		 const double bound, const size_t count, const void *in,
+		 void *out, size_t *out_bytes, double *max_err);
+
+/** @internal
+    @param wire_type The type from the slice header, e.g. REG_Q16_FLOAT
+    @param in Pointer to the encoded data
+    @param nbytes No. of bytes of encoded data
+    @param count No. of elements to decode
+    @param out Pointer to room for @p count elements of
+    Lossy_native_type(@p wire_type)
+    @return REG_SUCCESS, or REG_FAILURE if @p wire_type is not a lossy
+    encoding or @p nbytes is wrong for @p count elements
+
+    Reconstructs float or double data encoded by Lossy_encode(). */
+int Lossy_decode(const int wire_type, const void *in, const size_t nbytes,
+		 const size_t count, void *out);
+
+#endif /* __REG_STEER_LOSSY_H__ */
@@ -0,0 +1,144 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+
+#ifndef __REG_STEER_REGION_H__
+#define __REG_STEER_REGION_H__
+
+/** @file ReG_Steer_Region.h
+ *  @brief Cutting arrays down to the region that a consumer wants.
+ *
+ *  A consumer may ask for every so many elements of a box within the
+ *  whole array (see Set_IOType_region()).  The emitter uses the chunk
+ *  header (Make_chunk_header()) that goes before each block of the
+ *  array to work out which of the block's elements are wanted and
+ *  sends only those, with a chunk header that places them in the
+ *  smaller array that the consumer sees.
+ *
+ *  An emitter may also send each block at several levels of detail,
+ *  coarsest first (see Set_IOType_levels()).  Each level is made up
+ *  of one or more lattices of elements, which are extracted in the
+ *  same way and put back in place by the consumer.
+ *
+ *  @author Robert Haines
+ */
+
+#include "ReG_Steer_types.h"
+#include "ReG_Steer_Common.h"
+
+/** The next numeric slice is sent as it is */
+#define REG_REGION_NONE 0
+/** The next numeric slice is cut down to the region */
+#define REG_REGION_CUT  1
+/** None of the next numeric slice is wanted so it is not sent */
+#define REG_REGION_SKIP 2
+
+/** @internal
+    @param region The part of the whole array that is wanted
+    @param chunk The block of the whole array held by a slice
+    @param cut On successful return, the wanted elements of
+    @p chunk, described as a block of the (smaller) array made up of
+    just the wanted elements of the whole array
+    @param first On successful return, the position within @p chunk
+    of the first wanted element along each axis (x, y, z)
+    @return REG_SUCCESS, or REG_FAILURE if none of @p chunk is
+    wanted */
+int Region_clip(const Region_type *region, const Array_type *chunk,
+		Array_type *cut, int *first);
+
+/** @internal
+    @param chunk The block held by @p in, which is in F90 ordering if
+    @p chunk->is_f90 is set or C ordering otherwise
+    @param first The position within @p chunk of the first element to
+    take along each axis, as from Region_clip()
+    @param cut The elements to take, as from Region_clip()
+    @param region The region, which gives the stride along each axis
+    @param elem_size Size (in bytes) of one element
+    @param in Pointer to the data of @p chunk
+    @param out Pointer to room for the cut->nx*cut->ny*cut->nz
+    elements taken, which are stored contiguously in the same
+    ordering as @p in
+
+    Copies the wanted elements of a block.  Both arrays are walked in
+    the order they are stored so that runs along the fastest-varying
+    axis are copied whole when every element along it is wanted. */
+void Region_extract(const Array_type *chunk, const int *first,
+		    const Array_type *cut, const Region_type *region,
+		    const size_t elem_size, const void *in, void *out);
+
+/** @internal
+    @param chunk The block that @p out holds, which is in F90 ordering
+    if @p chunk->is_f90 is set or C ordering otherwise
+    @param first As for Region_extract()
+    @param cut As for Region_extract()
+    @param region As for Region_extract()
+    @param elem_size Size (in bytes) of one element
+    @param in Pointer to the cut->nx*cut->ny*cut->nz elements, as
+    stored by Region_extract()
+    @param out Pointer to the data of @p chunk
+
+    Puts elements taken by Region_extract() back where they came
+    from.  The rest of @p out is left as it is. */
+void Region_insert(const Array_type *chunk, const int *first,
+		   const Array_type *cut, const Region_type *region,
+		   const size_t elem_size, const void *in, void *out);
+
+/** @internal
+    @param chunk The block that @p data holds, which is in F90
+    ordering if @p chunk->is_f90 is set or C ordering otherwise
+    @param spacing Spacing of the elements that are in place along
+    each axis, counted from the origin of the block
+    @param elem_size Size (in bytes) of one element
+    @param data Pointer to the data of @p chunk
+
+    Sets every element of a block that is not on the lattice of
+    elements every @p spacing along each axis to the nearest element
+    before it that is, so that a block received a level of detail at
+    a time is a whole picture at that level. */
+void Region_fill(const Array_type *chunk, const int spacing,
+		 const size_t elem_size, void *data);
+
+#endif /* __REG_STEER_REGION_H__ */
@@ -0,0 +1,109 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+
+#ifndef __REG_STEER_REORDER_H__
+#define __REG_STEER_REORDER_H__
+
+/** @file ReG_Steer_Reorder.h
+ *  @brief Conversion of N-dimensional arrays between C and F90 ordering.
+ *
+ *  A cache-blocked transposition engine used by Reorder_array() and
+ *  by the consumer when it has been asked to convert the ordering of
+ *  the arrays it receives.  Large arrays are split across threads;
+ *  the no. of threads defaults to the no. of online processors and
+ *  may be set with the REG_REORDER_THREADS environment variable.
+ *
+ *  @author Robert Haines
+ */
+
+#include "ReG_Steer_types.h"
+
+/** @internal
+    @param ndims No. of dimensions (1 to REG_REORDER_MAX_DIMS)
+    @param tot_extent Extent of the whole (output) array in each dimension
+    @param sub_extent Extent of the block held in @p in in each dimension
+    @param origin Position of the block within the whole array
+    @param elem_size Size (in bytes) of one element
+    @param in Pointer to the block, contiguous and in C ordering if
+    @p to_f90 is REG_TRUE or F90 ordering otherwise
+    @param out Pointer to the whole array, which is in the other ordering
+    @param to_f90 Whether to convert from C to F90 ordering (REG_TRUE) or
+    from F90 to C ordering
+    @return REG_SUCCESS, or REG_FAILURE if the dimensions or extents
+    are invalid
+
+    Copies the block in @p in into its place in @p out, converting its
+    ordering on the way.  Dimensions are always given in F90 index
+    order, i.e. @p tot_extent[0] is the extent of the index that varies
+    most rapidly in an F90 array. */
+int Reorder_nd(const int ndims, const int *tot_extent,
+	       const int *sub_extent, const int *origin,
+	       const size_t elem_size, const void *in, void *out,
+	       const int to_f90);
+
+/** @internal
+    @param ndims No. of dimensions (1 to REG_REORDER_MAX_DIMS)
+    @param tot_extent Extent of the whole (output) array in each dimension
+    @param sub_extent Extent of the block held in @p in in each dimension
+    @param origin Position of the block within the whole array
+    @param type The (native) type of the data: REG_INT, REG_LONG,
+    REG_FLOAT or REG_DBL
+    @param in Pointer to the XDR-encoded block, ordered as for Reorder_nd()
+    @param out Pointer to the whole (native) array
+    @param to_f90 Whether to convert from C to F90 ordering (REG_TRUE) or
+    from F90 to C ordering
+    @return REG_SUCCESS, or REG_FAILURE if @p type cannot be decoded or
+    the dimensions or extents are invalid
+
+    As Reorder_nd() but also decodes the XDR data.  Each element is
+    read once and stored, decoded, straight into its place in @p out. */
+int Reorder_decode_nd(const int ndims, const int *tot_extent,
+		      const int *sub_extent, const int *origin,
+		      const int type, const void *in, void *out,
+		      const int to_f90);
+
+#endif /* __REG_STEER_REORDER_H__ */
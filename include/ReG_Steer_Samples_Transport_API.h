@@ -134,6 +134,20 @@ int Emit_header_impl(const int index);
 int Emit_data_impl(const int index, const size_t num_bytes_to_send,
 		   void* pData);
 
+/** @internal
+    @param index Index of IOType to use to send data
+    @param num_bufs No. of buffers to send
+    @param bufs Array of pointers to the buffers to send
+    @param num_bytes Array of the no. of bytes in each buffer
+
+    Sends several buffers, one after the other, in as few operations
+    as the transport allows.  Used to emit a batch of slices in one
+    go: each slice header is followed by the data of the slice. */
+int Emit_data_batch_impl(const int     index,
+			 const int     num_bufs,
+			 void**        bufs,
+			 const size_t* num_bytes);
+
 /** @internal
     @param index Index of IOType from which to get header data
     @param datatype On successful return, the type of the data in
@@ -201,6 +215,48 @@ int Emit_stop_impl(int index);
 
 int Consume_stop_impl(int index);
 
+/** @internal
+    @param index Index of the IOType to wait on
+    @param timeout_ms Longest time to wait (milliseconds)
+    @return REG_SUCCESS if something has happened that might let
+    Emit_start() or Consume_start() succeed, REG_TIMED_OUT if nothing
+    has, REG_FAILURE if there is nothing that we can wait on
+
+    Sleep until the transport has something for an IOType - a new
+    connection, an acknowledgement, the start of a sample - or until
+    @p timeout_ms has passed, whichever is sooner. Used by the
+    blocking versions of Emit_start() and Consume_start(), which fall
+    back to polling if this returns REG_FAILURE. */
+int Wait_for_IOType_impl(const int index, const int timeout_ms);
+
+/** @internal
+    @param index Index of the IOType to get data from
+    @param num_bytes No. of bytes of data in the slice
+    @param pData On successful return, points to the data
+    @return REG_SUCCESS, or REG_FAILURE if the transport can't hand
+    over the data where it lies, in which case nothing has been read
+    unless the sample turned out to be short
+
+    Consume the data of a slice without copying it.  @p pData stays
+    valid until Consume_stop_impl() is called. */
+int Consume_data_map_impl(const int index,
+			  const size_t num_bytes,
+			  void** pData);
+
+/** @internal
+    @param index Index of the IOType to get data from
+    @param slice The slice (numbered from zero) to move to, or -1 to
+    just count the slices
+    @param num_slices On successful return, the no. of slices in the
+    sample being consumed
+    @return REG_SUCCESS, or REG_FAILURE if the transport keeps no index
+    of the slices in the sample or @p slice is out of range
+
+    Move to the header of a slice in the sample being consumed. */
+int Consume_seek_slice_impl(const int index,
+			    const int slice,
+			    int* num_slices);
+
 #else /* DOXYGEN */
 
 REG_DECLARE_FUNC(int, Initialize_samples_transport, ());
@@ -213,6 +269,7 @@ REG_DECLARE_FUNC(int, Get_communication_status, (const int));
 REG_DECLARE_FUNC(int, Emit_data_non_blocking, (const int, const int, void*));
 REG_DECLARE_FUNC(int, Emit_header, (const int));
 REG_DECLARE_FUNC(int, Emit_data, (const int, const size_t, void*));
+REG_DECLARE_FUNC(int, Emit_data_batch, (const int, const int, void**, const size_t*));
 REG_DECLARE_FUNC(int, Consume_msg_header, (int, int*, int*, int*, int*));
 REG_DECLARE_FUNC(int, Emit_msg_header, (const int, const size_t, void*));
 REG_DECLARE_FUNC(int, Consume_start_data_check, (const int));
@@ -223,6 +280,9 @@ REG_DECLARE_FUNC(int, Get_IOType_address, (int, char**, int*));
 REG_DECLARE_FUNC(int, Emit_start, (int, int));
 REG_DECLARE_FUNC(int, Emit_stop, (int));
 REG_DECLARE_FUNC(int, Consume_stop, (int));
+REG_DECLARE_FUNC(int, Wait_for_IOType, (const int, const int));
+REG_DECLARE_FUNC(int, Consume_data_map, (const int, const size_t, void**));
+REG_DECLARE_FUNC(int, Consume_seek_slice, (const int, const int, int*));
 
 #undef REG_MODULE
 
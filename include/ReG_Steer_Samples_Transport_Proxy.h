@@ -56,4 +56,20 @@
 
 int Consume_proxy_destination_ack(const int index);
 
+/** @internal
+    @param index Index of the IOType to send on
+    @param label Label by which the proxy knows the destination
+    @param num_bufs No. of buffers to send after anything that has
+    been gathered
+    @param bufs Array of pointers to the buffers
+    @param num_bytes Array of the sizes of the buffers in bytes
+    @return REG_SUCCESS, REG_FAILURE, REG_NOT_READY if the proxy has
+    no destination for the data
+
+    Wrap @p bufs, along with anything gathered, in a single message
+    to the proxy and send it with as few system calls as possible. */
+int send_proxy_message(const int index, const char* label,
+		       const int num_bufs, void** bufs,
+		       const size_t* num_bytes);
+
 #endif /* __REG_STEER_SAMPLES_TRANSPORT_PROXY_H__ */
@@ -0,0 +1,222 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+
+#ifndef __REG_STEER_SAMPLES_TRANSPORT_SHM_H__
+#define __REG_STEER_SAMPLES_TRANSPORT_SHM_H__
+
+/** @file ReG_Steer_Samples_Transport_Shm.h
+ *  @brief Data structures and routines for the shared-memory samples
+ *  transport.
+ *
+ *  Each IOType has its own POSIX shared memory segment, created by the
+ *  emitter, which holds a single-producer/single-consumer ring of
+ *  bytes. The byte stream carried by the ring is exactly what the
+ *  sockets transport would send.
+ *
+ *  @author Robert Haines
+ */
+
+#include "ReG_Steer_types.h"
+
+#include <stdint.h>
+#include <sys/types.h>
+
+/** Identifies a segment as one of ours ("ReGs") */
+#define REG_SHM_MAGIC 0x52654773
+
+/** Layout version of the segment header */
+#define REG_SHM_VERSION 3
+
+/** Default size of the ring (bytes) if REG_SHM_BUFSIZE is not set.
+    Rounded up to a power of two whatever its source */
+#define REG_SHM_DEFAULT_BUFSIZE 8388608
+
+/** Default prefix of segment names if REG_SHM_PREFIX is not set */
+#define REG_SHM_DEFAULT_PREFIX "ReG_Steer_"
+
+/** How long (ms) to sleep waiting for the peer before checking that
+    it is still there */
+#define REG_SHM_WAIT_MS 100
+
+/** Keeps the two ends of the ring on separate cache lines */
+#define REG_SHM_CACHE_LINE 64
+
+/** @internal
+    Header at the start of each shared memory segment. The counters run
+    freely and are masked to index the ring so that head - tail is
+    always the number of bytes waiting to be read. Each side only
+    writes its own cache line. */
+typedef struct {
+  /** REG_SHM_MAGIC once the segment has been set up */
+  volatile uint32_t magic;
+  /** REG_SHM_VERSION */
+  volatile uint32_t version;
+  /** Size of the ring in bytes (a power of two) */
+  volatile uint32_t size;
+  /** Process id of the emitter */
+  volatile uint32_t producer_pid;
+  /** Process id of the attached consumer (zero if none) */
+  volatile uint32_t consumer_pid;
+  /** Bumped each time a consumer attaches */
+  volatile uint32_t consumer_gen;
+  /** Set when the emitter is going away */
+  volatile uint32_t closed;
+  char pad0[REG_SHM_CACHE_LINE - 7*sizeof(uint32_t)];
+
+  /** Bytes written so far - only written by the emitter */
+  volatile uint32_t head;
+  /** Set while the emitter waits for space */
+  volatile uint32_t producer_waiting;
+  char pad1[REG_SHM_CACHE_LINE - 2*sizeof(uint32_t)];
+
+  /** Bytes read so far - only written by the consumer */
+  volatile uint32_t tail;
+  /** Set while the consumer waits for data */
+  volatile uint32_t consumer_waiting;
+  /** Bumped each time the consumer leaves an acknowledgement */
+  volatile uint32_t ack_seq;
+  /** Latest acknowledgement from the consumer */
+  char ack_msg[REG_ACK_MAX_SIZE + 1];
+  char pad2[4*REG_SHM_CACHE_LINE - 3*sizeof(uint32_t) -
+	    (REG_ACK_MAX_SIZE + 1)];
+} shm_ring_header_type;
+
+/** @internal
+    Structure to hold the shared memory information for an IOType */
+typedef struct {
+  /** Name of the shared memory segment */
+  char                  name[REG_MAX_STRING_LENGTH];
+  /** Mapped segment (NULL if not mapped) */
+  shm_ring_header_type* ring;
+  /** Start of the ring of data within the segment */
+  char*                 data;
+  /** Size of the mapping in bytes */
+  size_t                map_bytes;
+  /** Whether (REG_TRUE) or not we created the segment */
+  int                   owner;
+  /** Last consumer generation seen by the emitter */
+  uint32_t              consumer_gen;
+  /** Last acknowledgement sequence no. seen by the emitter */
+  uint32_t              ack_seq;
+  /** No. of system calls made while emitting since last counted */
+  int                   num_syscalls;
+} shm_info_type;
+
+typedef struct {
+  int max_entries;
+  int num_used;
+  shm_info_type* shm_info;
+} shm_info_table_type;
+
+/* Function Prototypes */
+
+/** @internal
+    @param table Pointer to the table of shared memory information to
+    be initialised
+    @param max_entries The maximum size of that table
+
+    Initialise shared memory info table. */
+int shm_info_table_init(shm_info_table_type* table,
+			const int max_entries);
+
+/** @internal
+    @param index Index of the IOType
+
+    Work out the name of the segment for an IOType from its label. */
+int shm_name_samples(const int index);
+
+/** @internal
+    @param index Index of the IOType
+
+    Create (replacing any stale one) and map the segment for an
+    emitting IOType. */
+int create_segment_samples(const int index);
+
+/** @internal
+    @param index Index of the IOType
+
+    Map the segment of a consuming IOType, if its emitter has created
+    it, and announce ourselves to the emitter. */
+int attach_segment_samples(const int index);
+
+/** @internal
+    @param index Index of the IOType
+
+    Unmap the segment of an IOType, closing and removing it if we
+    created it. */
+void release_segment_samples(const int index);
+
+/** @internal
+    @param index Index of the IOType
+    @return REG_SUCCESS if the other end is attached and alive
+
+    Check on the other end of the ring of an IOType. An emitter
+    renegotiates the data format if a new consumer has attached. */
+int check_peer_samples(const int index);
+
+/** @internal
+    @param index Index of the IOType
+    @param num_bufs No. of buffers to write
+    @param bufs The buffers
+    @param num_bytes Size of each buffer
+    @param block Whether (REG_TRUE) or not to wait for space
+
+    Copy buffers into the ring and publish them in one go if they fit,
+    waiting for the consumer to make room if @p block is REG_TRUE. */
+int ring_write_samples(const int index, const int num_bufs,
+		       void** bufs, const size_t* num_bytes,
+		       const int block);
+
+/** @internal
+    @param index Index of the IOType
+    @param buf Where to put the data
+    @param num_bytes No. of bytes to read
+
+    Read from the ring, waiting for the emitter if necessary. */
+int ring_read_samples(const int index, void* buf, const size_t num_bytes);
+
+#endif /* __REG_STEER_SAMPLES_TRANSPORT_SHM_H__ */
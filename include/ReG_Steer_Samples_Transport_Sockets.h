@@ -130,4 +130,110 @@ void retry_connect_samples(const int index);
     connection if none (whether listener or connector) */
 void poll_socket_samples(const int index);
 
+/** @internal
+    @param index Index of the IOType to which socket belongs
+
+    Starts gathering the small messages making up a sample so that
+    they are sent along with the larger ones */
+void start_gather_samples(const int index);
+
+/** @internal
+    @param index Index of the IOType to which socket belongs
+    @return REG_SUCCESS, REG_FAILURE
+
+    Sends anything that has been gathered but not yet sent */
+int flush_gather_samples(const int index);
+
+/** @internal
+    @param index Index of the IOType to which socket belongs
+    @param handle Handle of a socket connected to one of its consumers
+
+    Where an output IOType can have several consumers, puts a limit
+    on how long a send on the socket may block */
+void limit_sink_send_samples(const int index, const int handle);
+
+/** @internal
+    @param index Index of the IOType to which socket belongs
+    @param handle Handle of the socket connected to the new consumer
+    @return REG_SUCCESS, REG_FAILURE
+
+    Adds a consumer that has just connected to an output IOType */
+int add_sink_samples(const int index, const int handle);
+
+/** @internal
+    @param index Index of the IOType to which socket belongs
+    @param sink Which of the consumers of the IOType to drop
+
+    Closes the connection to one of the consumers of an output IOType */
+void drop_sink_samples(const int index, const int sink);
+
+/** @internal
+    @param index Index of the IOType to which socket belongs
+    @return REG_SUCCESS if at least one consumer is ready for the next
+    sample, REG_FAILURE otherwise
+
+    Reads any acknowledgements from the consumers of an output IOType
+    and works out which of them are to be sent the next sample, and in
+    what form */
+int consume_sink_acks_samples(const int index);
+
+/** @internal
+    @param index Index of the IOType to which socket belongs
+    @param nbufs No. of buffers to send after anything gathered
+    @param bufs Array of @p nbufs pointers to the buffers
+    @param lens Array of the lengths of the buffers in bytes
+    @param more If REG_TRUE, more data will follow shortly
+    @return REG_SUCCESS if the data went to at least one consumer,
+    REG_FAILURE otherwise
+
+    As send_gathered() but sends the same data to each consumer that
+    is being sent the current sample, dropping any that fail */
+int send_sinks_samples(const int index, const int nbufs, void** bufs,
+		       const size_t* lens, const int more);
+
+/** @internal
+    @param index Index of the IOType to which socket belongs
+
+    Flushes the end of a sample to each consumer that was sent it and
+    notes which of them missed it */
+void finish_sinks_samples(const int index);
+
+/** @internal
+    @param index Index of the IOType to which socket belongs
+    @return REG_SUCCESS if at least one consumer is to be sent the
+    sample, REG_FAILURE otherwise
+
+    Drops any of the consumers to be sent the sample that have gone,
+    works out whether the sample can use parallel streams and sets up
+    the data header that each consumer is to be sent */
+int start_sinks_samples(const int index);
+
+/** @internal
+    @param index Index of the IOType to which socket belongs
+
+    Listens for the parallel streams of the consumers of an output
+    IOType, accepts any that have connected and closes any that have
+    gone */
+void accept_stripes_samples(const int index);
+
+/** @internal
+    @param index Index of the IOType to which socket belongs
+    @param header The data header of the sample about to be read
+    @return REG_SUCCESS, REG_FAILURE
+
+    Reads what the data header says about parallel streams, connects
+    them if they are offered and we want them, and skips whatever
+    was sent over them for samples that we didn't read to the end */
+int start_stripes_samples(const int index, const char* header);
+
+/** @internal
+    @param index Index of the IOType to which socket belongs
+    @param port Port on which the emitter listens for parallel streams
+    @param num No. of streams to connect
+    @return REG_SUCCESS, REG_FAILURE
+
+    Connects our parallel streams to the emitter */
+int connect_stripes_samples(const int index, const int port,
+			    const int num);
+
 #endif /* __REG_STEER_SAMPLES_TRANSPORT_SOCKETS_H__ */
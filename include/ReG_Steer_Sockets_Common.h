@@ -55,9 +55,99 @@
  */
 
 #include "ReG_Steer_types.h"
+#include <stdint.h>
+#include <time.h>
 
 #define REG_SOCKETS_ERROR -1
 
+/** Size of the buffer in which the small messages making up a sample
+    (headers, footers and short slices) are gathered before they are
+    sent along with the next large one */
+#define REG_GATHER_BUFSIZE 16384
+
+/** No. of buffers that send_gathered() can send without allocating
+    memory to describe them */
+#define REG_GATHER_MAX_PARTS 16
+
+/** Size (in bytes) of the header of a frame of a sample */
+#define REG_FRAME_HDR_SIZE 24
+/** The first four bytes of a frame header */
+#define REG_FRAME_HDR_MAGIC "ReGf"
+/** Version of the frame header that we send */
+#define REG_FRAME_HDR_VERSION 1
+/** Frame header flag: the frame is the first of a sample */
+#define REG_FRAME_FLAG_START 1
+/** Frame header flag: the frame is the last of a sample */
+#define REG_FRAME_FLAG_END 2
+/** Frame header flag: the header carries a checksum of the frame */
+#define REG_FRAME_FLAG_CHECKSUM 4
+
+/** Returned by reactor_events(): there is data to read on the socket
+    or, for a listener, a connection to accept */
+#define REG_REACTOR_READ 1
+
+/** Returned by reactor_events(): the other end of the socket has hung
+    up or the socket is in error */
+#define REG_REACTOR_HUP 2
+
+/** Longest time (in microseconds) for which reactor_events() reuses
+    the results of a poll */
+#define REG_REACTOR_MAX_AGE 1000
+
+/** How long (in seconds) a send to one of several consumers of an
+    IOType may block before that consumer is given up on */
+#define REG_CONSUMER_SEND_TIMEOUT 5
+
+/** @internal
+    The parallel streams that the data of large slices is dealt out
+    between, in REG_STRIPE_CHUNK_SIZE pieces taken in turn */
+typedef struct {
+  /** Handles of the streams' sockets, in the order that the pieces
+      go to them.  The first @p num are used, -1 where a stream has
+      not connected (yet) */
+  int                   handles[REG_MAX_STREAMS];
+  /** No. of entries of @p handles that are connected */
+  int                   num_connected;
+  /** No. of streams that there should be, zero if there are none */
+  int                   num;
+  /** No. of bytes sent or received over the streams since they were
+      all connected, which says which piece comes next */
+  uint64_t              total;
+} stripe_info_type;
+
+/** @internal
+    State of one of the consumers connected to an output IOType */
+typedef struct {
+  /** Handle of the socket connected to the consumer */
+  int                   handle;
+  /** Whether (REG_TRUE) or not the kernel may be holding back data
+      sent to this consumer */
+  int                   corked;
+  /** Whether (REG_TRUE) or not the consumer is being sent the sample
+      currently being emitted */
+  int                   active;
+  /** Whether (REG_TRUE) or not we are waiting for the consumer to
+      acknowledge the last sample it was sent */
+  int                   ack_needed;
+  /** Whether (REG_TRUE) or not the consumer has missed a sample since
+      the last one it was sent */
+  int                   missed;
+  /** Slice header version that the consumer understands */
+  int                   slice_hdr_version;
+  /** Whether (REG_TRUE) or not the consumer can take native data */
+  int                   use_native;
+  /** The consumer's parallel streams, if it has any */
+  stripe_info_type      stripes;
+  /** The data header of the sample being emitted, as this consumer
+      is to be sent it */
+  char                  header[REG_PACKET_SIZE];
+  /** Whether (REG_TRUE) or not @p header is still to be sent */
+  int                   header_pending;
+  /** Whether (REG_TRUE) or not the sample being emitted goes to this
+      consumer in frames */
+  int                   framed;
+} sink_info_type;
+
 /** @internal
     Structure to hold socket information */
 typedef struct {
@@ -87,6 +177,64 @@ typedef struct {
   int			listener_status;
   /** status indicator for connecting socket */
   int			comms_status;
+  /** Buffer in which small messages are gathered while emitting */
+  char*                 gather_buf;
+  /** No. of bytes currently held in @p gather_buf */
+  int                   gather_bytes;
+  /** Whether (REG_TRUE) or not we are part-way through emitting a
+      sample and so should gather small messages rather than send them */
+  int                   gathering;
+  /** Whether (REG_TRUE) or not the kernel may be holding back data
+      that we have sent, waiting for more */
+  int                   corked;
+  /** No. of system calls made while emitting since last counted */
+  int                   num_syscalls;
+  /** The consumers connected to an output IOType, in the order that
+      they connected.  @p connector_handle is that of the first */
+  sink_info_type*       sinks;
+  /** No. of entries used in @p sinks */
+  int                   num_sinks;
+  /** No. of entries allocated in @p sinks */
+  int                   max_sinks;
+  /** Room for the handles of the listener and of every consumer, for
+      Wait_for_IOType() to wait on */
+  int*                  wait_handles;
+  /** Handle of the socket on which consumers connect parallel
+      streams ("server" end) */
+  int                   stripe_listener;
+  /** Port on which consumers connect parallel streams */
+  int                   stripe_port;
+  /** Handles of parallel streams that have connected but have yet to
+      say which consumer they belong to, -1 where unused */
+  int                   stripe_pending[REG_MAX_STREAMS];
+  /** When each of @p stripe_pending connected */
+  time_t                stripe_pending_since[REG_MAX_STREAMS];
+  /** Our parallel streams to the emitter ("client" end) */
+  stripe_info_type      stripes;
+  /** Sequence no. of the sample being emitted or consumed, as carried
+      in its frames */
+  unsigned int          frame_seq;
+  /** Whether (REG_TRUE) or not the next frame sent ends the sample
+      being emitted */
+  int                   frame_end;
+  /** Whether (REG_TRUE) or not the sample being consumed came in
+      frames */
+  int                   framed;
+  /** Flags (REG_FRAME_FLAG_*) of the frame being consumed */
+  int                   frame_flags;
+  /** No. of bytes of the frame being consumed still to be read */
+  uint64_t              frame_left;
+  /** Checksum of the frame being consumed as sent, and of what has
+      been read of it so far */
+  unsigned int          frame_check;
+  unsigned int          frame_sum;
+  /** Whether (REG_TRUE) or not a frame of the sample being consumed
+      did not match its checksum */
+  int                   frame_bad;
+  /** Whether (REG_TRUE) or not the first frame of the next sample has
+      been read already, because the emitter gave up on the last one
+      part-way through */
+  int                   frame_restart;
 } socket_info_type;
 
 typedef struct {
@@ -168,6 +316,53 @@ void signal_handler_sockets(int a_signal);
     See send(2). */
 ssize_t send_no_signal(int s, const void *buf, size_t len, int flags);
 
+/** @internal
+    @param socket_info Pointer to the socket information for the
+    connection
+    @param buf Pointer to the message to gather
+    @param len Length of the message in bytes
+    @return REG_SUCCESS, REG_FAILURE if there is not enough room left
+    in the gather buffer
+
+    Copy a message into the gather buffer of a connection so that it
+    can be sent later by send_gathered(). */
+int gather_data(socket_info_type* socket_info, const void* buf, size_t len);
+
+/** @internal
+    @param socket_info Pointer to the socket information for the
+    connection
+    @param prefix Pointer to data to send before anything gathered
+    (may be NULL)
+    @param prefix_len Length of @p prefix in bytes
+    @param nbufs No. of buffers to send after anything gathered
+    @param bufs Array of @p nbufs pointers to the buffers
+    @param lens Array of the lengths of the buffers in bytes
+    @param more If REG_TRUE, more data will follow shortly so the
+    last segment need not be sent until it is full
+    @return REG_SUCCESS, REG_FAILURE
+
+    Send @p prefix, the contents of the gather buffer and then each
+    of @p bufs through the connecting socket using as few calls to
+    sendmsg() as possible.  Empties the gather buffer. */
+int send_gathered(socket_info_type* socket_info,
+		  const void* prefix, size_t prefix_len,
+		  const int nbufs, void** bufs, const size_t* lens,
+		  int more);
+
+/** @internal
+    @param socket_info Pointer to the socket information for the
+    connection
+    @param on REG_TRUE to cork the connecting socket, REG_FALSE to
+    uncork it (and so flush anything held back)
+    @return REG_SUCCESS or REG_FAILURE
+
+    Stop TCP from sending partial segments while a sample is being
+    emitted.  Where sends can be flagged with MSG_MORE that is used
+    instead and uncorking just pushes out anything held back.
+    Otherwise TCP_CORK or TCP_NOPUSH is used if available.  Does
+    nothing if the socket is already in the requested state. */
+int set_tcpcork(socket_info_type* socket_info, int on);
+
 /** @internal
     @param s File descriptor of the receiving socket
     @param buf Pointer to buffer in which to put received data (must
@@ -186,6 +381,179 @@ ssize_t recv_wait_all(int s, void *buf, size_t len, int flags);
     cross-platform (ie MSVC) manner. See setsockopt(2). */
 int set_tcpnodelay(int s);
 
+/** @internal
+    @param s File descriptor of the socket to set.
+    @param seconds How long a send may block before it fails
+
+    A wrapper around the setsockopt() call to set SO_SNDTIMEO in a
+    cross-platform (ie MSVC) manner. See setsockopt(2). */
+int set_send_timeout(int s, int seconds);
+
+/** @internal
+    @param s File descriptor of the socket to set.
+    @param bytes How many bytes there must be to read before the
+    socket counts as readable
+
+    A wrapper around the setsockopt() call to set SO_RCVLOWAT. See
+    socket(7). */
+int set_recv_lowat(int s, int bytes);
+
+/** @internal
+    @param s File descriptor of the socket
+    @param peer REG_TRUE for the address of the other end of the
+    socket, REG_FALSE for that of this end
+    @param host If not NULL, on successful return holds the numeric
+    host address (must be at least NI_MAXHOST in size)
+    @param port On successful return, the port no.
+    @return REG_SUCCESS, REG_FAILURE
+
+    Find out the address of one end of a connected socket. */
+int get_socket_address(int s, int peer, char* host, int* port);
+
+/** @internal
+    @param interface Address of the interface to listen on
+    @param min_port Lowest port to try (zero for any)
+    @param max_port Highest port to try (zero for any)
+    @param port On successful return, the port listened on
+    @return Handle of the listening socket or REG_SOCKETS_ERROR
+
+    Listen on the first free port in a range. */
+int listen_in_range(const char* interface, int min_port, int max_port,
+		    int* port);
+
+/** @internal
+    @param interface Address of the interface to connect out of
+    @param min_port Lowest port to try to connect out of (zero for any)
+    @param max_port Highest port to try to connect out of (zero for any)
+    @param hostname Host to connect to
+    @param port Port to connect to
+    @return Handle of the connected socket or REG_SOCKETS_ERROR
+
+    Connect out of the first free port in a range (so as to get out
+    through firewalls). */
+int connect_from_range(const char* interface, int min_port, int max_port,
+		       const char* hostname, int port);
+
+/** @internal
+    @param stripes The parallel streams to send over, all connected
+    @param buf The data to send
+    @param len No. of bytes to send
+    @return REG_SUCCESS, REG_FAILURE
+
+    Deal @p len bytes out between parallel streams in
+    REG_STRIPE_CHUNK_SIZE pieces, carrying on from where the last
+    call left off, and send them with a thread per stream. */
+int send_striped(stripe_info_type* stripes, const void* buf, size_t len);
+
+/** @internal
+    @param stripes The parallel streams to receive from, all connected
+    @param buf Buffer to put the data in, at least @p len in size (or
+    NULL to throw the data away)
+    @param len No. of bytes to receive
+    @return REG_SUCCESS, REG_FAILURE
+
+    The other end of send_striped(): receive @p len bytes from
+    parallel streams with a thread per stream and put them back in
+    order. */
+int recv_striped(stripe_info_type* stripes, void* buf, size_t len);
+
+/** @internal
+    @param stripes The parallel streams to close
+
+    Close any parallel streams and forget about them. */
+void close_stripes(stripe_info_type* stripes);
+
+/** @internal
+    @param s File descriptor of the socket to ask about
+    @return Some combination of REG_REACTOR_READ and REG_REACTOR_HUP,
+    or zero if nothing is waiting
+
+    Find out what is waiting on a socket without blocking. Every socket
+    asked about is watched by one library-wide epoll set and a single
+    epoll_wait() finds out about all of them at once. Its results are
+    reused until a socket is asked about a second time or they are
+    more than REG_REACTOR_MAX_AGE old, so a pass over all the IOTypes
+    and the steering connection (a call to Steering_control(), say)
+    costs one system call, however many sockets there are, while a
+    socket that has not been asked about for a while is never told
+    about an old poll. Safe to call from the asynchronous emit thread.
+    Falls back to select() on a single socket where there is no
+    epoll. */
+int reactor_events(int s);
+
+/** @internal
+    @param s File descriptor of the socket
+
+    Stop watching a socket. Must be called before the socket is closed
+    as the descriptor may be reused. */
+void reactor_remove(int s);
+
+/** @internal
+    @param handles File descriptors of the sockets to wait on (any
+    that are -1 are ignored)
+    @param num No. of entries in @p handles
+    @param timeout_ms Longest time to wait (milliseconds)
+    @return REG_SUCCESS if any of the sockets has something to read
+    (or, for a listener, a connection to accept), REG_TIMED_OUT if
+    none has, REG_FAILURE if there is no socket to wait on
+
+    Sleep until one of the sockets is ready or @p timeout_ms has
+    passed.  Unlike reactor_events() this blocks, so it is only for
+    when there is nothing else to do. */
+int wait_for_sockets(const int* handles, const int num,
+		     const int timeout_ms);
+
+/** @internal
+    @param buf Buffer of at least REG_FRAME_HDR_SIZE bytes
+    @param flags Any of REG_FRAME_FLAG_START, REG_FRAME_FLAG_END and
+    REG_FRAME_FLAG_CHECKSUM
+    @param seqnum Sequence no. of the sample that the frame is part of
+    @param num_bytes No. of bytes in the frame after its header
+    @param checksum Checksum of those bytes, from frame_checksum(),
+    if @p flags has REG_FRAME_FLAG_CHECKSUM
+
+    Packs the header of a frame of a sample into @p buf.  All fields
+    are written in network byte order. */
+void pack_frame_header(char* buf, int flags, unsigned int seqnum,
+		       uint64_t num_bytes, unsigned int checksum);
+
+/** @internal
+    @param buf Buffer of REG_FRAME_HDR_SIZE bytes holding the header
+    @param flags On successful return, the REG_FRAME_FLAG_* flags
+    @param seqnum On successful return, the sequence no. of the sample
+    @param num_bytes On successful return, the no. of bytes in the
+    frame after its header
+    @param checksum On successful return, the checksum of those bytes
+    (zero if there is none)
+    @return REG_SUCCESS or REG_FAILURE if @p buf is not a frame header
+    that we understand
+
+    Unpacks a frame header created by pack_frame_header(). */
+int unpack_frame_header(const char* buf, int* flags, unsigned int* seqnum,
+			uint64_t* num_bytes, unsigned int* checksum);
+
+/** @internal
+    @param sum Checksum of the bytes before @p buf, or
+    frame_checksum(0, NULL, 0) if there are none
+    @param buf The bytes to add to the checksum
+    @param len No. of bytes in @p buf
+    @return The checksum of the bytes so far
+
+    Adler-32 checksum (zlib's adler32()) of the bytes of a frame,
+    added to in pieces. */
+unsigned int frame_checksum(unsigned int sum, const void* buf, size_t len);
+
+/** @internal
+    @param sum1 Checksum of a first run of bytes
+    @param sum2 Checksum of the run of bytes that follows it
+    @param len2 No. of bytes in that second run
+    @return The checksum of the two runs of bytes, one after the other
+
+    Lets the checksums of pieces of a frame be worked out once and
+    put together for each consumer. */
+unsigned int frame_checksum_combine(unsigned int sum1, unsigned int sum2,
+				    uint64_t len2);
+
 #if defined(_MSC_VER) || defined(DOXYGEN)
 /** @internal
 
@@ -0,0 +1,102 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+
+#ifndef __REG_STEER_XDR_CODEC_H__
+#define __REG_STEER_XDR_CODEC_H__
+
+/** @file ReG_Steer_XDR_Codec.h
+ *  @brief Bulk XDR encoding and decoding of numeric arrays.
+ *
+ *  Replaces per-element calls to xdr_int, xdr_long, xdr_float and
+ *  xdr_double (via xdr_vector) with whole-array byte swaps.  The
+ *  output is bit-identical to that of the system XDR routines.
+ *
+ *  @author Robert Haines
+ */
+
+#include "ReG_Steer_types.h"
+
+/** @internal
+    @param type The (native) type of data, e.g. REG_INT
+    @return The no. of bytes that one element of @p type occupies
+    once XDR encoded, or zero if @p type cannot be XDR encoded */
+int Xdr_sizeof_type(const int type);
+
+/** @internal
+    @param type The (native) type of data, e.g. REG_INT
+    @return The equivalent XDR type code, e.g. REG_XDR_INT, or -1 if
+    @p type cannot be XDR encoded */
+int Xdr_type_from_native(const int type);
+
+/** @internal
+    @param type The type of data to encode: REG_INT, REG_LONG,
+    REG_FLOAT or REG_DBL
+    @param count The no. of elements to encode
+    @param in Pointer to the native data
+    @param out Pointer to a buffer of at least
+    @p count * Xdr_sizeof_type(@p type) bytes to hold the encoded data
+    @param nbytes On successful return, the no. of bytes written
+    @return REG_SUCCESS, or REG_FAILURE if @p type is not supported or a
+    long value does not fit in an XDR long (32 bits)
+
+    Encodes a whole array as XDR. */
+int Xdr_encode_array(const int type, const size_t count,
+		     const void *in, void *out, size_t *nbytes);
+
+/** @internal
+    @param type The type of data to decode: REG_INT, REG_LONG,
+    REG_FLOAT or REG_DBL
+    @param count The no. of elements to decode
+    @param in Pointer to the XDR-encoded data
+    @param out Pointer to a buffer to hold @p count native elements
+    @return REG_SUCCESS, or REG_FAILURE if @p type is not supported
+
+    Decodes a whole array of XDR data. */
+int Xdr_decode_array(const int type, const size_t count,
+		     const void *in, void *out);
+
+#endif /* __REG_STEER_XDR_CODEC_H__ */
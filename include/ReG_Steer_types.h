@@ -150,6 +150,11 @@
     than all of the commands &#35;define'd above */
 #define REG_MIN_IOTYPE_HANDLE 1000
 
+/** Interval (microseconds) at which Emit_start_blocking() and
+    Consume_start_blocking() poll when the samples transport has
+    nothing that they can wait on */
+#define REG_BLOCKING_POLL_INTERVAL 10000
+
 /** The three different types that an IOtype/CHKtype can have */
 /** Type for an IOtype that is input only */
 #define REG_IO_IN    0
@@ -158,6 +163,81 @@
 /** Type for an IOtype that is for input and output */
 #define REG_IO_INOUT 2
 
+/** What Emit_start() does for an asynchronous IOType when both of its
+    snapshot buffers are busy */
+/** Wait for the I/O thread to free a buffer */
+#define REG_ASYNC_BLOCK      0
+/** Skip this sample - Emit_start() returns REG_NOT_READY */
+#define REG_ASYNC_DROP       1
+/** Replace the oldest snapshot that is still waiting to be sent */
+#define REG_ASYNC_OVERWRITE  2
+
+/** No. of snapshot buffers per asynchronous IOType */
+#define REG_ASYNC_NUM_BUFFERS 2
+/** Interval (microseconds) at which the I/O thread polls for an
+    acknowledgement when a snapshot is waiting for one */
+#define REG_ASYNC_POLL_INTERVAL 10000
+/** Time (seconds) that Disable_IOType_async() and Steering_finalize()
+    wait for queued snapshots to be sent before discarding them */
+#define REG_ASYNC_DRAIN_TIMEOUT 10
+
+/** Codecs that the data in a slice may be compressed with */
+/** Not compressed */
+#define REG_COMPRESS_NONE 0
+/** zlib (deflate) at its fastest level */
+#define REG_COMPRESS_ZLIB 1
+/** Highest codec code */
+#define REG_COMPRESS_MAX  1
+/** Slices smaller than this (in bytes) are never compressed */
+#define REG_COMPRESS_MIN_BYTES 1024
+
+/** Lossy encodings of float and double slices */
+/** Send the data exactly */
+#define REG_LOSSY_NONE     0
+/** Round away the mantissa bits that the error bound doesn't need */
+#define REG_LOSSY_TRUNCATE 1
+/** Quantise to 16 bits with a per-slice offset and scale */
+#define REG_LOSSY_QUANT16  2
+/** Convert to IEEE 754 half precision */
+#define REG_LOSSY_HALF     3
+/** Highest lossy encoding code */
+#define REG_LOSSY_MAX      3
+
+/** How the error bound of a lossy encoding is given */
+/** Largest absolute error in any element */
+#define REG_ERROR_ABS 0
+/** Largest error in any element relative to the largest magnitude in
+    the slice */
+#define REG_ERROR_REL 1
+
+/** Maximum no. of dimensions of an array that Reorder_array() can
+    convert between C and F90 ordering */
+#define REG_REORDER_MAX_DIMS 5
+/** Size (in bytes) of the pieces in which a consumer reads XDR data
+    that it is decoding and reordering */
+#define REG_REORDER_CHUNK_SIZE 4194304
+
+/** Maximum no. of levels of detail that an IOType can send arrays
+    at (see Set_IOType_levels()) */
+#define REG_MAX_LEVELS 8
+/** Most bytes in each part of a level of detail that an emitter
+    sends, unless one plane of the part holds more */
+#define REG_LEVEL_PART_SIZE 4194304
+
+/** Maximum no. of samples that a consumer can let an emitter send
+    ahead of its acknowledgements (see Set_IOType_window()) */
+#define REG_MAX_WINDOW 64
+
+/** Maximum no. of parallel streams that an IOType can send large
+    slices over (see Set_IOType_streams()) */
+#define REG_MAX_STREAMS 16
+/** Slices smaller than this (in bytes) always go over the main
+    connection of an IOType */
+#define REG_STRIPE_MIN_BYTES 1048576
+/** Size (in bytes) of the pieces in which the data of a large slice
+    is dealt out between parallel streams */
+#define REG_STRIPE_CHUNK_SIZE 262144
+
 /** Size (in bytes) of input buffer for each active IO channel */
 #define REG_IO_BUFSIZE  1048576
 
@@ -177,6 +257,85 @@
     being sent down a socket */
 #define END_SLICE_HEADER   "</ReG_data_slice_header>"
 
+/** Slice header version meaning that the peer only understands the
+    original text header (six @p REG_PACKET_SIZE packets per slice) */
+#define REG_SLICE_HDR_TEXT    0
+/** Highest version of the compact, binary slice header that we
+    understand */
+#define REG_SLICE_HDR_VERSION 7
+/** First version of the binary slice header that can describe
+    compressed data */
+#define REG_SLICE_HDR_COMPRESS_VERSION 2
+/** First version of the binary slice header that can carry the
+    lossy data types (REG_Q16_FLOAT etc.) */
+#define REG_SLICE_HDR_LOSSY_VERSION 3
+/** First version of the binary slice header that can flag key
+    frames and deltas (REG_SLICE_FLAG_*) */
+#define REG_SLICE_HDR_DELTA_VERSION 4
+/** First version of the binary slice header whose consumers can
+    take samples in frames (REG_FRAME_HDR_MAGIC).  The slice header
+    itself is unchanged */
+#define REG_SLICE_HDR_FRAME_VERSION 5
+/** First version of the binary slice header whose emitters can cut
+    arrays down to a region asked for by the consumer
+    (REG_SLICE_FLAG_REGIONS) */
+#define REG_SLICE_HDR_REGION_VERSION 6
+/** First version of the binary slice header whose emitters can keep
+    several samples in flight (REG_SLICE_FLAG_CREDITS) */
+#define REG_SLICE_HDR_CREDIT_VERSION 7
+/** Slice header flag: the consumer should keep a copy of this slice
+    for deltas in later samples to be applied to */
+#define REG_SLICE_FLAG_KEY    1
+/** Slice header flag: this slice is the XOR of the data with the
+    same slice in the previous sample */
+#define REG_SLICE_FLAG_DELTA  2
+/** Slice header flag: the data of this slice follows over the
+    IOType's parallel streams rather than its main connection.  Only
+    sent to consumers that have connected such streams */
+#define REG_SLICE_FLAG_STRIPED 4
+/** Slice header flag: the emitter will cut arrays down to the region
+    given in the consumer's acknowledgement (see Set_IOType_region()) */
+#define REG_SLICE_FLAG_REGIONS 8
+/** Slice header flag: the emitter will send as many samples ahead of
+    the consumer's acknowledgements as it is given credit for (see
+    Set_IOType_window()) */
+#define REG_SLICE_FLAG_CREDITS 16
+/** Size (in bytes) of a binary slice header */
+#define REG_SLICE_HDR_SIZE    24
+/** The first four bytes of a binary slice header.  Every text packet
+    starts with '<' so the two forms cannot be confused */
+#define REG_SLICE_HDR_MAGIC   "ReGs"
+/** Maximum number of slices that Emit_data_slices() hands to the
+    transport in one go */
+#define REG_SLICE_BATCH_SIZE  64
+/** Starts the packet at the very end of a data file (files
+    transport) that says where in the file its index of slices is */
+#define REG_INDEX_TAG         "<ReG_index"
+/** Size (in bytes) of a buffer big enough for any chunk header
+    (Make_chunk_header()) */
+#define REG_CHUNK_HDR_SIZE    256
+/** Size (in bytes) of one entry in the index of slices at the end of
+    a data file */
+#define REG_INDEX_ENTRY_SIZE  72
+/** Size (in bytes) of an acknowledgement message */
+#define REG_ACK_SIZE          16
+/** The tag that identifies an acknowledgement message */
+#define REG_ACK_TAG           "<ACK/>"
+/** Size (in bytes) of the description of a region that follows an
+    acknowledgement whose version tag ends "+>" or "*>" rather than
+    "/>" */
+#define REG_ACK_REGION_SIZE   128
+/** The tag that starts the description of a region */
+#define REG_ACK_REGION_TAG    "<Region"
+/** Size (in bytes) of the credit that follows the region space of
+    an acknowledgement whose version tag ends "*>" */
+#define REG_ACK_CREDIT_SIZE   64
+/** The tag that starts a credit */
+#define REG_ACK_CREDIT_TAG    "<Credit"
+/** Size (in bytes) of the longest acknowledgement message */
+#define REG_ACK_MAX_SIZE      (REG_ACK_SIZE + REG_ACK_REGION_SIZE + \
+			       REG_ACK_CREDIT_SIZE)
+
 
 /* Coding scheme for data types */
 /** Encoding for an int type - equivalent to KIND(REG_INT_KIND) in F90 */
@@ -200,6 +359,14 @@
 #define REG_LONG       8
 /** Encoding for an XDR long */
 #define REG_XDR_LONG   9
+/** Encoding for floats quantised to 16 bits (REG_LOSSY_QUANT16) */
+#define REG_Q16_FLOAT   10
+/** Encoding for doubles quantised to 16 bits (REG_LOSSY_QUANT16) */
+#define REG_Q16_DOUBLE  11
+/** Encoding for floats sent as half precision (REG_LOSSY_HALF) */
+#define REG_HALF_FLOAT  12
+/** Encoding for doubles sent as half precision (REG_LOSSY_HALF) */
+#define REG_HALF_DOUBLE 13
 
 /** Stores the size in bytes of an XDR-encoded int - NOT USED? */
 #define REG_SIZEOF_XDR_INT    4
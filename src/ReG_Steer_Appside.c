@@ -58,6 +58,13 @@
 #include "ReG_Steer_Steering_Transport_API.h"
 #include "ReG_Steer_Logging.h"
 #include "ReG_Steer_XML.h"
+#include "ReG_Steer_XDR_Codec.h"
+#include "ReG_Steer_Async_Emit.h"
+#include "ReG_Steer_Reorder.h"
+#include "ReG_Steer_Compress.h"
+#include "ReG_Steer_Lossy.h"
+#include "ReG_Steer_Region.h"
+#include "ReG_Steer_Buffers.h"
 #include "Base64.h"
 #include "soapRealityGrid.nsmap"
 
@@ -65,6 +72,8 @@
 #include "ReG_Steer_Dynamic_Loader.h"
 #endif
 
+#include <limits.h>
+
 /**
    The table holding details of our communication channel with the
    steering client
@@ -518,6 +527,10 @@ int Steering_finalize()
   Close_log_file(&Chk_log);
   Close_log_file(&Param_log);
 
+  /* Send any samples still queued for asynchronous emission and
+     stop the I/O thread */
+  Async_emit_finalize();
+
   /* Tell the steerer that we are done - signal that component
      no-longer steerable */
   Finalize_steering_connection();
@@ -533,11 +546,12 @@ int Steering_finalize()
 
     /* Free buffers associated with each iotype */
     for(i = 0; i < IOTypes_table.num_registered; i++) {
-      if(IOTypes_table.io_def[i].buffer) {
-	free(IOTypes_table.io_def[i].buffer);
-	IOTypes_table.io_def[i].buffer = NULL;
-	IOTypes_table.io_def[i].buffer_bytes = 0;
-	IOTypes_table.io_def[i].buffer_max_bytes = 0;
+      Release_IOdef_entry_buffers(&(IOTypes_table.io_def[i]));
+      Free_delta_refs(&(IOTypes_table.io_def[i]));
+      if(IOTypes_table.io_def[i].consumers) {
+	free(IOTypes_table.io_def[i].consumers);
+	IOTypes_table.io_def[i].consumers = NULL;
+	IOTypes_table.io_def[i].num_consumers = 0;
       }
     }
     free(IOTypes_table.io_def);
@@ -552,12 +566,7 @@ int Steering_finalize()
 
   if(ChkTypes_table.io_def) {
     for(i = 0; i < ChkTypes_table.num_registered; i++) {
-      if(ChkTypes_table.io_def[i].buffer) {
-	free(ChkTypes_table.io_def[i].buffer);
-	ChkTypes_table.io_def[i].buffer = NULL;
-	ChkTypes_table.io_def[i].buffer_bytes = 0;
-	ChkTypes_table.io_def[i].buffer_max_bytes = 0;
-      }
+      Release_IOdef_entry_buffers(&(ChkTypes_table.io_def[i]));
     }
     free(ChkTypes_table.io_def);
     ChkTypes_table.io_def = NULL;
@@ -565,6 +574,9 @@ int Steering_finalize()
   ChkTypes_table.num_registered = 0;
   ChkTypes_table.max_entries = REG_INITIAL_NUM_IOTYPES;
 
+  /* Nothing is using the pooled buffers now */
+  Buffer_pool_finalize();
+
   /* Clean-up log of checkpoints & params */
   Finalize_log(&Chk_log);
   Finalize_log(&Param_log);
@@ -739,6 +751,11 @@ int Register_IOType(const char* IOLabel,
   IOTypes_table.io_def[current].buffer = NULL;
   IOTypes_table.io_def[current].buffer_bytes = 0;
   IOTypes_table.io_def[current].buffer_max_bytes = 0;
+  IOTypes_table.io_def[current].slice_buffer = NULL;
+  IOTypes_table.io_def[current].slice_buffer_max_bytes = 0;
+  IOTypes_table.io_def[current].buffer_held_bytes = 0;
+  IOTypes_table.io_def[current].buffer_high_water = 0;
+  IOTypes_table.io_def[current].buffer_limit = 0;
   IOTypes_table.io_def[current].use_xdr = REG_FALSE;
   IOTypes_table.io_def[current].num_xdr_bytes = 0;
   IOTypes_table.io_def[current].array.nx = 0;
@@ -753,9 +770,84 @@ int Register_IOType(const char* IOLabel,
   IOTypes_table.io_def[current].use_ack    = REG_TRUE;
   /* No ack needed for first data set to be emitted */
   IOTypes_table.io_def[current].ack_needed = REG_FALSE;
+  /* One sample at a time unless the consumer grants more */
+  IOTypes_table.io_def[current].window = 1;
+  IOTypes_table.io_def[current].samples_in_flight = 0;
+  IOTypes_table.io_def[current].credit_capable = REG_FALSE;
+  IOTypes_table.io_def[current].peer_credits = REG_FALSE;
+  IOTypes_table.io_def[current].acks_owed = 0;
   /* For use with ioProxy so that we know whether we were in the
      process of consuming data when we hit the signal handler */
   IOTypes_table.io_def[current].consuming  = REG_FALSE;
+  /* Whole arrays unless asked for part of them */
+  memset(&(IOTypes_table.io_def[current].region), 0, sizeof(Region_type));
+  IOTypes_table.io_def[current].use_region = REG_FALSE;
+  IOTypes_table.io_def[current].peer_regions = REG_FALSE;
+  IOTypes_table.io_def[current].region_next = REG_REGION_NONE;
+  /* Full resolution only unless asked for levels of detail */
+  IOTypes_table.io_def[current].num_levels = 1;
+  IOTypes_table.io_def[current].level_buffer = NULL;
+  IOTypes_table.io_def[current].level_buffer_max_bytes = 0;
+  IOTypes_table.io_def[current].level_pending = REG_FALSE;
+  IOTypes_table.io_def[current].level_done = -1;
+  IOTypes_table.io_def[current].level_count = 0;
+  IOTypes_table.io_def[current].level_part.num_levels = 0;
+  /* Use text slice headers and XDR until the consumer tells us
+     otherwise */
+  Set_peer_capabilities(&(IOTypes_table.io_def[current]), NULL);
+  IOTypes_table.io_def[current].num_native_slices = 0;
+  IOTypes_table.io_def[current].num_xdr_slices = 0;
+  IOTypes_table.io_def[current].num_samples_emitted = 0;
+  IOTypes_table.io_def[current].num_emit_syscalls = 0;
+  IOTypes_table.io_def[current].write_queue_bytes = 0.0;
+  IOTypes_table.io_def[current].write_queue_high = 0.0;
+  IOTypes_table.io_def[current].num_writes = 0;
+  IOTypes_table.io_def[current].write_seconds = 0.0;
+  IOTypes_table.io_def[current].max_write_seconds = 0.0;
+  IOTypes_table.io_def[current].num_write_stalls = 0;
+  /* One consumer at a time unless asked otherwise */
+  IOTypes_table.io_def[current].max_consumers = 1;
+  IOTypes_table.io_def[current].consumers = NULL;
+  IOTypes_table.io_def[current].num_consumers = 0;
+  /* Everything over one connection unless asked otherwise */
+  IOTypes_table.io_def[current].num_streams = 1;
+  IOTypes_table.io_def[current].stripe_slices = REG_FALSE;
+  IOTypes_table.io_def[current].frame_checksum = REG_FALSE;
+  IOTypes_table.io_def[current].is_async = REG_FALSE;
+  /* No compression unless asked for */
+  IOTypes_table.io_def[current].compression = REG_COMPRESS_NONE;
+  IOTypes_table.io_def[current].comp_buffer = NULL;
+  IOTypes_table.io_def[current].comp_buffer_max_bytes = 0;
+  IOTypes_table.io_def[current].slice_codec = REG_COMPRESS_NONE;
+  IOTypes_table.io_def[current].slice_bytes = 0;
+  IOTypes_table.io_def[current].slice_raw_bytes = 0;
+  IOTypes_table.io_def[current].comp_raw_bytes = 0.0;
+  IOTypes_table.io_def[current].comp_bytes = 0.0;
+  IOTypes_table.io_def[current].comp_ratio = 1.0;
+  IOTypes_table.io_def[current].comp_time = 0.0;
+  /* Send float and double data exactly unless asked otherwise */
+  IOTypes_table.io_def[current].lossy_mode = REG_LOSSY_NONE;
+  IOTypes_table.io_def[current].lossy_bound_type = REG_ERROR_ABS;
+  IOTypes_table.io_def[current].lossy_bound = 0.0;
+  IOTypes_table.io_def[current].slice_lossy_type = 0;
+  IOTypes_table.io_def[current].lossy_bytes_saved = 0.0;
+  IOTypes_table.io_def[current].lossy_max_error = 0.0;
+  /* Send whole samples unless asked to send deltas */
+  IOTypes_table.io_def[current].delta_interval = 0;
+  IOTypes_table.io_def[current].delta_count = 0;
+  IOTypes_table.io_def[current].delta_key_needed = REG_TRUE;
+  IOTypes_table.io_def[current].delta_is_key = REG_TRUE;
+  IOTypes_table.io_def[current].delta_slice = 0;
+  IOTypes_table.io_def[current].delta_sample = 0;
+  IOTypes_table.io_def[current].delta_refs = NULL;
+  IOTypes_table.io_def[current].num_delta_refs = 0;
+  IOTypes_table.io_def[current].slice_flags = 0;
+  IOTypes_table.io_def[current].slice_wire_type = 0;
+
+  if(Register_IOType_comp_params(current) != REG_SUCCESS ||
+     Register_IOType_window_param(current) != REG_SUCCESS) {
+    return REG_FAILURE;
+  }
 
   /* set up transport for sample data - eg sockets */
   if(Initialize_IOType_transport(direction, current) != REG_SUCCESS) {
@@ -771,16 +863,20 @@ int Register_IOType(const char* IOLabel,
   if(current == IOTypes_table.max_entries) {
     new_size = IOTypes_table.max_entries + REG_INITIAL_NUM_IOTYPES;
 
+    /* The I/O thread must not be using the table while it moves */
+    Async_emit_lock();
     dum_ptr = (IOdef_entry*)realloc((void *)(IOTypes_table.io_def),
 		                      new_size*sizeof(IOdef_entry));
+    if(dum_ptr != NULL) {
+      IOTypes_table.io_def = dum_ptr;
+      Update_IOType_param_ptrs(current);
+    }
+    Async_emit_unlock();
 
     if(dum_ptr == NULL) {
       fprintf(stderr, "STEER: Register_IOTypes: failed to allocate memory\n");
       return REG_FAILURE;
     }
-    else {
-      IOTypes_table.io_def = dum_ptr;
-    }
 
     IOTypes_table.max_entries += REG_INITIAL_NUM_IOTYPES;
   }
@@ -795,6 +891,136 @@ int Register_IOType(const char* IOLabel,
 
 /*----------------------------------------------------------------*/
 
+/* Labels a parameter belonging to an IOType "<IOType label> <what>",
+   cutting the IOType's label short if the whole won't fit */
+static void iotype_param_label(char *label, const IOdef_entry *io,
+			       const char *what) {
+  snprintf(label, REG_MAX_STRING_LENGTH, "%.*s %s",
+	   (int)(REG_MAX_STRING_LENGTH - 2 - strlen(what)), io->label, what);
+}
+
+/*----------------------------------------------------------------*/
+
+int Register_IOType_comp_params(int index) {
+
+  IOdef_entry *io = &(IOTypes_table.io_def[index]);
+  char         label[REG_MAX_STRING_LENGTH];
+  char         max_val[16];
+
+  io->comp_param_handle = REG_PARAM_HANDLE_NOTSET;
+  io->comp_ratio_param_handle = REG_PARAM_HANDLE_NOTSET;
+  io->comp_time_param_handle = REG_PARAM_HANDLE_NOTSET;
+  io->lossy_saved_param_handle = REG_PARAM_HANDLE_NOTSET;
+  io->lossy_err_param_handle = REG_PARAM_HANDLE_NOTSET;
+
+  /* Only emitted data is compressed but the consumer is told the
+     ratio that it is receiving.  Only the emitter knows the error
+     that a lossy encoding introduced */
+  if(io->direction != REG_IO_IN) {
+    iotype_param_label(label, io, "compression");
+    sprintf(max_val, "%d", REG_COMPRESS_MAX);
+    if(Register_param(label, REG_TRUE, (void *)&(io->compression),
+		      REG_INT, "0", max_val) != REG_SUCCESS) {
+      return REG_FAILURE;
+    }
+    io->comp_param_handle = Params_table.next_handle - 1;
+
+    iotype_param_label(label, io, "lossy bytes saved");
+    if(Register_param(label, REG_FALSE, (void *)&(io->lossy_bytes_saved),
+		      REG_DBL, "", "") != REG_SUCCESS) {
+      return REG_FAILURE;
+    }
+    io->lossy_saved_param_handle = Params_table.next_handle - 1;
+
+    iotype_param_label(label, io, "lossy max error");
+    if(Register_param(label, REG_FALSE, (void *)&(io->lossy_max_error),
+		      REG_DBL, "", "") != REG_SUCCESS) {
+      return REG_FAILURE;
+    }
+    io->lossy_err_param_handle = Params_table.next_handle - 1;
+  }
+
+  iotype_param_label(label, io, "compression ratio");
+  if(Register_param(label, REG_FALSE, (void *)&(io->comp_ratio),
+		    REG_FLOAT, "", "") != REG_SUCCESS) {
+    return REG_FAILURE;
+  }
+  io->comp_ratio_param_handle = Params_table.next_handle - 1;
+
+#if REG_USE_TIMING
+  iotype_param_label(label, io, "compression time (s)");
+  if(Register_param(label, REG_FALSE, (void *)&(io->comp_time),
+		    REG_FLOAT, "", "") != REG_SUCCESS) {
+    return REG_FAILURE;
+  }
+  io->comp_time_param_handle = Params_table.next_handle - 1;
+#endif
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Register_IOType_window_param(int index) {
+
+  IOdef_entry *io = &(IOTypes_table.io_def[index]);
+  char         label[REG_MAX_STRING_LENGTH];
+  char         max_val[16];
+
+  io->window_param_handle = REG_PARAM_HANDLE_NOTSET;
+
+  /* Only a consumer grants credit to its emitter */
+  if(io->direction != REG_IO_IN) return REG_SUCCESS;
+
+  iotype_param_label(label, io, "window");
+  sprintf(max_val, "%d", REG_MAX_WINDOW);
+  if(Register_param(label, REG_TRUE, (void *)&(io->window),
+		    REG_INT, "1", max_val) != REG_SUCCESS) {
+    return REG_FAILURE;
+  }
+  io->window_param_handle = Params_table.next_handle - 1;
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+/* Re-points a parameter at its new location within the table of
+   IOTypes */
+static void update_param_ptr(int handle, void *ptr) {
+  int iparam;
+
+  if(handle == REG_PARAM_HANDLE_NOTSET) return;
+
+  iparam = Param_index_from_handle(&Params_table, handle);
+  if(iparam != -1) {
+    Params_table.param[iparam].ptr = ptr;
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+void Update_IOType_param_ptrs(int num) {
+  int          i;
+  IOdef_entry *io;
+
+  for(i = 0; i < num; i++) {
+    io = &(IOTypes_table.io_def[i]);
+    update_param_ptr(io->freq_param_handle, (void *)&(io->frequency));
+    update_param_ptr(io->comp_param_handle, (void *)&(io->compression));
+    update_param_ptr(io->window_param_handle, (void *)&(io->window));
+    update_param_ptr(io->comp_ratio_param_handle,
+		     (void *)&(io->comp_ratio));
+    update_param_ptr(io->comp_time_param_handle, (void *)&(io->comp_time));
+    update_param_ptr(io->lossy_saved_param_handle,
+		     (void *)&(io->lossy_bytes_saved));
+    update_param_ptr(io->lossy_err_param_handle,
+		     (void *)&(io->lossy_max_error));
+  }
+}
+
+/*----------------------------------------------------------------*/
+
 int Disable_IOType(int IOType){
 
   int index;
@@ -814,10 +1040,15 @@ int Disable_IOType(int IOType){
   }
 
   if(IOTypes_table.io_def[index].is_enabled == REG_TRUE) {
+    Async_emit_lock();
     status = Disable_IOType_impl(index);
 
     IOTypes_table.io_def[index].is_enabled = REG_FALSE;
 
+    /* Let another IOType have the buffers while this one is idle */
+    Release_IOdef_entry_buffers(&(IOTypes_table.io_def[index]));
+    Async_emit_unlock();
+
     /* If this is an output IOType then destroying the socket
        changes the listening port and so we have to reset its IOType
        definition. */
@@ -875,9 +1106,12 @@ int Enable_IOType(int IOType) {
   }
 
   if(IOTypes_table.io_def[index].is_enabled == REG_FALSE) {
+    Async_emit_lock();
     status = Enable_IOType_impl(index);
 
     IOTypes_table.io_def[index].is_enabled = REG_TRUE;
+    IOTypes_table.io_def[index].ack_needed = REG_FALSE;
+    Async_emit_unlock();
 
     /* If this is an output IOType then creating the socket
        changes the listening port and so we have to reset its IOType
@@ -886,8 +1120,6 @@ int Enable_IOType(int IOType) {
        IOTypes_table.io_def[index].direction == REG_IO_OUT) {
       Emit_IOType_defs();
     }
-
-    IOTypes_table.io_def[index].ack_needed = REG_FALSE;
   }
 #ifdef REG_DEBUG
   else {
@@ -961,154 +1193,943 @@ int Disable_IOType_acks(int IOType) {
 
 /*----------------------------------------------------------------*/
 
-int Set_f90_array_ordering(int IOTypeIndex, int flag) {
+int Get_IOType_slice_counts(int  IOType,
+			    int *NumNativeSlices,
+			    int *NumXDRSlices) {
+
+  int index;
+
+  *NumNativeSlices = 0;
+  *NumXDRSlices = 0;
 
   /* Check that steering is enabled */
   if(!ReG_SteeringEnabled) return REG_SUCCESS;
 
   /* Can only call this function if steering lib initialised */
-  if(!ReG_SteeringInit) return REG_FAILURE;
+  if(!ReG_SteeringInit) {
+    fprintf(stderr, "STEER: ERROR: Get_IOType_slice_counts: "
+	    "steering library not initialised\n");
+    return REG_FAILURE;
+  }
 
-  if(IOTypeIndex < 0) {
-    fprintf(stderr, "STEER: Set_f90_array_ordering: IOTypeIndex is < 0\n");
+  /* Find corresponding entry in table of IOtypes */
+  index = IOdef_index_from_handle(&IOTypes_table, IOType);
+  if(index == REG_IODEF_HANDLE_NOTSET) {
+    fprintf(stderr, "STEER: ERROR: Get_IOType_slice_counts: "
+	    "failed to find matching IOType\n");
     return REG_FAILURE;
   }
 
-  IOTypes_table.io_def[IOTypeIndex].array.is_f90 = flag;
+  *NumNativeSlices = IOTypes_table.io_def[index].num_native_slices;
+  *NumXDRSlices = IOTypes_table.io_def[index].num_xdr_slices;
 
   return REG_SUCCESS;
 }
 
 /*----------------------------------------------------------------*/
 
-int Called_from_f90(int flag) {
+int Get_IOType_emit_stats(int  IOType,
+			  int *NumSamples,
+			  int *NumSyscalls) {
 
-  if(flag == REG_TRUE) {
-    ReG_CalledFromF90 = REG_TRUE;
-  }
-  else if(flag == REG_FALSE) {
-    ReG_CalledFromF90 = REG_FALSE;
+  int index;
+
+  *NumSamples = 0;
+  *NumSyscalls = 0;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) {
+    fprintf(stderr, "STEER: ERROR: Get_IOType_emit_stats: "
+	    "steering library not initialised\n");
+    return REG_FAILURE;
   }
-  else {
-    fprintf(stderr, "STEER: Called_from_f90: flag is neither REG_TRUE or REG_FALSE\n");
+
+  /* Find corresponding entry in table of IOtypes */
+  index = IOdef_index_from_handle(&IOTypes_table, IOType);
+  if(index == REG_IODEF_HANDLE_NOTSET) {
+    fprintf(stderr, "STEER: ERROR: Get_IOType_emit_stats: "
+	    "failed to find matching IOType\n");
     return REG_FAILURE;
   }
 
+  *NumSamples = IOTypes_table.io_def[index].num_samples_emitted;
+  *NumSyscalls = IOTypes_table.io_def[index].num_emit_syscalls;
+
   return REG_SUCCESS;
 }
 
 /*----------------------------------------------------------------*/
 
-int Register_ChkTypes(const int    NumTypes,
-		      char** ChkLabel,
-		      int*   direction,
-		      int*   ChkFrequency,
-		      int*   ChkType)
-{
-  int 	       i;
-  int          return_status = REG_SUCCESS;
+int Enable_IOType_async(int IOType,
+			int Policy) {
+
+  int index;
 
   /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
 
-  if(!ReG_SteeringEnabled) {
-    for(i=0; i<NumTypes; i++){
-      ChkType[i] = REG_IODEF_HANDLE_NOTSET;
-    }
-    return REG_SUCCESS;
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) {
+    fprintf(stderr, "STEER: ERROR: Enable_IOType_async: "
+	    "steering library not initialised\n");
+    return REG_FAILURE;
   }
 
-  /* Can only call this function if steering lib initialised */
+  /* Find corresponding entry in table of IOtypes */
+  index = IOdef_index_from_handle(&IOTypes_table, IOType);
+  if(index == REG_IODEF_HANDLE_NOTSET) {
+    fprintf(stderr, "STEER: ERROR: Enable_IOType_async: "
+	    "failed to find matching IOType\n");
+    return REG_FAILURE;
+  }
 
-  if(!ReG_SteeringInit) return REG_FAILURE;
+  if(IOTypes_table.io_def[index].direction == REG_IO_IN) {
+    fprintf(stderr, "STEER: ERROR: Enable_IOType_async: IOType with "
+	    "index %d has direction REG_IO_IN\n", index);
+    return REG_FAILURE;
+  }
 
-  for(i = 0; i < NumTypes; i++) {
-    if(Register_ChkType(ChkLabel[i],
-			direction[i],
-			ChkFrequency[i],
-			&(ChkType[i])) != REG_SUCCESS) {
-      return_status = REG_FAILURE;
-    }
-  } /* End of loop over Chk types to register */
+  if(Policy != REG_ASYNC_BLOCK && Policy != REG_ASYNC_DROP &&
+     Policy != REG_ASYNC_OVERWRITE) {
+    fprintf(stderr, "STEER: ERROR: Enable_IOType_async: "
+	    "unrecognised policy %d\n", Policy);
+    return REG_FAILURE;
+  }
 
-  return return_status;
+  if(Async_emit_enable(index, Policy) != REG_SUCCESS) {
+    return REG_FAILURE;
+  }
+
+  IOTypes_table.io_def[index].is_async = REG_TRUE;
+
+  return REG_SUCCESS;
 }
 
 /*----------------------------------------------------------------*/
 
-int Register_ChkType(const char* ChkLabel,
-		     const int         direction,
-		     const int         ChkFrequency,
-		     int*        ChkType)
-{
-  int current;
-  int iparam;
-  int new_size;
-  IOdef_entry* dum_ptr;
+int Disable_IOType_async(int IOType) {
+
+  int index;
 
   /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
 
-  if(!ReG_SteeringEnabled) {
-    *ChkType = REG_IODEF_HANDLE_NOTSET;
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) {
+    fprintf(stderr, "STEER: ERROR: Disable_IOType_async: "
+	    "steering library not initialised\n");
+    return REG_FAILURE;
+  }
+
+  /* Find corresponding entry in table of IOtypes */
+  index = IOdef_index_from_handle(&IOTypes_table, IOType);
+  if(index == REG_IODEF_HANDLE_NOTSET) {
+    fprintf(stderr, "STEER: ERROR: Disable_IOType_async: "
+	    "failed to find matching IOType\n");
+    return REG_FAILURE;
+  }
+
+  if(IOTypes_table.io_def[index].is_async == REG_FALSE) {
     return REG_SUCCESS;
   }
 
-  /* Can only call this function if steering lib initialised */
+  /* Stop taking snapshots before draining the queue */
+  IOTypes_table.io_def[index].is_async = REG_FALSE;
 
-  if(!ReG_SteeringInit) return REG_FAILURE;
+  return Async_emit_disable(index);
+}
 
-  /* Chk types cannot be deleted so is safe to use num_registered to
-     get next free entry */
-  current = ChkTypes_table.num_registered;
+/*----------------------------------------------------------------*/
 
-  if(String_contains_xml_chars(ChkLabel) == REG_TRUE) {
-    fprintf(stderr, "STEER: ERROR: Register_ChkType: Chk label contains "
-	    "reserved xml characters (<,>,&): %s\n", ChkLabel);
+int Set_IOType_compression(int IOType,
+			   int Codec) {
+
+  int index;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_compression: "
+	    "steering library not initialised\n");
     return REG_FAILURE;
   }
 
-  strcpy(ChkTypes_table.io_def[current].label, ChkLabel);
+  /* Find corresponding entry in table of IOtypes */
+  index = IOdef_index_from_handle(&IOTypes_table, IOType);
+  if(index == REG_IODEF_HANDLE_NOTSET) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_compression: "
+	    "failed to find matching IOType\n");
+    return REG_FAILURE;
+  }
 
-  /* filename not used currently */
-/*   sprintf(ChkTypes_table.io_def[current].filename, "NOT_SET"); */
+  if(IOTypes_table.io_def[index].direction == REG_IO_IN) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_compression: IOType with "
+	    "index %d has direction REG_IO_IN\n", index);
+    return REG_FAILURE;
+  }
 
-  /* Whether input or output */
-  ChkTypes_table.io_def[current].direction = direction;
+  if(!Compress_codec_supported(Codec)) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_compression: "
+	    "unsupported codec %d\n", Codec);
+    return REG_FAILURE;
+  }
 
-  /* Set variables required for registration of associated io
-     frequency as a steerable parameter (but only if checkpoint is
-     to be emitted) */
-  if(direction != REG_IO_IN) {
-    /* Set variables required for registration of associated io
-       frequency as a steerable parameter */
+  IOTypes_table.io_def[index].compression = Codec;
 
-    ChkTypes_table.io_def[current].frequency = ChkFrequency;
+  return REG_SUCCESS;
+}
+/*----------------------------------------------------------------*/
 
-    Register_param("Chk_Frequency",
-		   REG_TRUE,
-		   (void *)&(ChkTypes_table.io_def[current].frequency),
-		   REG_INT,
-		   "0", " ");
+int Set_IOType_lossy(int    IOType,
+		     int    Mode,
+		     int    BoundType,
+		     double Bound) {
 
-    /* Store the handle given to this parameter - this line MUST
-       immediately succeed the call to Register_params */
+  int index;
 
-    ChkTypes_table.io_def[current].freq_param_handle =
-	                               Params_table.next_handle - 1;
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
 
-    /* Annotate the parameter table entry just created to flag that
-       it is a parameter that is internal to the steering library */
-    iparam = Param_index_from_handle(&Params_table,
-			  ChkTypes_table.io_def[current].freq_param_handle);
-    if(iparam != -1) {
-      Params_table.param[iparam].is_internal = REG_TRUE;
-    }
-    else {
-#ifdef REG_DEBUG
-      fprintf(stderr, "STEER: Register_ChkType: failed to get handle for param\n");
-#endif
-      *ChkType = REG_IODEF_HANDLE_NOTSET;
-      return REG_FAILURE;
-    }
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_lossy: "
+	    "steering library not initialised\n");
+    return REG_FAILURE;
+  }
+
+  /* Find corresponding entry in table of IOtypes */
+  index = IOdef_index_from_handle(&IOTypes_table, IOType);
+  if(index == REG_IODEF_HANDLE_NOTSET) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_lossy: "
+	    "failed to find matching IOType\n");
+    return REG_FAILURE;
+  }
+
+  if(IOTypes_table.io_def[index].direction == REG_IO_IN) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_lossy: IOType with "
+	    "index %d has direction REG_IO_IN\n", index);
+    return REG_FAILURE;
+  }
+
+  if(Mode < REG_LOSSY_NONE || Mode > REG_LOSSY_MAX) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_lossy: "
+	    "unrecognised mode %d\n", Mode);
+    return REG_FAILURE;
+  }
+
+  if(Mode != REG_LOSSY_NONE &&
+     ((BoundType != REG_ERROR_ABS && BoundType != REG_ERROR_REL) ||
+      !(Bound > 0.0))) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_lossy: error bound must "
+	    "be REG_ERROR_ABS or REG_ERROR_REL and greater than zero\n");
+    return REG_FAILURE;
+  }
+
+  /* The I/O thread sizes its buffers from these */
+  Async_emit_lock();
+  IOTypes_table.io_def[index].lossy_mode = Mode;
+  IOTypes_table.io_def[index].lossy_bound_type = BoundType;
+  IOTypes_table.io_def[index].lossy_bound = Bound;
+  Async_emit_unlock();
+
+  return REG_SUCCESS;
+}
+/*----------------------------------------------------------------*/
+
+int Set_IOType_delta(int IOType,
+		     int KeyInterval) {
+
+  int index;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_delta: "
+	    "steering library not initialised\n");
+    return REG_FAILURE;
+  }
+
+  /* Find corresponding entry in table of IOtypes */
+  index = IOdef_index_from_handle(&IOTypes_table, IOType);
+  if(index == REG_IODEF_HANDLE_NOTSET) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_delta: "
+	    "failed to find matching IOType\n");
+    return REG_FAILURE;
+  }
+
+  if(IOTypes_table.io_def[index].direction == REG_IO_IN) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_delta: IOType with "
+	    "index %d has direction REG_IO_IN\n", index);
+    return REG_FAILURE;
+  }
+
+  if(KeyInterval < 0) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_delta: key frame "
+	    "interval must not be negative\n");
+    return REG_FAILURE;
+  }
+
+  /* The I/O thread sizes its buffers from these.  Start again with a
+     key frame whatever the old interval was */
+  Async_emit_lock();
+  IOTypes_table.io_def[index].delta_interval = KeyInterval;
+  IOTypes_table.io_def[index].delta_key_needed = REG_TRUE;
+  Async_emit_unlock();
+
+  return REG_SUCCESS;
+}
+/*----------------------------------------------------------------*/
+
+int Set_IOType_max_consumers(int IOType,
+			     int MaxConsumers) {
+
+  int index;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_max_consumers: "
+	    "steering library not initialised\n");
+    return REG_FAILURE;
+  }
+
+  /* Find corresponding entry in table of IOtypes */
+  index = IOdef_index_from_handle(&IOTypes_table, IOType);
+  if(index == REG_IODEF_HANDLE_NOTSET) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_max_consumers: "
+	    "failed to find matching IOType\n");
+    return REG_FAILURE;
+  }
+
+  if(IOTypes_table.io_def[index].direction == REG_IO_IN) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_max_consumers: IOType "
+	    "with index %d has direction REG_IO_IN\n", index);
+    return REG_FAILURE;
+  }
+
+  if(MaxConsumers < 1) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_max_consumers: must "
+	    "allow at least one consumer\n");
+    return REG_FAILURE;
+  }
+
+  /* The I/O thread may be accepting consumers */
+  Async_emit_lock();
+  IOTypes_table.io_def[index].max_consumers = MaxConsumers;
+  Async_emit_unlock();
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Get_IOType_consumer_stats(int     IOType,
+			      int     Consumer,
+			      int    *NumConsumers,
+			      double *NumBytes,
+			      double *BytesPerSec,
+			      int    *NumSamples,
+			      int    *NumSkipped) {
+
+  Consumer_stats_type *stats;
+  double               now;
+  int                  index;
+
+  *NumConsumers = 0;
+  *NumBytes = 0.0;
+  *BytesPerSec = 0.0;
+  *NumSamples = 0;
+  *NumSkipped = 0;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) {
+    fprintf(stderr, "STEER: ERROR: Get_IOType_consumer_stats: "
+	    "steering library not initialised\n");
+    return REG_FAILURE;
+  }
+
+  /* Find corresponding entry in table of IOtypes */
+  index = IOdef_index_from_handle(&IOTypes_table, IOType);
+  if(index == REG_IODEF_HANDLE_NOTSET) {
+    fprintf(stderr, "STEER: ERROR: Get_IOType_consumer_stats: "
+	    "failed to find matching IOType\n");
+    return REG_FAILURE;
+  }
+
+  Get_current_time_seconds(&now);
+
+  /* Consumers come and go as the I/O thread sends samples */
+  Async_emit_lock();
+  *NumConsumers = IOTypes_table.io_def[index].num_consumers;
+  if(Consumer >= 0 && Consumer < *NumConsumers) {
+    stats = &(IOTypes_table.io_def[index].consumers[Consumer]);
+    *NumBytes = stats->num_bytes;
+    if(now > stats->connect_time) {
+      *BytesPerSec = stats->num_bytes/(now - stats->connect_time);
+    }
+    *NumSamples = stats->num_samples;
+    *NumSkipped = stats->num_skipped;
+  }
+  Async_emit_unlock();
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Set_IOType_streams(int IOType,
+		       int NumStreams) {
+
+  int index;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_streams: "
+	    "steering library not initialised\n");
+    return REG_FAILURE;
+  }
+
+  /* Find corresponding entry in table of IOtypes */
+  index = IOdef_index_from_handle(&IOTypes_table, IOType);
+  if(index == REG_IODEF_HANDLE_NOTSET) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_streams: "
+	    "failed to find matching IOType\n");
+    return REG_FAILURE;
+  }
+
+  if(NumStreams < 1 || NumStreams > REG_MAX_STREAMS) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_streams: no. of "
+	    "streams must be between 1 and %d\n", REG_MAX_STREAMS);
+    return REG_FAILURE;
+  }
+
+  /* The I/O thread may be part-way through a sample */
+  Async_emit_lock();
+  IOTypes_table.io_def[index].num_streams = NumStreams;
+  Async_emit_unlock();
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Set_IOType_checksum(int IOType,
+			int Checksum) {
+
+  int index;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_checksum: "
+	    "steering library not initialised\n");
+    return REG_FAILURE;
+  }
+
+  /* Find corresponding entry in table of IOtypes */
+  index = IOdef_index_from_handle(&IOTypes_table, IOType);
+  if(index == REG_IODEF_HANDLE_NOTSET) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_checksum: "
+	    "failed to find matching IOType\n");
+    return REG_FAILURE;
+  }
+
+  if(IOTypes_table.io_def[index].direction == REG_IO_IN) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_checksum: IOType with "
+	    "index %d has direction REG_IO_IN\n", index);
+    return REG_FAILURE;
+  }
+
+  /* The I/O thread may be part-way through a sample */
+  Async_emit_lock();
+  IOTypes_table.io_def[index].frame_checksum =
+    Checksum ? REG_TRUE : REG_FALSE;
+  Async_emit_unlock();
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Set_IOType_region(int IOType,
+		      int Sx,      int Sy,      int Sz,
+		      int Nx,      int Ny,      int Nz,
+		      int StrideX, int StrideY, int StrideZ) {
+
+  IOdef_entry *io;
+  int          index;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_region: "
+	    "steering library not initialised\n");
+    return REG_FAILURE;
+  }
+
+  /* Find corresponding entry in table of IOtypes */
+  index = IOdef_index_from_handle(&IOTypes_table, IOType);
+  if(index == REG_IODEF_HANDLE_NOTSET) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_region: "
+	    "failed to find matching IOType\n");
+    return REG_FAILURE;
+  }
+  io = &(IOTypes_table.io_def[index]);
+
+  if(io->direction == REG_IO_OUT) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_region: IOType with "
+	    "index %d has direction REG_IO_OUT\n", index);
+    return REG_FAILURE;
+  }
+
+  if(Sx < 0 || Sy < 0 || Sz < 0 || Nx < 0 || Ny < 0 || Nz < 0 ||
+     StrideX < 1 || StrideY < 1 || StrideZ < 1) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_region: origin and "
+	    "extent must not be negative and strides must be at "
+	    "least one\n");
+    return REG_FAILURE;
+  }
+
+  io->region.sx = Sx;
+  io->region.sy = Sy;
+  io->region.sz = Sz;
+  io->region.nx = Nx;
+  io->region.ny = Ny;
+  io->region.nz = Nz;
+  io->region.dx = StrideX;
+  io->region.dy = StrideY;
+  io->region.dz = StrideZ;
+
+  /* The whole array needs no region */
+  io->use_region = (Sx || Sy || Sz || Nx || Ny || Nz || StrideX > 1 ||
+		    StrideY > 1 || StrideZ > 1) ? REG_TRUE : REG_FALSE;
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Set_IOType_levels(int IOType,
+		      int NumLevels) {
+
+  int index;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_levels: "
+	    "steering library not initialised\n");
+    return REG_FAILURE;
+  }
+
+  /* Find corresponding entry in table of IOtypes */
+  index = IOdef_index_from_handle(&IOTypes_table, IOType);
+  if(index == REG_IODEF_HANDLE_NOTSET) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_levels: "
+	    "failed to find matching IOType\n");
+    return REG_FAILURE;
+  }
+
+  if(IOTypes_table.io_def[index].direction == REG_IO_IN) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_levels: IOType with "
+	    "index %d has direction REG_IO_IN\n", index);
+    return REG_FAILURE;
+  }
+
+  if(NumLevels < 1 || NumLevels > REG_MAX_LEVELS) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_levels: no. of levels "
+	    "must be between 1 and %d\n", REG_MAX_LEVELS);
+    return REG_FAILURE;
+  }
+
+  /* The I/O thread may be part-way through a sample */
+  Async_emit_lock();
+  IOTypes_table.io_def[index].num_levels = NumLevels;
+  Async_emit_unlock();
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Set_IOType_window(int IOType,
+		      int NumSamples) {
+
+  int index;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_window: "
+	    "steering library not initialised\n");
+    return REG_FAILURE;
+  }
+
+  /* Find corresponding entry in table of IOtypes */
+  index = IOdef_index_from_handle(&IOTypes_table, IOType);
+  if(index == REG_IODEF_HANDLE_NOTSET) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_window: "
+	    "failed to find matching IOType\n");
+    return REG_FAILURE;
+  }
+
+  if(IOTypes_table.io_def[index].direction != REG_IO_IN) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_window: IOType with "
+	    "index %d does not have direction REG_IO_IN\n", index);
+    return REG_FAILURE;
+  }
+
+  if(NumSamples < 1 || NumSamples > REG_MAX_WINDOW) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_window: no. of samples "
+	    "must be between 1 and %d\n", REG_MAX_WINDOW);
+    return REG_FAILURE;
+  }
+
+  /* Goes to the emitter with our next acknowledgement */
+  IOTypes_table.io_def[index].window = NumSamples;
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Set_IOType_buffer_limit(int    IOType,
+			    double MaxBytes) {
+
+  int index;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_buffer_limit: "
+	    "steering library not initialised\n");
+    return REG_FAILURE;
+  }
+
+  /* Find corresponding entry in table of IOtypes */
+  index = IOdef_index_from_handle(&IOTypes_table, IOType);
+  if(index == REG_IODEF_HANDLE_NOTSET) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_buffer_limit: "
+	    "failed to find matching IOType\n");
+    return REG_FAILURE;
+  }
+
+  if(MaxBytes < 0.0) {
+    fprintf(stderr, "STEER: ERROR: Set_IOType_buffer_limit: limit "
+	    "must not be negative\n");
+    return REG_FAILURE;
+  }
+
+  /* The I/O thread may be growing the buffers */
+  Async_emit_lock();
+  IOTypes_table.io_def[index].buffer_limit = (size_t)MaxBytes;
+  Async_emit_unlock();
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Get_IOType_buffer_stats(int     IOType,
+			    double *HeldBytes,
+			    double *HighWater) {
+
+  int index;
+
+  *HeldBytes = 0.0;
+  *HighWater = 0.0;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) {
+    fprintf(stderr, "STEER: ERROR: Get_IOType_buffer_stats: "
+	    "steering library not initialised\n");
+    return REG_FAILURE;
+  }
+
+  /* Find corresponding entry in table of IOtypes */
+  index = IOdef_index_from_handle(&IOTypes_table, IOType);
+  if(index == REG_IODEF_HANDLE_NOTSET) {
+    fprintf(stderr, "STEER: ERROR: Get_IOType_buffer_stats: "
+	    "failed to find matching IOType\n");
+    return REG_FAILURE;
+  }
+
+  Async_emit_lock();
+  *HeldBytes = (double)IOTypes_table.io_def[index].buffer_held_bytes;
+  *HighWater = (double)IOTypes_table.io_def[index].buffer_high_water;
+  Async_emit_unlock();
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Get_IOType_write_stats(int     IOType,
+			   double *QueuedBytes,
+			   double *HighWater,
+			   double *MeanSeconds,
+			   double *MaxSeconds,
+			   int    *NumStalls) {
+
+  IOdef_entry *io;
+  int          index;
+
+  *QueuedBytes = 0.0;
+  *HighWater = 0.0;
+  *MeanSeconds = 0.0;
+  *MaxSeconds = 0.0;
+  *NumStalls = 0;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) {
+    fprintf(stderr, "STEER: ERROR: Get_IOType_write_stats: "
+	    "steering library not initialised\n");
+    return REG_FAILURE;
+  }
+
+  /* Find corresponding entry in table of IOtypes */
+  index = IOdef_index_from_handle(&IOTypes_table, IOType);
+  if(index == REG_IODEF_HANDLE_NOTSET) {
+    fprintf(stderr, "STEER: ERROR: Get_IOType_write_stats: "
+	    "failed to find matching IOType\n");
+    return REG_FAILURE;
+  }
+
+  /* Updated by Emit_stop(), which may be called by the I/O thread */
+  Async_emit_lock();
+  io = &(IOTypes_table.io_def[index]);
+  *QueuedBytes = io->write_queue_bytes;
+  *HighWater = io->write_queue_high;
+  if(io->num_writes > 0) {
+    *MeanSeconds = io->write_seconds/(double)io->num_writes;
+  }
+  *MaxSeconds = io->max_write_seconds;
+  *NumStalls = io->num_write_stalls;
+  Async_emit_unlock();
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Set_async_emit_cpu(int Cpu) {
+
+  return Async_emit_set_cpu(Cpu);
+}
+
+/*----------------------------------------------------------------*/
+
+int Get_IOType_async_stats(int  IOType,
+			   int *NumDropped,
+			   int *NumOverwritten) {
+
+  int index;
+
+  *NumDropped = 0;
+  *NumOverwritten = 0;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) {
+    fprintf(stderr, "STEER: ERROR: Get_IOType_async_stats: "
+	    "steering library not initialised\n");
+    return REG_FAILURE;
+  }
+
+  /* Find corresponding entry in table of IOtypes */
+  index = IOdef_index_from_handle(&IOTypes_table, IOType);
+  if(index == REG_IODEF_HANDLE_NOTSET) {
+    fprintf(stderr, "STEER: ERROR: Get_IOType_async_stats: "
+	    "failed to find matching IOType\n");
+    return REG_FAILURE;
+  }
+
+  return Async_emit_stats(index, NumDropped, NumOverwritten);
+}
+
+/*----------------------------------------------------------------*/
+
+int Set_f90_array_ordering(int IOTypeIndex, int flag) {
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) return REG_FAILURE;
+
+  if(IOTypeIndex < 0) {
+    fprintf(stderr, "STEER: Set_f90_array_ordering: IOTypeIndex is < 0\n");
+    return REG_FAILURE;
+  }
+
+  IOTypes_table.io_def[IOTypeIndex].array.is_f90 = flag;
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Called_from_f90(int flag) {
+
+  if(flag == REG_TRUE) {
+    ReG_CalledFromF90 = REG_TRUE;
+  }
+  else if(flag == REG_FALSE) {
+    ReG_CalledFromF90 = REG_FALSE;
+  }
+  else {
+    fprintf(stderr, "STEER: Called_from_f90: flag is neither REG_TRUE or REG_FALSE\n");
+    return REG_FAILURE;
+  }
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Register_ChkTypes(const int    NumTypes,
+		      char** ChkLabel,
+		      int*   direction,
+		      int*   ChkFrequency,
+		      int*   ChkType)
+{
+  int 	       i;
+  int          return_status = REG_SUCCESS;
+
+  /* Check that steering is enabled */
+
+  if(!ReG_SteeringEnabled) {
+    for(i=0; i<NumTypes; i++){
+      ChkType[i] = REG_IODEF_HANDLE_NOTSET;
+    }
+    return REG_SUCCESS;
+  }
+
+  /* Can only call this function if steering lib initialised */
+
+  if(!ReG_SteeringInit) return REG_FAILURE;
+
+  for(i = 0; i < NumTypes; i++) {
+    if(Register_ChkType(ChkLabel[i],
+			direction[i],
+			ChkFrequency[i],
+			&(ChkType[i])) != REG_SUCCESS) {
+      return_status = REG_FAILURE;
+    }
+  } /* End of loop over Chk types to register */
+
+  return return_status;
+}
+
+/*----------------------------------------------------------------*/
+
+int Register_ChkType(const char* ChkLabel,
+		     const int         direction,
+		     const int         ChkFrequency,
+		     int*        ChkType)
+{
+  int current;
+  int iparam;
+  int new_size;
+  IOdef_entry* dum_ptr;
+
+  /* Check that steering is enabled */
+
+  if(!ReG_SteeringEnabled) {
+    *ChkType = REG_IODEF_HANDLE_NOTSET;
+    return REG_SUCCESS;
+  }
+
+  /* Can only call this function if steering lib initialised */
+
+  if(!ReG_SteeringInit) return REG_FAILURE;
+
+  /* Chk types cannot be deleted so is safe to use num_registered to
+     get next free entry */
+  current = ChkTypes_table.num_registered;
+
+  if(String_contains_xml_chars(ChkLabel) == REG_TRUE) {
+    fprintf(stderr, "STEER: ERROR: Register_ChkType: Chk label contains "
+	    "reserved xml characters (<,>,&): %s\n", ChkLabel);
+    return REG_FAILURE;
+  }
+
+  strcpy(ChkTypes_table.io_def[current].label, ChkLabel);
+
+  /* filename not used currently */
+/*   sprintf(ChkTypes_table.io_def[current].filename, "NOT_SET"); */
+
+  /* Whether input or output */
+  ChkTypes_table.io_def[current].direction = direction;
+
+  /* Set variables required for registration of associated io
+     frequency as a steerable parameter (but only if checkpoint is
+     to be emitted) */
+  if(direction != REG_IO_IN) {
+    /* Set variables required for registration of associated io
+       frequency as a steerable parameter */
+
+    ChkTypes_table.io_def[current].frequency = ChkFrequency;
+
+    Register_param("Chk_Frequency",
+		   REG_TRUE,
+		   (void *)&(ChkTypes_table.io_def[current].frequency),
+		   REG_INT,
+		   "0", " ");
+
+    /* Store the handle given to this parameter - this line MUST
+       immediately succeed the call to Register_params */
+
+    ChkTypes_table.io_def[current].freq_param_handle =
+	                               Params_table.next_handle - 1;
+
+    /* Annotate the parameter table entry just created to flag that
+       it is a parameter that is internal to the steering library */
+    iparam = Param_index_from_handle(&Params_table,
+			  ChkTypes_table.io_def[current].freq_param_handle);
+    if(iparam != -1) {
+      Params_table.param[iparam].is_internal = REG_TRUE;
+    }
+    else {
+#ifdef REG_DEBUG
+      fprintf(stderr, "STEER: Register_ChkType: failed to get handle for param\n");
+#endif
+      *ChkType = REG_IODEF_HANDLE_NOTSET;
+      return REG_FAILURE;
+    }
   }
   else {
     /* Auto consume is senseless for checkpoints so set frequency-related
@@ -1117,200 +2138,1422 @@ int Register_ChkType(const char* ChkLabel,
     ChkTypes_table.io_def[current].frequency = 0;
   }
 
-  /* Set-up buffer used to store checkpoint filenames */
-  ChkTypes_table.io_def[current].buffer = NULL;
-  ChkTypes_table.io_def[current].buffer_bytes = 0;
-  ChkTypes_table.io_def[current].buffer_max_bytes = 0;
+  /* Set-up buffer used to store checkpoint filenames */
+  ChkTypes_table.io_def[current].buffer = NULL;
+  ChkTypes_table.io_def[current].buffer_bytes = 0;
+  ChkTypes_table.io_def[current].buffer_max_bytes = 0;
+  ChkTypes_table.io_def[current].comp_buffer = NULL;
+  ChkTypes_table.io_def[current].comp_buffer_max_bytes = 0;
+  ChkTypes_table.io_def[current].slice_buffer = NULL;
+  ChkTypes_table.io_def[current].slice_buffer_max_bytes = 0;
+  ChkTypes_table.io_def[current].level_buffer = NULL;
+  ChkTypes_table.io_def[current].level_buffer_max_bytes = 0;
+  ChkTypes_table.io_def[current].buffer_held_bytes = 0;
+  ChkTypes_table.io_def[current].buffer_high_water = 0;
+  ChkTypes_table.io_def[current].buffer_limit = 0;
+
+  /* Create, store and return a handle for this ChkType */
+  ChkTypes_table.io_def[current].handle = Next_IO_Chk_handle++;
+  *ChkType = ChkTypes_table.io_def[current].handle;
+
+  /* Check whether we need to allocate more storage */
+  current++;
+  if(current == ChkTypes_table.max_entries) {
+    new_size = ChkTypes_table.max_entries + REG_INITIAL_NUM_IOTYPES;
+
+    dum_ptr = (IOdef_entry*)realloc((void *)(ChkTypes_table.io_def),
+		                    new_size*sizeof(IOdef_entry));
+
+    if(dum_ptr == NULL) {
+      fprintf(stderr, "STEER: Register_ChkType: failed to allocate memory\n");
+      return REG_FAILURE;
+    }
+    else {
+
+      ChkTypes_table.io_def = dum_ptr;
+    }
+
+    ChkTypes_table.max_entries += REG_INITIAL_NUM_IOTYPES;
+  }
+
+  ChkTypes_table.num_registered = current;
+
+  /* Flag that the registered Chk Types have changed */
+  ReG_ChkTypesChanged = REG_TRUE;
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Record_Chkpt(int   ChkType,
+		 char *ChkTag)
+{
+  int    index;
+  int    count;
+  time_t time_now;
+  char   *pchar;
+
+  /* Can only call this function if steering lib initialised */
+
+  if(!ReG_SteeringInit) return REG_FAILURE;
+
+  if(ChkType == REG_IODEF_HANDLE_NOTSET) return REG_SUCCESS;
+
+  /* Check that we have enough storage space - if not then store
+     current entries on disk (rather than continually grab more
+     memory) */
+
+  if(Chk_log.num_entries == Chk_log.max_entries) {
+    /* Save_log also resets Chk_log.num_entries to zero */
+    if(Save_log(&Chk_log) != REG_SUCCESS) {
+      fprintf(stderr, "STEER: Record_Chkpt: Save_log failed\n");
+      return REG_FAILURE;
+    }
+  }
+
+  Chk_log.entry[Chk_log.num_entries].key = Chk_log.primary_key_value++;
+  strcpy(Chk_log.entry[Chk_log.num_entries].chk_tag, ChkTag);
+  Chk_log.entry[Chk_log.num_entries].chk_handle      = ChkType;
+  Chk_log.entry[Chk_log.num_entries].sent_to_steerer = REG_FALSE;
+
+  /* Store the values of all registered parameters at this point (so
+     long as they're not internal to the library) */
+  count = 0;
+  for(index = 0; index<Params_table.max_entries; index++) {
+    if(Params_table.param[index].handle == REG_PARAM_HANDLE_NOTSET ||
+       Params_table.param[index].is_internal == REG_TRUE) {
+
+      /* Time stamp is a special case - is internal but we do want
+	 it for checkpoint records */
+      if(Params_table.param[index].handle != REG_TIMESTAMP_HANDLE) {
+	continue;
+      }
+      else {
+	/* Get timestamp */
+	if((int)(time_now = time(NULL)) != -1) {
+	  pchar = ctime(&time_now);
+	  strcpy(Params_table.param[index].value, pchar);
+	  /* Remove new-line character */
+          Params_table.param[index].value[strlen(pchar)-1] = '\0';
+	}
+	else {
+	  strcpy(Params_table.param[index].value, "");
+	}
+      }
+    }
+
+    /* Don't include raw binary parameters in the log */
+    if(Params_table.param[index].type == REG_BIN) continue;
+
+    /* This is one we want - store its handle and current value */
+    Chk_log.entry[Chk_log.num_entries].param[count].handle =
+                                           Params_table.param[index].handle;
+
+    /* Update value associated with pointer */
+    Get_ptr_value(&(Params_table.param[index]));
+
+    /* Save this value */
+    strcpy(Chk_log.entry[Chk_log.num_entries].param[count].value,
+           Params_table.param[index].value);
+
+    /* Storage for params associated with log entry is static */
+    if(++count >= REG_MAX_NUM_STR_PARAMS) break;
+  }
+
+  /* Store the no. of params this entry has */
+  Chk_log.entry[Chk_log.num_entries].num_param = count;
+
+  /* Keep a count of entries that we have yet to send to steerer */
+  Chk_log.num_unsent++;
+
+  Chk_log.num_entries++;
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Record_checkpoint_set(int ChkType, char* ChkTag, char* Path) {
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit)
+    return REG_FAILURE;
+
+  if(ChkType == REG_IODEF_HANDLE_NOTSET)
+    return REG_SUCCESS;
+
+  return Record_checkpoint_set_impl(ChkType, ChkTag, Path);
+}
+
+int Add_checkpoint_file(int   ChkType,
+			char *filename)
+{
+  int index;
+  int nbytes;
+
+  /* Can only call this function if steering lib initialised */
+  if (!ReG_SteeringInit) return REG_FAILURE;
+
+  if (ChkType == REG_IODEF_HANDLE_NOTSET) return REG_SUCCESS;
+
+  index = IOdef_index_from_handle(&ChkTypes_table, ChkType);
+
+  if (index == REG_IODEF_HANDLE_NOTSET) return REG_FAILURE;
+
+  /* Remove any trailing white space from the filename */
+  trimWhiteSpace(filename);
+
+  /* Check that it doesn't contain any spaces (since we use a space-delimited
+     list to store the filenames) */
+  if(strchr(filename, ' ')){
+
+    fprintf(stderr, "STEER: ERROR: Add_checkpoint_file - filenames must not "
+	    "contain spaces (file >>%s<<)\n", filename);
+    return REG_FAILURE;
+  }
+
+  /* Check that we have sufficient memory; +2 to allow for space delimiter
+     and terminating character */
+  nbytes = strlen(filename)+2;
+
+  if( (ChkTypes_table.io_def[index].buffer_max_bytes -
+       ChkTypes_table.io_def[index].buffer_bytes) < nbytes ){
+
+    if( Realloc_chktype_buffer(index,
+			       (ChkTypes_table.io_def[index].buffer_max_bytes +
+				56*nbytes)) != REG_SUCCESS){
+      return REG_FAILURE;
+    }
+  }
+
+  if(ChkTypes_table.io_def[index].buffer_bytes){
+
+    nbytes = sprintf( &(( (char *)(ChkTypes_table.io_def[index].buffer) )[ChkTypes_table.io_def[index].buffer_bytes - 1]),
+		      "%s ", filename);
+
+    /* Update the count of the bytes stored - unlike below don't need '+1' because
+       we've just overwritten the final '\0' character in the string */
+    ChkTypes_table.io_def[index].buffer_bytes += nbytes;
+  }
+  else{
+    nbytes = sprintf( (char *)(ChkTypes_table.io_def[index].buffer),
+		   "%s ", filename);
+    /* Update the count of the bytes stored - include the '\0' (and
+       hence the '-1' above) */
+    ChkTypes_table.io_def[index].buffer_bytes += nbytes + 1;
+  }
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Consume_start(int  IOType,
+		  int *IOTypeIndex)
+{
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) return REG_FAILURE;
+
+  /* Find corresponding entry in table of IOtypes */
+  *IOTypeIndex = IOdef_index_from_handle(&IOTypes_table, IOType);
+  if(*IOTypeIndex == REG_IODEF_HANDLE_NOTSET) {
+    fprintf(stderr, "STEER: Consume_start: failed to find matching IOType, "
+	    "handle = %d\n", IOType);
+    return REG_FAILURE;
+  }
+
+  /* Check that this IOType is enabled */
+  if(IOTypes_table.io_def[*IOTypeIndex].is_enabled == REG_FALSE) {
+    return REG_FAILURE;
+  }
+
+  /* Check that this IOType can be consumed */
+  if(IOTypes_table.io_def[*IOTypeIndex].direction == REG_IO_OUT) {
+    fprintf(stderr, "STEER: ERROR: Consume_start: IOType has direction REG_IO_OUT\n");
+    return REG_FAILURE;
+  }
+
+  if(IOTypes_table.io_def[*IOTypeIndex].ack_needed == REG_TRUE) {
+    IOTypes_table.io_def[*IOTypeIndex].ack_needed = REG_FALSE;
+    IOTypes_table.io_def[*IOTypeIndex].acks_owed++;
+
+    /* Signal that we have read this data and are ready for the next
+       set.  An emitter that takes credit is still sending, so is
+       only told every half window or so */
+    if(!IOTypes_table.io_def[*IOTypeIndex].peer_credits ||
+       IOTypes_table.io_def[*IOTypeIndex].acks_owed >=
+       (IOTypes_table.io_def[*IOTypeIndex].window + 1)/2) {
+      Emit_ack(*IOTypeIndex);
+    }
+  }
+
+  /* Initialise array-ordering flags */
+  IOTypes_table.io_def[*IOTypeIndex].convert_array_order = REG_FALSE;
+
+  /* Start the compression statistics for this sample */
+  IOTypes_table.io_def[*IOTypeIndex].comp_raw_bytes = 0.0;
+  IOTypes_table.io_def[*IOTypeIndex].comp_bytes = 0.0;
+  IOTypes_table.io_def[*IOTypeIndex].comp_time = 0.0;
+
+  /* No level of detail received yet */
+  IOTypes_table.io_def[*IOTypeIndex].level_done = -1;
+  IOTypes_table.io_def[*IOTypeIndex].level_count = 0;
+  IOTypes_table.io_def[*IOTypeIndex].level_part.num_levels = 0;
+
+  if(Consume_start_data_check(*IOTypeIndex) != REG_SUCCESS) {
+    /* We've caught up so the emitter may be waiting for credit */
+    if(IOTypes_table.io_def[*IOTypeIndex].acks_owed > 0) {
+      Emit_ack(*IOTypeIndex);
+    }
+    return REG_FAILURE;
+  }
+
+  /* Deltas in this sample apply to the slices of the last one we
+     consumed - unless we've lost track of the emitter since */
+  Consume_delta_start(*IOTypeIndex);
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    @return Wall clock time in seconds since some fixed point
+
+    Used by the blocking calls to keep track of how long they have
+    left, whether or not REG_USE_TIMING is set. */
+static double Blocking_time_now()
+{
+#ifdef _MSC_VER
+  return 0.001*(double)GetTickCount();
+#else
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return (double)(tv.tv_sec) + 1.0e-6*(double)(tv.tv_usec);
+#endif
+}
+
+/*----------------------------------------------------------------*/
+
+int Consume_start_blocking(int   IOType,
+			   int  *IOTypeIndex,
+			   float TimeOut)
+{
+  double start_time;
+  double time_left;
+  int    status;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) return REG_FAILURE;
+
+  start_time = Blocking_time_now();
+  while((status = Consume_start(IOType, IOTypeIndex)) != REG_SUCCESS) {
+    time_left = (double)TimeOut - (Blocking_time_now() - start_time);
+    if(time_left <= 0.0){
+#ifdef REG_DEBUG
+      fprintf(stderr, "STEER: Consume_start_blocking: timed out\n");
+#endif
+      status = REG_TIMED_OUT;
+      break;
+    }
+
+    /* Sleep until the transport has something for us */
+    Wait_for_IOType(*IOTypeIndex, time_left);
+  }
+
+  return status;
+}
+/*----------------------------------------------------------------*/
+
+int Consume_stop(int *IOTypeIndex)
+{
+  int return_status = REG_SUCCESS;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  /* Can only call this function if steering lib initialised */
+  if(!ReG_SteeringInit) return REG_FAILURE;
+
+  if(*IOTypeIndex < 0 || *IOTypeIndex >= IOTypes_table.num_registered) {
+    fprintf(stderr, "STEER: Consume_stop: IOType index out of range\n");
+    return REG_FAILURE;
+  }
+
+  /* Check that this IOType is enabled */
+  if(IOTypes_table.io_def[*IOTypeIndex].is_enabled == REG_FALSE) {
+    return REG_FAILURE;
+  }
+
+  /* We are no longer in the process of consuming data */
+  IOTypes_table.io_def[*IOTypeIndex].consuming = REG_FALSE;
+
+  /* Set flag that we should signal data source that we are ready for new data
+     when we next call Consume_start */
+  IOTypes_table.io_def[*IOTypeIndex].ack_needed = REG_TRUE;
+
+  /* The transport may have found that the sample was damaged */
+  if(Consume_stop_impl(*IOTypeIndex) != REG_SUCCESS) {
+    return_status = REG_FAILURE;
+  }
+
+  /* The channel's buffer is kept for the next sample and given back
+     by Disable_IOType() */
+
+  /* Reset handle associated with channel */
+  *IOTypeIndex = REG_IODEF_HANDLE_NOTSET;
+
+  return return_status;
+}
+
+/*----------------------------------------------------------------*/
+
+int Consume_data_slice_header(int  IOTypeIndex,
+			      int *DataType,
+			      int *Count)
+{
+  int status;
+  int NumBytes;
+  int IsFortranArray;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_FAILURE;
+
+  /* Check that this IOType is enabled */
+  if(IOTypes_table.io_def[IOTypeIndex].is_enabled == REG_FALSE){
+    return REG_FAILURE;
+  }
+
+  /* Text slice headers never describe compressed data */
+  IOTypes_table.io_def[IOTypeIndex].slice_codec = REG_COMPRESS_NONE;
+  IOTypes_table.io_def[IOTypeIndex].slice_raw_bytes = 0;
+  IOTypes_table.io_def[IOTypeIndex].slice_lossy_type = 0;
+  IOTypes_table.io_def[IOTypeIndex].slice_flags = 0;
+
+  status = Consume_iotype_msg_header(IOTypeIndex,
+				     DataType,
+				     Count,
+				     &NumBytes,
+				     &IsFortranArray);
+
+  if(status != REG_SUCCESS) return REG_FAILURE;
+
+  /* Only an emitter that says it can cut arrays down is told what
+     part of them we want */
+  IOTypes_table.io_def[IOTypeIndex].peer_regions =
+    (IOTypes_table.io_def[IOTypeIndex].slice_flags &
+     REG_SLICE_FLAG_REGIONS) ? REG_TRUE : REG_FALSE;
+  /* ...and only one that takes credit is given it */
+  IOTypes_table.io_def[IOTypeIndex].peer_credits =
+    (IOTypes_table.io_def[IOTypeIndex].slice_flags &
+     REG_SLICE_FLAG_CREDITS) ? REG_TRUE : REG_FALSE;
+
+  /* Deltas are taken of the slice as it was sent */
+  IOTypes_table.io_def[IOTypeIndex].slice_wire_type = *DataType;
+
+  /* Any XDR byte count must be of the data once decompressed */
+  IOTypes_table.io_def[IOTypeIndex].slice_bytes = NumBytes;
+  if(IOTypes_table.io_def[IOTypeIndex].slice_codec != REG_COMPRESS_NONE){
+    NumBytes = IOTypes_table.io_def[IOTypeIndex].slice_raw_bytes;
+  }
+  else{
+    IOTypes_table.io_def[IOTypeIndex].slice_raw_bytes = NumBytes;
+  }
+
+  /* Use of XDR is internal to library so make sure user doesn't
+     get confused.  use_xdr flag set here for use in subsequent call
+     to consume_data_slice */
+  switch(*DataType){
+
+  case REG_XDR_INT:
+    IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_TRUE;
+    IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes = NumBytes;
+    *DataType = REG_INT;
+    break;
+
+  case REG_XDR_FLOAT:
+    IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_TRUE;
+    IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes = NumBytes;
+    *DataType = REG_FLOAT;
+    break;
+
+  case REG_XDR_DOUBLE:
+    IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_TRUE;
+    IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes = NumBytes;
+    *DataType = REG_DBL;
+    break;
+
+  case REG_XDR_LONG:
+    IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_TRUE;
+    IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes = NumBytes;
+    *DataType = REG_LONG;
+    break;
+
+  /* As is use of lossy encodings - the user gets back the type that
+     was emitted */
+  case REG_Q16_FLOAT:
+  case REG_Q16_DOUBLE:
+  case REG_HALF_FLOAT:
+  case REG_HALF_DOUBLE:
+    IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_FALSE;
+    IOTypes_table.io_def[IOTypeIndex].slice_lossy_type = *DataType;
+    *DataType = Lossy_native_type(*DataType);
+    break;
+
+  default:
+    IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_FALSE;
+    break;
+  }
+
+  /* Keep track of whether numeric data arrived native or as XDR */
+  if(IOTypes_table.io_def[IOTypeIndex].use_xdr){
+    IOTypes_table.io_def[IOTypeIndex].num_xdr_slices++;
+  }
+  else if(*DataType != REG_CHAR &&
+	  !IOTypes_table.io_def[IOTypeIndex].slice_lossy_type){
+    IOTypes_table.io_def[IOTypeIndex].num_native_slices++;
+  }
+
+  /* The part of a block sent a level of detail at a time is put in
+     place in the whole block, which is what the caller reads it into */
+  if(IOTypes_table.io_def[IOTypeIndex].level_part.num_levels > 0 &&
+     *DataType != REG_CHAR){
+    IOTypes_table.io_def[IOTypeIndex].level_part_count = *Count;
+    *Count = IOTypes_table.io_def[IOTypeIndex].level_block.nx*
+      IOTypes_table.io_def[IOTypeIndex].level_block.ny*
+      IOTypes_table.io_def[IOTypeIndex].level_block.nz;
+  }
+
+  /* Check whether or not we'll need to convert the array ordering *
+  if(ReG_CalledFromF90 != IsFortranArray){
+
+    * Assume we don't ever want to re-order char data *
+    if(*DataType != REG_CHAR){
+      IOTypes_table.io_def[IOTypeIndex].convert_array_order = REG_TRUE;
+    }
+    else{
+      IOTypes_table.io_def[IOTypeIndex].convert_array_order = REG_FALSE;
+    }
+  }
+  else{
+    IOTypes_table.io_def[IOTypeIndex].convert_array_order = REG_FALSE;
+  }
+  */
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    As Consume_data_slice() but without keeping track of the level of
+    detail that has been received. */
+static int consume_slice_data(int    IOTypeIndex,
+			      int    DataType,
+			      int    Count,
+			      void  *pData)
+{
+  int              return_status = REG_SUCCESS;
+  size_t	   num_bytes_to_read;
+  void            *pout;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  /* Check that this IOType is enabled */
+  if(IOTypes_table.io_def[IOTypeIndex].is_enabled == REG_FALSE) {
+    return REG_FAILURE;
+  }
+
+  /* Calculate how many bytes to expect */
+  switch(DataType) {
+
+  case REG_INT:
+    if(IOTypes_table.io_def[IOTypeIndex].use_xdr) {
+      num_bytes_to_read = IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes;
+    }
+    else {
+      num_bytes_to_read = Count*sizeof(int);
+    }
+    break;
+
+  case REG_LONG:
+    if(IOTypes_table.io_def[IOTypeIndex].use_xdr) {
+      num_bytes_to_read = IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes;
+    }
+    else {
+      num_bytes_to_read = Count*sizeof(long);
+    }
+    break;
+
+  case REG_FLOAT:
+    if(IOTypes_table.io_def[IOTypeIndex].use_xdr) {
+      num_bytes_to_read = IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes;
+    }
+    else {
+      num_bytes_to_read = Count*sizeof(float);
+    }
+    break;
+
+  case REG_DBL:
+    if(IOTypes_table.io_def[IOTypeIndex].use_xdr) {
+      num_bytes_to_read = IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes;
+    }
+    else {
+      num_bytes_to_read = Count*sizeof(double);
+    }
+    break;
+
+  case REG_CHAR:
+    num_bytes_to_read = Count*sizeof(char);
+    break;
+
+  default:
+    fprintf(stderr, "STEER: Consume_data_slice: Unrecognised data type specified "
+	    "in slice header\n");
+
+    /* Reset use_xdr flag set as only valid on a per-slice basis */
+    IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_FALSE;
+    IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes = 0;
+
+    return REG_FAILURE;
+    break;
+  }
+
+  /* Key frames and deltas are read whole so that they can be kept
+     or applied to the last sample */
+  if(IOTypes_table.io_def[IOTypeIndex].slice_flags &
+     (REG_SLICE_FLAG_KEY | REG_SLICE_FLAG_DELTA)) {
+
+    return_status = Consume_delta_data(IOTypeIndex, DataType, Count,
+				       IOTypes_table.io_def[IOTypeIndex].slice_raw_bytes,
+				       pData);
+
+    /* Reset flags set as only valid on a per-slice basis */
+    IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_FALSE;
+    IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes = 0;
+    IOTypes_table.io_def[IOTypeIndex].slice_lossy_type = 0;
+    IOTypes_table.io_def[IOTypeIndex].slice_codec = REG_COMPRESS_NONE;
+    IOTypes_table.io_def[IOTypeIndex].slice_flags = 0;
+
+    return return_status;
+  }
+
+  /* Lossily-encoded data is reconstructed from the IOType's buffer */
+  if(IOTypes_table.io_def[IOTypeIndex].slice_lossy_type) {
+
+    return_status = Consume_lossy_data(IOTypeIndex, DataType, Count,
+				       IOTypes_table.io_def[IOTypeIndex].slice_raw_bytes,
+				       pData);
+
+    /* Reset flags set as only valid on a per-slice basis */
+    IOTypes_table.io_def[IOTypeIndex].slice_lossy_type = 0;
+    IOTypes_table.io_def[IOTypeIndex].slice_codec = REG_COMPRESS_NONE;
+
+    return return_status;
+  }
+
+  /* Compressed data is read whole, decompressed and then decoded */
+  if(IOTypes_table.io_def[IOTypeIndex].slice_codec != REG_COMPRESS_NONE) {
+
+    /* Decompress to wherever the uncompressed data would have been
+       read */
+    pout = pData;
+    if(IOTypes_table.io_def[IOTypeIndex].use_xdr ||
+       IOTypes_table.io_def[IOTypeIndex].convert_array_order == REG_TRUE) {
+
+      if(IOTypes_table.io_def[IOTypeIndex].buffer_max_bytes <
+	 num_bytes_to_read) {
+	return_status = Realloc_iotype_buffer(IOTypeIndex,
+					      num_bytes_to_read);
+      }
+      pout = IOTypes_table.io_def[IOTypeIndex].buffer;
+    }
+
+    if(return_status == REG_SUCCESS) {
+      return_status = Consume_compressed_data(IOTypeIndex, DataType,
+					      num_bytes_to_read, pout);
+    }
+    if(return_status == REG_SUCCESS) {
+      return_status = Reorder_decode_array(&(IOTypes_table.io_def[IOTypeIndex]),
+					   DataType, Count, pData);
+    }
+
+    /* Reset flags set as only valid on a per-slice basis */
+    IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_FALSE;
+    IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes = 0;
+    IOTypes_table.io_def[IOTypeIndex].slice_codec = REG_COMPRESS_NONE;
+
+    return return_status;
+  }
+
+  /* Data that must be reordered is read, decoded and reordered a
+     piece at a time */
+  if(IOTypes_table.io_def[IOTypeIndex].convert_array_order == REG_TRUE) {
+
+    return_status = Consume_reordered_data(IOTypeIndex, DataType,
+					   Count, pData);
+
+    /* Reset use_xdr flag set as only valid on a per-slice basis */
+    IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_FALSE;
+    IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes = 0;
+
+    return return_status;
+  }
+
+  /* Check that input buffer is large enough (only an issue if have XDR-
+     encoded data or need to reorder it) */
+  if(IOTypes_table.io_def[IOTypeIndex].use_xdr ||
+     IOTypes_table.io_def[IOTypeIndex].convert_array_order == REG_TRUE) {
+
+    if(IOTypes_table.io_def[IOTypeIndex].buffer_max_bytes < num_bytes_to_read) {
+
+      if(Realloc_iotype_buffer(IOTypeIndex, num_bytes_to_read)
+	 != REG_SUCCESS) {
+
+	/* Reset use_xdr flag set as only valid on a per-slice basis */
+	IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_FALSE;
+	IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes = 0;
+	return REG_FAILURE;
+      }
+    }
+  }
+
+  /* Read this number of bytes - if xdr is being used or the array needs to
+     be reordered then the data is read into
+     IOTypes_table.io_def[IOTypeIndex].buffer, else it is stored
+     in the buffer pointed to by pData. */
+  if (Consume_data_read(IOTypeIndex,
+			DataType,
+			num_bytes_to_read,
+			pData) != REG_SUCCESS)
+    return REG_FAILURE;
+
+
+  /* Re-order and decode (xdr) data as necessary */
+  Reorder_decode_array(&(IOTypes_table.io_def[IOTypeIndex]),
+		       DataType, Count,  pData);
+
+  /* Reset use_xdr flag set as only valid on a per-slice basis */
+  IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_FALSE;
+  IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes = 0;
+
+  return return_status;
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    @param io The IOdef_entry of the IOType being consumed
+    @param DataType Type of the slice just consumed
+    @param Count No. of objects in the slice
+    @param pData The data of the slice
+
+    Keeps track of the block being received a level of detail at a
+    time: a chunk header with a level in it says which part of the
+    block the next numeric slice holds. */
+static void note_slice_level(IOdef_entry *io,
+			     int          DataType,
+			     int          Count,
+			     const void  *pData)
+{
+  Array_type       chunk;
+  Chunk_level_type level;
+
+  if(DataType != REG_CHAR) return;
+
+  io->level_part.num_levels = 0;
+  if(Unpack_chunk_header((const char*) pData, (size_t) Count, &chunk,
+			 &level) != REG_SUCCESS){
+    return;
+  }
+
+  /* Any block starts with its coarsest level */
+  if(level.num_levels == 0 || level.level == level.num_levels - 1){
+    io->level_done = -1;
+  }
+  io->level_count = level.num_levels;
+  io->level_block = chunk;
+  io->level_part = level;
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    @param block The block of an array being sent a level of detail
+    at a time
+    @param part The part of @p block, relative to its origin
+    @param lattice On successful return, @p part relative to the
+    origin of the whole array
+    @param cut On successful return, the elements of @p part, as
+    from Region_clip()
+    @param first On successful return, the position of the first of
+    them, as from Region_clip()
+    @return REG_SUCCESS, or REG_FAILURE if @p part is empty
+
+    Works out which elements of a block a part of one of its levels of
+    detail holds. */
+static int clip_level_part(const Array_type  *block,
+			   const Region_type *part,
+			   Region_type       *lattice,
+			   Array_type        *cut,
+			   int               *first)
+{
+  *lattice = *part;
+  lattice->sx += block->sx;
+  lattice->sy += block->sy;
+  lattice->sz += block->sz;
+
+  return Region_clip(lattice, block, cut, first);
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    As Consume_data_slice() but for a slice holding part of a block
+    that is being sent a level of detail at a time.  The part is read
+    into the IOType's @p level_buffer and put in place in @p pData,
+    which holds the whole block and must be the same for every part
+    of it.  Once the last part of a level is in, the elements of
+    finer levels are filled in from the nearest that have arrived. */
+static int consume_level_part(int    IOTypeIndex,
+			      int    DataType,
+			      int    Count,
+			      void  *pData)
+{
+  IOdef_entry     *io = &(IOTypes_table.io_def[IOTypeIndex]);
+  Chunk_level_type part = io->level_part;
+  Region_type      lattice;
+  Array_type       cut;
+  int              first[3];
+  int              elem_size;
+
+  /* One numeric slice follows each chunk header */
+  io->level_part.num_levels = 0;
+
+  elem_size = Sizeof_type(DataType);
+  if(elem_size == 0 || DataType == REG_CHAR ||
+     Count != io->level_block.nx*io->level_block.ny*io->level_block.nz ||
+     clip_level_part(&(io->level_block), &(part.region), &lattice, &cut,
+		     first) != REG_SUCCESS ||
+     cut.nx*cut.ny*cut.nz != io->level_part_count){
+    fprintf(stderr, "STEER: ERROR: Consume_data_slice: slice of %d "
+	    "objects does not match the chunk header before it\n",
+	    io->level_part_count);
+    return REG_FAILURE;
+  }
+
+  if(Realloc_scratch_buffer(io, &(io->level_buffer),
+			    &(io->level_buffer_max_bytes),
+			    (size_t) io->level_part_count*elem_size,
+			    "Consume_data_slice") != REG_SUCCESS ||
+     consume_slice_data(IOTypeIndex, DataType, io->level_part_count,
+			io->level_buffer) != REG_SUCCESS){
+    return REG_FAILURE;
+  }
+
+  Region_insert(&(io->level_block), first, &cut, &lattice,
+		(size_t) elem_size, io->level_buffer, pData);
+
+  if(part.part == part.num_parts - 1){
+    if(part.level > 0){
+      Region_fill(&(io->level_block), 1 << part.level, (size_t) elem_size,
+		  pData);
+    }
+    io->level_done = part.level;
+  }
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Consume_data_slice(int    IOTypeIndex,
+		       int    DataType,
+		       int    Count,
+		       void  *pData)
+{
+  if(ReG_SteeringEnabled && DataType != REG_CHAR &&
+     IOTypes_table.io_def[IOTypeIndex].level_part.num_levels > 0){
+    return consume_level_part(IOTypeIndex, DataType, Count, pData);
+  }
+
+  if(consume_slice_data(IOTypeIndex, DataType, Count,
+			pData) != REG_SUCCESS){
+    return REG_FAILURE;
+  }
+
+  if(ReG_SteeringEnabled){
+    note_slice_level(&(IOTypes_table.io_def[IOTypeIndex]), DataType,
+		     Count, pData);
+  }
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Consume_data_slice_ptr(int    IOTypeIndex,
+			   int    DataType,
+			   int    Count,
+			   void **pData)
+{
+  IOdef_entry *io;
+  size_t       num_bytes;
+  void        *ptr;
+  int          elem_size;
+
+  *pData = NULL;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_FAILURE;
+
+  io = &(IOTypes_table.io_def[IOTypeIndex]);
+
+  /* Check that this IOType is enabled */
+  if(io->is_enabled == REG_FALSE) return REG_FAILURE;
+
+  if((elem_size = Sizeof_type(DataType)) == 0 || Count < 0) {
+    fprintf(stderr, "STEER: ERROR: Consume_data_slice_ptr: bad data "
+	    "type or count\n");
+    return REG_FAILURE;
+  }
+  num_bytes = (size_t)Count*elem_size;
+
+  /* Data that is stored just as the application wants it may be
+     handed over where it lies, if the transport allows */
+  if(!io->use_xdr && io->convert_array_order != REG_TRUE &&
+     io->level_part.num_levels == 0 &&
+     io->slice_codec == REG_COMPRESS_NONE && !io->slice_lossy_type &&
+     !(io->slice_flags & (REG_SLICE_FLAG_KEY | REG_SLICE_FLAG_DELTA |
+			  REG_SLICE_FLAG_STRIPED)) &&
+     Consume_data_map(IOTypeIndex, num_bytes, &ptr) == REG_SUCCESS) {
+
+    io->num_xdr_bytes = 0;
+    note_slice_level(io, DataType, Count, ptr);
+
+    if(((size_t)ptr) % elem_size == 0) {
+      *pData = ptr;
+      return REG_SUCCESS;
+    }
+
+    /* Not aligned for the type so it has to be copied after all */
+    if(Realloc_scratch_buffer(io, &(io->slice_buffer),
+			      &(io->slice_buffer_max_bytes), num_bytes,
+			      "Consume_data_slice_ptr") != REG_SUCCESS) {
+      return REG_FAILURE;
+    }
+    memcpy(io->slice_buffer, ptr, num_bytes);
+    *pData = io->slice_buffer;
+    return REG_SUCCESS;
+  }
+
+  if(Realloc_scratch_buffer(io, &(io->slice_buffer),
+			    &(io->slice_buffer_max_bytes), num_bytes,
+			    "Consume_data_slice_ptr") != REG_SUCCESS) {
+    /* Reset flags set as only valid on a per-slice basis */
+    io->use_xdr = REG_FALSE;
+    io->num_xdr_bytes = 0;
+    io->slice_lossy_type = 0;
+    io->slice_codec = REG_COMPRESS_NONE;
+    io->slice_flags = 0;
+    return REG_FAILURE;
+  }
+
+  if(Consume_data_slice(IOTypeIndex, DataType, Count,
+			io->slice_buffer) != REG_SUCCESS) {
+    return REG_FAILURE;
+  }
+
+  *pData = io->slice_buffer;
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Get_consumed_slice_count(int  IOTypeIndex,
+			     int *NumSlices)
+{
+  *NumSlices = 0;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_FAILURE;
+
+  if(IOTypeIndex < 0 || IOTypeIndex >= IOTypes_table.num_registered){
+    fprintf(stderr, "STEER: ERROR: Get_consumed_slice_count: invalid "
+	    "IOType index (%d) supplied\n", IOTypeIndex);
+    return REG_FAILURE;
+  }
+
+  /* Check that this IOType is enabled */
+  if(IOTypes_table.io_def[IOTypeIndex].is_enabled == REG_FALSE){
+    return REG_FAILURE;
+  }
+
+  return Consume_seek_slice_impl(IOTypeIndex, -1, NumSlices);
+}
+
+/*----------------------------------------------------------------*/
+
+int Get_IOType_level(int  IOTypeIndex,
+		     int *Level,
+		     int *NumLevels)
+{
+  *Level = -1;
+  *NumLevels = 0;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_FAILURE;
+
+  if(IOTypeIndex < 0 || IOTypeIndex >= IOTypes_table.num_registered){
+    fprintf(stderr, "STEER: ERROR: Get_IOType_level: invalid "
+	    "IOType index (%d) supplied\n", IOTypeIndex);
+    return REG_FAILURE;
+  }
+
+  /* Check that this IOType is enabled */
+  if(IOTypes_table.io_def[IOTypeIndex].is_enabled == REG_FALSE){
+    return REG_FAILURE;
+  }
 
-  /* Create, store and return a handle for this ChkType */
-  ChkTypes_table.io_def[current].handle = Next_IO_Chk_handle++;
-  *ChkType = ChkTypes_table.io_def[current].handle;
+  *Level = IOTypes_table.io_def[IOTypeIndex].level_done;
+  *NumLevels = IOTypes_table.io_def[IOTypeIndex].level_count;
 
-  /* Check whether we need to allocate more storage */
-  current++;
-  if(current == ChkTypes_table.max_entries) {
-    new_size = ChkTypes_table.max_entries + REG_INITIAL_NUM_IOTYPES;
+  return REG_SUCCESS;
+}
 
-    dum_ptr = (IOdef_entry*)realloc((void *)(ChkTypes_table.io_def),
-		                    new_size*sizeof(IOdef_entry));
+/*----------------------------------------------------------------*/
 
-    if(dum_ptr == NULL) {
-      fprintf(stderr, "STEER: Register_ChkType: failed to allocate memory\n");
-      return REG_FAILURE;
-    }
-    else {
+int Consume_seek_slice(int IOTypeIndex,
+		       int Slice)
+{
+  int num_slices;
 
-      ChkTypes_table.io_def = dum_ptr;
-    }
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_FAILURE;
 
-    ChkTypes_table.max_entries += REG_INITIAL_NUM_IOTYPES;
+  if(IOTypeIndex < 0 || IOTypeIndex >= IOTypes_table.num_registered){
+    fprintf(stderr, "STEER: ERROR: Consume_seek_slice: invalid IOType "
+	    "index (%d) supplied\n", IOTypeIndex);
+    return REG_FAILURE;
   }
 
-  ChkTypes_table.num_registered = current;
+  /* Check that this IOType is enabled */
+  if(IOTypes_table.io_def[IOTypeIndex].is_enabled == REG_FALSE){
+    return REG_FAILURE;
+  }
 
-  /* Flag that the registered Chk Types have changed */
-  ReG_ChkTypesChanged = REG_TRUE;
+  if(Slice < 0 ||
+     Consume_seek_slice_impl(IOTypeIndex, Slice, &num_slices)
+     != REG_SUCCESS){
+    return REG_FAILURE;
+  }
+
+  /* Deltas are matched with what they are a delta of by position in
+     the sample */
+  IOTypes_table.io_def[IOTypeIndex].delta_slice = Slice;
 
   return REG_SUCCESS;
 }
 
 /*----------------------------------------------------------------*/
 
-int Record_Chkpt(int   ChkType,
-		 char *ChkTag)
+int Consume_reordered_data(int    IOTypeIndex,
+			   int    DataType,
+			   int    Count,
+			   void  *pData)
 {
-  int    index;
-  int    count;
-  time_t time_now;
-  char   *pchar;
+  IOdef_entry *io;
+  Array_type  *array;
+  int          tot_extent[3];
+  int          sub_extent[3];
+  int          origin[3];
+  int          chunk_extent[3];
+  int          chunk_origin[3];
+  int          slow, plane, nplanes, n;
+  size_t       in_size, nelem, plane_bytes, num_bytes;
+  int          status;
+  int          return_status = REG_SUCCESS;
 
-  /* Can only call this function if steering lib initialised */
+  io = &(IOTypes_table.io_def[IOTypeIndex]);
+  array = &(io->array);
 
-  if(!ReG_SteeringInit) return REG_FAILURE;
+  tot_extent[0] = array->totx;
+  tot_extent[1] = array->toty;
+  tot_extent[2] = array->totz;
+  sub_extent[0] = array->nx;
+  sub_extent[1] = array->ny;
+  sub_extent[2] = array->nz;
+  origin[0] = array->sx;
+  origin[1] = array->sy;
+  origin[2] = array->sz;
 
-  if(ChkType == REG_IODEF_HANDLE_NOTSET) return REG_SUCCESS;
+  /* Size of an element as it arrives */
+  if(io->use_xdr){
+    in_size = (size_t)Xdr_sizeof_type(DataType);
+    num_bytes = (size_t)io->num_xdr_bytes;
+  }
+  else{
+    in_size = (size_t)Sizeof_type(DataType);
+    num_bytes = (size_t)Count*in_size;
+  }
+  nelem = (size_t)array->nx*(size_t)array->ny*(size_t)array->nz;
 
-  /* Check that we have enough storage space - if not then store
-     current entries on disk (rather than continually grab more
-     memory) */
+  if(in_size == 0 || nelem == 0){
+    fprintf(stderr, "STEER: Consume_reordered_data: cannot reorder data "
+	    "of type %d into array block of %lu elements\n", DataType,
+	    (unsigned long)nelem);
+    return REG_FAILURE;
+  }
 
-  if(Chk_log.num_entries == Chk_log.max_entries) {
-    /* Save_log also resets Chk_log.num_entries to zero */
-    if(Save_log(&Chk_log) != REG_SUCCESS) {
-      fprintf(stderr, "STEER: Record_Chkpt: Save_log failed\n");
+  if((size_t)Count < nelem || num_bytes < nelem*in_size){
+    fprintf(stderr, "STEER: Consume_reordered_data: have %d objects but "
+	    "array block holds %lu\n", Count, (unsigned long)nelem);
+    return REG_FAILURE;
+  }
+
+  /* The data arrives in the ordering we are converting _from_ so
+     planes normal to the dimension that varies least rapidly in it
+     are contiguous.  Read as many of those at a time as will fill
+     REG_REORDER_CHUNK_SIZE bytes (but at least one) */
+  slow = (array->is_f90 == REG_TRUE) ? 0 : 2;
+  plane_bytes = in_size*(nelem/(size_t)sub_extent[slow]);
+  nplanes = (int)(REG_REORDER_CHUNK_SIZE/plane_bytes);
+  if(nplanes < 1) nplanes = 1;
+  if(nplanes > sub_extent[slow]) nplanes = sub_extent[slow];
+
+  if(io->buffer_max_bytes < (int)(nplanes*plane_bytes)){
+    if(Realloc_iotype_buffer(IOTypeIndex, (int)(nplanes*plane_bytes))
+       != REG_SUCCESS){
       return REG_FAILURE;
     }
   }
 
-  Chk_log.entry[Chk_log.num_entries].key = Chk_log.primary_key_value++;
-  strcpy(Chk_log.entry[Chk_log.num_entries].chk_tag, ChkTag);
-  Chk_log.entry[Chk_log.num_entries].chk_handle      = ChkType;
-  Chk_log.entry[Chk_log.num_entries].sent_to_steerer = REG_FALSE;
+  for(n = 0; n < 3; n++){
+    chunk_extent[n] = sub_extent[n];
+    chunk_origin[n] = origin[n];
+  }
 
-  /* Store the values of all registered parameters at this point (so
-     long as they're not internal to the library) */
-  count = 0;
-  for(index = 0; index<Params_table.max_entries; index++) {
-    if(Params_table.param[index].handle == REG_PARAM_HANDLE_NOTSET ||
-       Params_table.param[index].is_internal == REG_TRUE) {
+  for(plane = 0; plane < sub_extent[slow]; plane += n){
 
-      /* Time stamp is a special case - is internal but we do want
-	 it for checkpoint records */
-      if(Params_table.param[index].handle != REG_TIMESTAMP_HANDLE) {
-	continue;
-      }
-      else {
-	/* Get timestamp */
-	if((int)(time_now = time(NULL)) != -1) {
-	  pchar = ctime(&time_now);
-	  strcpy(Params_table.param[index].value, pchar);
-	  /* Remove new-line character */
-          Params_table.param[index].value[strlen(pchar)-1] = '\0';
-	}
-	else {
-	  strcpy(Params_table.param[index].value, "");
-	}
-      }
+    n = sub_extent[slow] - plane;
+    if(n > nplanes) n = nplanes;
+
+    if(Consume_data_read(IOTypeIndex, DataType, (int)(n*plane_bytes),
+			 pData) != REG_SUCCESS){
+      return REG_FAILURE;
     }
 
-    /* Don't include raw binary parameters in the log */
-    if(Params_table.param[index].type == REG_BIN) continue;
+    /* Carry on reading if this fails so we stay in step with the
+       emitter */
+    chunk_extent[slow] = n;
+    chunk_origin[slow] = origin[slow] + plane;
+    if(io->use_xdr){
+      status = Reorder_decode_nd(3, tot_extent, chunk_extent, chunk_origin,
+				 DataType, io->buffer, pData,
+				 array->is_f90);
+    }
+    else{
+      status = Reorder_nd(3, tot_extent, chunk_extent, chunk_origin,
+			  in_size, io->buffer, pData, array->is_f90);
+    }
+    if(status != REG_SUCCESS) return_status = REG_FAILURE;
+  }
 
-    /* This is one we want - store its handle and current value */
-    Chk_log.entry[Chk_log.num_entries].param[count].handle =
-                                           Params_table.param[index].handle;
+  /* Read and discard anything after the array block */
+  num_bytes -= nelem*in_size;
+  while(num_bytes > 0){
 
-    /* Update value associated with pointer */
-    Get_ptr_value(&(Params_table.param[index]));
+    n = (int)((num_bytes < nplanes*plane_bytes) ?
+	      num_bytes : nplanes*plane_bytes);
+    if(Consume_data_read(IOTypeIndex, DataType, n, pData) != REG_SUCCESS){
+      return REG_FAILURE;
+    }
+    num_bytes -= n;
+  }
 
-    /* Save this value */
-    strcpy(Chk_log.entry[Chk_log.num_entries].param[count].value,
-           Params_table.param[index].value);
+  return return_status;
+}
 
-    /* Storage for params associated with log entry is static */
-    if(++count >= REG_MAX_NUM_STR_PARAMS) break;
+/*----------------------------------------------------------------*/
+
+int Consume_compressed_data(int    IOTypeIndex,
+			    int    DataType,
+			    size_t NumBytes,
+			    void  *pOut)
+{
+  IOdef_entry *io = &(IOTypes_table.io_def[IOTypeIndex]);
+  int          use_xdr;
+  int          convert;
+  int          status;
+  double       time0, time1;
+
+  if((size_t)io->slice_raw_bytes != NumBytes) {
+    fprintf(stderr, "STEER: ERROR: Consume_compressed_data: slice holds "
+	    "%d bytes once decompressed but expected %lu\n",
+	    io->slice_raw_bytes, (unsigned long)NumBytes);
+    return REG_FAILURE;
   }
 
-  /* Store the no. of params this entry has */
-  Chk_log.entry[Chk_log.num_entries].num_param = count;
+  if(io->comp_buffer_max_bytes < (size_t)io->slice_bytes) {
+    if(Realloc_iotype_comp_buffer(IOTypeIndex,
+				  (size_t)io->slice_bytes) != REG_SUCCESS) {
+      return REG_FAILURE;
+    }
+  }
 
-  /* Keep a count of entries that we have yet to send to steerer */
-  Chk_log.num_unsent++;
+  /* Read the compressed bytes as they are - the transports put data
+     into the IOType's buffer if it is XDR or to be reordered */
+  use_xdr = io->use_xdr;
+  convert = io->convert_array_order;
+  io->use_xdr = REG_FALSE;
+  io->convert_array_order = REG_FALSE;
+  status = Consume_data_read(IOTypeIndex, DataType, io->slice_bytes,
+			     io->comp_buffer);
+  io->use_xdr = use_xdr;
+  io->convert_array_order = convert;
+  if(status != REG_SUCCESS) return REG_FAILURE;
 
-  Chk_log.num_entries++;
+  Get_current_time_seconds(&time0);
+  status = Decompress_data(io->slice_codec, io->comp_buffer,
+			   (size_t)io->slice_bytes, pOut, NumBytes);
+  Get_current_time_seconds(&time1);
+  if(status != REG_SUCCESS) return REG_FAILURE;
+
+  io->comp_time += (float)(time1 - time0);
+  io->comp_raw_bytes += (double)NumBytes;
+  io->comp_bytes += (double)io->slice_bytes;
+  io->comp_ratio = (float)(io->comp_raw_bytes/io->comp_bytes);
 
   return REG_SUCCESS;
 }
 
 /*----------------------------------------------------------------*/
 
-int Record_checkpoint_set(int ChkType, char* ChkTag, char* Path) {
-  /* Can only call this function if steering lib initialised */
-  if(!ReG_SteeringInit)
-    return REG_FAILURE;
+/* Reads a whole slice of NumBytes bytes as sent (decompressing it if
+   need be) into the IOType's buffer, which is made big enough to hold
+   the slice or Count decoded elements, whichever is larger */
+static int read_whole_slice(int    IOTypeIndex,
+			    int    DataType,
+			    int    Count,
+			    size_t NumBytes)
+{
+  IOdef_entry *io = &(IOTypes_table.io_def[IOTypeIndex]);
+  size_t       num_bytes;
+  int          use_xdr;
+  int          convert;
+  int          status;
+
+  num_bytes = Count*(size_t)Sizeof_type(DataType);
+  if(num_bytes < NumBytes) num_bytes = NumBytes;
+  if(io->buffer_max_bytes < num_bytes) {
+    if(Realloc_iotype_buffer(IOTypeIndex, num_bytes) != REG_SUCCESS) {
+      return REG_FAILURE;
+    }
+  }
 
-  if(ChkType == REG_IODEF_HANDLE_NOTSET)
+  if(io->slice_codec != REG_COMPRESS_NONE) {
+    return Consume_compressed_data(IOTypeIndex, DataType, NumBytes,
+				   io->buffer);
+  }
+
+  /* The transports only read into the IOType's buffer for XDR or
+     reordered data so tell them where to put it */
+  use_xdr = io->use_xdr;
+  convert = io->convert_array_order;
+  io->use_xdr = REG_FALSE;
+  io->convert_array_order = REG_FALSE;
+  status = Consume_data_read(IOTypeIndex, DataType, NumBytes,
+			     io->buffer);
+  io->use_xdr = use_xdr;
+  io->convert_array_order = convert;
+
+  return status;
+}
+
+/*----------------------------------------------------------------*/
+
+/* Decodes a whole slice of NumBytes bytes, as read by
+   read_whole_slice(), from the IOType's buffer into pData */
+static int decode_whole_slice(int    IOTypeIndex,
+			      int    DataType,
+			      int    Count,
+			      size_t NumBytes,
+			      void  *pData)
+{
+  IOdef_entry *io = &(IOTypes_table.io_def[IOTypeIndex]);
+  size_t       num_bytes = Count*(size_t)Sizeof_type(DataType);
+
+  if(io->slice_lossy_type) {
+    if(Lossy_decode(io->slice_lossy_type, io->buffer, NumBytes,
+		    (size_t)Count, pData) != REG_SUCCESS) {
+      fprintf(stderr, "STEER: ERROR: Consume_data_slice: failed to "
+	      "decode %d objects of type %d from %lu bytes\n", Count,
+	      io->slice_lossy_type, (unsigned long)NumBytes);
+      return REG_FAILURE;
+    }
+
+    /* Reordering works from the IOType's buffer into pData */
+    if(io->convert_array_order == REG_TRUE) {
+      memcpy(io->buffer, pData, num_bytes);
+      return Reorder_decode_array(io, DataType, Count, pData);
+    }
     return REG_SUCCESS;
+  }
 
-  return Record_checkpoint_set_impl(ChkType, ChkTag, Path);
+  if(io->use_xdr || io->convert_array_order == REG_TRUE) {
+    return Reorder_decode_array(io, DataType, Count, pData);
+  }
+
+  if(NumBytes != num_bytes) {
+    fprintf(stderr, "STEER: ERROR: Consume_data_slice: slice holds %lu "
+	    "bytes but %d objects of type %d need %lu\n",
+	    (unsigned long)NumBytes, Count, DataType,
+	    (unsigned long)num_bytes);
+    return REG_FAILURE;
+  }
+  memcpy(pData, io->buffer, num_bytes);
+
+  return REG_SUCCESS;
 }
 
-int Add_checkpoint_file(int   ChkType,
-			char *filename)
+/*----------------------------------------------------------------*/
+
+int Consume_lossy_data(int    IOTypeIndex,
+		       int    DataType,
+		       int    Count,
+		       size_t NumBytes,
+		       void  *pData)
 {
-  int index;
-  int nbytes;
+  if(read_whole_slice(IOTypeIndex, DataType, Count,
+		      NumBytes) != REG_SUCCESS) {
+    return REG_FAILURE;
+  }
 
-  /* Can only call this function if steering lib initialised */
-  if (!ReG_SteeringInit) return REG_FAILURE;
+  return decode_whole_slice(IOTypeIndex, DataType, Count, NumBytes,
+			    pData);
+}
 
-  if (ChkType == REG_IODEF_HANDLE_NOTSET) return REG_SUCCESS;
+/*----------------------------------------------------------------*/
 
-  index = IOdef_index_from_handle(&ChkTypes_table, ChkType);
+void Consume_delta_start(int IOTypeIndex)
+{
+  IOdef_entry *io = &(IOTypes_table.io_def[IOTypeIndex]);
+  int          i;
 
-  if (index == REG_IODEF_HANDLE_NOTSET) return REG_FAILURE;
+  io->delta_sample++;
+  io->delta_slice = 0;
 
-  /* Remove any trailing white space from the filename */
-  trimWhiteSpace(filename);
+  if(io->delta_key_needed == REG_TRUE) {
+    for(i = 0; i < io->num_delta_refs; i++) {
+      io->delta_refs[i].sample = -1;
+    }
+    io->delta_key_needed = REG_FALSE;
+  }
+}
 
-  /* Check that it doesn't contain any spaces (since we use a space-delimited
-     list to store the filenames) */
-  if(strchr(filename, ' ')){
+/*----------------------------------------------------------------*/
 
-    fprintf(stderr, "STEER: ERROR: Add_checkpoint_file - filenames must not "
-	    "contain spaces (file >>%s<<)\n", filename);
+int Consume_delta_data(int    IOTypeIndex,
+		       int    DataType,
+		       int    Count,
+		       size_t NumBytes,
+		       void  *pData)
+{
+  IOdef_entry    *io = &(IOTypes_table.io_def[IOTypeIndex]);
+  Delta_ref_type *ref;
+  int             index = io->delta_slice++;
+
+  /* Read the slice even if we can't use it so as to stay in step
+     with the emitter */
+  if(read_whole_slice(IOTypeIndex, DataType, Count,
+		      NumBytes) != REG_SUCCESS) {
     return REG_FAILURE;
   }
 
-  /* Check that we have sufficient memory; +2 to allow for space delimiter
-     and terminating character */
-  nbytes = strlen(filename)+2;
+  if(!(ref = Get_delta_ref(io, index))) return REG_FAILURE;
 
-  if( (ChkTypes_table.io_def[index].buffer_max_bytes -
-       ChkTypes_table.io_def[index].buffer_bytes) < nbytes ){
+  if(io->slice_flags & REG_SLICE_FLAG_DELTA) {
 
-    if( Realloc_chktype_buffer(index,
-			       (ChkTypes_table.io_def[index].buffer_max_bytes +
-				56*nbytes)) != REG_SUCCESS){
+    if(ref->sample != io->delta_sample - 1 ||
+       ref->type != io->slice_wire_type || ref->nbytes != NumBytes) {
+      fprintf(stderr, "STEER: ERROR: Consume_delta_data: no key frame "
+	      "for slice %d to apply delta to - waiting for the next "
+	      "one\n", index);
+      ref->sample = -1;
       return REG_FAILURE;
     }
+    Delta_xor(io->buffer, io->buffer, ref->data, NumBytes, REG_FALSE);
+  }
+  else if(Set_delta_ref(ref, io->slice_wire_type, io->buffer,
+			NumBytes) != REG_SUCCESS) {
+    ref->sample = -1;
+    return REG_FAILURE;
   }
+  ref->sample = io->delta_sample;
 
-  if(ChkTypes_table.io_def[index].buffer_bytes){
+  return decode_whole_slice(IOTypeIndex, DataType, Count, NumBytes,
+			    pData);
+}
 
-    nbytes = sprintf( &(( (char *)(ChkTypes_table.io_def[index].buffer) )[ChkTypes_table.io_def[index].buffer_bytes - 1]),
-		      "%s ", filename);
+/*----------------------------------------------------------------*/
 
-    /* Update the count of the bytes stored - unlike below don't need '+1' because
-       we've just overwritten the final '\0' character in the string */
-    ChkTypes_table.io_def[index].buffer_bytes += nbytes;
+int Consume_data_slices(int                    IOTypeIndex,
+			int                    NumSlices,
+			struct reg_data_slice *Slices)
+{
+  int i;
+  int type;
+  int count;
+
+  /* Check that steering is enabled */
+  if(!ReG_SteeringEnabled) return REG_SUCCESS;
+
+  if(IOTypeIndex < 0 || IOTypeIndex >= IOTypes_table.num_registered){
+    fprintf(stderr, "STEER: ERROR: Consume_data_slices: invalid IOType "
+	    "handle (%d) supplied\n", IOTypeIndex);
+    return REG_FAILURE;
   }
-  else{
-    nbytes = sprintf( (char *)(ChkTypes_table.io_def[index].buffer),
-		   "%s ", filename);
-    /* Update the count of the bytes stored - include the '\0' (and
-       hence the '-1' above) */
-    ChkTypes_table.io_def[index].buffer_bytes += nbytes + 1;
+
+  /* Check that this IOType is enabled */
+  if(IOTypes_table.io_def[IOTypeIndex].is_enabled == REG_FALSE){
+    return REG_FAILURE;
+  }
+
+  if(NumSlices < 0 || (NumSlices > 0 && !Slices)){
+    fprintf(stderr, "STEER: ERROR: Consume_data_slices: invalid batch of "
+	    "%d slices\n", NumSlices);
+    return REG_FAILURE;
+  }
+
+  for(i = 0; i < NumSlices; i++){
+
+    if(Consume_data_slice_header(IOTypeIndex, &type,
+				 &count) != REG_SUCCESS){
+      fprintf(stderr, "STEER: ERROR: Consume_data_slices: only got %d "
+	      "of %d slices\n", i, NumSlices);
+      return REG_FAILURE;
+    }
+
+    if(type != Slices[i].type || count > Slices[i].count){
+      fprintf(stderr, "STEER: ERROR: Consume_data_slices: slice %d has "
+	      "type %d and %d objects but expected type %d and at most %d\n",
+	      i, type, count, Slices[i].type, Slices[i].count);
+      return REG_FAILURE;
+    }
+
+    if(Consume_data_slice(IOTypeIndex, type, count,
+			  Slices[i].data) != REG_SUCCESS){
+      return REG_FAILURE;
+    }
+    Slices[i].count = count;
   }
 
   return REG_SUCCESS;
@@ -1318,57 +3561,76 @@ int Add_checkpoint_file(int   ChkType,
 
 /*----------------------------------------------------------------*/
 
-int Consume_start(int  IOType,
-		  int *IOTypeIndex)
+int Emit_start(int  IOType,
+	       int  SeqNum,
+	       int *IOTypeIndex)
 {
   /* Check that steering is enabled */
   if(!ReG_SteeringEnabled) return REG_SUCCESS;
 
   /* Can only call this function if steering lib initialised */
-  if(!ReG_SteeringInit) return REG_FAILURE;
+  if (!ReG_SteeringInit) return REG_FAILURE;
 
   /* Find corresponding entry in table of IOtypes */
   *IOTypeIndex = IOdef_index_from_handle(&IOTypes_table, IOType);
-  if(*IOTypeIndex == REG_IODEF_HANDLE_NOTSET) {
-    fprintf(stderr, "STEER: Consume_start: failed to find matching IOType, "
-	    "handle = %d\n", IOType);
+  if(*IOTypeIndex == REG_IODEF_HANDLE_NOTSET){
+
+    fprintf(stderr, "STEER: Emit_start: failed to find matching IOType\n");
     return REG_FAILURE;
   }
 
   /* Check that this IOType is enabled */
-  if(IOTypes_table.io_def[*IOTypeIndex].is_enabled == REG_FALSE) {
+  if(IOTypes_table.io_def[*IOTypeIndex].is_enabled == REG_FALSE){
     return REG_FAILURE;
   }
 
-  /* Check that this IOType can be consumed */
-  if(IOTypes_table.io_def[*IOTypeIndex].direction == REG_IO_OUT) {
-    fprintf(stderr, "STEER: ERROR: Consume_start: IOType has direction REG_IO_OUT\n");
+  /* Check that this IOType can be emitted */
+  if(IOTypes_table.io_def[*IOTypeIndex].direction == REG_IO_IN){
+
+    fprintf(stderr, "STEER: ERROR: Emit_start: IOType with index %d has "
+	    "direction REG_IO_IN\n", *IOTypeIndex);
     return REG_FAILURE;
   }
 
-  if(IOTypes_table.io_def[*IOTypeIndex].ack_needed == REG_TRUE) {
-    /* Signal that we have read this data and are ready for the next
-       set */
-    Emit_ack(*IOTypeIndex);
-    IOTypes_table.io_def[*IOTypeIndex].ack_needed = REG_FALSE;
+  /* Asynchronous IOTypes only need a free snapshot buffer - the I/O
+     thread deals with the consumer */
+  if(IOTypes_table.io_def[*IOTypeIndex].is_async){
+    return Async_emit_start(*IOTypeIndex, SeqNum);
   }
 
   /* Initialise array-ordering flags */
   IOTypes_table.io_def[*IOTypeIndex].convert_array_order = REG_FALSE;
 
-  return Consume_start_data_check(*IOTypeIndex);
+  if(Consume_ack(*IOTypeIndex) != REG_SUCCESS){
+    return REG_NOT_READY;
+  }
+
+  /* Set whether or not to encode as XDR - the ack from the consumer
+     tells us whether it stores numeric data exactly as we do */
+  IOTypes_table.io_def[*IOTypeIndex].use_xdr =
+    IOTypes_table.io_def[*IOTypeIndex].use_native ? REG_FALSE : REG_TRUE;
+
+  if(Emit_start_impl(*IOTypeIndex, SeqNum) != REG_SUCCESS)
+    return REG_FAILURE;
+
+  if(Emit_header(*IOTypeIndex) != REG_SUCCESS) {
+    IOTypes_table.io_def[*IOTypeIndex].ack_needed = REG_FALSE;
+    return REG_FAILURE;
+  }
+
+  return REG_SUCCESS;
 }
 
 /*----------------------------------------------------------------*/
 
-int Consume_start_blocking(int   IOType,
-			   int  *IOTypeIndex,
-			   float TimeOut)
+int Emit_start_blocking(int    IOType,
+			int    SeqNum,
+			int   *IOTypeIndex,
+			float  TimeOut)
 {
-  unsigned long time_out_uS; /* microseconds */
-  unsigned long blocked_poll_interval = 10000; /* microseconds */
-  unsigned long wait_time;
-  int           status;
+  double start_time;
+  double time_left;
+  int    status;
 
   /* Check that steering is enabled */
   if(!ReG_SteeringEnabled) return REG_SUCCESS;
@@ -1376,63 +3638,93 @@ int Consume_start_blocking(int   IOType,
   /* Can only call this function if steering lib initialised */
   if(!ReG_SteeringInit) return REG_FAILURE;
 
-  /* Convert time out from seconds to microseconds */
-  time_out_uS = (unsigned long)(TimeOut*1000000);
-
-  wait_time = 0;
-  while((status = Consume_start(IOType, IOTypeIndex)) != REG_SUCCESS) {
-    usleep(blocked_poll_interval);
-    if((wait_time += blocked_poll_interval) > time_out_uS){
+  start_time = Blocking_time_now();
+  while((status = Emit_start(IOType, SeqNum, IOTypeIndex)) != REG_SUCCESS) {
+    time_left = (double)TimeOut - (Blocking_time_now() - start_time);
+    if(time_left <= 0.0) {
 #ifdef REG_DEBUG
-      fprintf(stderr, "STEER: Consume_start_blocking: timed out\n");
+      fprintf(stderr, "STEER: Emit_start_blocking: timed out\n");
 #endif
       status = REG_TIMED_OUT;
       break;
     }
+
+    /* Sleep until a consumer connects or acknowledges the last
+       sample, or a snapshot buffer is freed */
+    Wait_for_IOType(*IOTypeIndex, time_left);
   }
 
   return status;
 }
+
 /*----------------------------------------------------------------*/
 
-int Consume_stop(int *IOTypeIndex)
+int Emit_stop(int *IOTypeIndex)
 {
   int return_status = REG_SUCCESS;
 
+  if(*IOTypeIndex < 0 || *IOTypeIndex >= IOTypes_table.num_registered){
+    fprintf(stderr, "STEER: ERROR: Emit_stop: invalid IOType handle "
+	    "(%d) supplied\n", *IOTypeIndex);
+    return REG_FAILURE;
+  }
+
   /* Check that steering is enabled */
   if(!ReG_SteeringEnabled) return REG_SUCCESS;
 
   /* Can only call this function if steering lib initialised */
-  if(!ReG_SteeringInit) return REG_FAILURE;
+  if (!ReG_SteeringInit) return REG_FAILURE;
 
-  if(*IOTypeIndex < 0 || *IOTypeIndex >= IOTypes_table.num_registered) {
-    fprintf(stderr, "STEER: Consume_stop: IOType index out of range\n");
+  /* Check that this IOType is enabled */
+  if(IOTypes_table.io_def[*IOTypeIndex].is_enabled == REG_FALSE){
     return REG_FAILURE;
   }
 
-  /* Check that this IOType is enabled */
-  if(IOTypes_table.io_def[*IOTypeIndex].is_enabled == REG_FALSE) {
-    return REG_FAILURE;
+  /* Hand the snapshot to the I/O thread to send */
+  if(IOTypes_table.io_def[*IOTypeIndex].is_async){
+    return_status = Async_emit_stop(*IOTypeIndex);
+    *IOTypeIndex = REG_IODEF_HANDLE_NOTSET;
+    return return_status;
   }
 
-  /* We are no longer in the process of consuming data */
-  IOTypes_table.io_def[*IOTypeIndex].consuming = REG_FALSE;
+  /* Anything held back by Send_data_slices() goes now */
+  return_status = Flush_data_slices(*IOTypeIndex,
+				    Steer_lib_config.scratch_buffer);
 
-  /* Set flag that we should signal data source that we are ready for new data
-     when we next call Consume_start */
-  IOTypes_table.io_def[*IOTypeIndex].ack_needed = REG_TRUE;
+  /* Send footer */
+  sprintf(Steer_lib_config.scratch_buffer, REG_PACKET_FORMAT, REG_DATA_FOOTER);
+  /* Include termination char WITHIN the packet */
+  Steer_lib_config.scratch_buffer[REG_PACKET_SIZE-1] = '\0';
 
-  Consume_stop_impl(*IOTypeIndex);
+  if(Emit_footer(*IOTypeIndex,
+		 Steer_lib_config.scratch_buffer) != REG_SUCCESS){
+    return_status = REG_FAILURE;
+  }
 
-  /* Free memory associated with channel */
-  if( IOTypes_table.io_def[*IOTypeIndex].buffer ){
-    free(IOTypes_table.io_def[*IOTypeIndex].buffer);
-    IOTypes_table.io_def[*IOTypeIndex].buffer = NULL;
-    IOTypes_table.io_def[*IOTypeIndex].buffer_bytes = 0;
-    IOTypes_table.io_def[*IOTypeIndex].buffer_max_bytes = 0;
+  /* The transport may not have sent everything until now */
+  if(Emit_stop_impl(*IOTypeIndex) != REG_SUCCESS){
+    return_status = REG_FAILURE;
+  }
+
+  /* Flag that we'll want an acknowledgement of this data set
+     before we try to read another one */
+  if(return_status == REG_SUCCESS){
+    IOTypes_table.io_def[*IOTypeIndex].num_samples_emitted++;
+    IOTypes_table.io_def[*IOTypeIndex].samples_in_flight++;
+    IOTypes_table.io_def[*IOTypeIndex].ack_needed = REG_TRUE;
+#ifdef REG_DEBUG_FULL
+    fprintf(stderr, "STEER: INFO: Emit_stop: set ack_needed = "
+	    "REG_TRUE for index %d\n", *IOTypeIndex);
+#endif
+  }
+  else{
+    IOTypes_table.io_def[*IOTypeIndex].ack_needed = REG_FALSE;
+#ifdef REG_DEBUG_FULL
+    fprintf(stderr, "STEER: INFO: Emit_stop: set ack_needed = "
+	    "REG_FALSE for index %d\n", *IOTypeIndex);
+#endif
   }
 
-  /* Reset handle associated with channel */
   *IOTypeIndex = REG_IODEF_HANDLE_NOTSET;
 
   return return_status;
@@ -1440,354 +3732,421 @@ int Consume_stop(int *IOTypeIndex)
 
 /*----------------------------------------------------------------*/
 
-int Consume_data_slice_header(int  IOTypeIndex,
-			      int *DataType,
-			      int *Count)
+size_t Encoded_size_bound(int IOTypeIndex,
+			  int DataType,
+			  int Count)
 {
-  int status;
-  int NumBytes;
-  int IsFortranArray;
+  size_t num_bytes = 0;
+  size_t num_lossy;
 
-  /* Check that steering is enabled */
-  if(!ReG_SteeringEnabled) return REG_FAILURE;
-
-  /* Check that this IOType is enabled */
-  if(IOTypes_table.io_def[IOTypeIndex].is_enabled == REG_FALSE){
-    return REG_FAILURE;
+  /* Deltas are made in the buffer as the caller's data must be left
+     alone */
+  if(IOTypes_table.io_def[IOTypeIndex].delta_interval > 0){
+    num_bytes = Count*(size_t)Sizeof_type(DataType);
   }
 
-  status = Consume_iotype_msg_header(IOTypeIndex,
-				     DataType,
-				     Count,
-				     &NumBytes,
-				     &IsFortranArray);
+  if(DataType == REG_CHAR) return num_bytes;
 
-  if(status != REG_SUCCESS) return REG_FAILURE;
+  if(IOTypes_table.io_def[IOTypeIndex].use_xdr &&
+     Count*(size_t)Xdr_sizeof_type(DataType) > num_bytes){
+    num_bytes = Count*Xdr_sizeof_type(DataType);
+  }
 
-  /* Use of XDR is internal to library so make sure user doesn't
-     get confused.  use_xdr flag set here for use in subsequent call
-     to consume_data_slice */
-  switch(*DataType){
+  num_lossy = Lossy_encoded_size(IOTypes_table.io_def[IOTypeIndex].lossy_mode,
+				 DataType, (size_t)Count);
 
-  case REG_XDR_INT:
-    IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_TRUE;
-    IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes = NumBytes;
-    *DataType = REG_INT;
-    break;
+  return (num_lossy > num_bytes) ? num_lossy : num_bytes;
+}
 
-  case REG_XDR_FLOAT:
-    IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_TRUE;
-    IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes = NumBytes;
-    *DataType = REG_FLOAT;
-    break;
+/*----------------------------------------------------------------*/
 
-  case REG_XDR_DOUBLE:
-    IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_TRUE;
-    IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes = NumBytes;
-    *DataType = REG_DBL;
-    break;
+/* Encodes a float or double slice into pXdrBuf if the IOType asks for
+   a lossy encoding and it can be done within the error bound.
+   Returns REG_TRUE if it was, REG_FALSE if the slice must be sent
+   exactly */
+static int encode_lossy(int          IOTypeIndex,
+			int          DataType,
+			int          Count,
+			const void  *pData,
+			void        *pXdrBuf,
+			int         *EmitType,
+			size_t      *NumBytes)
+{
+  IOdef_entry *io = &(IOTypes_table.io_def[IOTypeIndex]);
+  int          mode = io->lossy_mode;
+  double       max_err;
 
-  case REG_XDR_LONG:
-    IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_TRUE;
-    IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes = NumBytes;
-    *DataType = REG_LONG;
-    break;
+  if(mode == REG_LOSSY_NONE || Count <= 0) return REG_FALSE;
 
-  default:
-    IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_FALSE;
-    break;
+  /* Only newer consumers know the lossy data types */
+  if(mode != REG_LOSSY_TRUNCATE &&
+     io->slice_hdr_version < REG_SLICE_HDR_LOSSY_VERSION) return REG_FALSE;
+
+  if(Lossy_encode(mode, DataType, io->lossy_bound_type, io->lossy_bound,
+		  (size_t)Count, pData, pXdrBuf, NumBytes,
+		  &max_err) != REG_SUCCESS){
+    return REG_FALSE;
   }
 
-  /* Check whether or not we'll need to convert the array ordering *
-  if(ReG_CalledFromF90 != IsFortranArray){
+  *EmitType = Lossy_wire_type(mode, DataType);
 
-    * Assume we don't ever want to re-order char data *
-    if(*DataType != REG_CHAR){
-      IOTypes_table.io_def[IOTypeIndex].convert_array_order = REG_TRUE;
+  /* Truncated values are still plain floats or doubles so may need
+     to go out as XDR - which can be done in place */
+  if(mode == REG_LOSSY_TRUNCATE){
+    if(io->use_xdr){
+      if(Xdr_encode_array(DataType, (size_t)Count, pXdrBuf, pXdrBuf,
+			  NumBytes) != REG_SUCCESS){
+	return REG_FALSE;
+      }
+      *EmitType = Xdr_type_from_native(DataType);
+      io->num_xdr_slices++;
     }
     else{
-      IOTypes_table.io_def[IOTypeIndex].convert_array_order = REG_FALSE;
+      io->num_native_slices++;
     }
   }
-  else{
-    IOTypes_table.io_def[IOTypeIndex].convert_array_order = REG_FALSE;
-  }
-  */
 
-  return REG_SUCCESS;
+  io->lossy_bytes_saved += (double)(Count*Sizeof_type(DataType)) -
+    (double)(*NumBytes);
+  if(max_err > io->lossy_max_error) io->lossy_max_error = max_err;
+
+  return REG_TRUE;
 }
 
 /*----------------------------------------------------------------*/
 
-int Consume_data_slice(int    IOTypeIndex,
-		       int    DataType,
-		       int    Count,
-		       void  *pData)
+int Encode_data_slice(int          IOTypeIndex,
+		      int          DataType,
+		      int          Count,
+		      const void  *pData,
+		      void        *pXdrBuf,
+		      int         *EmitType,
+		      size_t      *NumBytes,
+		      void       **pOut)
 {
-  int              return_status = REG_SUCCESS;
-  size_t	   num_bytes_to_read;
-
-  /* Check that steering is enabled */
-  if(!ReG_SteeringEnabled) return REG_SUCCESS;
-
-  /* Check that this IOType is enabled */
-  if(IOTypes_table.io_def[IOTypeIndex].is_enabled == REG_FALSE) {
-    return REG_FAILURE;
-  }
-
-  /* Calculate how many bytes to expect */
-  switch(DataType) {
+  switch(DataType){
 
-  case REG_INT:
-    if(IOTypes_table.io_def[IOTypeIndex].use_xdr) {
-      num_bytes_to_read = IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes;
-    }
-    else {
-      num_bytes_to_read = Count*sizeof(int);
+  case REG_FLOAT:
+  case REG_DBL:
+    /* Visualisation data may not need to be sent exactly */
+    if(encode_lossy(IOTypeIndex, DataType, Count, pData, pXdrBuf,
+		    EmitType, NumBytes)){
+      *pOut = pXdrBuf;
+      break;
     }
-    break;
+    /* Fall through */
 
+  case REG_INT:
   case REG_LONG:
-    if(IOTypes_table.io_def[IOTypeIndex].use_xdr) {
-      num_bytes_to_read = IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes;
-    }
-    else {
-      num_bytes_to_read = Count*sizeof(long);
-    }
-    break;
-
-  case REG_FLOAT:
-    if(IOTypes_table.io_def[IOTypeIndex].use_xdr) {
-      num_bytes_to_read = IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes;
-    }
-    else {
-      num_bytes_to_read = Count*sizeof(float);
-    }
-    break;
+    if(IOTypes_table.io_def[IOTypeIndex].use_xdr){
+      *EmitType = Xdr_type_from_native(DataType);
 
-  case REG_DBL:
-    if(IOTypes_table.io_def[IOTypeIndex].use_xdr) {
-      num_bytes_to_read = IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes;
+      /* Encode the whole array in one go */
+      if(Xdr_encode_array(DataType, (size_t)Count, pData, pXdrBuf,
+			  NumBytes) != REG_SUCCESS){
+	fprintf(stderr, "STEER: ERROR: Encode_data_slice: XDR encode "
+		"failed\n");
+	return REG_FAILURE;
+      }
+      *pOut = pXdrBuf;
+      IOTypes_table.io_def[IOTypeIndex].num_xdr_slices++;
     }
-    else {
-      num_bytes_to_read = Count*sizeof(double);
+    else{
+      *EmitType = DataType;
+      *NumBytes = Count*Sizeof_type(DataType);
+      *pOut = (void *)pData;
+      IOTypes_table.io_def[IOTypeIndex].num_native_slices++;
     }
     break;
 
   case REG_CHAR:
-    num_bytes_to_read = Count*sizeof(char);
+    *EmitType = DataType;
+    *NumBytes = Count*sizeof(char);
+    *pOut = (void *)pData;
     break;
 
   default:
-    fprintf(stderr, "STEER: Consume_data_slice: Unrecognised data type specified "
-	    "in slice header\n");
-
-    /* Reset use_xdr flag set as only valid on a per-slice basis */
-    IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_FALSE;
-    IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes = 0;
-
+    fprintf(stderr, "STEER: Encode_data_slice: Unrecognised data type\n");
     return REG_FAILURE;
     break;
   }
 
-  /* Check that input buffer is large enough (only an issue if have XDR-
-     encoded data or need to reorder it) */
-  if(IOTypes_table.io_def[IOTypeIndex].use_xdr ||
-     IOTypes_table.io_def[IOTypeIndex].convert_array_order == REG_TRUE) {
+  return REG_SUCCESS;
+}
 
-    if(IOTypes_table.io_def[IOTypeIndex].buffer_max_bytes < num_bytes_to_read) {
+/*----------------------------------------------------------------*/
 
-      if(Realloc_iotype_buffer(IOTypeIndex, num_bytes_to_read)
-	 != REG_SUCCESS) {
+int Get_slice_codec(int IOTypeIndex)
+{
+  IOdef_entry *io = &(IOTypes_table.io_def[IOTypeIndex]);
 
-	/* Reset use_xdr flag set as only valid on a per-slice basis */
-	IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_FALSE;
-	IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes = 0;
-	return REG_FAILURE;
-      }
-    }
+  /* The codec may have been steered to something we don't have and
+     older consumers cannot be told that the data is compressed */
+  if(io->compression == REG_COMPRESS_NONE ||
+     !Compress_codec_supported(io->compression) ||
+     io->slice_hdr_version < REG_SLICE_HDR_COMPRESS_VERSION) {
+    return REG_COMPRESS_NONE;
   }
 
-  /* Read this number of bytes - if xdr is being used or the array needs to
-     be reordered then the data is read into
-     IOTypes_table.io_def[IOTypeIndex].buffer, else it is stored
-     in the buffer pointed to by pData. */
-  if (Consume_data_read(IOTypeIndex,
-			DataType,
-			num_bytes_to_read,
-			pData) != REG_SUCCESS)
-    return REG_FAILURE;
+  return io->compression;
+}
+
+/*----------------------------------------------------------------*/
 
+int Compress_data_slice(int      IOTypeIndex,
+			int      Codec,
+			void    *pIn,
+			size_t   NumBytes,
+			void    *pCompBuf,
+			int     *EmitCodec,
+			size_t  *SendBytes,
+			void   **pOut)
+{
+  IOdef_entry *io = &(IOTypes_table.io_def[IOTypeIndex]);
+  size_t       comp_bytes;
+  double       time0, time1;
+  int          status;
 
-  /* Re-order and decode (xdr) data as necessary - CURRENTLY
-     ONLY DECODES.*/
-  Reorder_decode_array(&(IOTypes_table.io_def[IOTypeIndex]),
-		       DataType, Count,  pData);
+  *EmitCodec = REG_COMPRESS_NONE;
+  *SendBytes = NumBytes;
+  *pOut = pIn;
 
-  /* Reset use_xdr flag set as only valid on a per-slice basis */
-  IOTypes_table.io_def[IOTypeIndex].use_xdr = REG_FALSE;
-  IOTypes_table.io_def[IOTypeIndex].num_xdr_bytes = 0;
+  /* Small slices aren't worth the effort */
+  if(Codec == REG_COMPRESS_NONE || NumBytes < REG_COMPRESS_MIN_BYTES) {
+    return REG_SUCCESS;
+  }
 
-  return return_status;
+  comp_bytes = Compress_bound(Codec, NumBytes);
+  Get_current_time_seconds(&time0);
+  status = Compress_data(Codec, pIn, NumBytes, pCompBuf, &comp_bytes);
+  Get_current_time_seconds(&time1);
+  io->comp_time += (float)(time1 - time0);
+
+  /* Send the data as it is if it didn't shrink */
+  if(status == REG_SUCCESS && comp_bytes < NumBytes) {
+    *EmitCodec = Codec;
+    *SendBytes = comp_bytes;
+    *pOut = pCompBuf;
+  }
+
+  io->comp_raw_bytes += (double)NumBytes;
+  io->comp_bytes += (double)(*SendBytes);
+  io->comp_ratio = (float)(io->comp_raw_bytes/io->comp_bytes);
+
+  return REG_SUCCESS;
 }
 
 /*----------------------------------------------------------------*/
 
-int Emit_start(int  IOType,
-	       int  SeqNum,
-	       int *IOTypeIndex)
+void Emit_delta_start(int IOTypeIndex)
 {
-  /* Check that steering is enabled */
-  if(!ReG_SteeringEnabled) return REG_SUCCESS;
-
-  /* Can only call this function if steering lib initialised */
-  if (!ReG_SteeringInit) return REG_FAILURE;
+  IOdef_entry *io = &(IOTypes_table.io_def[IOTypeIndex]);
 
-  /* Find corresponding entry in table of IOtypes */
-  *IOTypeIndex = IOdef_index_from_handle(&IOTypes_table, IOType);
-  if(*IOTypeIndex == REG_IODEF_HANDLE_NOTSET){
+  io->delta_slice = 0;
+  if(io->delta_interval <= 0) return;
 
-    fprintf(stderr, "STEER: Emit_start: failed to find matching IOType\n");
-    return REG_FAILURE;
+  /* A consumer that can't take deltas is sent whole samples and the
+     first one it gets once it can must be a key frame */
+  if(io->slice_hdr_version < REG_SLICE_HDR_DELTA_VERSION) {
+    io->delta_key_needed = REG_TRUE;
+    return;
   }
 
-  /* Check that this IOType is enabled */
-  if(IOTypes_table.io_def[*IOTypeIndex].is_enabled == REG_FALSE){
-    return REG_FAILURE;
+  if(io->delta_key_needed == REG_TRUE ||
+     io->delta_count >= io->delta_interval) {
+    io->delta_is_key = REG_TRUE;
+    io->delta_count = 0;
+    io->delta_key_needed = REG_FALSE;
   }
-
-  /* Check that this IOType can be emitted */
-  if(IOTypes_table.io_def[*IOTypeIndex].direction == REG_IO_IN){
-
-    fprintf(stderr, "STEER: ERROR: Emit_start: IOType with index %d has "
-	    "direction REG_IO_IN\n", *IOTypeIndex);
-    return REG_FAILURE;
+  else {
+    io->delta_is_key = REG_FALSE;
   }
+  io->delta_count++;
+}
 
-  /* Set whether or not to encode as XDR */
-  IOTypes_table.io_def[*IOTypeIndex].use_xdr = REG_TRUE;
+/*----------------------------------------------------------------*/
 
-  /* Initialise array-ordering flags */
-  IOTypes_table.io_def[*IOTypeIndex].convert_array_order = REG_FALSE;
+int Delta_encode_slice(int     IOTypeIndex,
+		       int     EmitType,
+		       void   *pIn,
+		       size_t  NumBytes,
+		       void   *pDeltaBuf,
+		       void  **pOut,
+		       int    *Flags)
+{
+  IOdef_entry    *io = &(IOTypes_table.io_def[IOTypeIndex]);
+  Delta_ref_type *ref;
 
-  if(Consume_ack(*IOTypeIndex) != REG_SUCCESS){
-    return REG_NOT_READY;
+  *Flags = 0;
+  *pOut = pIn;
+
+  if(io->delta_interval <= 0 ||
+     io->slice_hdr_version < REG_SLICE_HDR_DELTA_VERSION) {
+    return REG_SUCCESS;
   }
 
-  if(Emit_start_impl(*IOTypeIndex, SeqNum) != REG_SUCCESS)
+  if(!(ref = Get_delta_ref(io, io->delta_slice++))) {
+    io->delta_key_needed = REG_TRUE;
     return REG_FAILURE;
+  }
 
-  if(Emit_header(*IOTypeIndex) != REG_SUCCESS) {
-    IOTypes_table.io_def[*IOTypeIndex].ack_needed = REG_FALSE;
+  /* A slice that has changed shape since the last sample can only be
+     sent whole */
+  if(!io->delta_is_key && ref->nbytes == NumBytes &&
+     ref->type == EmitType && ref->data) {
+    Delta_xor(pIn, pDeltaBuf, ref->data, NumBytes, REG_TRUE);
+    *Flags = REG_SLICE_FLAG_DELTA;
+    *pOut = pDeltaBuf;
+    return REG_SUCCESS;
+  }
+
+  if(Set_delta_ref(ref, EmitType, pIn, NumBytes) != REG_SUCCESS) {
+    io->delta_key_needed = REG_TRUE;
     return REG_FAILURE;
   }
+  *Flags = REG_SLICE_FLAG_KEY;
 
   return REG_SUCCESS;
 }
 
 /*----------------------------------------------------------------*/
 
-int Emit_start_blocking(int    IOType,
-			int    SeqNum,
-			int   *IOTypeIndex,
-			float  TimeOut)
+int Emit_data_slice(int		      IOTypeIndex,
+		    int               DataType,
+		    int               Count,
+		    const void       *pData)
 {
-  unsigned long time_out_uS; /* microseconds */
-  unsigned long blocked_poll_interval = 10000; /* microseconds */
-  unsigned long wait_time;
-  int           status;
+  int              datatype;
+  int              codec;
+  int              flags;
+  size_t	   num_bytes_to_send;
+  size_t           num_raw_bytes;
+  void            *out_ptr;
+  struct reg_data_slice slice;
 
   /* Check that steering is enabled */
   if(!ReG_SteeringEnabled) return REG_SUCCESS;
 
   /* Can only call this function if steering lib initialised */
-  if(!ReG_SteeringInit) return REG_FAILURE;
+  if (!ReG_SteeringInit) return REG_FAILURE;
 
-  /* Convert time out from seconds to microseconds */
-  time_out_uS = (unsigned long)(TimeOut*1000000);
+  if(IOTypeIndex < 0 || IOTypeIndex >= IOTypes_table.num_registered){
+    fprintf(stderr, "STEER: ERROR: Emit_data_slice: invalid IOType "
+	    "handle (%d) supplied\n", IOTypeIndex);
+    return REG_FAILURE;
+  }
 
-  wait_time = 0;
-  while((status = Emit_start(IOType, SeqNum, IOTypeIndex)) != REG_SUCCESS) {
+  /* Asynchronous IOTypes just take a copy of the data */
+  if(IOTypes_table.io_def[IOTypeIndex].is_async){
+    if(IOTypes_table.io_def[IOTypeIndex].is_enabled == REG_FALSE){
+      return REG_FAILURE;
+    }
+    return Async_emit_slice(IOTypeIndex, DataType, Count, pData,
+			    ReG_CalledFromF90);
+  }
 
-    usleep(blocked_poll_interval);
-    if((wait_time += blocked_poll_interval) > time_out_uS) {
-#ifdef REG_DEBUG
-      fprintf(stderr, "STEER: Emit_start_blocking: timed out\n");
-#endif
-      status = REG_TIMED_OUT;
-      break;
+  /* check comms connection has been made */
+  if (Get_communication_status(IOTypeIndex) !=  REG_SUCCESS)
+    return REG_FAILURE;
+
+  /* Check that this IOType is enabled */
+  if(IOTypes_table.io_def[IOTypeIndex].is_enabled == REG_FALSE){
+    return REG_FAILURE;
+  }
+
+  /* Arrays being cut down to the consumer's region or sent a level
+     of detail at a time go by way of Send_data_slices(), which keeps
+     track of the chunk headers */
+  if(IOTypes_table.io_def[IOTypeIndex].use_region ||
+     IOTypes_table.io_def[IOTypeIndex].num_levels > 1){
+    slice.type = DataType;
+    slice.count = Count;
+    slice.data = (void*) pData;
+    if(Send_data_slices(IOTypeIndex, 1, &slice, ReG_CalledFromF90,
+			Steer_lib_config.scratch_buffer) != REG_SUCCESS){
+      IOTypes_table.io_def[IOTypeIndex].ack_needed = REG_FALSE;
+      return REG_FAILURE;
     }
+    return REG_SUCCESS;
   }
 
-  return status;
-}
+  /* Make sure there is room to encode the data if required */
+  num_bytes_to_send = Encoded_size_bound(IOTypeIndex, DataType, Count);
+  if(num_bytes_to_send > 0){
 
-/*----------------------------------------------------------------*/
+    if(num_bytes_to_send > IOTypes_table.io_def[IOTypeIndex].buffer_max_bytes){
 
-int Emit_stop(int *IOTypeIndex)
-{
-  int return_status = REG_SUCCESS;
+      /* This function will malloc if buffer not already set */
+      if(Realloc_iotype_buffer(IOTypeIndex, num_bytes_to_send)
+	 != REG_SUCCESS){
+	IOTypes_table.io_def[IOTypeIndex].ack_needed = REG_FALSE;
+	return REG_FAILURE;
+      }
+    }
+  }
 
-  if(*IOTypeIndex < 0 || *IOTypeIndex >= IOTypes_table.num_registered){
-    fprintf(stderr, "STEER: ERROR: Emit_stop: invalid IOType handle "
-	    "(%d) supplied\n", *IOTypeIndex);
+  /* Check data type, calculate number of bytes to send and convert
+     to XDR if required */
+  if(Encode_data_slice(IOTypeIndex, DataType, Count, pData,
+		       IOTypes_table.io_def[IOTypeIndex].buffer,
+		       &datatype, &num_raw_bytes,
+		       &out_ptr) != REG_SUCCESS){
+    IOTypes_table.io_def[IOTypeIndex].ack_needed = REG_FALSE;
     return REG_FAILURE;
   }
 
-  /* Check that steering is enabled */
-  if(!ReG_SteeringEnabled) return REG_SUCCESS;
-
-  /* Can only call this function if steering lib initialised */
-  if (!ReG_SteeringInit) return REG_FAILURE;
-
-  /* Check that this IOType is enabled */
-  if(IOTypes_table.io_def[*IOTypeIndex].is_enabled == REG_FALSE){
+  /* Send only what has changed since the last sample if the IOType
+     asks for it */
+  if(Delta_encode_slice(IOTypeIndex, datatype, out_ptr, num_raw_bytes,
+			IOTypes_table.io_def[IOTypeIndex].buffer,
+			&out_ptr, &flags) != REG_SUCCESS){
+    IOTypes_table.io_def[IOTypeIndex].ack_needed = REG_FALSE;
     return REG_FAILURE;
   }
 
-  /* Send footer */
-  sprintf(Steer_lib_config.scratch_buffer, REG_PACKET_FORMAT, REG_DATA_FOOTER);
-  /* Include termination char WITHIN the packet */
-  Steer_lib_config.scratch_buffer[REG_PACKET_SIZE-1] = '\0';
+  /* Compress the (encoded) data if the IOType asks for it */
+  codec = Get_slice_codec(IOTypeIndex);
+  if(codec != REG_COMPRESS_NONE && num_raw_bytes >= REG_COMPRESS_MIN_BYTES){
+    if(Realloc_iotype_comp_buffer(IOTypeIndex,
+				  Compress_bound(codec, num_raw_bytes))
+       != REG_SUCCESS){
+      IOTypes_table.io_def[IOTypeIndex].ack_needed = REG_FALSE;
+      return REG_FAILURE;
+    }
+  }
+  Compress_data_slice(IOTypeIndex, codec, out_ptr, num_raw_bytes,
+		      IOTypes_table.io_def[IOTypeIndex].comp_buffer,
+		      &codec, &num_bytes_to_send, &out_ptr);
 
-  return_status = Emit_footer(*IOTypeIndex, Steer_lib_config.scratch_buffer);
+  /* Send ReG-specific header */
 
-  Emit_stop_impl(*IOTypeIndex);
+  if( Emit_iotype_msg_header(IOTypeIndex,
+			     datatype,
+			     Count,
+			     num_bytes_to_send,
+			     ReG_CalledFromF90,
+			     codec,
+			     (int)num_raw_bytes,
+			     flags) == REG_SUCCESS){
 
-  /* Flag that we'll want an acknowledgement of this data set
-     before we try to read another one */
-  if(return_status == REG_SUCCESS){
-    IOTypes_table.io_def[*IOTypeIndex].ack_needed = REG_TRUE;
-#ifdef REG_DEBUG_FULL
-    fprintf(stderr, "STEER: INFO: Emit_stop: set ack_needed = "
-	    "REG_TRUE for index %d\n", *IOTypeIndex);
-#endif
-  }
-  else{
-    IOTypes_table.io_def[*IOTypeIndex].ack_needed = REG_FALSE;
-#ifdef REG_DEBUG_FULL
-    fprintf(stderr, "STEER: INFO: Emit_stop: set ack_needed = "
-	    "REG_FALSE for index %d\n", *IOTypeIndex);
-#endif
+    /* Send data */
+    if( Emit_data(IOTypeIndex,
+		  datatype,
+		  num_bytes_to_send,
+		  out_ptr) == REG_SUCCESS) return REG_SUCCESS;
   }
 
-  *IOTypeIndex = REG_IODEF_HANDLE_NOTSET;
-
-  return return_status;
+  IOTypes_table.io_def[IOTypeIndex].ack_needed = REG_FALSE;
+  return REG_FAILURE;
 }
 
 /*----------------------------------------------------------------*/
 
-int Emit_data_slice(int		      IOTypeIndex,
-		    int               DataType,
-		    int               Count,
-		    const void       *pData)
+int Emit_data_slices(int                          IOTypeIndex,
+		     int                          NumSlices,
+		     const struct reg_data_slice *Slices)
 {
-  int              datatype;
-  int              actual_count;
-  size_t	   num_bytes_to_send;
-  XDR              xdrs;
-  void            *out_ptr;
+  int i;
 
   /* Check that steering is enabled */
   if(!ReG_SteeringEnabled) return REG_SUCCESS;
@@ -1796,13 +4155,15 @@ int Emit_data_slice(int		      IOTypeIndex,
   if (!ReG_SteeringInit) return REG_FAILURE;
 
   if(IOTypeIndex < 0 || IOTypeIndex >= IOTypes_table.num_registered){
-    fprintf(stderr, "STEER: ERROR: Emit_data_slice: invalid IOType "
+    fprintf(stderr, "STEER: ERROR: Emit_data_slices: invalid IOType "
 	    "handle (%d) supplied\n", IOTypeIndex);
     return REG_FAILURE;
   }
 
-  /* check comms connection has been made */
-  if (Get_communication_status(IOTypeIndex) !=  REG_SUCCESS)
+  /* check comms connection has been made - for asynchronous IOTypes
+     that is up to the I/O thread */
+  if (!IOTypes_table.io_def[IOTypeIndex].is_async &&
+      Get_communication_status(IOTypeIndex) !=  REG_SUCCESS)
     return REG_FAILURE;
 
   /* Check that this IOType is enabled */
@@ -1810,176 +4171,596 @@ int Emit_data_slice(int		      IOTypeIndex,
     return REG_FAILURE;
   }
 
-  actual_count = Count;
+  /* Check the whole batch before any of it is sent */
+  if(NumSlices < 0 || (NumSlices > 0 && !Slices)){
+    fprintf(stderr, "STEER: ERROR: Emit_data_slices: invalid batch of "
+	    "%d slices\n", NumSlices);
+    return REG_FAILURE;
+  }
+  for(i = 0; i < NumSlices; i++){
+    if(Slices[i].count < 0 || (Slices[i].count > 0 && !Slices[i].data)){
+      fprintf(stderr, "STEER: ERROR: Emit_data_slices: slice %d has "
+	      "no data or a negative count\n", i);
+      return REG_FAILURE;
+    }
+    if(!Sizeof_type(Slices[i].type)){
+      fprintf(stderr, "STEER: ERROR: Emit_data_slices: slice %d has "
+	      "unrecognised data type %d\n", i, Slices[i].type);
+      return REG_FAILURE;
+    }
+  }
 
-  /* Check data type, calculate number of bytes to send and convert
-     to XDR if required */
-  switch(DataType){
+  if(IOTypes_table.io_def[IOTypeIndex].is_async){
+    for(i = 0; i < NumSlices; i++){
+      if(Async_emit_slice(IOTypeIndex, Slices[i].type, Slices[i].count,
+			  Slices[i].data, ReG_CalledFromF90) != REG_SUCCESS){
+	return REG_FAILURE;
+      }
+    }
+    return REG_SUCCESS;
+  }
 
-  case REG_INT:
-    if(IOTypes_table.io_def[IOTypeIndex].use_xdr){
-      datatype = REG_XDR_INT;
-      num_bytes_to_send = actual_count*REG_MAX_SIZEOF_XDR_TYPE;
+  if(Send_data_slices(IOTypeIndex, NumSlices, Slices, ReG_CalledFromF90,
+		      Steer_lib_config.scratch_buffer) != REG_SUCCESS){
+    IOTypes_table.io_def[IOTypeIndex].ack_needed = REG_FALSE;
+    return REG_FAILURE;
+  }
+
+  return REG_SUCCESS;
+}
 
-      if(num_bytes_to_send > IOTypes_table.io_def[IOTypeIndex].buffer_max_bytes){
+/*----------------------------------------------------------------*/
 
-	if(Realloc_iotype_buffer(IOTypeIndex, num_bytes_to_send)
-	   != REG_SUCCESS){
-	  IOTypes_table.io_def[IOTypeIndex].ack_needed = REG_FALSE;
-	  return REG_FAILURE;
+/** @internal
+    As Send_data_slices() but sends every slice as it is. */
+static int send_whole_slices(int                          IOTypeIndex,
+			     int                          NumSlices,
+			     const struct reg_data_slice *Slices,
+			     int                          IsFortranArray,
+			     char                        *HdrBuffer)
+{
+  int    i, j, n;
+  int    datatype;
+  int    codec, slice_codec;
+  int    flags;
+  size_t num_xdr_bytes;
+  size_t num_comp_bytes;
+  size_t num_raw_bytes;
+  size_t num_bytes[2*REG_SLICE_BATCH_SIZE];
+  void  *bufs[2*REG_SLICE_BATCH_SIZE];
+  char  *phdr;
+  char  *pxdr;
+  char  *pcomp;
+
+  codec = Get_slice_codec(IOTypeIndex);
+
+  /* Headers are built in HdrBuffer and XDR-encoded data in the
+     IOType's buffer so take the slices a batch at a time */
+  for(i = 0; i < NumSlices; i += n){
+    n = NumSlices - i;
+    if(n > REG_SLICE_BATCH_SIZE) n = REG_SLICE_BATCH_SIZE;
+
+    num_xdr_bytes = 0;
+    for(j = i; j < i + n; j++){
+      num_xdr_bytes += Encoded_size_bound(IOTypeIndex, Slices[j].type,
+					  Slices[j].count);
+    }
+
+    if(num_xdr_bytes > IOTypes_table.io_def[IOTypeIndex].buffer_max_bytes){
+      if(Realloc_iotype_buffer(IOTypeIndex, num_xdr_bytes) != REG_SUCCESS){
+	return REG_FAILURE;
+      }
+    }
+
+    /* Compressed slices are packed one after another too */
+    if(codec != REG_COMPRESS_NONE){
+      num_comp_bytes = 0;
+      for(j = i; j < i + n; j++){
+	num_raw_bytes = Encoded_size_bound(IOTypeIndex, Slices[j].type,
+					   Slices[j].count);
+	if(num_raw_bytes < Slices[j].count*(size_t)Sizeof_type(Slices[j].type)){
+	  num_raw_bytes = Slices[j].count*Sizeof_type(Slices[j].type);
+	}
+	if(num_raw_bytes >= REG_COMPRESS_MIN_BYTES){
+	  num_comp_bytes += Compress_bound(codec, num_raw_bytes);
+	}
+      }
+      if(Realloc_iotype_comp_buffer(IOTypeIndex,
+				    num_comp_bytes) != REG_SUCCESS){
+	return REG_FAILURE;
+      }
+    }
+
+    phdr = HdrBuffer;
+    pxdr = (char*) IOTypes_table.io_def[IOTypeIndex].buffer;
+    pcomp = (char*) IOTypes_table.io_def[IOTypeIndex].comp_buffer;
+
+    for(j = 0; j < n; j++){
+      if(Encode_data_slice(IOTypeIndex, Slices[i+j].type, Slices[i+j].count,
+			   Slices[i+j].data, pxdr, &datatype,
+			   &num_raw_bytes,
+			   &(bufs[2*j+1])) != REG_SUCCESS){
+	return REG_FAILURE;
+      }
+      if(Delta_encode_slice(IOTypeIndex, datatype, bufs[2*j+1],
+			    num_raw_bytes, pxdr, &(bufs[2*j+1]),
+			    &flags) != REG_SUCCESS){
+	return REG_FAILURE;
+      }
+      if(bufs[2*j+1] == (void*) pxdr) pxdr += num_raw_bytes;
+
+      Compress_data_slice(IOTypeIndex, codec, bufs[2*j+1], num_raw_bytes,
+			  pcomp, &slice_codec, &(num_bytes[2*j+1]),
+			  &(bufs[2*j+1]));
+      if(bufs[2*j+1] == (void*) pcomp) pcomp += num_bytes[2*j+1];
+
+      bufs[2*j] = (void*) phdr;
+      num_bytes[2*j] = Pack_iotype_msg_header(IOTypeIndex, datatype,
+					      Slices[i+j].count,
+					      (int) num_bytes[2*j+1],
+					      IsFortranArray, slice_codec,
+					      (int) num_raw_bytes, flags,
+					      phdr);
+      phdr += num_bytes[2*j];
+    }
+
+    /* Send the headers and data for the whole batch in one go */
+    if(Emit_data_batch_impl(IOTypeIndex, 2*n, bufs,
+			    num_bytes) != REG_SUCCESS){
+      return REG_FAILURE;
+    }
+  }
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    @param region The region to set
+    @param is_f90 Whether the region is of an array in F90 ordering
+    @param start Origin of the region along each axis, from the axis
+    that varies slowest to the one that varies fastest
+    @param len Extent of the region along each axis, likewise
+    @param stride Stride of the region along each axis, likewise
+
+    Sets a region with its axes in storage order. */
+static void set_level_region(Region_type *region,
+			     int          is_f90,
+			     const int   *start,
+			     const int   *len,
+			     const int   *stride)
+{
+  int x = is_f90 ? 2 : 0;
+  int z = 2 - x;
+
+  region->sx = start[x]; region->nx = len[x]; region->dx = stride[x];
+  region->sy = start[1]; region->ny = len[1]; region->dy = stride[1];
+  region->sz = start[z]; region->nz = len[z]; region->dz = stride[z];
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    @param IOTypeIndex Index of the IOType
+    @param Slice A numeric slice holding the block described by the
+    chunk header held in the IOType's @p level_header
+    @param IsFortranArray Whether the slice is from a Fortran array
+    @param HdrBuffer As for Send_data_slices()
+    @return REG_SUCCESS or REG_FAILURE
+
+    Sends a block a level of detail at a time, coarsest first.  The
+    coarsest level is every 2^(n-1)th element along each axis from the
+    origin of the block, for n levels.  Each finer level adds the
+    planes (normal to the axis that varies slowest) half way between
+    those already sent, then the rows half way between those already
+    sent in the other planes, then the elements half way between those
+    already sent in the other rows.  Every element of the block is
+    sent just once and, at full resolution, two of those three parts
+    are whole rows.  Each part is gathered into the IOType's
+    @p level_buffer a few planes at a time (see REG_LEVEL_PART_SIZE)
+    and sent after a chunk header that says where in the block it
+    goes. */
+static int send_level_parts(int                          IOTypeIndex,
+			    const struct reg_data_slice *Slice,
+			    int                          IsFortranArray,
+			    char                        *HdrBuffer)
+{
+  IOdef_entry          *io = &(IOTypes_table.io_def[IOTypeIndex]);
+  Array_type           *block = &(io->level_header);
+  Chunk_level_type      level;
+  Region_type           part[3];
+  Region_type           lattice;
+  Array_type            cut;
+  struct reg_data_slice slices[2];
+  char                  chunk_hdr[REG_CHUNK_HDR_SIZE];
+  int                   first[3];
+  int                   start[3], len[3], stride[3];
+  int                   num_planes[3];
+  int                   num_pieces[3];
+  int                   extent;
+  int                   coarsest;
+  int                   n, p, q, r, s;
+  size_t                elem_size;
+  size_t                plane_bytes;
+
+  elem_size = (size_t) Sizeof_type(Slice->type);
+
+  /* No coarser than one element across the longest axis */
+  extent = block->nx;
+  if(block->ny > extent) extent = block->ny;
+  if(block->nz > extent) extent = block->nz;
+  level.num_levels = io->num_levels;
+  while(level.num_levels > 1 && (1 << (level.num_levels - 1)) >= extent){
+    level.num_levels--;
+  }
+
+  slices[0].type = REG_CHAR;
+  slices[0].data = (void*) chunk_hdr;
+
+  /* A block too small to be worth it goes as it is */
+  if(level.num_levels == 1){
+    Pack_chunk_header(chunk_hdr, block, NULL);
+    slices[0].count = (int) strlen(chunk_hdr);
+    slices[1] = *Slice;
+    return send_whole_slices(IOTypeIndex, 2, slices, IsFortranArray,
+			     HdrBuffer);
+  }
+
+  slices[1].type = Slice->type;
+
+  for(level.level = level.num_levels - 1; level.level >= 0;
+      level.level--){
+
+    coarsest = (level.level == level.num_levels - 1);
+    s = 1 << level.level;
+    n = coarsest ? 1 : 3;
+
+    /* Work out the parts first as the chunk headers give their no. */
+    level.num_parts = 0;
+    for(p = 0; p < n; p++){
+      for(r = 0; r < 3; r++){
+	start[r] = (!coarsest && r == p) ? s : 0;
+	len[r] = 0;
+	stride[r] = (coarsest || r > p) ? s : 2*s;
+      }
+      set_level_region(&(part[p]), block->is_f90, start, len, stride);
+
+      /* Thin blocks have nothing in some parts */
+      num_planes[p] = 1;
+      num_pieces[p] = 0;
+      if(clip_level_part(block, &(part[p]), &lattice, &cut,
+			 first) == REG_SUCCESS){
+	extent = block->is_f90 ? cut.nz : cut.nx;
+	plane_bytes = (size_t) cut.nx*cut.ny*cut.nz/extent*elem_size;
+	if(plane_bytes < REG_LEVEL_PART_SIZE){
+	  num_planes[p] = (int) (REG_LEVEL_PART_SIZE/plane_bytes);
 	}
+	num_pieces[p] = (extent + num_planes[p] - 1)/num_planes[p];
       }
+      level.num_parts += num_pieces[p];
+    }
+
+    level.part = 0;
+    for(p = 0; p < n; p++){
+      for(q = 0; q < num_pieces[p]; q++){
+
+	/* A few planes of the part at a time */
+	start[0] = block->is_f90 ? part[p].sz : part[p].sx;
+	stride[0] = block->is_f90 ? part[p].dz : part[p].dx;
+	start[0] += q*num_planes[p]*stride[0];
+	len[0] = num_planes[p]*stride[0];
+	level.region = part[p];
+	if(block->is_f90){
+	  level.region.sz = start[0];
+	  level.region.nz = len[0];
+	}
+	else{
+	  level.region.sx = start[0];
+	  level.region.nx = len[0];
+	}
+	clip_level_part(block, &(level.region), &lattice, &cut, first);
 
-      xdrmem_create(&xdrs,
-		    IOTypes_table.io_def[IOTypeIndex].buffer,
-		    num_bytes_to_send,
-		    XDR_ENCODE);
-      xdr_vector(&xdrs, (char *)pData, (unsigned int)actual_count,
-		 (unsigned int)sizeof(int), (xdrproc_t)xdr_int);
+	slices[1].count = cut.nx*cut.ny*cut.nz;
+	if(Realloc_scratch_buffer(io, &(io->level_buffer),
+				  &(io->level_buffer_max_bytes),
+				  (size_t) slices[1].count*elem_size,
+				  "Send_data_slices") != REG_SUCCESS){
+	  return REG_FAILURE;
+	}
+	slices[1].data = io->level_buffer;
+	Region_extract(block, first, &cut, &lattice, elem_size, Slice->data,
+		       io->level_buffer);
 
-      num_bytes_to_send = (int)xdr_getpos(&xdrs);
-      out_ptr = IOTypes_table.io_def[IOTypeIndex].buffer;
+	Pack_chunk_header(chunk_hdr, block, &level);
+	slices[0].count = (int) strlen(chunk_hdr);
 
-      xdr_destroy(&xdrs);
+	if(send_whole_slices(IOTypeIndex, 2, slices, IsFortranArray,
+			     HdrBuffer) != REG_SUCCESS){
+	  return REG_FAILURE;
+	}
+	level.part++;
+      }
     }
-    else{
-      datatype = DataType;
-      num_bytes_to_send = actual_count*sizeof(int);
-      out_ptr = (void *)pData;
+  }
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    @param IOTypeIndex Index of the IOType
+    @param Batch The batch of slices being built up
+    @param n The no. of slices in @p Batch, updated on return
+    @param Slice The slice to add to the batch
+    @param IsFortranArray Whether the slices are from a Fortran array
+    @param HdrBuffer As for Send_data_slices()
+    @return REG_SUCCESS or REG_FAILURE
+
+    Adds a slice to a batch and sends the batch once it is full. */
+static int add_level_slice(int                          IOTypeIndex,
+			   struct reg_data_slice       *Batch,
+			   int                         *n,
+			   const struct reg_data_slice *Slice,
+			   int                          IsFortranArray,
+			   char                        *HdrBuffer)
+{
+  Batch[(*n)++] = *Slice;
+  if(*n < REG_SLICE_BATCH_SIZE) return REG_SUCCESS;
+
+  *n = 0;
+  return send_whole_slices(IOTypeIndex, REG_SLICE_BATCH_SIZE, Batch,
+			   IsFortranArray, HdrBuffer);
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    As Send_data_slices() but sends each array of REG_INT, REG_LONG,
+    REG_FLOAT or REG_DBL that follows a chunk header a level of detail
+    at a time, by send_level_parts(), in place of the chunk header.
+    Anything else is sent as it is. */
+static int send_level_slices(int                          IOTypeIndex,
+			     int                          NumSlices,
+			     const struct reg_data_slice *Slices,
+			     int                          IsFortranArray,
+			     char                        *HdrBuffer)
+{
+  IOdef_entry          *io = &(IOTypes_table.io_def[IOTypeIndex]);
+  struct reg_data_slice batch[REG_SLICE_BATCH_SIZE];
+  struct reg_data_slice header;
+  char                  chunk_hdrs[REG_SLICE_BATCH_SIZE][REG_CHUNK_HDR_SIZE];
+  Array_type            chunk;
+  int                   i, n = 0;
+
+  header.type = REG_CHAR;
+
+  for(i = 0; i < NumSlices; i++){
+
+    if(Slices[i].type == REG_CHAR &&
+       Unpack_chunk_header((const char*) Slices[i].data,
+			   (size_t) Slices[i].count, &chunk,
+			   NULL) == REG_SUCCESS){
+      /* This one is held until we see what follows it, so the one
+	 before it (if any) had no array after it */
+      if(io->level_pending){
+	Pack_chunk_header(chunk_hdrs[n], &(io->level_header), NULL);
+	header.data = (void*) chunk_hdrs[n];
+	header.count = (int) strlen(chunk_hdrs[n]);
+	if(add_level_slice(IOTypeIndex, batch, &n, &header, IsFortranArray,
+			   HdrBuffer) != REG_SUCCESS){
+	  return REG_FAILURE;
+	}
+      }
+      io->level_header = chunk;
+      io->level_pending = REG_TRUE;
+      continue;
     }
-    break;
 
-  case REG_LONG:
-    if(IOTypes_table.io_def[IOTypeIndex].use_xdr){
-      datatype = REG_XDR_LONG;
-      num_bytes_to_send = actual_count*REG_MAX_SIZEOF_XDR_TYPE;
+    if(io->level_pending){
+      io->level_pending = REG_FALSE;
 
-      if(num_bytes_to_send > IOTypes_table.io_def[IOTypeIndex].buffer_max_bytes){
+      if((Slices[i].type == REG_INT || Slices[i].type == REG_LONG ||
+	  Slices[i].type == REG_FLOAT || Slices[i].type == REG_DBL) &&
+	 Slices[i].count == io->level_header.nx*io->level_header.ny*
+	 io->level_header.nz && io->level_header.nx > 0 &&
+	 io->level_header.ny > 0 && io->level_header.nz > 0){
 
-	if(Realloc_iotype_buffer(IOTypeIndex, num_bytes_to_send)
-	   != REG_SUCCESS){
-	  IOTypes_table.io_def[IOTypeIndex].ack_needed = REG_FALSE;
+	/* Keep everything in the order it was emitted */
+	if(n > 0 && send_whole_slices(IOTypeIndex, n, batch, IsFortranArray,
+				      HdrBuffer) != REG_SUCCESS){
 	  return REG_FAILURE;
 	}
-      }
-
-      xdrmem_create(&xdrs,
-		    IOTypes_table.io_def[IOTypeIndex].buffer,
-		    num_bytes_to_send,
-		    XDR_ENCODE);
-      xdr_vector(&xdrs, (char *)pData, (unsigned int)actual_count,
-		 (unsigned int)sizeof(long), (xdrproc_t)xdr_long);
+	n = 0;
 
-      num_bytes_to_send = (int)xdr_getpos(&xdrs);
-      out_ptr = IOTypes_table.io_def[IOTypeIndex].buffer;
+	if(send_level_parts(IOTypeIndex, &(Slices[i]), IsFortranArray,
+			    HdrBuffer) != REG_SUCCESS){
+	  return REG_FAILURE;
+	}
+	continue;
+      }
 
-      xdr_destroy(&xdrs);
-    }
-    else{
-      datatype = DataType;
-      num_bytes_to_send = actual_count*sizeof(int);
-      out_ptr = (void *)pData;
+      Pack_chunk_header(chunk_hdrs[n], &(io->level_header), NULL);
+      header.data = (void*) chunk_hdrs[n];
+      header.count = (int) strlen(chunk_hdrs[n]);
+      if(add_level_slice(IOTypeIndex, batch, &n, &header, IsFortranArray,
+			 HdrBuffer) != REG_SUCCESS){
+	return REG_FAILURE;
+      }
     }
-    break;
 
-  case REG_FLOAT:
-    if(IOTypes_table.io_def[IOTypeIndex].use_xdr){
-      datatype = REG_XDR_FLOAT;
-      num_bytes_to_send = actual_count*REG_MAX_SIZEOF_XDR_TYPE;
+    if(add_level_slice(IOTypeIndex, batch, &n, &(Slices[i]),
+		       IsFortranArray, HdrBuffer) != REG_SUCCESS){
+      return REG_FAILURE;
+    }
+  }
 
-      if(num_bytes_to_send > IOTypes_table.io_def[IOTypeIndex].buffer_max_bytes){
+  if(n > 0){
+    return send_whole_slices(IOTypeIndex, n, batch, IsFortranArray,
+			     HdrBuffer);
+  }
 
-	if(Realloc_iotype_buffer(IOTypeIndex, num_bytes_to_send)
-	   != REG_SUCCESS){
-	  IOTypes_table.io_def[IOTypeIndex].ack_needed = REG_FALSE;
-	  return REG_FAILURE;
-	}
-      }
+  return REG_SUCCESS;
+}
 
-      xdrmem_create(&xdrs,
-		    IOTypes_table.io_def[IOTypeIndex].buffer,
-		    num_bytes_to_send,
-		    XDR_ENCODE);
-      xdr_vector(&xdrs, (char *)pData, (unsigned int)actual_count,
-		 (unsigned int)sizeof(float), (xdrproc_t)xdr_float);
+/*----------------------------------------------------------------*/
 
-      num_bytes_to_send = (int)xdr_getpos(&xdrs);
-      out_ptr = IOTypes_table.io_def[IOTypeIndex].buffer;
+/** @internal
+    As Send_data_slices() but sends arrays a level of detail at a time
+    if the IOType asks for it. */
+static int send_slices(int                          IOTypeIndex,
+		       int                          NumSlices,
+		       const struct reg_data_slice *Slices,
+		       int                          IsFortranArray,
+		       char                        *HdrBuffer)
+{
+  if(IOTypes_table.io_def[IOTypeIndex].num_levels > 1){
+    return send_level_slices(IOTypeIndex, NumSlices, Slices,
+			     IsFortranArray, HdrBuffer);
+  }
 
-      xdr_destroy(&xdrs);
-    }
-    else{
-      datatype = DataType;
-      num_bytes_to_send = actual_count*sizeof(float);
-      out_ptr = (void *)pData;
-    }
-    break;
+  return send_whole_slices(IOTypeIndex, NumSlices, Slices, IsFortranArray,
+			   HdrBuffer);
+}
 
-  case REG_DBL:
-    if(IOTypes_table.io_def[IOTypeIndex].use_xdr){
-      datatype = REG_XDR_DOUBLE;
-      num_bytes_to_send = actual_count*REG_MAX_SIZEOF_XDR_TYPE;
+/*----------------------------------------------------------------*/
 
-      if(num_bytes_to_send > IOTypes_table.io_def[IOTypeIndex].buffer_max_bytes){
+/** @internal
+    As Send_data_slices() but cuts each array that follows a chunk
+    header down to the consumer's region, and rewrites the chunk
+    header to match.  An array with none of the region in it is not
+    sent at all, nor is its chunk header. */
+static int send_region_slices(int                          IOTypeIndex,
+			      int                          NumSlices,
+			      const struct reg_data_slice *Slices,
+			      int                          IsFortranArray,
+			      char                        *HdrBuffer)
+{
+  IOdef_entry          *io = &(IOTypes_table.io_def[IOTypeIndex]);
+  struct reg_data_slice batch[REG_SLICE_BATCH_SIZE];
+  char                  chunk_hdrs[REG_SLICE_BATCH_SIZE][REG_CHUNK_HDR_SIZE];
+  Array_type            cut;
+  int                   first[3];
+  int                   i, n = 0;
+  int                   next;
+  size_t                elem_size;
+  size_t                num_bytes;
+  size_t                used = 0;
+
+  for(i = 0; i < NumSlices; i++){
+    batch[n] = Slices[i];
+
+    if(Slices[i].type == REG_CHAR){
+      /* Any other character data goes as it is */
+      if(Unpack_chunk_header((const char*) Slices[i].data,
+			     (size_t) Slices[i].count,
+			     &(io->region_chunk), NULL) == REG_SUCCESS){
+
+	if(Region_clip(&(io->region), &(io->region_chunk), &cut,
+		       first) != REG_SUCCESS){
+	  io->region_next = REG_REGION_SKIP;
+	  continue;
+	}
+	io->region_next = REG_REGION_CUT;
+	Pack_chunk_header(chunk_hdrs[n], &cut, NULL);
+	batch[n].data = (void*) chunk_hdrs[n];
+	batch[n].count = (int) strlen(chunk_hdrs[n]);
+      }
+    }
+    else if(io->region_next != REG_REGION_NONE){
+      next = io->region_next;
+      io->region_next = REG_REGION_NONE;
+      if(next == REG_REGION_SKIP) continue;
+
+      Region_clip(&(io->region), &(io->region_chunk), &cut, first);
+      elem_size = (size_t) Sizeof_type(Slices[i].type);
+      if(Slices[i].count != io->region_chunk.nx*io->region_chunk.ny*
+	 io->region_chunk.nz){
+	fprintf(stderr, "STEER: ERROR: Send_data_slices: slice of %d "
+		"objects does not match the chunk header before it\n",
+		Slices[i].count);
+	return REG_FAILURE;
+      }
 
-	/* This function will malloc if buffer not already set */
-	if(Realloc_iotype_buffer(IOTypeIndex, num_bytes_to_send)
-	   != REG_SUCCESS){
-	  IOTypes_table.io_def[IOTypeIndex].ack_needed = REG_FALSE;
+      /* Cut-down arrays are packed one after another (each aligned
+	 for any type) so send what we have if there is no room */
+      num_bytes = (size_t) cut.nx*cut.ny*cut.nz*elem_size;
+      if(used + num_bytes > io->slice_buffer_max_bytes){
+	if(n > 0 && send_slices(IOTypeIndex, n, batch, IsFortranArray,
+				HdrBuffer) != REG_SUCCESS){
+	  return REG_FAILURE;
+	}
+	batch[0] = batch[n];
+	n = 0;
+	used = 0;
+	if(Realloc_scratch_buffer(io, &(io->slice_buffer),
+				  &(io->slice_buffer_max_bytes), num_bytes,
+				  "Send_data_slices") != REG_SUCCESS){
 	  return REG_FAILURE;
 	}
       }
 
-      xdrmem_create(&xdrs,
-		    IOTypes_table.io_def[IOTypeIndex].buffer,
-		    num_bytes_to_send,
-		    XDR_ENCODE);
-      xdr_vector(&xdrs, (char *)pData, (unsigned int)actual_count,
-		 (unsigned int)sizeof(double), (xdrproc_t)xdr_double);
-
-      num_bytes_to_send = (int)xdr_getpos(&xdrs);
-      out_ptr = IOTypes_table.io_def[IOTypeIndex].buffer;
-
-      xdr_destroy(&xdrs);
+      batch[n].data = (void*) ((char*) io->slice_buffer + used);
+      batch[n].count = cut.nx*cut.ny*cut.nz;
+      Region_extract(&(io->region_chunk), first, &cut, &(io->region),
+		     elem_size, Slices[i].data, batch[n].data);
+      used += (num_bytes + sizeof(double) - 1) & ~(sizeof(double) - 1);
     }
-    else{
-      datatype = DataType;
-      num_bytes_to_send = actual_count*sizeof(double);
-      out_ptr = (void *)pData;
+
+    if(++n == REG_SLICE_BATCH_SIZE){
+      if(send_slices(IOTypeIndex, n, batch, IsFortranArray,
+		     HdrBuffer) != REG_SUCCESS){
+	return REG_FAILURE;
+      }
+      n = 0;
+      used = 0;
     }
-    break;
+  }
 
-  case REG_CHAR:
-    datatype = DataType;
+  if(n > 0){
+    return send_slices(IOTypeIndex, n, batch, IsFortranArray, HdrBuffer);
+  }
 
-    num_bytes_to_send = actual_count*sizeof(char);
-    out_ptr = (void *)pData;
-    break;
+  return REG_SUCCESS;
+}
 
-  default:
-    fprintf(stderr, "STEER: Emit_data_slice: Unrecognised data type\n");
-    IOTypes_table.io_def[IOTypeIndex].ack_needed = REG_FALSE;
-    return REG_FAILURE;
-    break;
+/*----------------------------------------------------------------*/
+
+int Send_data_slices(int                          IOTypeIndex,
+		     int                          NumSlices,
+		     const struct reg_data_slice *Slices,
+		     int                          IsFortranArray,
+		     char                        *HdrBuffer)
+{
+  if(IOTypes_table.io_def[IOTypeIndex].use_region){
+    return send_region_slices(IOTypeIndex, NumSlices, Slices,
+			      IsFortranArray, HdrBuffer);
   }
 
-  /* Send ReG-specific header */
+  return send_slices(IOTypeIndex, NumSlices, Slices, IsFortranArray,
+		     HdrBuffer);
+}
 
-  if( Emit_iotype_msg_header(IOTypeIndex,
-			     datatype,
-			     actual_count,
-			     num_bytes_to_send,
-			     ReG_CalledFromF90) == REG_SUCCESS){
+/*----------------------------------------------------------------*/
 
-    /* Send data */
-    if( Emit_data(IOTypeIndex,
-		  datatype,
-		  num_bytes_to_send,
-		  out_ptr) == REG_SUCCESS) return REG_SUCCESS;
-  }
+int Flush_data_slices(int   IOTypeIndex,
+		      char *HdrBuffer)
+{
+  IOdef_entry          *io = &(IOTypes_table.io_def[IOTypeIndex]);
+  struct reg_data_slice slice;
+  char                  chunk_hdr[REG_CHUNK_HDR_SIZE];
 
-  IOTypes_table.io_def[IOTypeIndex].ack_needed = REG_FALSE;
-  return REG_FAILURE;
+  if(!io->level_pending) return REG_SUCCESS;
+
+  /* A chunk header at the very end of the sample goes as it is */
+  io->level_pending = REG_FALSE;
+  Pack_chunk_header(chunk_hdr, &(io->level_header), NULL);
+  slice.type = REG_CHAR;
+  slice.data = (void*) chunk_hdr;
+  slice.count = (int) strlen(chunk_hdr);
+
+  return send_whole_slices(IOTypeIndex, 1, &slice, REG_FALSE, HdrBuffer);
 }
 
 /*----------------------------------------------------------------*/
@@ -4414,17 +7195,14 @@ int Make_chunk_header(char *header,
                       int   sx,  int sy,   int sz,
                       int   nx,  int ny,   int nz)
 {
-  char *pchar = header;
+  Array_type array;
 
-  pchar += sprintf(pchar, "CHUNK_HDR\n"
-		   "ARRAY  %d %d %d\n"
-		   "ORIGIN %d %d %d\n"
-		   "EXTENT %d %d %d\n"
-		   "FROM_FORTRAN %d\n"
-		   "END_CHUNK_HDR\n",
-		   totx, toty, totz,
-		   sx, sy, sz, nx, ny, nz,
-		   ReG_CalledFromF90);
+  array.totx = totx; array.toty = toty; array.totz = totz;
+  array.sx = sx; array.sy = sy; array.sz = sz;
+  array.nx = nx; array.ny = ny; array.nz = nz;
+  array.is_f90 = ReG_CalledFromF90;
+
+  Pack_chunk_header(header, &array, NULL);
 
   return REG_SUCCESS;
 }
@@ -4705,8 +7483,26 @@ return Consume_data_read_impl(index,
 
 /*---------------------------------------------------*/
 
+int Consume_data_map(const int     index,
+		     const size_t  num_bytes,
+		     void        **pData)
+{
+  if(index < 0 || index >= IOTypes_table.num_registered) {
+
+    fprintf(stderr, "STEER: ERROR: Consume_data_map: IOType "
+	    "index (%d) out of range\n", index);
+    return REG_FAILURE;
+  }
+
+  return Consume_data_map_impl(index, num_bytes, pData);
+}
+
+/*---------------------------------------------------*/
+
 int Emit_ack(const int index)
 {
+  int status;
+
   if(index < 0 || index >= IOTypes_table.num_registered){
     fprintf(stderr, "STEER: ERROR: Emit_ack: IOType "
 	    "index (%d) out of range\n", index);
@@ -4718,7 +7514,13 @@ int Emit_ack(const int index)
     return REG_FAILURE;
   }
 
-  return Emit_ack_impl(index);
+  status = Emit_ack_impl(index);
+
+  /* Whether or not it got there, the samples consumed so far have
+     been acknowledged as far as we are concerned */
+  IOTypes_table.io_def[index].acks_owed = 0;
+
+  return status;
 }
 
 /*---------------------------------------------------*/
@@ -4753,9 +7555,59 @@ int Consume_ack(const int index)
   }
 }
 
+/*----------------------------------------------------------------*/
+
+int Wait_for_IOType(const int index, const double TimeOut)
+{
+  unsigned long poll_uS = REG_BLOCKING_POLL_INTERVAL;
+  int           status = REG_FAILURE;
+
+  if(TimeOut <= 0.0) return REG_TIMED_OUT;
+
+  if(index >= 0 && index < IOTypes_table.num_registered &&
+     IOTypes_table.io_def[index].is_enabled == REG_TRUE){
+
+    /* Round up rather than wake just short of the time out */
+    if(IOTypes_table.io_def[index].is_async){
+      status = Async_emit_wait(index, (int)(1000.0*TimeOut) + 1);
+    }
+    else{
+      status = Wait_for_IOType_impl(index, (int)(1000.0*TimeOut) + 1);
+    }
+  }
+
+  /* Nothing to wait on so fall back to polling */
+  if(status == REG_FAILURE){
+    if(1.0e6*TimeOut < (double)poll_uS){
+      poll_uS = (unsigned long)(1.0e6*TimeOut);
+    }
+    usleep(poll_uS);
+  }
+
+  return status;
+}
+
 /*---------------------------------------------------*/
 
 int Emit_header(const int index) {
+
+  /* Start the compression statistics for this sample */
+  IOTypes_table.io_def[index].comp_raw_bytes = 0.0;
+  IOTypes_table.io_def[index].comp_bytes = 0.0;
+  IOTypes_table.io_def[index].comp_time = 0.0;
+  IOTypes_table.io_def[index].lossy_bytes_saved = 0.0;
+  IOTypes_table.io_def[index].lossy_max_error = 0.0;
+
+  Emit_delta_start(index);
+
+  /* Any chunk header held back from a sample that was never
+     finished */
+  IOTypes_table.io_def[index].level_pending = REG_FALSE;
+
+  /* Up to the transport whether this sample can use parallel
+     streams */
+  IOTypes_table.io_def[index].stripe_slices = REG_FALSE;
+
   return Emit_header_impl(index);
 }
 
@@ -4813,11 +7665,61 @@ int Emit_iotype_msg_header(int IOTypeIndex,
 			   int DataType,
 			   int Count,
 			   int NumBytes,
-			   int IsFortranArray)
+			   int IsFortranArray,
+			   int Codec,
+			   int RawBytes,
+			   int Flags)
 {
   char  buffer[7*REG_PACKET_SIZE];
+  int   num_bytes;
+
+  num_bytes = Pack_iotype_msg_header(IOTypeIndex, DataType, Count, NumBytes,
+				     IsFortranArray, Codec, RawBytes, Flags,
+				     buffer);
+
+  return Emit_msg_header_impl(IOTypeIndex, num_bytes, (void*)buffer);
+}
+
+/*----------------------------------------------------------------*/
+
+int Pack_iotype_msg_header(int   IOTypeIndex,
+			   int   DataType,
+			   int   Count,
+			   int   NumBytes,
+			   int   IsFortranArray,
+			   int   Codec,
+			   int   RawBytes,
+			   int   Flags,
+			   char *buffer)
+{
   char  tmp_buffer[REG_PACKET_SIZE];
   char *pchar;
+  int   version = IOTypes_table.io_def[IOTypeIndex].slice_hdr_version;
+
+  /* Use the compact binary header if the consumer understands it */
+  if(version > REG_SLICE_HDR_TEXT) {
+    /* The transport sends the data of large slices over parallel
+       streams if it can */
+    if(IOTypes_table.io_def[IOTypeIndex].stripe_slices &&
+       NumBytes >= REG_STRIPE_MIN_BYTES) {
+      Flags |= REG_SLICE_FLAG_STRIPED;
+    }
+
+    /* Tell the consumer that it may ask for part of each array */
+    if(version >= REG_SLICE_HDR_REGION_VERSION) {
+      Flags |= REG_SLICE_FLAG_REGIONS;
+    }
+
+    /* ...and that it may let us send samples ahead of it */
+    if(version >= REG_SLICE_HDR_CREDIT_VERSION &&
+       IOTypes_table.io_def[IOTypeIndex].credit_capable) {
+      Flags |= REG_SLICE_FLAG_CREDITS;
+    }
+
+    Pack_slice_header(buffer, version, DataType, Count, NumBytes,
+		      IsFortranArray, Codec, RawBytes, Flags);
+    return REG_SLICE_HDR_SIZE;
+  }
 
   pchar = buffer;
   pchar += sprintf(pchar, REG_PACKET_FORMAT, "<ReG_data_slice_header>");
@@ -4843,8 +7745,7 @@ int Emit_iotype_msg_header(int IOTypeIndex,
   pchar += sprintf(pchar, REG_PACKET_FORMAT, "</ReG_data_slice_header>");
   *(pchar-1) = '\0';
 
-  return Emit_msg_header_impl(IOTypeIndex, (int)(pchar-buffer), (void*)buffer);
-
+  return (int)(pchar-buffer);
 }
 
 /*----------------------------------------------------------------*/
@@ -4857,6 +7758,44 @@ int Realloc_iotype_buffer(int index,
 
 /*----------------------------------------------------------------*/
 
+int Realloc_iotype_comp_buffer(int    index,
+			       size_t num_bytes) {
+  IOdef_entry *io = &(IOTypes_table.io_def[index]);
+
+  return Realloc_scratch_buffer(io, &(io->comp_buffer),
+				&(io->comp_buffer_max_bytes), num_bytes,
+				"Realloc_iotype_comp_buffer");
+}
+
+/*----------------------------------------------------------------*/
+
+int Realloc_scratch_buffer(IOdef_entry *iodef,
+			   void       **buf,
+			   size_t      *max_bytes,
+			   size_t       num_bytes,
+			   const char  *func) {
+  void   *new_buf;
+  size_t  new_bytes;
+
+  if(num_bytes <= *max_bytes) return REG_SUCCESS;
+
+  /* Nothing in the buffer outlives a slice so it need not be copied */
+  if(Check_buffer_limit(iodef, *max_bytes, Buffer_class_bytes(num_bytes),
+			func) != REG_SUCCESS ||
+     !(new_buf = Buffer_get(num_bytes, &new_bytes))) {
+    return REG_FAILURE;
+  }
+
+  Buffer_put(*buf, *max_bytes);
+  Account_buffer(iodef, *max_bytes, new_bytes);
+  *buf = new_buf;
+  *max_bytes = new_bytes;
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
 int Realloc_chktype_buffer(int index,
 			   int num_bytes) {
   return Realloc_IOdef_entry_buffer(&(ChkTypes_table.io_def[index]),
@@ -4868,228 +7807,146 @@ int Realloc_chktype_buffer(int index,
 int Realloc_IOdef_entry_buffer(IOdef_entry *iodef,
 			       int num_bytes)
 {
-  void *dum_ptr;
+  void   *new_buf;
+  size_t  new_bytes;
 
-  if(!iodef)return REG_FAILURE;
+  if(!iodef || num_bytes < 0)return REG_FAILURE;
 
-#ifdef REG_DEBUG
-  if(iodef->buffer){
-    fprintf(stderr, "STEER: Realloc_IOdef_entry_buffer: realloc'ing "
-	    "pointer %p\n", iodef->buffer);
-  }
-  else{
-    fprintf(stderr, "STEER: Realloc_IOdef_entry_buffer: doing "
-	    "malloc for IO buffer\n");
+  if(iodef->buffer && num_bytes <= iodef->buffer_max_bytes){
+    return REG_SUCCESS;
   }
-#endif
-
-  if(iodef->buffer){
-
-    if(!(dum_ptr = realloc(iodef->buffer,
-			 (size_t)num_bytes))){
 
-      free(iodef->buffer);
-      iodef->buffer = NULL;
-      iodef->buffer_bytes = 0;
-      iodef->buffer_max_bytes = 0;
+#ifdef REG_DEBUG
+  fprintf(stderr, "STEER: Realloc_IOdef_entry_buffer: getting %d "
+	  "bytes of IO buffer to replace %d\n", num_bytes,
+	  iodef->buffer_max_bytes);
+#endif
 
-      fprintf(stderr, "STEER: Realloc_IOdef_entry_buffer: realloc "
-	      "failed for %d bytes\n", num_bytes);
-      return REG_FAILURE;
-    }
+  new_bytes = Buffer_class_bytes((size_t)num_bytes);
+  if(new_bytes == 0 || new_bytes > (size_t)INT_MAX){
+    fprintf(stderr, "STEER: Realloc_IOdef_entry_buffer: no buffer of "
+	    "%d bytes can be used\n", num_bytes);
+    return REG_FAILURE;
+  }
 
-    iodef->buffer = dum_ptr;
+  if(Check_buffer_limit(iodef, (size_t)iodef->buffer_max_bytes,
+			new_bytes, "Realloc_IOdef_entry_buffer")
+     != REG_SUCCESS){
+    return REG_FAILURE;
   }
-  else{
-    if(!(iodef->buffer = malloc(num_bytes))){
 
-      iodef->buffer_max_bytes = 0;
+  if(!(new_buf = Buffer_get((size_t)num_bytes, &new_bytes))){
+    return REG_FAILURE;
+  }
 
-      fprintf(stderr, "STEER: Realloc_IOdef_entry_buffer: malloc "
-	      "failed for %d bytes\n", num_bytes);
-      return REG_FAILURE;
+  /* Keep what is in the old buffer, as realloc would have done */
+  if(iodef->buffer){
+    if(iodef->buffer_bytes > 0){
+      memcpy(new_buf, iodef->buffer, (size_t)iodef->buffer_bytes);
     }
+    Buffer_put(iodef->buffer, (size_t)iodef->buffer_max_bytes);
   }
 
-  iodef->buffer_max_bytes = num_bytes;
+  Account_buffer(iodef, (size_t)iodef->buffer_max_bytes, new_bytes);
+  iodef->buffer = new_buf;
+  iodef->buffer_max_bytes = (int)new_bytes;
 
   return REG_SUCCESS;
 }
 
 /*----------------------------------------------------------------*/
 
-int Reorder_array(int          ndims,
-		  int         *tot_extent,
-		  int         *sub_extent,
-		  int         *origin,
-		  int          type,
-		  void        *pInData,
-		  void        *pOutData,
-		  int          to_f90)
+int Check_buffer_limit(IOdef_entry *iodef,
+		       size_t       old_bytes,
+		       size_t       new_bytes,
+		       const char  *func)
 {
-  int         i, j, k;
-  int         ox, oy, oz;
-  int         nx, ny, nz;
-  int         nslab, nrow;
-  int        *pi, *pi_old;
-  float      *pf, *pf_old;
-  double     *pd, *pd_old;
+  size_t held = iodef->buffer_held_bytes - old_bytes + new_bytes;
 
-  if(ndims != 3){
-
-    fprintf(stderr, "STEER: Reorder_array: only 3D arrays supported\n");
-    return REG_FAILURE;
+  if(iodef->buffer_limit == 0 || held <= iodef->buffer_limit){
+    return REG_SUCCESS;
   }
 
-  ox = origin[0];
-  oy = origin[1];
-  oz = origin[2];
-  nx = sub_extent[0];
-  ny = sub_extent[1];
-  nz = sub_extent[2];
-
-  switch(type){
-
-  case REG_INT:
-    pi = (int *)pOutData;
-    pi_old = (int *)pInData;
-
-    if(to_f90 != REG_TRUE){
-
-      /* Convert F90 array to C array */
-      nslab = tot_extent[2]*tot_extent[1];
-      nrow  = tot_extent[2];
-
-      /* Order loops so i,j,k vary as they should for an F90-style
-	 array ordered consecutively in memory */
-      for(k=oz; k<(nz+oz); k++){
-	for(j=oy; j<(ny+oy); j++){
-	  for(i=ox; i<(nx+ox); i++){
-	    /* Calculate position of (i,j,k)'th element in a C array
-	       (where k varies most rapidly) and store value */
-	    pi[i*nslab + j*nrow + k] = *(pi_old++);
-	  }
-	}
-      }
-    }
-    else{
-
-      /* Convert C array to F90 array */
-
-      nslab = tot_extent[0]*tot_extent[1];
-      nrow  = tot_extent[0];
-
-      /* Order loops so i,j,k vary as they should for a C-style
-	 array ordered consecutively in memory */
-      for(i=ox; i<(nx+ox); i++){
-	for(j=oy; j<(ny+oy); j++){
-	  for(k=oz; k<(nz+oz); k++){
-	    /* Calculate position of (i,j,k)'th element in an F90 array
-	       (where i varies most rapidly) and store value */
-	    pi[k*nslab + j*nrow + i] = *(pi_old++);
-	  }
-	}
-      }
-    }
-    break;
-
-  case REG_FLOAT:
-
-    pf = (float *)pOutData;
-    pf_old = (float *)pInData;
-
-    if(to_f90 != REG_TRUE){
-
-      /* Convert F90 array to C array */
-
-      nslab = tot_extent[2]*tot_extent[1];
-      nrow  = tot_extent[2];
+  fprintf(stderr, "STEER: ERROR: %s: %lu bytes of buffers would take "
+	  "'%s' over its limit of %lu bytes\n", func, (unsigned long)held,
+	  iodef->label, (unsigned long)iodef->buffer_limit);
+  return REG_FAILURE;
+}
 
-      /* Order loops so i,j,k vary as they should for an F90-style
-	 array ordered consecutively in memory */
-      for(k=oz; k<(nz+oz); k++){
-	for(j=oy; j<(ny+oy); j++){
-	  for(i=ox; i<(nx+ox); i++){
-	    /* Calculate position of (i,j,k)'th element in a C array
-	       (where k varies most rapidly) and store value */
-	    pf[i*nslab + j*nrow + k] = *(pf_old++);
-	  }
-	}
-      }
-    }
-    else{
+/*----------------------------------------------------------------*/
 
-      /* Convert C array to F90 array */
+void Account_buffer(IOdef_entry *iodef,
+		    size_t       old_bytes,
+		    size_t       new_bytes)
+{
+  iodef->buffer_held_bytes += new_bytes;
+  iodef->buffer_held_bytes -= old_bytes;
+  if(iodef->buffer_held_bytes > iodef->buffer_high_water){
+    iodef->buffer_high_water = iodef->buffer_held_bytes;
+  }
+}
 
-      nslab = tot_extent[0]*tot_extent[1];
-      nrow  = tot_extent[0];
+/*----------------------------------------------------------------*/
 
-      /* Order loops so i,j,k vary as they should for a C-style
-	 array ordered consecutively in memory */
-      for(i=ox; i<(nx+ox); i++){
-	for(j=oy; j<(ny+oy); j++){
-	  for(k=oz; k<(nz+oz); k++){
-	    /* Calculate position of (i,j,k)'th element in an F90 array
-	       (where i varies most rapidly) and store value */
-	    pf[k*nslab + j*nrow + i] = *(pf_old++);
-	  }
-	}
-      }
-    }
-    break;
+void Release_IOdef_entry_buffers(IOdef_entry *iodef)
+{
+  if(iodef->buffer){
+    Buffer_put(iodef->buffer, (size_t)iodef->buffer_max_bytes);
+    iodef->buffer = NULL;
+  }
+  iodef->buffer_bytes = 0;
+  iodef->buffer_max_bytes = 0;
 
-  case REG_DBL:
+  if(iodef->comp_buffer){
+    Buffer_put(iodef->comp_buffer, iodef->comp_buffer_max_bytes);
+    iodef->comp_buffer = NULL;
+  }
+  iodef->comp_buffer_max_bytes = 0;
 
-    pd = (double *)pOutData;
-    pd_old = (double *)pInData;
+  if(iodef->slice_buffer){
+    Buffer_put(iodef->slice_buffer, iodef->slice_buffer_max_bytes);
+    iodef->slice_buffer = NULL;
+  }
+  iodef->slice_buffer_max_bytes = 0;
 
-    if(to_f90 != REG_TRUE){
+  if(iodef->level_buffer){
+    Buffer_put(iodef->level_buffer, iodef->level_buffer_max_bytes);
+    iodef->level_buffer = NULL;
+  }
+  iodef->level_buffer_max_bytes = 0;
 
-      /* Convert F90 array to C array */
+  iodef->buffer_held_bytes = 0;
+}
 
-      nslab = tot_extent[2]*tot_extent[1];
-      nrow  = tot_extent[2];
+/*----------------------------------------------------------------*/
 
-      /* Order loops so i,j,k vary as they should for an F90-style
-	 array ordered consecutively in memory */
-      for(k=oz; k<(nz+oz); k++){
-	for(j=oy; j<(ny+oy); j++){
-	  for(i=ox; i<(nx+ox); i++){
-	    /* Calculate position of (i,j,k)'th element in a C array
-	       (where k varies most rapidly) and store value */
-	    pd[i*nslab + j*nrow + k] = *(pd_old++);
-	  }
-	}
-      }
-    }
-    else{
+int Reorder_array(int          ndims,
+		  int         *tot_extent,
+		  int         *sub_extent,
+		  int         *origin,
+		  int          type,
+		  void        *pInData,
+		  void        *pOutData,
+		  int          to_f90)
+{
+  int elem_size;
 
-      /* Convert C array to F90 array */
+  if(ndims < 1 || ndims > REG_REORDER_MAX_DIMS){
 
-      nslab = tot_extent[0]*tot_extent[1];
-      nrow  = tot_extent[0];
+    fprintf(stderr, "STEER: Reorder_array: only 1 to %dD arrays supported\n",
+	    REG_REORDER_MAX_DIMS);
+    return REG_FAILURE;
+  }
 
-      /* Order loops so i,j,k vary as they should for a C-style
-	 array ordered consecutively in memory */
-      for(i=ox; i<(nx+ox); i++){
-	for(j=oy; j<(ny+oy); j++){
-	  for(k=oz; k<(nz+oz); k++){
-	    /* Calculate position of (i,j,k)'th element in an F90 array
-	       (where i varies most rapidly) and store value */
-	    pd[k*nslab + j*nrow + i] = *(pd_old++);
-	  }
-	}
-      }
-    }
-    break;
+  if((elem_size = Sizeof_type(type)) == 0){
 
-  default:
     fprintf(stderr, "STEER: Reorder_array: unrecognised data type: %d\n",
 	    type);
-    break;
+    return REG_FAILURE;
   }
 
-  return REG_SUCCESS;
+  return Reorder_nd(ndims, tot_extent, sub_extent, origin,
+		    (size_t)elem_size, pInData, pOutData, to_f90);
 }
 
 /*------------------------------------------------------------------*/
@@ -315,6 +315,424 @@ INT_KIND_1_DECL(Status);
 
 /*----------------------------------------------------------------
 
+SUBROUTINE enable_iotype_async_f(IOType, Policy, Status)
+
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: IOType
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: Policy
+  INTEGER (KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+
+/** Wrapper for Enable_IOType_async(), for use from within F90
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(enable_iotype_async_f) ARGS(`IOType,
+                                           Policy,
+                                           Status')
+INT_KIND_1_DECL(IOType);
+INT_KIND_1_DECL(Policy);
+INT_KIND_1_DECL(Status);
+{
+  *Status = INT_KIND_1_CAST( Enable_IOType_async((int)(*IOType),
+                                                 (int)(*Policy)) );
+
+  return;
+}
+
+/*----------------------------------------------------------------
+
+SUBROUTINE disable_iotype_async_f(IOType, Status)
+
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: IOType
+  INTEGER (KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+
+/** Wrapper for Disable_IOType_async(), for use from within F90
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(disable_iotype_async_f) ARGS(`IOType,
+                                            Status')
+INT_KIND_1_DECL(IOType);
+INT_KIND_1_DECL(Status);
+{
+  *Status = INT_KIND_1_CAST( Disable_IOType_async((int)(*IOType)) );
+
+  return;
+}
+
+/*----------------------------------------------------------------
+
+SUBROUTINE set_iotype_compression_f(IOType, Codec, Status)
+
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: IOType
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: Codec
+  INTEGER (KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+
+/** Wrapper for Set_IOType_compression(), for use from within F90
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(set_iotype_compression_f) ARGS(`IOType,
+                                              Codec,
+                                              Status')
+INT_KIND_1_DECL(IOType);
+INT_KIND_1_DECL(Codec);
+INT_KIND_1_DECL(Status);
+{
+  *Status = INT_KIND_1_CAST( Set_IOType_compression((int)(*IOType),
+						    (int)(*Codec)) );
+
+  return;
+}
+
+/*----------------------------------------------------------------
+
+SUBROUTINE set_iotype_lossy_f(IOType, Mode, BoundType, Bound, Status)
+
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: IOType
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: Mode
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: BoundType
+  REAL    (KIND=REG_DP_KIND), INTENT(in)  :: Bound
+  INTEGER (KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+
+/** Wrapper for Set_IOType_lossy(), for use from within F90
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(set_iotype_lossy_f) ARGS(`IOType,
+                                        Mode,
+                                        BoundType,
+                                        Bound,
+                                        Status')
+INT_KIND_1_DECL(IOType);
+INT_KIND_1_DECL(Mode);
+INT_KIND_1_DECL(BoundType);
+double *Bound;
+INT_KIND_1_DECL(Status);
+{
+  *Status = INT_KIND_1_CAST( Set_IOType_lossy((int)(*IOType),
+					      (int)(*Mode),
+					      (int)(*BoundType),
+					      *Bound) );
+
+  return;
+}
+
+/*----------------------------------------------------------------
+
+SUBROUTINE set_iotype_delta_f(IOType, KeyInterval, Status)
+
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: IOType
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: KeyInterval
+  INTEGER (KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+
+/** Wrapper for Set_IOType_delta(), for use from within F90
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(set_iotype_delta_f) ARGS(`IOType,
+                                        KeyInterval,
+                                        Status')
+INT_KIND_1_DECL(IOType);
+INT_KIND_1_DECL(KeyInterval);
+INT_KIND_1_DECL(Status);
+{
+  *Status = INT_KIND_1_CAST( Set_IOType_delta((int)(*IOType),
+					      (int)(*KeyInterval)) );
+
+  return;
+}
+
+/*----------------------------------------------------------------
+
+SUBROUTINE set_iotype_max_consumers_f(IOType, MaxConsumers, Status)
+
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: IOType
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: MaxConsumers
+  INTEGER (KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+
+/** Wrapper for Set_IOType_max_consumers(), for use from within F90
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(set_iotype_max_consumers_f) ARGS(`IOType,
+                                                MaxConsumers,
+                                                Status')
+INT_KIND_1_DECL(IOType);
+INT_KIND_1_DECL(MaxConsumers);
+INT_KIND_1_DECL(Status);
+{
+  *Status = INT_KIND_1_CAST( Set_IOType_max_consumers((int)(*IOType),
+						      (int)(*MaxConsumers)) );
+
+  return;
+}
+
+/*----------------------------------------------------------------
+
+SUBROUTINE set_iotype_streams_f(IOType, NumStreams, Status)
+
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: IOType
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: NumStreams
+  INTEGER (KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+
+/** Wrapper for Set_IOType_streams(), for use from within F90
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(set_iotype_streams_f) ARGS(`IOType,
+                                          NumStreams,
+                                          Status')
+INT_KIND_1_DECL(IOType);
+INT_KIND_1_DECL(NumStreams);
+INT_KIND_1_DECL(Status);
+{
+  *Status = INT_KIND_1_CAST( Set_IOType_streams((int)(*IOType),
+						(int)(*NumStreams)) );
+
+  return;
+}
+
+/*----------------------------------------------------------------
+
+SUBROUTINE set_iotype_checksum_f(IOType, Checksum, Status)
+
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: IOType
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: Checksum
+  INTEGER (KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+
+/** Wrapper for Set_IOType_checksum(), for use from within F90
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(set_iotype_checksum_f) ARGS(`IOType,
+                                           Checksum,
+                                           Status')
+INT_KIND_1_DECL(IOType);
+INT_KIND_1_DECL(Checksum);
+INT_KIND_1_DECL(Status);
+{
+  *Status = INT_KIND_1_CAST( Set_IOType_checksum((int)(*IOType),
+						 (int)(*Checksum)) );
+
+  return;
+}
+
+/*----------------------------------------------------------------
+
+SUBROUTINE set_iotype_region_f(IOType, Sx, Sy, Sz, Nx, Ny, Nz,
+                               StrideX, StrideY, StrideZ, Status)
+
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: IOType
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: Sx, Sy, Sz
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: Nx, Ny, Nz
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: StrideX, StrideY, StrideZ
+  INTEGER (KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+
+/** Wrapper for Set_IOType_region(), for use from within F90
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(set_iotype_region_f) ARGS(`IOType,
+                                         Sx, Sy, Sz,
+                                         Nx, Ny, Nz,
+                                         StrideX, StrideY, StrideZ,
+                                         Status')
+INT_KIND_1_DECL(IOType);
+INT_KIND_1_DECL(Sx);
+INT_KIND_1_DECL(Sy);
+INT_KIND_1_DECL(Sz);
+INT_KIND_1_DECL(Nx);
+INT_KIND_1_DECL(Ny);
+INT_KIND_1_DECL(Nz);
+INT_KIND_1_DECL(StrideX);
+INT_KIND_1_DECL(StrideY);
+INT_KIND_1_DECL(StrideZ);
+INT_KIND_1_DECL(Status);
+{
+  *Status = INT_KIND_1_CAST( Set_IOType_region((int)(*IOType),
+					       (int)(*Sx), (int)(*Sy),
+					       (int)(*Sz), (int)(*Nx),
+					       (int)(*Ny), (int)(*Nz),
+					       (int)(*StrideX),
+					       (int)(*StrideY),
+					       (int)(*StrideZ)) );
+
+  return;
+}
+
+/*----------------------------------------------------------------
+
+SUBROUTINE set_iotype_levels_f(IOType, NumLevels, Status)
+
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: IOType
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: NumLevels
+  INTEGER (KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+
+/** Wrapper for Set_IOType_levels(), for use from within F90
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(set_iotype_levels_f) ARGS(`IOType,
+                                         NumLevels,
+                                         Status')
+INT_KIND_1_DECL(IOType);
+INT_KIND_1_DECL(NumLevels);
+INT_KIND_1_DECL(Status);
+{
+  *Status = INT_KIND_1_CAST( Set_IOType_levels((int)(*IOType),
+					       (int)(*NumLevels)) );
+
+  return;
+}
+
+/*----------------------------------------------------------------
+
+SUBROUTINE set_iotype_window_f(IOType, NumSamples, Status)
+
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: IOType
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: NumSamples
+  INTEGER (KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+
+/** Wrapper for Set_IOType_window(), for use from within F90
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(set_iotype_window_f) ARGS(`IOType,
+                                         NumSamples,
+                                         Status')
+INT_KIND_1_DECL(IOType);
+INT_KIND_1_DECL(NumSamples);
+INT_KIND_1_DECL(Status);
+{
+  *Status = INT_KIND_1_CAST( Set_IOType_window((int)(*IOType),
+					       (int)(*NumSamples)) );
+
+  return;
+}
+
+/*----------------------------------------------------------------
+
+SUBROUTINE set_iotype_buffer_limit_f(IOType, MaxBytes, Status)
+
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: IOType
+  REAL    (KIND=REG_DP_KIND), INTENT(in)  :: MaxBytes
+  INTEGER (KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+
+/** Wrapper for Set_IOType_buffer_limit(), for use from within F90
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(set_iotype_buffer_limit_f) ARGS(`IOType,
+                                               MaxBytes,
+                                               Status')
+INT_KIND_1_DECL(IOType);
+double *MaxBytes;
+INT_KIND_1_DECL(Status);
+{
+  *Status = INT_KIND_1_CAST( Set_IOType_buffer_limit((int)(*IOType),
+						     *MaxBytes) );
+
+  return;
+}
+
+/*----------------------------------------------------------------
+
+SUBROUTINE get_iotype_buffer_stats_f(IOType, HeldBytes, HighWater, Status)
+
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: IOType
+  REAL    (KIND=REG_DP_KIND), INTENT(out) :: HeldBytes
+  REAL    (KIND=REG_DP_KIND), INTENT(out) :: HighWater
+  INTEGER (KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+
+/** Wrapper for Get_IOType_buffer_stats(), for use from within F90
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(get_iotype_buffer_stats_f) ARGS(`IOType,
+                                               HeldBytes,
+                                               HighWater,
+                                               Status')
+INT_KIND_1_DECL(IOType);
+double *HeldBytes;
+double *HighWater;
+INT_KIND_1_DECL(Status);
+{
+  *Status = INT_KIND_1_CAST( Get_IOType_buffer_stats((int)(*IOType),
+						     HeldBytes,
+						     HighWater) );
+
+  return;
+}
+
+/*----------------------------------------------------------------
+
+SUBROUTINE get_iotype_write_stats_f(IOType, QueuedBytes, HighWater,
+                                    MeanSeconds, MaxSeconds, NumStalls,
+                                    Status)
+
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: IOType
+  REAL    (KIND=REG_DP_KIND), INTENT(out) :: QueuedBytes
+  REAL    (KIND=REG_DP_KIND), INTENT(out) :: HighWater
+  REAL    (KIND=REG_DP_KIND), INTENT(out) :: MeanSeconds
+  REAL    (KIND=REG_DP_KIND), INTENT(out) :: MaxSeconds
+  INTEGER (KIND=REG_SP_KIND), INTENT(out) :: NumStalls
+  INTEGER (KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+
+/** Wrapper for Get_IOType_write_stats(), for use from within F90
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(get_iotype_write_stats_f) ARGS(`IOType,
+                                              QueuedBytes,
+                                              HighWater,
+                                              MeanSeconds,
+                                              MaxSeconds,
+                                              NumStalls,
+                                              Status')
+INT_KIND_1_DECL(IOType);
+double *QueuedBytes;
+double *HighWater;
+double *MeanSeconds;
+double *MaxSeconds;
+INT_KIND_1_DECL(NumStalls);
+INT_KIND_1_DECL(Status);
+{
+  int stalls;
+
+  *Status = INT_KIND_1_CAST( Get_IOType_write_stats((int)(*IOType),
+						    QueuedBytes,
+						    HighWater,
+						    MeanSeconds,
+						    MaxSeconds,
+						    &stalls) );
+  *NumStalls = INT_KIND_1_CAST(stalls);
+
+  return;
+}
+
+/*----------------------------------------------------------------
+
+SUBROUTINE set_async_emit_cpu_f(Cpu, Status)
+
+  INTEGER (KIND=REG_SP_KIND), INTENT(in)  :: Cpu
+  INTEGER (KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+
+/** Wrapper for Set_async_emit_cpu(), for use from within F90
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(set_async_emit_cpu_f) ARGS(`Cpu,
+                                          Status')
+INT_KIND_1_DECL(Cpu);
+INT_KIND_1_DECL(Status);
+{
+  *Status = INT_KIND_1_CAST( Set_async_emit_cpu((int)(*Cpu)) );
+
+  return;
+}
+
+/*----------------------------------------------------------------
+
 SUBROUTINE register_iotypes_f(NumTypes, IOLabel, IODirn, IOFrequency,
                               IOType, Status)
 
@@ -1424,6 +1842,81 @@ INT_KIND_1_DECL(Status);
   return;
 }
 
+/*----------------------------------------------------------------
+SUBROUTINE get_consumed_slice_count_f(IOHandle, NumSlices, Status)
+
+  INTEGER(KIND=REG_SP_KIND), INTENT(in)  :: IOHandle
+  INTEGER(KIND=REG_SP_KIND), INTENT(out) :: NumSlices
+  INTEGER(KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+/** Wrapper for Get_consumed_slice_count(), for use from within F90.
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(get_consumed_slice_count_f) ARGS(`IOHandle,
+                                                NumSlices,
+                                                Status')
+INT_KIND_1_DECL(IOHandle);
+INT_KIND_1_DECL(NumSlices);
+INT_KIND_1_DECL(Status);
+{
+  int lNumSlices;
+  *Status = INT_KIND_1_CAST( Get_consumed_slice_count((int)*IOHandle,
+                                                      &lNumSlices));
+  *NumSlices = INT_KIND_1_CAST(lNumSlices);
+  return;
+}
+
+/*----------------------------------------------------------------
+SUBROUTINE get_iotype_level_f(IOHandle, Level, NumLevels, Status)
+
+  INTEGER(KIND=REG_SP_KIND), INTENT(in)  :: IOHandle
+  INTEGER(KIND=REG_SP_KIND), INTENT(out) :: Level
+  INTEGER(KIND=REG_SP_KIND), INTENT(out) :: NumLevels
+  INTEGER(KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+/** Wrapper for Get_IOType_level(), for use from within F90.
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(get_iotype_level_f) ARGS(`IOHandle,
+                                        Level,
+                                        NumLevels,
+                                        Status')
+INT_KIND_1_DECL(IOHandle);
+INT_KIND_1_DECL(Level);
+INT_KIND_1_DECL(NumLevels);
+INT_KIND_1_DECL(Status);
+{
+  int lLevel;
+  int lNumLevels;
+  *Status = INT_KIND_1_CAST( Get_IOType_level((int)*IOHandle, &lLevel,
+                                              &lNumLevels));
+  *Level = INT_KIND_1_CAST(lLevel);
+  *NumLevels = INT_KIND_1_CAST(lNumLevels);
+  return;
+}
+
+/*----------------------------------------------------------------
+SUBROUTINE consume_seek_slice_f(IOHandle, Slice, Status)
+
+  INTEGER(KIND=REG_SP_KIND), INTENT(in)  :: IOHandle
+  INTEGER(KIND=REG_SP_KIND), INTENT(in)  :: Slice
+  INTEGER(KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+/** Wrapper for Consume_seek_slice(), for use from within F90.
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(consume_seek_slice_f) ARGS(`IOHandle,
+                                          Slice,
+                                          Status')
+INT_KIND_1_DECL(IOHandle);
+INT_KIND_1_DECL(Slice);
+INT_KIND_1_DECL(Status);
+{
+  *Status = INT_KIND_1_CAST( Consume_seek_slice((int)*IOHandle,
+                                                (int)*Slice));
+  return;
+}
+
 /*----------------------------------------------------------------
 SUBROUTINE consume_data_slice_f(IOHandle, pData, Status)
 
@@ -1454,6 +1947,75 @@ INT_KIND_1_DECL(Status);
   return;
 }
 
+/*----------------------------------------------------------------
+SUBROUTINE consume_data_slices_f(IOHandle, NumSlices, DataTypes, &
+                                 Counts, pData, Status)
+
+  INTEGER(KIND=REG_SP_KIND), INTENT(in)  :: IOHandle
+  INTEGER(KIND=REG_SP_KIND), INTENT(in)  :: NumSlices
+  INTEGER(KIND=REG_SP_KIND), DIMENSION(NumSlices), INTENT(in) :: DataTypes
+  INTEGER(KIND=REG_SP_KIND), DIMENSION(NumSlices), INTENT(inout) :: Counts
+  XXXXXXX(KIND=REG_DP_KIND), DIMENSION(),INTENT(out) :: pData
+  INTEGER(KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+/** Wrapper for Consume_data_slices(), for use from within F90.  The
+    slices are read into the single buffer @p pData, one after the
+    other, with space for @p Counts(i) objects of @p DataTypes(i)
+    reserved for the i'th slice.  On return, @p Counts holds the
+    number of objects actually read into each slice.
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(consume_data_slices_f) ARGS(`IOHandle,
+                                           NumSlices,
+                                           DataTypes,
+                                           Counts,
+                                           pData,
+                                           Status')
+INT_KIND_1_DECL(IOHandle);
+INT_KIND_1_DECL(NumSlices);
+INT_KIND_1_DECL(DataTypes);
+INT_KIND_1_DECL(Counts);
+void *pData;
+INT_KIND_1_DECL(Status);
+{
+  int i;
+  int lNumSlices = (int)*NumSlices;
+  char *pchar = (char *)pData;
+  struct reg_data_slice *slices;
+
+  if(lNumSlices < 1){
+    *Status = INT_KIND_1_CAST( Consume_data_slices((int)*IOHandle, 0,
+                                                   NULL) );
+    return;
+  }
+
+  slices = (struct reg_data_slice *)malloc(lNumSlices*
+                                           sizeof(struct reg_data_slice));
+  if(!slices){
+    fprintf(stderr, "STEER: consume_data_slices_f: malloc failed\n");
+    *Status = INT_KIND_1_CAST(REG_FAILURE);
+    return;
+  }
+
+  for(i=0; i<lNumSlices; i++){
+    slices[i].type  = f90_to_c_type[(int)DataTypes[i]];
+    slices[i].count = (int)Counts[i];
+    slices[i].data  = (void *)pchar;
+    pchar += Counts[i]*sizeof_type[(int)DataTypes[i]];
+  }
+
+  *Status = INT_KIND_1_CAST( Consume_data_slices((int)*IOHandle,
+                                                 lNumSlices,
+                                                 slices) );
+
+  for(i=0; i<lNumSlices; i++){
+    Counts[i] = INT_KIND_1_CAST(slices[i].count);
+  }
+
+  free(slices);
+  return;
+}
+
 /*----------------------------------------------------------------
 SUBROUTINE emit_start_f(IOType, SeqNum, IOHandle, Status)
 
@@ -1576,6 +2138,68 @@ INT_KIND_1_DECL(Status);
   return;
 }
 
+/*----------------------------------------------------------------
+SUBROUTINE emit_data_slices_f(IOHandle, NumSlices, DataTypes, &
+                              Counts, pData, Status)
+
+  INTEGER(KIND=REG_SP_KIND), INTENT(in)  :: IOHandle
+  INTEGER(KIND=REG_SP_KIND), INTENT(in)  :: NumSlices
+  INTEGER(KIND=REG_SP_KIND), DIMENSION(NumSlices), INTENT(in) :: DataTypes
+  INTEGER(KIND=REG_SP_KIND), DIMENSION(NumSlices), INTENT(in) :: Counts
+  XXXXXXX(KIND=REG_DP_KIND), DIMENSION(),INTENT(in) :: pData
+  INTEGER(KIND=REG_SP_KIND), INTENT(out) :: Status
+----------------------------------------------------------------*/
+/** Wrapper for Emit_data_slices(), for use from within F90.  The
+    data for all of the slices is packed, one slice after the other,
+    into the single buffer @p pData with the i'th slice consisting of
+    @p Counts(i) objects of type @p DataTypes(i).
+    @param Status Return status of the call, REG_SUCCESS or
+    REG_FAILURE */
+void FUNCTION(emit_data_slices_f) ARGS(`IOHandle,
+                                        NumSlices,
+                                        DataTypes,
+                                        Counts,
+                                        pData,
+                                        Status')
+INT_KIND_1_DECL(IOHandle);
+INT_KIND_1_DECL(NumSlices);
+INT_KIND_1_DECL(DataTypes);
+INT_KIND_1_DECL(Counts);
+void *pData;
+INT_KIND_1_DECL(Status);
+{
+  int i;
+  int lNumSlices = (int)*NumSlices;
+  char *pchar = (char *)pData;
+  struct reg_data_slice *slices;
+
+  if(lNumSlices < 1){
+    *Status = INT_KIND_1_CAST( Emit_data_slices((int)*IOHandle, 0, NULL) );
+    return;
+  }
+
+  slices = (struct reg_data_slice *)malloc(lNumSlices*
+                                           sizeof(struct reg_data_slice));
+  if(!slices){
+    fprintf(stderr, "STEER: emit_data_slices_f: malloc failed\n");
+    *Status = INT_KIND_1_CAST(REG_FAILURE);
+    return;
+  }
+
+  for(i=0; i<lNumSlices; i++){
+    slices[i].type  = f90_to_c_type[(int)DataTypes[i]];
+    slices[i].count = (int)Counts[i];
+    slices[i].data  = (void *)pchar;
+    pchar += Counts[i]*sizeof_type[(int)DataTypes[i]];
+  }
+
+  *Status = INT_KIND_1_CAST( Emit_data_slices((int)*IOHandle,
+                                              lNumSlices,
+                                              slices) );
+  free(slices);
+  return;
+}
+
 /*----------------------------------------------------------------
 SUBROUTINE emit_char_data_slice_f(IOHandle, pData, Status)
 
@@ -0,0 +1,859 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+
+/** @internal
+    @file ReG_Steer_Async_Emit.c
+    @brief Asynchronous (background) emission of samples.
+
+    Each asynchronous IOType has REG_ASYNC_NUM_BUFFERS snapshots.  A
+    snapshot is FREE, being FILLED by the application, READY to send
+    or being SENT by the I/O thread.  The application only ever writes
+    to the snapshot it is filling and the I/O thread only reads READY
+    or SENDING ones, so the data itself is copied without holding a
+    lock; only changes of state are made under @p async_mutex.
+
+    The I/O thread holds @p async_io_mutex for as long as it is using
+    the samples transport.  The transports are not thread-safe so the
+    application must take it (with Async_emit_lock()) before doing
+    anything that touches the transport of an IOType, or that moves
+    the table of IOTypes, while the I/O thread is running.
+
+    @author Robert Haines
+  */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "ReG_Steer_Config.h"
+#include "ReG_Steer_Appside.h"
+#include "ReG_Steer_Appside_internal.h"
+#include "ReG_Steer_Samples_Transport_API.h"
+#include "ReG_Steer_Async_Emit.h"
+
+#if REG_HAS_PTHREADS
+
+#include <pthread.h>
+#if REG_HAS_PTHREAD_SETAFFINITY_NP
+#include <sched.h>
+#endif
+
+/** @internal States of a snapshot */
+#define ASYNC_FREE    0
+#define ASYNC_FILLING 1
+#define ASYNC_READY   2
+#define ASYNC_SENDING 3
+
+/** @internal Slices are copied into a snapshot on boundaries of this
+    many bytes so that they can be encoded in place */
+#define ASYNC_ALIGN   16
+
+/** @internal
+    A slice within a snapshot */
+typedef struct {
+  /** Type of the data */
+  int    type;
+  /** No. of elements of @p type */
+  int    count;
+  /** Offset of the data from the start of the snapshot's buffer */
+  size_t offset;
+} async_slice_type;
+
+/** @internal
+    A copy of a sample waiting to be sent */
+typedef struct {
+  /** ASYNC_FREE, ASYNC_FILLING, ASYNC_READY or ASYNC_SENDING */
+  int               state;
+  /** Sequence number given to Emit_start() */
+  int               seqnum;
+  /** Whether the data is from FORTRAN arrays */
+  int               is_fortran;
+  /** Snapshots are sent in the order in which they became ready */
+  unsigned long     order;
+  /** Copy of the data of all of the slices */
+  char             *data;
+  /** No. of bytes of @p data in use */
+  size_t            num_bytes;
+  /** Size of @p data */
+  size_t            max_bytes;
+  /** The slices that make up the sample */
+  async_slice_type *slice;
+  /** No. of entries of @p slice in use */
+  int               num_slices;
+  /** Size of @p slice */
+  int               max_slices;
+} async_snapshot_type;
+
+/** @internal
+    Asynchronous state of one IOType */
+typedef struct {
+  /** REG_ASYNC_BLOCK, REG_ASYNC_DROP or REG_ASYNC_OVERWRITE */
+  int                 policy;
+  /** Index of the snapshot being filled, -1 if none */
+  int                 filling;
+  /** No. of samples dropped */
+  int                 num_dropped;
+  /** No. of queued samples overwritten by newer ones */
+  int                 num_overwritten;
+  /** Whether the I/O thread found a consumer last time it tried */
+  int                 connected;
+  /** The snapshots */
+  async_snapshot_type snapshot[REG_ASYNC_NUM_BUFFERS];
+} async_iotype_type;
+
+extern IOdef_table_type IOTypes_table;
+
+/** Guards all of the state below and the state of every snapshot */
+static pthread_mutex_t     async_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** Signalled when a snapshot becomes ready or the thread should quit */
+static pthread_cond_t      async_work = PTHREAD_COND_INITIALIZER;
+/** Signalled when a snapshot is freed */
+static pthread_cond_t      async_done = PTHREAD_COND_INITIALIZER;
+/** Held by the I/O thread while it uses the samples transport */
+static pthread_mutex_t     async_io_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** The I/O thread */
+static pthread_t           async_thread;
+/** Whether the I/O thread is running */
+static int                 async_running = REG_FALSE;
+/** Whether the I/O thread has been asked to stop */
+static int                 async_quit = REG_FALSE;
+/** CPU to pin the I/O thread to, -1 for none */
+static int                 async_cpu = -1;
+/** Order in which the next snapshot to become ready will be sent */
+static unsigned long       async_next_order = 0;
+/** Asynchronous state of each IOType, indexed as IOTypes_table */
+static async_iotype_type **async_iotype = NULL;
+/** Size of @p async_iotype */
+static int                 async_num_iotypes = 0;
+/** Slice headers are built here by the I/O thread */
+static char                async_hdr_buffer[REG_SLICE_BATCH_SIZE*
+					    7*REG_PACKET_SIZE];
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    Pin @p thread to @p cpu, if there is one */
+static int async_pin_thread(pthread_t thread, int cpu)
+{
+#if REG_HAS_PTHREAD_SETAFFINITY_NP
+  cpu_set_t cpus;
+
+  if(cpu < 0) return REG_SUCCESS;
+
+  CPU_ZERO(&cpus);
+  CPU_SET(cpu, &cpus);
+  if(pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpus) != 0){
+    fprintf(stderr, "STEER: WARNING: Async_emit: failed to pin I/O "
+	    "thread to CPU %d\n", cpu);
+    return REG_FAILURE;
+  }
+
+  return REG_SUCCESS;
+#else
+  if(cpu < 0) return REG_SUCCESS;
+
+  fprintf(stderr, "STEER: WARNING: Async_emit: pinning the I/O thread "
+	  "is not supported on this platform\n");
+  return REG_FAILURE;
+#endif
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    @return Index of the snapshot of @p aio that has been ready for
+    longest, or -1 if none is ready */
+static int async_oldest_ready(async_iotype_type *aio)
+{
+  int i;
+  int oldest = -1;
+
+  for(i = 0; i < REG_ASYNC_NUM_BUFFERS; i++){
+    if(aio->snapshot[i].state == ASYNC_READY &&
+       (oldest < 0 ||
+	aio->snapshot[i].order < aio->snapshot[oldest].order)){
+      oldest = i;
+    }
+  }
+
+  return oldest;
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    Return a snapshot to the free pool, keeping its memory */
+static void async_free_snapshot(async_snapshot_type *snap)
+{
+  snap->state = ASYNC_FREE;
+  snap->num_bytes = 0;
+  snap->num_slices = 0;
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    Send a snapshot just as Emit_start(), Emit_data_slice() and
+    Emit_stop() would have done.  Called by the I/O thread with
+    @p async_io_mutex held.
+    @param connected On return, whether there is a consumer
+    @return REG_SUCCESS, REG_FAILURE or REG_NOT_READY if there is no
+    consumer yet or it has not acknowledged the previous sample */
+static int async_send_snapshot(const int            index,
+			       async_snapshot_type *snap,
+			       int                 *connected)
+{
+  struct reg_data_slice slices[REG_SLICE_BATCH_SIZE];
+  char   footer[REG_PACKET_SIZE + 1];
+  int    i, j, n;
+  int    status;
+
+  *connected = REG_TRUE;
+
+  if(IOTypes_table.io_def[index].is_enabled == REG_FALSE){
+    return REG_FAILURE;
+  }
+
+  if(Consume_ack(index) != REG_SUCCESS){
+    return REG_NOT_READY;
+  }
+
+  IOTypes_table.io_def[index].use_xdr =
+    IOTypes_table.io_def[index].use_native ? REG_FALSE : REG_TRUE;
+
+  if(Emit_start_impl(index, snap->seqnum) != REG_SUCCESS){
+    return REG_FAILURE;
+  }
+
+  /* Emitting the header is what looks for a consumer so keep the
+     snapshot until there is one */
+  if(Emit_header(index) != REG_SUCCESS){
+    IOTypes_table.io_def[index].ack_needed = REG_FALSE;
+    if(Get_communication_status(index) != REG_SUCCESS){
+      *connected = REG_FALSE;
+      return REG_NOT_READY;
+    }
+    return REG_FAILURE;
+  }
+
+  for(i = 0; i < snap->num_slices; i += n){
+    n = snap->num_slices - i;
+    if(n > REG_SLICE_BATCH_SIZE) n = REG_SLICE_BATCH_SIZE;
+
+    for(j = 0; j < n; j++){
+      slices[j].type  = snap->slice[i+j].type;
+      slices[j].count = snap->slice[i+j].count;
+      slices[j].data  = (void*) &(snap->data[snap->slice[i+j].offset]);
+    }
+
+    if(Send_data_slices(index, n, slices, snap->is_fortran,
+			async_hdr_buffer) != REG_SUCCESS){
+      IOTypes_table.io_def[index].ack_needed = REG_FALSE;
+      return REG_FAILURE;
+    }
+  }
+
+  /* Anything held back by Send_data_slices() goes now */
+  status = Flush_data_slices(index, async_hdr_buffer);
+
+  sprintf(footer, REG_PACKET_FORMAT, REG_DATA_FOOTER);
+
+  if(Emit_footer(index, footer) != REG_SUCCESS){
+    status = REG_FAILURE;
+  }
+
+  if(Emit_stop_impl(index) != REG_SUCCESS){
+    status = REG_FAILURE;
+  }
+
+  if(status == REG_SUCCESS){
+    IOTypes_table.io_def[index].num_samples_emitted++;
+    IOTypes_table.io_def[index].samples_in_flight++;
+    IOTypes_table.io_def[index].ack_needed = REG_TRUE;
+  }
+  else{
+    IOTypes_table.io_def[index].ack_needed = REG_FALSE;
+  }
+
+  return status;
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    Body of the I/O thread.  Sends the oldest ready snapshot of each
+    asynchronous IOType in turn, polling for acknowledgements while
+    any are waiting for one and sleeping when there is nothing to
+    do. */
+static void *async_emit_thread(void *arg)
+{
+  async_iotype_type   *aio;
+  async_snapshot_type *snap;
+  struct timespec      wake;
+  struct timeval       now;
+  int                  i, j;
+  int                  status;
+  int                  sent;
+  int                  waiting;
+  int                  connected;
+
+  /* Everything the thread needs is in the statics above */
+  (void) arg;
+
+  pthread_mutex_lock(&async_mutex);
+
+  while(!async_quit){
+    sent = REG_FALSE;
+    waiting = REG_FALSE;
+
+    for(i = 0; i < async_num_iotypes; i++){
+      if(!(aio = async_iotype[i])) continue;
+      if((j = async_oldest_ready(aio)) < 0) continue;
+
+      snap = &(aio->snapshot[j]);
+      snap->state = ASYNC_SENDING;
+      pthread_mutex_unlock(&async_mutex);
+
+      pthread_mutex_lock(&async_io_mutex);
+      status = async_send_snapshot(i, snap, &connected);
+      pthread_mutex_unlock(&async_io_mutex);
+
+      pthread_mutex_lock(&async_mutex);
+      if(aio->connected && !connected){
+	/* Anyone blocked waiting for a snapshot should give up */
+	pthread_cond_broadcast(&async_done);
+      }
+      aio->connected = connected;
+      if(status == REG_NOT_READY){
+	snap->state = ASYNC_READY;
+	waiting = REG_TRUE;
+      }
+      else{
+	if(status != REG_SUCCESS) aio->num_dropped++;
+	async_free_snapshot(snap);
+	pthread_cond_broadcast(&async_done);
+	sent = REG_TRUE;
+      }
+    }
+
+    if(sent) continue;
+
+    if(waiting){
+      gettimeofday(&now, NULL);
+      now.tv_usec += REG_ASYNC_POLL_INTERVAL;
+      wake.tv_sec = now.tv_sec + now.tv_usec/1000000;
+      wake.tv_nsec = (now.tv_usec%1000000)*1000;
+      pthread_cond_timedwait(&async_work, &async_mutex, &wake);
+    }
+    else{
+      pthread_cond_wait(&async_work, &async_mutex);
+    }
+  }
+
+  pthread_mutex_unlock(&async_mutex);
+
+  return NULL;
+}
+
+/*----------------------------------------------------------------*/
+
+int Async_emit_enable(const int index, const int policy)
+{
+  async_iotype_type **new_table;
+  async_iotype_type  *aio;
+  char               *cpu;
+  int                 i;
+
+  pthread_mutex_lock(&async_mutex);
+
+  if(index >= async_num_iotypes){
+    new_table = (async_iotype_type**)realloc(async_iotype, (index + 1)*
+					     sizeof(async_iotype_type*));
+    if(!new_table){
+      pthread_mutex_unlock(&async_mutex);
+      fprintf(stderr, "STEER: ERROR: Async_emit_enable: failed to "
+	      "allocate memory\n");
+      return REG_FAILURE;
+    }
+    for(i = async_num_iotypes; i <= index; i++){
+      new_table[i] = NULL;
+    }
+    async_iotype = new_table;
+    async_num_iotypes = index + 1;
+  }
+
+  if(!(aio = async_iotype[index])){
+    if(!(aio = (async_iotype_type*)calloc(1, sizeof(async_iotype_type)))){
+      pthread_mutex_unlock(&async_mutex);
+      fprintf(stderr, "STEER: ERROR: Async_emit_enable: failed to "
+	      "allocate memory\n");
+      return REG_FAILURE;
+    }
+    aio->filling = -1;
+    for(i = 0; i < REG_ASYNC_NUM_BUFFERS; i++){
+      async_free_snapshot(&(aio->snapshot[i]));
+    }
+    async_iotype[index] = aio;
+  }
+  aio->policy = policy;
+
+  if(!async_running){
+    async_quit = REG_FALSE;
+    if(pthread_create(&async_thread, NULL, async_emit_thread, NULL) != 0){
+      async_iotype[index] = NULL;
+      pthread_mutex_unlock(&async_mutex);
+      free(aio);
+      fprintf(stderr, "STEER: ERROR: Async_emit_enable: failed to "
+	      "start I/O thread\n");
+      return REG_FAILURE;
+    }
+    async_running = REG_TRUE;
+
+    if(async_cpu < 0 && (cpu = getenv("REG_ASYNC_EMIT_CPU"))){
+      async_cpu = atoi(cpu);
+    }
+    async_pin_thread(async_thread, async_cpu);
+  }
+
+  pthread_mutex_unlock(&async_mutex);
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Async_emit_disable(const int index)
+{
+  async_iotype_type *aio;
+  struct timespec    deadline;
+  struct timeval     now;
+  int                i;
+  int                busy;
+  int                timed_out = REG_FALSE;
+
+  pthread_mutex_lock(&async_mutex);
+
+  if(index < 0 || index >= async_num_iotypes ||
+     !(aio = async_iotype[index])){
+    pthread_mutex_unlock(&async_mutex);
+    return REG_SUCCESS;
+  }
+
+  /* A sample that was never finished is thrown away */
+  if(aio->filling >= 0){
+    async_free_snapshot(&(aio->snapshot[aio->filling]));
+    aio->filling = -1;
+  }
+
+  gettimeofday(&now, NULL);
+  deadline.tv_sec = now.tv_sec + REG_ASYNC_DRAIN_TIMEOUT;
+  deadline.tv_nsec = now.tv_usec*1000;
+
+  while(1){
+    busy = REG_FALSE;
+    for(i = 0; i < REG_ASYNC_NUM_BUFFERS; i++){
+      if(aio->snapshot[i].state == ASYNC_READY && timed_out){
+	async_free_snapshot(&(aio->snapshot[i]));
+	aio->num_dropped++;
+      }
+      if(aio->snapshot[i].state != ASYNC_FREE) busy = REG_TRUE;
+    }
+    if(!busy) break;
+
+    /* Snapshots still being sent are always waited for */
+    if(timed_out){
+      pthread_cond_wait(&async_done, &async_mutex);
+    }
+    else if(pthread_cond_timedwait(&async_done, &async_mutex,
+				   &deadline) == ETIMEDOUT){
+      fprintf(stderr, "STEER: WARNING: Async_emit_disable: discarding "
+	      "samples that could not be sent\n");
+      timed_out = REG_TRUE;
+    }
+  }
+
+  async_iotype[index] = NULL;
+  pthread_mutex_unlock(&async_mutex);
+
+  for(i = 0; i < REG_ASYNC_NUM_BUFFERS; i++){
+    if(aio->snapshot[i].data) free(aio->snapshot[i].data);
+    if(aio->snapshot[i].slice) free(aio->snapshot[i].slice);
+  }
+  free(aio);
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Async_emit_start(const int index, const int seqnum)
+{
+  async_iotype_type   *aio = async_iotype[index];
+  async_snapshot_type *snap;
+  int                  i;
+
+  pthread_mutex_lock(&async_mutex);
+
+  /* A sample that was never finished is thrown away */
+  if(aio->filling >= 0){
+    async_free_snapshot(&(aio->snapshot[aio->filling]));
+    aio->filling = -1;
+  }
+
+  while(1){
+    for(i = 0; i < REG_ASYNC_NUM_BUFFERS; i++){
+      if(aio->snapshot[i].state == ASYNC_FREE) break;
+    }
+    if(i < REG_ASYNC_NUM_BUFFERS) break;
+
+    /* Both buffers are busy.  Unless we can overwrite, there is no
+       point waiting for them if there is nobody to send them to */
+    if(aio->policy == REG_ASYNC_DROP ||
+       (aio->policy == REG_ASYNC_BLOCK && !aio->connected)){
+      aio->num_dropped++;
+      pthread_mutex_unlock(&async_mutex);
+      return REG_NOT_READY;
+    }
+
+    if(aio->policy == REG_ASYNC_OVERWRITE &&
+       (i = async_oldest_ready(aio)) >= 0){
+      aio->num_overwritten++;
+      break;
+    }
+
+    /* Block, or overwrite when every snapshot is being sent */
+    pthread_cond_wait(&async_done, &async_mutex);
+  }
+
+  snap = &(aio->snapshot[i]);
+  async_free_snapshot(snap);
+  snap->state = ASYNC_FILLING;
+  snap->seqnum = seqnum;
+  aio->filling = i;
+
+  pthread_mutex_unlock(&async_mutex);
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Async_emit_wait(const int index, const int timeout_ms)
+{
+  async_iotype_type *aio = async_iotype[index];
+  struct timespec    deadline;
+  struct timeval     now;
+  int                status = REG_TIMED_OUT;
+  int                i;
+
+  gettimeofday(&now, NULL);
+  now.tv_usec += (timeout_ms%1000)*1000;
+  deadline.tv_sec = now.tv_sec + timeout_ms/1000 + now.tv_usec/1000000;
+  deadline.tv_nsec = (now.tv_usec%1000000)*1000;
+
+  pthread_mutex_lock(&async_mutex);
+
+  while(1){
+    for(i = 0; i < REG_ASYNC_NUM_BUFFERS; i++){
+      if(aio->snapshot[i].state == ASYNC_FREE) break;
+    }
+    if(i < REG_ASYNC_NUM_BUFFERS){
+      status = REG_SUCCESS;
+      break;
+    }
+
+    if(pthread_cond_timedwait(&async_done, &async_mutex,
+			      &deadline) == ETIMEDOUT) break;
+  }
+
+  pthread_mutex_unlock(&async_mutex);
+
+  return status;
+}
+
+/*----------------------------------------------------------------*/
+
+int Async_emit_slice(const int   index,
+		     const int   type,
+		     const int   count,
+		     const void *pData,
+		     const int   is_fortran)
+{
+  async_iotype_type   *aio = async_iotype[index];
+  async_snapshot_type *snap;
+  async_slice_type    *new_slice;
+  char                *new_data;
+  size_t               offset;
+  size_t               nbytes;
+  size_t               new_size;
+  int                  size;
+
+  if(aio->filling < 0){
+    fprintf(stderr, "STEER: ERROR: Async_emit_slice: no sample in "
+	    "progress\n");
+    return REG_FAILURE;
+  }
+  snap = &(aio->snapshot[aio->filling]);
+
+  if(!(size = Sizeof_type(type)) || count < 0 || (count > 0 && !pData)){
+    fprintf(stderr, "STEER: ERROR: Async_emit_slice: invalid slice\n");
+    return REG_FAILURE;
+  }
+
+  nbytes = (size_t)count*size;
+  offset = (snap->num_bytes + ASYNC_ALIGN - 1) & ~((size_t)ASYNC_ALIGN - 1);
+
+  /* Buffers only ever grow so, once the first few samples have been
+     taken, no more memory is allocated */
+  if(offset + nbytes > snap->max_bytes){
+    new_size = 2*snap->max_bytes;
+    if(new_size < offset + nbytes) new_size = offset + nbytes;
+    if(!(new_data = (char*)realloc(snap->data, new_size))){
+      fprintf(stderr, "STEER: ERROR: Async_emit_slice: failed to "
+	      "allocate %lu bytes\n", (unsigned long)new_size);
+      return REG_FAILURE;
+    }
+    snap->data = new_data;
+    snap->max_bytes = new_size;
+  }
+
+  if(snap->num_slices == snap->max_slices){
+    new_size = snap->max_slices ? 2*snap->max_slices : REG_SLICE_BATCH_SIZE;
+    if(!(new_slice = (async_slice_type*)realloc(snap->slice, new_size*
+						sizeof(async_slice_type)))){
+      fprintf(stderr, "STEER: ERROR: Async_emit_slice: failed to "
+	      "allocate memory\n");
+      return REG_FAILURE;
+    }
+    snap->slice = new_slice;
+    snap->max_slices = (int)new_size;
+  }
+
+  if(nbytes > 0) memcpy(&(snap->data[offset]), pData, nbytes);
+
+  snap->slice[snap->num_slices].type = type;
+  snap->slice[snap->num_slices].count = count;
+  snap->slice[snap->num_slices].offset = offset;
+  snap->num_slices++;
+  snap->num_bytes = offset + nbytes;
+  snap->is_fortran = is_fortran;
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Async_emit_stop(const int index)
+{
+  async_iotype_type *aio = async_iotype[index];
+
+  if(aio->filling < 0){
+    fprintf(stderr, "STEER: ERROR: Async_emit_stop: no sample in "
+	    "progress\n");
+    return REG_FAILURE;
+  }
+
+  pthread_mutex_lock(&async_mutex);
+
+  aio->snapshot[aio->filling].state = ASYNC_READY;
+  aio->snapshot[aio->filling].order = async_next_order++;
+  aio->filling = -1;
+  pthread_cond_signal(&async_work);
+
+  pthread_mutex_unlock(&async_mutex);
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Async_emit_set_cpu(const int cpu)
+{
+  int status = REG_SUCCESS;
+
+  pthread_mutex_lock(&async_mutex);
+
+  async_cpu = cpu;
+  if(async_running){
+    status = async_pin_thread(async_thread, async_cpu);
+  }
+
+  pthread_mutex_unlock(&async_mutex);
+
+  return status;
+}
+
+/*----------------------------------------------------------------*/
+
+int Async_emit_stats(const int index, int *num_dropped,
+		     int *num_overwritten)
+{
+  pthread_mutex_lock(&async_mutex);
+
+  if(index >= 0 && index < async_num_iotypes && async_iotype[index]){
+    *num_dropped = async_iotype[index]->num_dropped;
+    *num_overwritten = async_iotype[index]->num_overwritten;
+  }
+  else{
+    *num_dropped = 0;
+    *num_overwritten = 0;
+  }
+
+  pthread_mutex_unlock(&async_mutex);
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+void Async_emit_lock()
+{
+  pthread_mutex_lock(&async_io_mutex);
+}
+
+/*----------------------------------------------------------------*/
+
+void Async_emit_unlock()
+{
+  pthread_mutex_unlock(&async_io_mutex);
+}
+
+/*----------------------------------------------------------------*/
+
+void Async_emit_finalize()
+{
+  int i;
+
+  for(i = 0; i < async_num_iotypes; i++){
+    Async_emit_disable(i);
+  }
+
+  pthread_mutex_lock(&async_mutex);
+  if(!async_running){
+    pthread_mutex_unlock(&async_mutex);
+    return;
+  }
+  async_quit = REG_TRUE;
+  pthread_cond_signal(&async_work);
+  pthread_mutex_unlock(&async_mutex);
+
+  pthread_join(async_thread, NULL);
+
+  pthread_mutex_lock(&async_mutex);
+  async_running = REG_FALSE;
+  free(async_iotype);
+  async_iotype = NULL;
+  async_num_iotypes = 0;
+  pthread_mutex_unlock(&async_mutex);
+}
+
+#else /* REG_HAS_PTHREADS */
+
+/* Without threads IOTypes are always emitted synchronously */
+
+int Async_emit_enable(const int index, const int policy)
+{
+  fprintf(stderr, "STEER: ERROR: Async_emit_enable: asynchronous "
+	  "emission is not supported on this platform\n");
+  return REG_FAILURE;
+}
+
+int Async_emit_disable(const int index)
+{
+  return REG_SUCCESS;
+}
+
+int Async_emit_start(const int index, const int seqnum)
+{
+  return REG_FAILURE;
+}
+
+int Async_emit_wait(const int index, const int timeout_ms)
+{
+  return REG_FAILURE;
+}
+
+int Async_emit_slice(const int   index,
+		     const int   type,
+		     const int   count,
+		     const void *pData,
+		     const int   is_fortran)
+{
+  return REG_FAILURE;
+}
+
+int Async_emit_stop(const int index)
+{
+  return REG_FAILURE;
+}
+
+int Async_emit_set_cpu(const int cpu)
+{
+  return REG_FAILURE;
+}
+
+int Async_emit_stats(const int index, int *num_dropped,
+		     int *num_overwritten)
+{
+  *num_dropped = 0;
+  *num_overwritten = 0;
+  return REG_SUCCESS;
+}
+
+void Async_emit_lock()
+{
+}
+
+void Async_emit_unlock()
+{
+}
+
+void Async_emit_finalize()
+{
+}
+
+#endif /* REG_HAS_PTHREADS */
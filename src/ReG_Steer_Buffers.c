@@ -0,0 +1,287 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+
+/** @internal
+    @file ReG_Steer_Buffers.c
+    @brief Pool of the buffers that IOTypes keep their data in.
+
+    Size classes go up in quarters of a power of two (4, 5, 6 and 7
+    times 2^k pages) so that no more than a quarter of a buffer is
+    wasted by rounding up and there are few enough classes for a
+    freed buffer to be reused by the next sample.  Up to
+    BUF_POOL_DEPTH idle buffers of each class, and BUF_POOL_MAX_BYTES
+    in all, are kept.
+
+    If REG_IO_HUGE_PAGES is set then buffers of at least a huge page
+    are aligned to one and the kernel is asked to back them with huge
+    pages, where it knows how.
+
+    @author Robert Haines
+  */
+
+#include "ReG_Steer_Config.h"
+#include "ReG_Steer_types.h"
+#include "ReG_Steer_Buffers.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#if REG_HAS_PTHREADS
+#include <pthread.h>
+#endif
+
+#if REG_HAS_MADV_HUGEPAGE
+#include <sys/mman.h>
+#endif
+
+/** @internal Size of the smallest class, in pages */
+#define BUF_MIN_PAGES      4
+/** @internal No. of classes.  The largest is 7*2^(BUF_NUM_CLASSES/4-1)
+    pages */
+#define BUF_NUM_CLASSES    160
+/** @internal Max. no. of idle buffers kept of each class */
+#define BUF_POOL_DEPTH     4
+/** @internal Max. no. of bytes of idle buffers kept in all */
+#define BUF_POOL_MAX_BYTES (64*1048576)
+/** @internal Size of a huge page, to which big buffers are aligned
+    if huge pages are asked for */
+#define BUF_HUGE_PAGE      (2*1048576)
+
+/** Idle buffers of each class */
+static void   *buf_pool[BUF_NUM_CLASSES][BUF_POOL_DEPTH];
+/** No. of entries of each row of @p buf_pool in use */
+static int     buf_pool_count[BUF_NUM_CLASSES];
+/** Total size of the idle buffers */
+static size_t  buf_pool_bytes = 0;
+/** Size of a page, zero until the pool has been set up */
+static size_t  buf_page_bytes = 0;
+/** Whether (REG_TRUE) or not to ask for huge pages */
+static int     buf_huge_pages = REG_FALSE;
+
+#if REG_HAS_PTHREADS
+/** Guards the pool - buffers are got and given back by the I/O
+    thread as well as the application */
+static pthread_mutex_t buf_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    Take the pool's lock, setting the pool up the first time */
+static void buf_lock()
+{
+  long  page;
+  char *pchar;
+
+#if REG_HAS_PTHREADS
+  pthread_mutex_lock(&buf_mutex);
+#endif
+
+  if(buf_page_bytes) return;
+
+  page = sysconf(_SC_PAGESIZE);
+  buf_page_bytes = (page > 0) ? (size_t) page : 4096;
+
+  if((pchar = getenv("REG_IO_HUGE_PAGES")) && atoi(pchar) > 0) {
+#if REG_HAS_MADV_HUGEPAGE
+    buf_huge_pages = REG_TRUE;
+#else
+    fprintf(stderr, "STEER: WARNING: Buffer_get: huge pages are not "
+	    "supported on this platform\n");
+#endif
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    Release the pool's lock */
+static void buf_unlock()
+{
+#if REG_HAS_PTHREADS
+  pthread_mutex_unlock(&buf_mutex);
+#endif
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    @param num_bytes Minimum no. of bytes
+    @return Class of the smallest buffer of at least @p num_bytes
+    bytes, or -1 if it is too big for any class */
+static int buf_class(const size_t num_bytes)
+{
+  size_t pages = (num_bytes + buf_page_bytes - 1)/buf_page_bytes;
+  int    k = 0;
+
+  if(pages <= BUF_MIN_PAGES) return 0;
+
+  /* Find k such that 3.5*2^k < pages <= 7*2^k */
+  while(pages > ((size_t) 7 << k)) {
+    k++;
+    if(4*k >= BUF_NUM_CLASSES) return -1;
+  }
+
+  return 4*k + (int) ((pages + ((size_t) 1 << k) - 1) >> k) - 4;
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    @param cls Size class
+    @return No. of bytes in a buffer of class @p cls */
+static size_t buf_class_size(const int cls)
+{
+  return ((size_t) (4 + cls % 4) << (cls/4))*buf_page_bytes;
+}
+
+/*----------------------------------------------------------------*/
+
+size_t Buffer_class_bytes(const size_t num_bytes)
+{
+  size_t bytes = 0;
+  int    cls;
+
+  buf_lock();
+  if((cls = buf_class(num_bytes)) >= 0) bytes = buf_class_size(cls);
+  buf_unlock();
+
+  return bytes;
+}
+
+/*----------------------------------------------------------------*/
+
+void *Buffer_get(const size_t num_bytes, size_t *class_bytes)
+{
+  void   *buf = NULL;
+  size_t  bytes;
+  size_t  align;
+  int     cls;
+
+  *class_bytes = 0;
+
+  buf_lock();
+  if((cls = buf_class(num_bytes)) < 0) {
+    buf_unlock();
+    fprintf(stderr, "STEER: ERROR: Buffer_get: no buffer can hold %lu "
+	    "bytes\n", (unsigned long) num_bytes);
+    return NULL;
+  }
+  bytes = buf_class_size(cls);
+
+  if(buf_pool_count[cls] > 0) {
+    buf = buf_pool[cls][--buf_pool_count[cls]];
+    buf_pool_bytes -= bytes;
+    buf_unlock();
+    *class_bytes = bytes;
+    return buf;
+  }
+
+  align = buf_page_bytes;
+  if(buf_huge_pages && bytes >= BUF_HUGE_PAGE) align = BUF_HUGE_PAGE;
+  buf_unlock();
+
+#if REG_HAS_POSIX_MEMALIGN
+  if(posix_memalign(&buf, align, bytes) != 0) buf = NULL;
+#else
+  buf = malloc(bytes);
+#endif
+
+  if(!buf) {
+    fprintf(stderr, "STEER: ERROR: Buffer_get: failed to allocate %lu "
+	    "bytes\n", (unsigned long) bytes);
+    return NULL;
+  }
+
+#if REG_HAS_MADV_HUGEPAGE
+  if(align == BUF_HUGE_PAGE) madvise(buf, bytes, MADV_HUGEPAGE);
+#endif
+
+  *class_bytes = bytes;
+  return buf;
+}
+
+/*----------------------------------------------------------------*/
+
+void Buffer_put(void *buf, const size_t class_bytes)
+{
+  int cls;
+
+  if(!buf) return;
+
+  buf_lock();
+  cls = buf_class(class_bytes);
+  if(cls >= 0 && buf_class_size(cls) == class_bytes &&
+     buf_pool_count[cls] < BUF_POOL_DEPTH &&
+     buf_pool_bytes + class_bytes <= BUF_POOL_MAX_BYTES) {
+    buf_pool[cls][buf_pool_count[cls]++] = buf;
+    buf_pool_bytes += class_bytes;
+    buf = NULL;
+  }
+  buf_unlock();
+
+  if(buf) free(buf);
+}
+
+/*----------------------------------------------------------------*/
+
+void Buffer_pool_finalize()
+{
+  int i;
+
+  buf_lock();
+  for(i = 0; i < BUF_NUM_CLASSES; i++) {
+    while(buf_pool_count[i] > 0) {
+      free(buf_pool[i][--buf_pool_count[i]]);
+    }
+  }
+  buf_pool_bytes = 0;
+  buf_unlock();
+}
+
+/*----------------------------------------------------------------*/
@@ -61,6 +61,12 @@
 #include "ReG_Steer_Config.h"
 #include "ReG_Steer_types.h"
 #include "ReG_Steer_Common.h"
+#include "ReG_Steer_Region.h"
+#include "ReG_Steer_XDR_Codec.h"
+#include "ReG_Steer_Reorder.h"
+#include "ReG_Steer_Compress.h"
+
+#include <stdint.h>
 
 /** Basic library config. Declared here as used by all. */
 Steer_lib_config_type Steer_lib_config;
@@ -624,24 +630,15 @@ int Reorder_decode_array(IOdef_entry *io,
 			 int          count,
 			 void        *pData)
 {
-  int         i, j, k;
-  int         nslab, nrow;
-  int        *pi, *pi_old;
-  float      *pf, *pf_old;
-  double     *pd, *pd_old;
-  long       *pl, *pl_old;
-  int         return_status = REG_SUCCESS;
-  XDR         xdrs;
+  int         tot_extent[3];
+  int         sub_extent[3];
+  int         origin[3];
+  int         elem_size;
+  size_t      nelem;
   Array_type *array;
 
   array = &(io->array);
-  /*
-  if( (io->convert_array_order == REG_TRUE) && (array->nx == 0) ){
 
-    fprintf(stderr, "STEER: Reorder_decode_array: array has zero dimension\n");
-    return REG_FAILURE;
-  }
-  */
   if(io->use_xdr){
 
 #ifdef REG_DEBUG
@@ -649,426 +646,79 @@ int Reorder_decode_array(IOdef_entry *io,
 	    type);
 #endif
 
-    xdrmem_create(&xdrs,
-		  io->buffer,
-		  io->num_xdr_bytes,
-		  XDR_DECODE);
-  }
-
-  if(io->use_xdr && io->convert_array_order != REG_TRUE){
-
-    /* Straight xdr decode with no re-ordering */
-    switch(type){
-
-    case REG_INT:
-
-      if(1 != xdr_vector(&xdrs, (char *)pData, (unsigned int)count,
-			 (unsigned int)sizeof(int), (xdrproc_t)xdr_int)){
-	fprintf(stderr, "STEER: Reorder_decode_array: xdr_vector decode "
-		"failed for REG_INT\n");
-	return_status = REG_FAILURE;
-      }
-      break;
-
-    case REG_LONG:
-
-      if(1 != xdr_vector(&xdrs, (char *)pData, (unsigned int)count,
-			 (unsigned int)sizeof(int), (xdrproc_t)xdr_long)){
-	fprintf(stderr, "STEER: Reorder_decode_array: xdr_vector decode "
-		"failed for REG_LONG\n");
-	return_status = REG_FAILURE;
-      }
-      break;
-
-    case REG_FLOAT:
-
-      if(1 != xdr_vector(&xdrs, (char *)pData, (unsigned int)count,
-			 (unsigned int)sizeof(float), (xdrproc_t)xdr_float)){
-	fprintf(stderr, "STEER: Reorder_decode_array: xdr_vector decode "
-		"failed for REG_FLOAT\n");
-	return_status = REG_FAILURE;
-      }
-      break;
-
-    case REG_DBL:
-
-      if(1 != xdr_vector(&xdrs, (char *)pData, (unsigned int)count,
-			 (unsigned int)sizeof(double), (xdrproc_t)xdr_double)){
-	fprintf(stderr, "STEER: Reorder_decode_array: xdr_vector decode "
-		"failed for REG_DBL\n");
-	return_status = REG_FAILURE;
-      }
-      break;
-
-    default:
-      fprintf(stderr, "STEER: Reorder_decode_array: unexpected datatype\n");
-      return_status = REG_FAILURE;
-      break;
+    if((size_t)io->num_xdr_bytes < count*(size_t)Xdr_sizeof_type(type)){
+      fprintf(stderr, "STEER: Reorder_decode_array: too little XDR data "
+	      "for %d objects of type %d\n", count, type);
+      return REG_FAILURE;
     }
   }
-  else if(io->convert_array_order == REG_TRUE){
-
-    switch(type){
-
-    case REG_INT:
-
-      pi = (int *)pData;
-
-      /* In this context, array->is_f90 flags whether we want to
-	 convert _to_ an F90-style array */
-      if(array->is_f90 != REG_TRUE){
-
-	/* Convert F90 array to C array */
-
-	nslab = (array->totz)*(array->toty);
-	nrow  = array->totz;
-
-	if(io->use_xdr){
-
-	  /* Order loops so i,j,k vary as they should for an F90-style
-	     array ordered consecutively in memory */
-	  for(k=array->sz; k<(array->nz+array->sz); k++){
-	    for(j=array->sy; j<(array->ny+array->sy); j++){
-	      for(i=array->sx; i<(array->nx+array->sx); i++){
-		/* Calculate position of (i,j,k)'th element in a C array
-		   (where k varies most rapidly) and store value. This
-		   statement decodes the next value from the array we
-		   specified when we opened 'xdrs'.*/
-		xdr_int(&xdrs, &(pi[i*nslab + j*nrow + k]));
-	      }
-	    }
-	  }
-	}
-	else{ /* No xdr-decode required */
-
-	  /* Data we've read in is stored in io->buffer */
-	  pi_old = (int *)io->buffer;
-
-	  /* Order loops so i,j,k vary as they should for an F90-style
-	     array ordered consecutively in memory */
-	  for(k=array->sz; k<(array->nz+array->sz); k++){
-	    for(j=array->sy; j<(array->ny+array->sy); j++){
-	      for(i=array->sx; i<(array->nx+array->sx); i++){
-		/* Calculate position of (i,j,k)'th element in a C array
-		   (where k varies most rapidly) and store value */
-		pi[i*nslab + j*nrow + k] = *(pi_old++);
-	      }
-	    }
-	  }
-	}
-      }
-      else{
-
-	/* Convert C array to F90 array */
-
-	nslab = array->totx*array->toty;
-	nrow  = array->totx;
-
-	if(io->use_xdr){
-
-	  /* Order loops so i,j,k vary as they should for a C-style
-	     array ordered consecutively in memory */
-	  for(i=array->sx; i<(array->nx+array->sx); i++){
-	    for(j=array->sy; j<(array->ny+array->sy); j++){
-	      for(k=array->sz; k<(array->nz+array->sz); k++){
-		/* Calculate position of (i,j,k)'th element in an F90 array
-		   (where i varies most rapidly) and store value */
-		xdr_int(&xdrs, &(pi[k*nslab + j*nrow + i]));
-	      }
-	    }
-	  }
-	}
-	else{ /* No xdr-decode required */
-
-	  /* Data we've read in is stored in io->buffer */
-	  pi_old = (int *)io->buffer;
-
-	  /* Order loops so i,j,k vary as they should for a C-style
-	     array ordered consecutively in memory */
-	  for(i=array->sx; i<(array->nx+array->sx); i++){
-	    for(j=array->sy; j<(array->ny+array->sy); j++){
-	      for(k=array->sz; k<(array->nz+array->sz); k++){
-		/* Calculate position of (i,j,k)'th element in an F90 array
-		   (where i varies most rapidly) and store value */
-		pi[k*nslab + j*nrow + i] = *(pi_old++);
-	      }
-	    }
-	  }
-	}
-      }
-      break;
-
-
-    case REG_LONG:
-
-      pl = (long *)pData;
-
-      /* In this context, array->is_f90 flags whether we want to
-	 convert _to_ an F90-style array */
-      if(array->is_f90 != REG_TRUE){
-
-	/* Convert F90 array to C array */
-
-	nslab = (array->totz)*(array->toty);
-	nrow  = array->totz;
-
-	if(io->use_xdr){
-
-	  /* Order loops so i,j,k vary as they should for an F90-style
-	     array ordered consecutively in memory */
-	  for(k=array->sz; k<(array->nz+array->sz); k++){
-	    for(j=array->sy; j<(array->ny+array->sy); j++){
-	      for(i=array->sx; i<(array->nx+array->sx); i++){
-		/* Calculate position of (i,j,k)'th element in a C array
-		   (where k varies most rapidly) and store value. This
-		   statement decodes the next value from the array we
-		   specified when we opened 'xdrs'.*/
-		xdr_long(&xdrs, &(pl[i*nslab + j*nrow + k]));
-	      }
-	    }
-	  }
-	}
-	else{ /* No xdr-decode required */
-
-	  /* Data we've read in is stored in io->buffer */
-	  pl_old = (long *)io->buffer;
-
-	  /* Order loops so i,j,k vary as they should for an F90-style
-	     array ordered consecutively in memory */
-	  for(k=array->sz; k<(array->nz+array->sz); k++){
-	    for(j=array->sy; j<(array->ny+array->sy); j++){
-	      for(i=array->sx; i<(array->nx+array->sx); i++){
-		/* Calculate position of (i,j,k)'th element in a C array
-		   (where k varies most rapidly) and store value */
-		pl[i*nslab + j*nrow + k] = *(pl_old++);
-	      }
-	    }
-	  }
-	}
-      }
-      else{
-
-	/* Convert C array to F90 array */
-
-	nslab = array->totx*array->toty;
-	nrow  = array->totx;
-
-	if(io->use_xdr){
-
-	  /* Order loops so i,j,k vary as they should for a C-style
-	     array ordered consecutively in memory */
-	  for(i=array->sx; i<(array->nx+array->sx); i++){
-	    for(j=array->sy; j<(array->ny+array->sy); j++){
-	      for(k=array->sz; k<(array->nz+array->sz); k++){
-		/* Calculate position of (i,j,k)'th element in an F90 array
-		   (where i varies most rapidly) and store value */
-		xdr_long(&xdrs, &(pl[k*nslab + j*nrow + i]));
-	      }
-	    }
-	  }
-	}
-	else{ /* No xdr-decode required */
-
-	  /* Data we've read in is stored in io->buffer */
-	  pl_old = (long *)io->buffer;
-
-	  /* Order loops so i,j,k vary as they should for a C-style
-	     array ordered consecutively in memory */
-	  for(i=array->sx; i<(array->nx+array->sx); i++){
-	    for(j=array->sy; j<(array->ny+array->sy); j++){
-	      for(k=array->sz; k<(array->nz+array->sz); k++){
-		/* Calculate position of (i,j,k)'th element in an F90 array
-		   (where i varies most rapidly) and store value */
-		pl[k*nslab + j*nrow + i] = *(pl_old++);
-	      }
-	    }
-	  }
-	}
-      }
-      break;
-
-    case REG_FLOAT:
-
-      pf = (float *)pData;
-
-      /* In this context, array->is_f90 flags whether we want to
-	 convert _to_ an F90-style array */
-      if(array->is_f90 != REG_TRUE){
-
-	/* Convert F90 array to C array */
-
-	nslab = (array->totz)*(array->toty);
-	nrow  = array->totz;
 
-	if(io->use_xdr){
+  if(io->convert_array_order != REG_TRUE){
 
-	  /* Order loops so i,j,k vary as they should for an F90-style
-	     array ordered consecutively in memory */
-	  for(k=array->sz; k<(array->nz+array->sz); k++){
-	    for(j=array->sy; j<(array->ny+array->sy); j++){
-	      for(i=array->sx; i<(array->nx+array->sx); i++){
-		/* Calculate position of (i,j,k)'th element in a C array
-		   (where k varies most rapidly) and store value */
-		xdr_float(&xdrs, &(pf[i*nslab + j*nrow + k]));
-	      }
-	    }
-	  }
-	}
-	else{ /* No xdr-decode required */
-
-	  /* Data we've read in is stored in io->buffer */
-	  pf_old = (float *)io->buffer;
-
-	  /* Order loops so i,j,k vary as they should for an F90-style
-	     array ordered consecutively in memory */
-	  for(k=array->sz; k<(array->nz+array->sz); k++){
-	    for(j=array->sy; j<(array->ny+array->sy); j++){
-	      for(i=array->sx; i<(array->nx+array->sx); i++){
-		/* Calculate position of (i,j,k)'th element in a C array
-		   (where k varies most rapidly) and store value */
-		pf[i*nslab + j*nrow + k] = *(pf_old++);
-	      }
-	    }
-	  }
-	}
-      }
-      else{
-
-	/* Convert C array to F90 array */
-
-	nslab = (array->totx)*(array->toty);
-	nrow  = array->totx;
-
-	if(io->use_xdr){
-
-	  /* Order loops so i,j,k vary as they should for a C-style
-	     array ordered consecutively in memory */
-	  for(i=array->sx; i<(array->nx+array->sx); i++){
-	    for(j=array->sy; j<(array->ny+array->sy); j++){
-	      for(k=array->sz; k<(array->nz+array->sz); k++){
-		/* Calculate position of (i,j,k)'th element in an F90 array
-		   (where i varies most rapidly) and store value */
-		xdr_float(&xdrs, &(pf[k*nslab + j*nrow + i]));
-	      }
-	    }
-	  }
-	}
-	else{ /* No xdr-decode required */
-
-	  /* Data we've read in is stored in io->buffer */
-	  pf_old = (float *)pData;
-
-	  /* Order loops so i,j,k vary as they should for a C-style
-	     array ordered consecutively in memory */
-	  for(i=array->sx; i<(array->nx+array->sx); i++){
-	    for(j=array->sy; j<(array->ny+array->sy); j++){
-	      for(k=array->sz; k<(array->nz+array->sz); k++){
-		/* Calculate position of (i,j,k)'th element in an F90 array
-		   (where i varies most rapidly) and store value */
-		pf[k*nslab + j*nrow + i] = *(pf_old++);
-	      }
-	    }
-	  }
-	}
-      }
-      break;
-
-    case REG_DBL:
+    /* Without xdr the data was read straight into pData */
+    if(!io->use_xdr) return REG_SUCCESS;
 
-      pd = (double *)pData;
-
-      /* In this context, array->is_f90 flags whether we want to
-	 convert _to_ an F90-style array */
-      if(array->is_f90 != REG_TRUE){
+    /* Straight xdr decode with no re-ordering */
+    if(Xdr_decode_array(type, (size_t)count, io->buffer, pData)
+       != REG_SUCCESS){
+      fprintf(stderr, "STEER: Reorder_decode_array: xdr decode "
+	      "failed for type %d\n", type);
+      return REG_FAILURE;
+    }
 
-	/* Convert F90 array to C array */
+    return REG_SUCCESS;
+  }
 
-	nslab = (array->totz)*(array->toty);
-	nrow  = array->totz;
+  /* The block we've received is stored in io->buffer and is
+     reordered into its place in the whole array, pData.  In this
+     context, array->is_f90 flags whether we want to convert _to_ an
+     F90-style array */
+  tot_extent[0] = array->totx;
+  tot_extent[1] = array->toty;
+  tot_extent[2] = array->totz;
+  sub_extent[0] = array->nx;
+  sub_extent[1] = array->ny;
+  sub_extent[2] = array->nz;
+  origin[0] = array->sx;
+  origin[1] = array->sy;
+  origin[2] = array->sz;
+
+  if((elem_size = Sizeof_type(type)) == 0){
+    fprintf(stderr, "STEER: Reorder_decode_array: cannot reorder data "
+	    "of type %d\n", type);
+    return REG_FAILURE;
+  }
 
-	if(io->use_xdr){
+  nelem = (size_t)array->nx*(size_t)array->ny*(size_t)array->nz;
+  if((size_t)count < nelem){
+    fprintf(stderr, "STEER: Reorder_decode_array: have %d objects but "
+	    "array block holds %lu\n", count, (unsigned long)nelem);
+    return REG_FAILURE;
+  }
 
-	  /* Order loops so i,j,k vary as they should for an F90-style
-	   array ordered consecutively in memory */
-	  for(k=array->sz; k<(array->nz+array->sz); k++){
-	    for(j=array->sy; j<(array->ny+array->sy); j++){
-	      for(i=array->sx; i<(array->nx+array->sx); i++){
-		/* Calculate position of (i,j,k)'th element in a C array
-		   (where k varies most rapidly) and store value */
-		xdr_double(&xdrs, &(pd[i*nslab + j*nrow + k]));
-	      }
-	    }
-	  }
-	}
-	else{ /* No xdr-decode required */
-
-	  /* Data we've read in is stored in io->buffer */
-	  pd_old = (double *)io->buffer;
-
-	  /* Order loops so i,j,k vary as they should for an F90-style
-	   array ordered consecutively in memory */
-	  for(k=array->sz; k<(array->nz+array->sz); k++){
-	    for(j=array->sy; j<(array->ny+array->sy); j++){
-	      for(i=array->sx; i<(array->nx+array->sx); i++){
-		/* Calculate position of (i,j,k)'th element in a C array
-		   (where k varies most rapidly) and store value */
-		pd[i*nslab + j*nrow + k] = *(pd_old++);
-	      }
-	    }
-	  }
-	}
-      }
-      else{
-
-	/* Convert C array to F90 array */
-
-	nslab = (array->totx)*(array->toty);
-	nrow  = array->totx;
-
-	if(io->use_xdr){
-
-	  /* Order loops so i,j,k vary as they should for a C-style
-	     array ordered consecutively in memory */
-	  for(i=array->sx; i<(array->nx+array->sx); i++){
-	    for(j=array->sy; j<(array->ny+array->sy); j++){
-	      for(k=array->sz; k<(array->nz+array->sz); k++){
-		/* Calculate position of (i,j,k)'th element in an F90 array
-		   (where i varies most rapidly) and store value */
-		xdr_double(&xdrs, &(pd[k*nslab + j*nrow + i]));
-	      }
-	    }
-	  }
-	}
-	else{ /* No xdr-decode required */
-
-	  /* Data we've read in is stored in io->buffer */
-	  pd_old = (double *)io->buffer;
-
-	  /* Order loops so i,j,k vary as they should for a C-style
-	     array ordered consecutively in memory */
-	  for(i=array->sx; i<(array->nx+array->sx); i++){
-	    for(j=array->sy; j<(array->ny+array->sy); j++){
-	      for(k=array->sz; k<(array->nz+array->sz); k++){
-		/* Calculate position of (i,j,k)'th element in an F90 array
-		   (where i varies most rapidly) and store value */
-		pd[k*nslab + j*nrow + i] = *(pd_old++);
-	      }
-	    }
-	  }
-	}
-      }
-      break;
+  /* Only slices that had to be read whole (compressed ones, say) get
+     here - others are reordered as they are read by
+     Consume_reordered_data().  Decoding in place and then reordering
+     measures faster than Reorder_decode_nd() but where a native
+     element is bigger than an XDR one (e.g. a 64-bit long) that would
+     need another copy of the block, so decode on the way instead */
+  if(io->use_xdr){
 
-    default:
-      break;
+    if(elem_size != Xdr_sizeof_type(type)){
+      return Reorder_decode_nd(3, tot_extent, sub_extent, origin, type,
+			       io->buffer, pData, array->is_f90);
     }
-  }
 
-  if(io->use_xdr){
-    xdr_destroy(&xdrs);
+    if(Xdr_decode_array(type, nelem, io->buffer, io->buffer)
+       != REG_SUCCESS){
+      fprintf(stderr, "STEER: Reorder_decode_array: xdr decode "
+	      "failed for type %d\n", type);
+      return REG_FAILURE;
+    }
   }
 
-  return return_status;
+  return Reorder_nd(3, tot_extent, sub_extent, origin,
+		    (size_t)elem_size, io->buffer, pData, array->is_f90);
 }
 
 /*------------------------------------------------------------------*/
@@ -1448,3 +1098,582 @@ int cmpstrs(const void* str1, const void* str2) {
 }
 
 /*----------------------------------------------------------------*/
+
+/* Layout of a binary slice header (all multi-byte fields big-endian):
+ *   0 -  3 REG_SLICE_HDR_MAGIC
+ *   4      version
+ *   5      array order (1 == Fortran, 0 == C)
+ *   6      compression codec (version 2 on, otherwise zero)
+ *   7      flags, REG_SLICE_FLAG_* (version 4 on, otherwise zero)
+ *   8 - 11 data type (may be one of the lossy types, REG_Q16_FLOAT
+ *          etc., from version 3 on)
+ *  12 - 15 no. of objects
+ *  16 - 19 no. of bytes (as sent, i.e. compressed)
+ *  20 - 23 no. of bytes before compression (version 2 on, otherwise
+ *          zero) */
+
+static void pack_uint32(char *buf, unsigned int val) {
+  unsigned char *p = (unsigned char*) buf;
+
+  p[0] = (unsigned char) ((val >> 24) & 0xFF);
+  p[1] = (unsigned char) ((val >> 16) & 0xFF);
+  p[2] = (unsigned char) ((val >> 8) & 0xFF);
+  p[3] = (unsigned char) (val & 0xFF);
+}
+
+static unsigned int unpack_uint32(const char *buf) {
+  const unsigned char *p = (const unsigned char*) buf;
+
+  return ((unsigned int) p[0] << 24) | ((unsigned int) p[1] << 16) |
+    ((unsigned int) p[2] << 8) | (unsigned int) p[3];
+}
+
+/*----------------------------------------------------------------*/
+
+void Pack_slice_header(char *buf, int Version, int DataType, int Count,
+		       int NumBytes, int IsFortranArray, int Codec,
+		       int RawBytes, int Flags) {
+
+  memset(buf, 0, REG_SLICE_HDR_SIZE);
+  memcpy(buf, REG_SLICE_HDR_MAGIC, 4);
+  buf[4] = (char) Version;
+  buf[5] = (char) (IsFortranArray ? 1 : 0);
+  pack_uint32(&(buf[8]), (unsigned int) DataType);
+  pack_uint32(&(buf[12]), (unsigned int) Count);
+  pack_uint32(&(buf[16]), (unsigned int) NumBytes);
+
+  /* Older consumers expect the codec fields to be zero */
+  if(Version >= REG_SLICE_HDR_COMPRESS_VERSION) {
+    buf[6] = (char) Codec;
+    pack_uint32(&(buf[20]), (unsigned int) RawBytes);
+  }
+  if(Version >= REG_SLICE_HDR_DELTA_VERSION) {
+    buf[7] = (char) Flags;
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+int Unpack_slice_header(const char *buf, int *DataType, int *Count,
+			int *NumBytes, int *IsFortranArray, int *Codec,
+			int *RawBytes, int *Flags) {
+  int version;
+
+  if(!Is_binary_slice_header(buf)) return REG_FAILURE;
+
+  version = (int) ((unsigned char) buf[4]);
+  if(version < 1 || version > REG_SLICE_HDR_VERSION) {
+    fprintf(stderr, "STEER: ERROR: Unpack_slice_header: unsupported "
+	    "slice header version %d\n", version);
+    return REG_FAILURE;
+  }
+
+  *IsFortranArray = buf[5] ? REG_TRUE : REG_FALSE;
+  *DataType = (int) unpack_uint32(&(buf[8]));
+  *Count = (int) unpack_uint32(&(buf[12]));
+  *NumBytes = (int) unpack_uint32(&(buf[16]));
+
+  if(version >= REG_SLICE_HDR_COMPRESS_VERSION) {
+    *Codec = (int) ((unsigned char) buf[6]);
+    *RawBytes = (int) unpack_uint32(&(buf[20]));
+  }
+  else {
+    *Codec = REG_COMPRESS_NONE;
+    *RawBytes = *NumBytes;
+  }
+
+  *Flags = (version >= REG_SLICE_HDR_DELTA_VERSION) ?
+    (int) ((unsigned char) buf[7]) : 0;
+
+  if(!Compress_codec_supported(*Codec)) {
+    fprintf(stderr, "STEER: ERROR: Unpack_slice_header: slice is "
+	    "compressed with unsupported codec %d\n", *Codec);
+    return REG_FAILURE;
+  }
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Is_binary_slice_header(const char *buf) {
+  return memcmp(buf, REG_SLICE_HDR_MAGIC, 4) ? REG_FALSE : REG_TRUE;
+}
+
+/*----------------------------------------------------------------*/
+
+/* The layout of an entry in the index of a data file, all fields in
+ * network byte order:
+ *
+ *  byte    field
+ *  0 - 7   offset of the slice header
+ *  8 - 15  offset of the slice data
+ *  16 - 19 data type (as sent)
+ *  20 - 23 no. of objects
+ *  24 - 27 no. of bytes (as stored)
+ *  28 - 31 no. of bytes once decompressed
+ *  32      compression codec
+ *  33      flags, REG_SLICE_FLAG_*
+ *  34      array order (1 == Fortran, 0 == C)
+ *  35      1 if the array fields are set, plus 2 if the chunk header
+ *          said the array is from Fortran
+ *  36 - 71 whole array extent, sub-array origin and sub-array extent
+ *          (x, y, z of each) */
+
+void Pack_index_entry(char *buf, const Slice_index_entry *entry) {
+  const Array_type *array = &(entry->array);
+
+  memset(buf, 0, REG_INDEX_ENTRY_SIZE);
+  pack_uint32(&(buf[0]), (unsigned int) (entry->header_offset >> 32));
+  pack_uint32(&(buf[4]), (unsigned int) (entry->header_offset & 0xFFFFFFFF));
+  pack_uint32(&(buf[8]), (unsigned int) (entry->data_offset >> 32));
+  pack_uint32(&(buf[12]), (unsigned int) (entry->data_offset & 0xFFFFFFFF));
+  pack_uint32(&(buf[16]), (unsigned int) entry->type);
+  pack_uint32(&(buf[20]), (unsigned int) entry->count);
+  pack_uint32(&(buf[24]), (unsigned int) entry->num_bytes);
+  pack_uint32(&(buf[28]), (unsigned int) entry->raw_bytes);
+  buf[32] = (char) entry->codec;
+  buf[33] = (char) entry->flags;
+  buf[34] = (char) (entry->is_fortran ? 1 : 0);
+
+  if(!entry->has_array) return;
+
+  buf[35] = (char) (1 | (array->is_f90 ? 2 : 0));
+  pack_uint32(&(buf[36]), (unsigned int) array->totx);
+  pack_uint32(&(buf[40]), (unsigned int) array->toty);
+  pack_uint32(&(buf[44]), (unsigned int) array->totz);
+  pack_uint32(&(buf[48]), (unsigned int) array->sx);
+  pack_uint32(&(buf[52]), (unsigned int) array->sy);
+  pack_uint32(&(buf[56]), (unsigned int) array->sz);
+  pack_uint32(&(buf[60]), (unsigned int) array->nx);
+  pack_uint32(&(buf[64]), (unsigned int) array->ny);
+  pack_uint32(&(buf[68]), (unsigned int) array->nz);
+}
+
+/*----------------------------------------------------------------*/
+
+void Unpack_index_entry(const char *buf, Slice_index_entry *entry) {
+  Array_type *array = &(entry->array);
+
+  entry->header_offset = ((uint64_t) unpack_uint32(&(buf[0])) << 32) |
+    (uint64_t) unpack_uint32(&(buf[4]));
+  entry->data_offset = ((uint64_t) unpack_uint32(&(buf[8])) << 32) |
+    (uint64_t) unpack_uint32(&(buf[12]));
+  entry->type = (int) unpack_uint32(&(buf[16]));
+  entry->count = (int) unpack_uint32(&(buf[20]));
+  entry->num_bytes = (int) unpack_uint32(&(buf[24]));
+  entry->raw_bytes = (int) unpack_uint32(&(buf[28]));
+  entry->codec = (int) ((unsigned char) buf[32]);
+  entry->flags = (int) ((unsigned char) buf[33]);
+  entry->is_fortran = buf[34] ? REG_TRUE : REG_FALSE;
+  entry->has_array = (buf[35] & 1) ? REG_TRUE : REG_FALSE;
+
+  array->is_f90 = (buf[35] & 2) ? REG_TRUE : REG_FALSE;
+  array->totx = (int) unpack_uint32(&(buf[36]));
+  array->toty = (int) unpack_uint32(&(buf[40]));
+  array->totz = (int) unpack_uint32(&(buf[44]));
+  array->sx = (int) unpack_uint32(&(buf[48]));
+  array->sy = (int) unpack_uint32(&(buf[52]));
+  array->sz = (int) unpack_uint32(&(buf[56]));
+  array->nx = (int) unpack_uint32(&(buf[60]));
+  array->ny = (int) unpack_uint32(&(buf[64]));
+  array->nz = (int) unpack_uint32(&(buf[68]));
+}
+
+/*----------------------------------------------------------------*/
+
+/* Describes how we store numeric data: byte order ('L'ittle or
+   'B'ig endian) followed by the sizes of int, long, float and
+   double, e.g. "L4844" */
+static void native_format(char *fmt) {
+  union {
+    int  i;
+    char c[sizeof(int)];
+  } test;
+
+  test.i = 1;
+  sprintf(fmt, "%c%d%d%d%d", (test.c[0] == 1) ? 'L' : 'B',
+	  (int)sizeof(int), (int)sizeof(long), (int)sizeof(float),
+	  (int)sizeof(double));
+}
+
+/*----------------------------------------------------------------*/
+
+int Sizeof_type(const int type) {
+
+  switch(type) {
+  case REG_INT:
+    return (int)sizeof(int);
+
+  case REG_LONG:
+    return (int)sizeof(long);
+
+  case REG_FLOAT:
+    return (int)sizeof(float);
+
+  case REG_DBL:
+    return (int)sizeof(double);
+
+  case REG_CHAR:
+    return (int)sizeof(char);
+
+  default:
+    return 0;
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+/* Copies text into a fixed-size field of an acknowledgement, padding
+   it with spaces (or cutting it short) to exactly size bytes */
+static void ack_field(char *field, size_t size, const char *text) {
+  size_t len = strlen(text);
+
+  if(len > size) len = size;
+  memcpy(field, text, len);
+  memset(&(field[len]), ' ', size - len);
+  field[size] = '\0';
+}
+
+/*----------------------------------------------------------------*/
+
+int Get_ack_msg(const IOdef_entry *io, char *ack_msg) {
+  char               fmt[16];
+  char               text[REG_ACK_MAX_SIZE + 1];
+  const Region_type *r;
+  int                region;
+
+  native_format(fmt);
+
+  /* Only an emitter that has said it can cut arrays down is sent a
+     region and only one that takes credit is sent a credit - any
+     other would take them for the next acknowledgement */
+  region = (io && io->use_region && io->peer_regions);
+  if(!region && !(io && io->peer_credits)) {
+    sprintf(text, "%s<V%d%s/>", REG_ACK_TAG, REG_SLICE_HDR_VERSION, fmt);
+    ack_field(ack_msg, REG_ACK_SIZE, text);
+    return REG_ACK_SIZE;
+  }
+
+  sprintf(text, "%s<V%d%s%c>", REG_ACK_TAG, REG_SLICE_HDR_VERSION, fmt,
+	  io->peer_credits ? '*' : '+');
+  ack_field(ack_msg, REG_ACK_SIZE, text);
+  text[0] = '\0';
+  if(region) {
+    r = &(io->region);
+    sprintf(text, "%s o=\"%d,%d,%d\" n=\"%d,%d,%d\" s=\"%d,%d,%d\"/>",
+	    REG_ACK_REGION_TAG, r->sx, r->sy, r->sz, r->nx, r->ny, r->nz,
+	    r->dx, r->dy, r->dz);
+  }
+  ack_field(&(ack_msg[REG_ACK_SIZE]), REG_ACK_REGION_SIZE, text);
+  if(!io->peer_credits) return REG_ACK_SIZE + REG_ACK_REGION_SIZE;
+
+  sprintf(text, "%s n=\"%d\" w=\"%d\"/>", REG_ACK_CREDIT_TAG,
+	  io->acks_owed, io->window);
+  ack_field(&(ack_msg[REG_ACK_SIZE + REG_ACK_REGION_SIZE]),
+	    REG_ACK_CREDIT_SIZE, text);
+  return REG_ACK_MAX_SIZE;
+}
+
+/*----------------------------------------------------------------*/
+
+void Pack_index_trailer(char *buf, int num_entries, uint64_t offset) {
+  char fmt[16];
+  char tmp_buffer[REG_PACKET_SIZE];
+
+  native_format(fmt);
+  snprintf(tmp_buffer, REG_PACKET_SIZE,
+	   "%s entries=\"%d\" offset=\"%.0f\" format=\"%s\"/>",
+	   REG_INDEX_TAG, num_entries, (double) offset, fmt);
+  sprintf(buf, REG_PACKET_FORMAT, tmp_buffer);
+  /* Put terminating char within the packet */
+  buf[REG_PACKET_SIZE-1] = '\0';
+}
+
+/*----------------------------------------------------------------*/
+
+int Unpack_index_trailer(const char *buf, int *num_entries,
+			 uint64_t *offset, char *format) {
+  char   tmp_buffer[REG_PACKET_SIZE];
+  char   fmt[16];
+  double off;
+
+  if(strncmp(buf, REG_INDEX_TAG, strlen(REG_INDEX_TAG))) return REG_FAILURE;
+
+  memcpy(tmp_buffer, buf, REG_PACKET_SIZE);
+  tmp_buffer[REG_PACKET_SIZE-1] = '\0';
+
+  if(sscanf(tmp_buffer, REG_INDEX_TAG " entries=\"%d\" offset=\"%lf\" "
+	    "format=\"%15[^\"]\"", num_entries, &off, fmt) != 3 ||
+     *num_entries < 0 || off < 0.0) {
+    return REG_FAILURE;
+  }
+
+  *offset = (uint64_t) off;
+  if(format) strcpy(format, fmt);
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+void Pack_chunk_header(char *buf, const Array_type *array,
+		       const Chunk_level_type *level) {
+  int len;
+
+  len = snprintf(buf, REG_CHUNK_HDR_SIZE, "CHUNK_HDR\n"
+		 "ARRAY  %d %d %d\n"
+		 "ORIGIN %d %d %d\n"
+		 "EXTENT %d %d %d\n"
+		 "FROM_FORTRAN %d\n",
+		 array->totx, array->toty, array->totz,
+		 array->sx, array->sy, array->sz,
+		 array->nx, array->ny, array->nz,
+		 array->is_f90);
+
+  /* Readers that know nothing of levels stop at FROM_FORTRAN */
+  if(level) {
+    len += snprintf(&(buf[len]), REG_CHUNK_HDR_SIZE - len,
+		    "LEVEL %d OF %d PART %d OF %d\n"
+		    "REGION %d %d %d %d %d %d %d %d %d\n",
+		    level->level, level->num_levels,
+		    level->part, level->num_parts,
+		    level->region.sx, level->region.sy, level->region.sz,
+		    level->region.nx, level->region.ny, level->region.nz,
+		    level->region.dx, level->region.dy, level->region.dz);
+  }
+
+  snprintf(&(buf[len]), REG_CHUNK_HDR_SIZE - len, "END_CHUNK_HDR\n");
+}
+
+/*----------------------------------------------------------------*/
+
+int Unpack_chunk_header(const char *buf, const size_t num_bytes,
+			Array_type *array, Chunk_level_type *level) {
+  char   tmp_buffer[REG_CHUNK_HDR_SIZE];
+  char  *pchar;
+  size_t len;
+
+  if(num_bytes < strlen("CHUNK_HDR") ||
+     strncmp(buf, "CHUNK_HDR", strlen("CHUNK_HDR"))) return REG_FAILURE;
+
+  len = (num_bytes < REG_CHUNK_HDR_SIZE) ? num_bytes :
+    REG_CHUNK_HDR_SIZE - 1;
+  memcpy(tmp_buffer, buf, len);
+  tmp_buffer[len] = '\0';
+
+  if(sscanf(tmp_buffer, "CHUNK_HDR ARRAY %d %d %d "
+	    "ORIGIN %d %d %d EXTENT %d %d %d "
+	    "FROM_FORTRAN %d",
+	    &(array->totx), &(array->toty), &(array->totz),
+	    &(array->sx), &(array->sy), &(array->sz),
+	    &(array->nx), &(array->ny), &(array->nz),
+	    &(array->is_f90)) != 10) {
+    return REG_FAILURE;
+  }
+
+  if(level) {
+    if(!(pchar = strstr(tmp_buffer, "LEVEL ")) ||
+       sscanf(pchar, "LEVEL %d OF %d PART %d OF %d "
+	      "REGION %d %d %d %d %d %d %d %d %d",
+	      &(level->level), &(level->num_levels),
+	      &(level->part), &(level->num_parts),
+	      &(level->region.sx), &(level->region.sy), &(level->region.sz),
+	      &(level->region.nx), &(level->region.ny), &(level->region.nz),
+	      &(level->region.dx), &(level->region.dy),
+	      &(level->region.dz)) != 13 ||
+       level->region.dx < 1 || level->region.dy < 1 ||
+       level->region.dz < 1) {
+      level->num_levels = 0;
+    }
+  }
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+void Set_peer_capabilities(IOdef_entry *io, const char *ack_msg) {
+  Region_type region;
+  char        fmt[16];
+  char       *pchar;
+  char       *pregion;
+  char        marker;
+  int         use_region;
+  int         version;
+  int         acked;
+  int         window;
+
+  /* Assume the worst - a consumer that only knows text slice headers
+     and XDR-encoded data and wants the whole of every array */
+  io->slice_hdr_version = REG_SLICE_HDR_TEXT;
+  io->use_native = REG_FALSE;
+  io->region_next = REG_REGION_NONE;
+  use_region = io->use_region;
+  region = io->region;
+  io->use_region = REG_FALSE;
+
+  /* This may be a new consumer so it can't be sent deltas against
+     what we sent to the last one */
+  if(!ack_msg) io->delta_key_needed = REG_TRUE;
+
+  /* Unless the consumer gives credit, an acknowledgement is of
+     everything that we have sent it and we send one sample at a
+     time */
+  io->window = 1;
+  acked = io->samples_in_flight;
+
+  if(ack_msg && (pchar = strstr(ack_msg, "<V")) &&
+     pchar[2] >= '1' && pchar[2] <= '9') {
+    version = pchar[2] - '0';
+
+    /* Talk to the consumer in the highest version that we both know */
+    if(version > REG_SLICE_HDR_VERSION) version = REG_SLICE_HDR_VERSION;
+    io->slice_hdr_version = version;
+
+    /* Only skip XDR if the consumer stores numbers exactly as we do */
+    native_format(fmt);
+    if(!strncmp(&(pchar[3]), fmt, strlen(fmt)) &&
+       (pchar[3 + strlen(fmt)] == '/' || pchar[3 + strlen(fmt)] == '+' ||
+	pchar[3 + strlen(fmt)] == '*')) {
+      io->use_native = REG_TRUE;
+    }
+
+    /* The part of each array that the consumer wants, if not all */
+    marker = ((pchar = strchr(pchar, '>'))) ? pchar[-1] : '/';
+    if(version >= REG_SLICE_HDR_REGION_VERSION &&
+       (marker == '+' || marker == '*') &&
+       (pregion = strstr(pchar, REG_ACK_REGION_TAG)) &&
+       sscanf(pregion, REG_ACK_REGION_TAG " o=\"%d,%d,%d\" n=\"%d,%d,%d\" "
+	      "s=\"%d,%d,%d\"", &(io->region.sx), &(io->region.sy),
+	      &(io->region.sz), &(io->region.nx), &(io->region.ny),
+	      &(io->region.nz), &(io->region.dx), &(io->region.dy),
+	      &(io->region.dz)) == 9 &&
+       io->region.sx >= 0 && io->region.sy >= 0 && io->region.sz >= 0 &&
+       io->region.nx >= 0 && io->region.ny >= 0 && io->region.nz >= 0 &&
+       io->region.dx > 0 && io->region.dy > 0 && io->region.dz > 0) {
+      io->use_region = REG_TRUE;
+    }
+
+    /* How many samples the consumer has read since it last told us
+       and how many it will let us send ahead of it */
+    if(version >= REG_SLICE_HDR_CREDIT_VERSION && marker == '*' &&
+       (pchar = strstr(pchar, REG_ACK_CREDIT_TAG)) &&
+       sscanf(pchar, REG_ACK_CREDIT_TAG " n=\"%d\" w=\"%d\"", &acked,
+	      &window) == 2 && acked >= 0 && window > 0) {
+      io->window = (window > REG_MAX_WINDOW) ? REG_MAX_WINDOW : window;
+    }
+    else {
+      acked = io->samples_in_flight;
+    }
+  }
+
+  /* A consumer that has come back may acknowledge samples that we
+     no longer count */
+  io->samples_in_flight = ack_msg ? io->samples_in_flight - acked : 0;
+  if(io->samples_in_flight < 0) io->samples_in_flight = 0;
+
+  /* Slices kept for deltas were of a different part of the array */
+  if(io->use_region != use_region ||
+     (use_region && memcmp(&region, &(io->region), sizeof(Region_type)))) {
+    io->delta_key_needed = REG_TRUE;
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+void Delta_xor(const void *in, void *out, void *ref, size_t nbytes,
+	       int encode) {
+
+  const char *pin  = (const char *) in;
+  char       *pout = (char *) out;
+  char       *pref = (char *) ref;
+  uint64_t    a, b, c;
+  size_t      i;
+
+  /* A word at a time - memcpy keeps us clear of alignment trouble
+     and compiles down to plain loads and stores */
+  for(i = 0; i + sizeof(uint64_t) <= nbytes; i += sizeof(uint64_t)) {
+    memcpy(&a, &(pin[i]), sizeof(uint64_t));
+    memcpy(&b, &(pref[i]), sizeof(uint64_t));
+    c = a ^ b;
+    memcpy(&(pout[i]), &c, sizeof(uint64_t));
+    memcpy(&(pref[i]), encode ? &a : &c, sizeof(uint64_t));
+  }
+  for(; i < nbytes; i++) {
+    char x = pin[i];
+    pout[i] = (char) (x ^ pref[i]);
+    pref[i] = encode ? x : pout[i];
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+Delta_ref_type *Get_delta_ref(IOdef_entry *io, int index) {
+
+  Delta_ref_type *dum_ptr;
+  int             n, i;
+
+  if(index >= io->num_delta_refs) {
+    /* Grow in lumps - samples rarely hold more than a few slices */
+    n = index + 8;
+    if(!(dum_ptr = (Delta_ref_type *)realloc(io->delta_refs,
+					     n*sizeof(Delta_ref_type)))) {
+      fprintf(stderr, "STEER: ERROR: Get_delta_ref: failed to allocate "
+	      "%d reference slices\n", n);
+      return NULL;
+    }
+    io->delta_refs = dum_ptr;
+
+    for(i = io->num_delta_refs; i < n; i++) {
+      io->delta_refs[i].type = 0;
+      io->delta_refs[i].nbytes = 0;
+      io->delta_refs[i].max_bytes = 0;
+      io->delta_refs[i].data = NULL;
+      io->delta_refs[i].sample = -1;
+    }
+    io->num_delta_refs = n;
+  }
+
+  return &(io->delta_refs[index]);
+}
+
+/*----------------------------------------------------------------*/
+
+int Set_delta_ref(Delta_ref_type *ref, int type, const void *data,
+		  size_t nbytes) {
+
+  void *dum_ptr;
+
+  if(nbytes > ref->max_bytes) {
+    if(!(dum_ptr = realloc(ref->data, nbytes))) {
+      fprintf(stderr, "STEER: ERROR: Set_delta_ref: failed to allocate "
+	      "%lu bytes\n", (unsigned long)nbytes);
+      return REG_FAILURE;
+    }
+    ref->data = dum_ptr;
+    ref->max_bytes = nbytes;
+  }
+
+  if(nbytes > 0) memcpy(ref->data, data, nbytes);
+  ref->type = type;
+  ref->nbytes = nbytes;
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+void Free_delta_refs(IOdef_entry *io) {
+
+  int i;
+
+  for(i = 0; i < io->num_delta_refs; i++) {
+    if(io->delta_refs[i].data) free(io->delta_refs[i].data);
+  }
+  if(io->delta_refs) free(io->delta_refs);
+  io->delta_refs = NULL;
+  io->num_delta_refs = 0;
+}
+
+/*----------------------------------------------------------------*/
@@ -0,0 +1,154 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+
+/** @internal
+    @file ReG_Steer_Compress.c
+    @brief Lossless compression of sample data.
+
+    zlib is already needed by the library so it is the built-in
+    codec.  It is run at its fastest level since the point is to get
+    samples over a congested link sooner, not to save the most space.
+    Other codecs can be added here and given a new REG_COMPRESS_*
+    code; a consumer that does not know a codec will reject the
+    slice rather than misread it.
+
+    @author Robert Haines
+  */
+
+#include "ReG_Steer_Config.h"
+#include "ReG_Steer_types.h"
+#include "ReG_Steer_Compress.h"
+
+#include <stdio.h>
+#include <zlib.h>
+
+/*----------------------------------------------------------------*/
+
+int Compress_codec_supported(const int codec) {
+
+  switch(codec) {
+  case REG_COMPRESS_NONE:
+  case REG_COMPRESS_ZLIB:
+    return REG_TRUE;
+
+  default:
+    return REG_FALSE;
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+size_t Compress_bound(const int codec, const size_t nbytes) {
+
+  switch(codec) {
+  case REG_COMPRESS_ZLIB:
+    return (size_t) compressBound((uLong) nbytes);
+
+  default:
+    return nbytes;
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+int Compress_data(const int codec, const void *in, const size_t nbytes,
+		  void *out, size_t *out_bytes) {
+  uLongf len;
+  int    status;
+
+  switch(codec) {
+  case REG_COMPRESS_ZLIB:
+    len = (uLongf) Compress_bound(codec, nbytes);
+    status = compress2((Bytef*) out, &len, (const Bytef*) in,
+		       (uLong) nbytes, Z_BEST_SPEED);
+    if(status != Z_OK) {
+      fprintf(stderr, "STEER: ERROR: Compress_data: zlib failed with "
+	      "status %d\n", status);
+      return REG_FAILURE;
+    }
+    *out_bytes = (size_t) len;
+    break;
+
+  default:
+    fprintf(stderr, "STEER: ERROR: Compress_data: unsupported codec %d\n",
+	    codec);
+    return REG_FAILURE;
+  }
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Decompress_data(const int codec, const void *in, const size_t nbytes,
+		    void *out, const size_t raw_bytes) {
+  uLongf len;
+  int    status;
+
+  switch(codec) {
+  case REG_COMPRESS_ZLIB:
+    len = (uLongf) raw_bytes;
+    status = uncompress((Bytef*) out, &len, (const Bytef*) in,
+			(uLong) nbytes);
+    if(status != Z_OK || len != (uLongf) raw_bytes) {
+      fprintf(stderr, "STEER: ERROR: Decompress_data: zlib failed with "
+	      "status %d (%lu of %lu bytes)\n", status,
+	      (unsigned long) len, (unsigned long) raw_bytes);
+      return REG_FAILURE;
+    }
+    break;
+
+  default:
+    fprintf(stderr, "STEER: ERROR: Decompress_data: unsupported codec "
+	    "%d\n", codec);
+    return REG_FAILURE;
+  }
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
@@ -97,6 +97,7 @@ int Load_samples_transport_api() {
   Load_symbol("Emit_data_non_blocking", env, mod_handle, (void*) &Emit_data_non_blocking_impl);
   Load_symbol("Emit_header", env, mod_handle, (void*) &Emit_header_impl);
   Load_symbol("Emit_data", env, mod_handle, (void*) &Emit_data_impl);
+  Load_symbol("Emit_data_batch", env, mod_handle, (void*) &Emit_data_batch_impl);
   Load_symbol("Consume_msg_header", env, mod_handle, (void*) &Consume_msg_header_impl);
   Load_symbol("Emit_msg_header", env, mod_handle, (void*) &Emit_msg_header_impl);
   Load_symbol("Consume_start_data_check", env, mod_handle, (void*) &Consume_start_data_check_impl);
@@ -107,6 +108,9 @@ int Load_samples_transport_api() {
   Load_symbol("Emit_start", env, mod_handle, (void*) &Emit_start_impl);
   Load_symbol("Emit_stop", env, mod_handle, (void*) &Emit_stop_impl);
   Load_symbol("Consume_stop", env, mod_handle, (void*) &Consume_stop_impl);
+  Load_symbol("Wait_for_IOType", env, mod_handle, (void*) &Wait_for_IOType_impl);
+  Load_symbol("Consume_data_map", env, mod_handle, (void*) &Consume_data_map_impl);
+  Load_symbol("Consume_seek_slice", env, mod_handle, (void*) &Consume_seek_slice_impl);
 
   Steer_lib_config.samples_mod_handle = mod_handle;
 
@@ -57,6 +57,12 @@
 #include "ReG_Steer_Common.h"
 #include "ReG_Steer_Appside_internal.h"
 
+#include <ctype.h>
+
+#if REG_HAS_INOTIFY
+#include <sys/inotify.h>
+#endif
+
 /*--------------------------------------------------------------------*/
 
 int file_info_table_init(file_info_table_type* table,
@@ -76,6 +82,28 @@ int file_info_table_init(file_info_table_type* table,
 
   for(i = 0; i < max_entries; i++) {
     table->file_info[i].fp = NULL;
+    table->file_info[i].watch_fd = -1;
+    table->file_info[i].map = NULL;
+    table->file_info[i].map_bytes = 0;
+    table->file_info[i].map_pos = 0;
+    table->file_info[i].index = NULL;
+    table->file_info[i].num_index = 0;
+    table->file_info[i].max_index = 0;
+    table->file_info[i].index_loaded = REG_FALSE;
+    table->file_info[i].index_data_next = REG_FALSE;
+    table->file_info[i].has_chunk = REG_FALSE;
+    table->file_info[i].async_write = REG_FALSE;
+    table->file_info[i].write_pos = 0;
+    table->file_info[i].stage = NULL;
+    table->file_info[i].stage_bytes = 0;
+    table->file_info[i].stage_max = 0;
+    table->file_info[i].write_failed = REG_FALSE;
+    table->file_info[i].queued_bytes = 0;
+    table->file_info[i].queue_high_water = 0;
+    table->file_info[i].num_writes = 0;
+    table->file_info[i].write_seconds = 0.0;
+    table->file_info[i].max_write_seconds = 0.0;
+    table->file_info[i].num_stalls = 0;
   }
 
   return REG_SUCCESS;
@@ -83,99 +111,375 @@ int file_info_table_init(file_info_table_type* table,
 
 /*----------------------------------------------------------------*/
 
-FILE* open_next_file(char* base_name) {
-  FILE* fp;
-  char  tmp_filename[REG_MAX_STRING_LENGTH+9];
-  char  filename1[REG_MAX_STRING_LENGTH+9];
-  char  filename2[REG_MAX_STRING_LENGTH+9];
-  struct stat stbuf;
-  long  time1;
-  long  time2;
-  int   i;
+/** What a consumer knows about one numbered sequence of files */
+typedef struct file_seq_state {
+  /** Root of the filenames in the sequence */
+  char    base_name[REG_MAX_STRING_LENGTH];
+  /** Inode of the manifest being read, 0 if there wasn't one */
+  ino_t   manifest_ino;
+  /** Offset in the manifest of the next entry to read */
+  off_t   manifest_pos;
+  /** Whether the directory may hold files that the manifest won't
+      tell us about */
+  int     rescan;
+  /** Modification time of the directory when it was last found to
+      hold nothing for us */
+  time_t  dir_mtime;
+  /** When that was */
+  time_t  scan_time;
+  struct file_seq_state* next;
+} file_seq_state;
+
+static file_seq_state* file_seqs = NULL;
 
-  fp = NULL;
+/*----------------------------------------------------------------*/
 
-  i = 0;
-  time1 = -1;
-  while(i<REG_MAX_NUM_FILES){
+/** @internal
+    @param base_name Root of the filenames in the sequence
+    @param create Whether to start tracking the sequence if we aren't
 
-    /* Look for presence of lock file */
-    sprintf(tmp_filename,"%s_%d.lock", base_name, i);
+    Find what we know about a sequence of files. */
+static file_seq_state* get_file_seq(const char* base_name, int create) {
+  file_seq_state* seq;
 
-    fp = fopen(tmp_filename, "r");
+  for(seq = file_seqs; seq; seq = seq->next) {
+    if(!strcmp(seq->base_name, base_name)) return seq;
+  }
+  if(!create) return NULL;
 
-    if (fp != NULL) {
+  if(!(seq = (file_seq_state*) malloc(sizeof(file_seq_state)))) {
+    fprintf(stderr, "STEER: get_file_seq: failed to allocate memory\n");
+    return NULL;
+  }
+  strncpy(seq->base_name, base_name, REG_MAX_STRING_LENGTH - 1);
+  seq->base_name[REG_MAX_STRING_LENGTH - 1] = '\0';
+  seq->manifest_ino = 0;
+  seq->manifest_pos = 0;
+  seq->rescan = REG_TRUE;
+  seq->dir_mtime = 0;
+  seq->scan_time = 0;
+  seq->next = file_seqs;
+  file_seqs = seq;
+
+  return seq;
+}
 
-      /* Found one - check its last-modified time */
-      fclose(fp);
-      fp = NULL;
-      if(stat(tmp_filename, &stbuf) != -1){
+/*----------------------------------------------------------------*/
 
-        /* timespec_t     st_mtim;      Time of last data modification
-           Times measured in seconds and nanoseconds
-           since 00:00:00 UTC, Jan. 1, 1970 */
-        sprintf(filename1,"%s_%d", base_name, i);
-	time1 = (long)stbuf.st_mtime;
-        break;
-      }
-      else{
+/** @internal
+    @param base_name Root of the filenames in the sequence
+
+    Forget about a sequence of files. */
+static void drop_file_seq(const char* base_name) {
+  file_seq_state** pseq;
+  file_seq_state*  seq;
+
+  for(pseq = &file_seqs; (seq = *pseq); pseq = &seq->next) {
+    if(!strcmp(seq->base_name, base_name)) {
+      *pseq = seq->next;
+      free(seq);
+      return;
+    }
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    @param seq The sequence to look for
+    @param base_name Root of the filenames, on success the name of
+    the oldest file that is ready
+
+    List the directory for lock files in the sequence.  Unless we've
+    been told to, don't bother if the directory hasn't changed since
+    it last held nothing for us. */
+static int scan_for_next_file(file_seq_state* seq, char* base_name) {
+  DIR*           dir;
+  struct dirent* entry;
+  struct stat    stbuf;
+  char           dir_name[REG_MAX_STRING_LENGTH];
+  char           lock_name[REG_MAX_STRING_LENGTH + 16];
+  const char*    prefix;
+  char*          end;
+  size_t         len;
+  time_t         now;
+  time_t         best_time = 0;
+  long           best = -1;
+  long           index;
+
+  /* Split the base name into directory and filename prefix */
+  if((prefix = strrchr(base_name, '/'))) {
+    prefix++;
+    len = prefix - base_name;
+    strncpy(dir_name, base_name, len);
+    dir_name[len] = '\0';
+  }
+  else {
+    prefix = base_name;
+    strcpy(dir_name, "./");
+  }
 
-	fprintf(stderr, "STEER: Open_next_file: failed to stat %s\n", tmp_filename);
+  now = time(NULL);
+  if(stat(dir_name, &stbuf) == -1) return REG_FAILURE;
+
+  /* Modification times may only be good to the second (and the
+     clock that set them may be a little out) so only trust one that
+     is comfortably older than the last scan */
+  if(!seq->rescan && stbuf.st_mtime == seq->dir_mtime &&
+     seq->dir_mtime < seq->scan_time - 1) {
+    return REG_FAILURE;
+  }
+  seq->dir_mtime = stbuf.st_mtime;
+  seq->scan_time = now;
+
+  if(!(dir = opendir(dir_name))) return REG_FAILURE;
+
+  len = strlen(prefix);
+  while((entry = readdir(dir))) {
+
+    /* Looking for <prefix>_<index>.lock */
+    if(strncmp(entry->d_name, prefix, len) || entry->d_name[len] != '_' ||
+       !isdigit((unsigned char) entry->d_name[len + 1])) continue;
+
+    index = strtol(&(entry->d_name[len + 1]), &end, 10);
+    if(strcmp(end, ".lock")) continue;
+
+    if(snprintf(lock_name, sizeof(lock_name), "%s%s", dir_name,
+		entry->d_name) >= (int) sizeof(lock_name) ||
+       stat(lock_name, &stbuf) == -1) continue;
+
+    /* We want the oldest file - the one with the lowest index if it's
+       too close to call (as the counter may have wrapped around) */
+    if(best == -1 || stbuf.st_mtime < best_time ||
+       (stbuf.st_mtime == best_time && index < best)) {
+      best = index;
+      best_time = stbuf.st_mtime;
+    }
+  }
+  closedir(dir);
+
+  if(best == -1) {
+    seq->rescan = REG_FALSE;
+    return REG_FAILURE;
+  }
+
+  /* There may well be more where that came from */
+  seq->rescan = REG_TRUE;
+  if(snprintf(base_name, REG_MAX_STRING_LENGTH, "%s_%ld", seq->base_name,
+	      best) >= REG_MAX_STRING_LENGTH) {
+    return REG_FAILURE;
+  }
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    @param seq The sequence to look for
+    @param base_name Root of the filenames, on success the name of
+    the next file that is ready
+    @param manifest Name of the manifest
+
+    Read on through the manifest to the next file that hasn't already
+    been taken. */
+static int read_manifest(file_seq_state* seq, char* base_name,
+			 const char* manifest) {
+  struct stat stbuf;
+  char        buffer[256];
+  char        lock_name[REG_MAX_STRING_LENGTH + 32];
+  char*       line;
+  char*       end;
+  int         fd;
+  int         n;
+
+  if((fd = open(manifest, O_RDONLY)) == -1) return REG_FAILURE;
+
+  while(lseek(fd, seq->manifest_pos, SEEK_SET) != (off_t) -1 &&
+	(n = read(fd, buffer, sizeof(buffer) - 1)) > 0) {
+
+    buffer[n] = '\0';
+    line = buffer;
+    while((end = strchr(line, '\n'))) {
+      *end = '\0';
+      seq->manifest_pos += end - line + 1;
+
+      snprintf(lock_name, sizeof(lock_name), "%s_%ld.lock",
+	       seq->base_name, atol(line));
+      if(stat(lock_name, &stbuf) == 0) {
+	close(fd);
+	return (snprintf(base_name, REG_MAX_STRING_LENGTH, "%s_%ld",
+			 seq->base_name, atol(line)) < REG_MAX_STRING_LENGTH) ?
+	  REG_SUCCESS : REG_FAILURE;
       }
+      line = end + 1;
     }
 
-    i++;
+    /* Don't read an entry that's only half written */
+    if(line == buffer) break;
   }
 
-  /* Now search in the opposite direction (in case consumption lags
-     creation and we've wrapped around the REG_MAX_NUM_FILES counter) */
+  close(fd);
+  return REG_FAILURE;
+}
+
+/*----------------------------------------------------------------*/
 
-  i = REG_MAX_NUM_FILES - 1;
-  time2 = -1;
-  while(i > -1){
+/** @internal
+    @param manifest Name of the manifest that is being replaced
+    @param base_len Length of the root of the filenames in the
+    sequence, at the start of @p manifest
+    @param fd Descriptor of the replacement manifest
+    @return REG_SUCCESS or REG_FAILURE
+
+    Copy the entries of a manifest whose files have not been taken
+    yet into its replacement, so that a consumer that is behind still
+    finds them there. */
+static int carry_over_manifest(const char* manifest, int base_len,
+			       int fd) {
+  struct stat stbuf;
+  char        line[32];
+  char        lock_name[REG_MAX_STRING_LENGTH + 32];
+  FILE*       fp;
+  int         len;
+  int         status = REG_SUCCESS;
+
+  if(!(fp = fopen(manifest, "r"))) return REG_SUCCESS;
+
+  while(status == REG_SUCCESS && fgets(line, sizeof(line), fp)) {
+    if(!strchr(line, '\n')) continue;
+
+    snprintf(lock_name, sizeof(lock_name), "%.*s_%ld.lock", base_len,
+	     manifest, atol(line));
+    if(stat(lock_name, &stbuf) == 0) {
+      len = (int) strlen(line);
+      if(write(fd, line, len) != len) status = REG_FAILURE;
+    }
+  }
+  fclose(fp);
 
-    /* Look for presence of lock file */
-    sprintf(tmp_filename,"%s_%d.lock", base_name, i);
+  return status;
+}
 
-    fp = fopen(tmp_filename, "r");
+/*----------------------------------------------------------------*/
 
-    if (fp != NULL) {
+/** @internal
+    @param filename Name of the file that's ready, <base>_<index>
 
-      /* Found one - check its last-modified time */
-      fclose(fp);
-      fp = NULL;
-      if(stat(tmp_filename, &stbuf) != -1){
+    Add a file to the manifest of its sequence.  The manifest is
+    started afresh (under a new inode, so that consumers notice) once
+    it has grown too big, keeping the entries for any files that
+    haven't been taken yet. */
+static void append_to_manifest(const char* filename) {
+  struct stat stbuf;
+  char        manifest[REG_MAX_STRING_LENGTH + 16];
+  char        new_manifest[REG_MAX_STRING_LENGTH + 24];
+  char        entry[32];
+  const char* pchar;
+  int         base_len;
+  int         fd;
+  int         len;
+
+  if(!(pchar = strrchr(filename, '_')) || !isdigit((unsigned char) pchar[1]))
+    return;
+
+  base_len = (int)(pchar - filename);
+  if(snprintf(manifest, sizeof(manifest), "%.*s%s", base_len, filename,
+	      REG_MANIFEST_SUFFIX) >= (int) sizeof(manifest)) {
+    return;
+  }
+  len = sprintf(entry, "%ld\n", atol(pchar + 1));
+
+  if((fd = open(manifest, REG_MANIFEST_FLAGS, REG_LOCK_PERMS)) == -1)
+    return;
+
+  if(fstat(fd, &stbuf) == 0 && stbuf.st_size >= REG_MANIFEST_MAX_BYTES) {
+    close(fd);
+    snprintf(new_manifest, sizeof(new_manifest), "%s.new", manifest);
+
+    /* Clear out any left behind by an emitter that died part way */
+    unlink(new_manifest);
+    if((fd = open(new_manifest, REG_LOCK_FLAGS, REG_LOCK_PERMS)) == -1)
+      return;
+    if(carry_over_manifest(manifest, base_len, fd) != REG_SUCCESS ||
+       write(fd, entry, len) != len || rename(new_manifest, manifest)) {
+      fprintf(stderr, "STEER: append_to_manifest: failed to replace %s\n",
+	      manifest);
+      remove(new_manifest);
+    }
+    close(fd);
+    return;
+  }
 
-        /* timespec_t     st_mtim;      Time of last data modification
-           Times measured in seconds and nanoseconds
-           since 00:00:00 UTC, Jan. 1, 1970 */
-        sprintf(filename2,"%s_%d", base_name, i);
-	time2 = (long)stbuf.st_mtime;/*.tv_sec;*/
-        break;
-      }
-      else{
+  if(write(fd, entry, len) != len) {
+    fprintf(stderr, "STEER: append_to_manifest: failed to write %s\n",
+	    manifest);
+  }
+  close(fd);
+}
 
-	fprintf(stderr, "STEER: Open_next_file: failed to stat %s\n", tmp_filename);
-      }
+/*----------------------------------------------------------------*/
+
+int find_next_file(char* base_name) {
+  file_seq_state* seq;
+  struct stat     stbuf;
+  char            manifest[REG_MAX_STRING_LENGTH + 16];
+  int             is_new;
+
+  is_new = (get_file_seq(base_name, REG_FALSE) == NULL);
+  if(!(seq = get_file_seq(base_name, REG_TRUE))) return REG_FAILURE;
+
+  snprintf(manifest, sizeof(manifest), "%s%s", base_name,
+	   REG_MANIFEST_SUFFIX);
+
+  if(stat(manifest, &stbuf) == 0) {
+    if(stbuf.st_ino != seq->manifest_ino ||
+       stbuf.st_size < seq->manifest_pos) {
+
+      /* A manifest we haven't seen before.  The first time round
+	 skip its history and take what's waiting from the directory;
+	 otherwise start at the top, and check the directory for
+	 anything that only made it into the old one */
+      seq->manifest_ino = stbuf.st_ino;
+      seq->manifest_pos = is_new ? stbuf.st_size : 0;
+      seq->rescan = REG_TRUE;
     }
+  }
+  else if(seq->manifest_ino != 0) {
+    seq->manifest_ino = 0;
+    seq->manifest_pos = 0;
+    seq->rescan = REG_TRUE;
+  }
 
-    i--;
+  /* Without a manifest the directory is all we have to go on */
+  if((seq->rescan || seq->manifest_ino == 0) &&
+     scan_for_next_file(seq, base_name) == REG_SUCCESS) {
+    return REG_SUCCESS;
   }
 
-  /* We want to open the oldest file that we've found... */
+  if(seq->manifest_ino != 0 && stbuf.st_size > seq->manifest_pos) {
+    return read_manifest(seq, base_name, manifest);
+  }
 
-  if(time1 != -1 && time2 != -1){
+  return REG_FAILURE;
+}
 
-    if(time2 < time1) strcpy(filename1, filename2);
+/*----------------------------------------------------------------*/
 
-    if( (fp = fopen(filename1, "r")) ){
+FILE* open_next_file(char* base_name) {
+  FILE* fp = NULL;
+  char  filename[REG_MAX_STRING_LENGTH];
+
+  strcpy(filename, base_name);
+
+  if(find_next_file(filename) == REG_SUCCESS &&
+     (fp = fopen(filename, "r"))) {
 
 #ifdef REG_DEBUG
-      fprintf(stderr, "STEER: Open_next_file: opening %s\n", filename1);
+    fprintf(stderr, "STEER: Open_next_file: opening %s\n", filename);
 #endif
-      /* Return the name of the file actually opened */
-      strcpy(base_name, filename1);
-    }
+    /* Return the name of the file actually opened */
+    strcpy(base_name, filename);
   }
 
   return fp;
@@ -197,6 +501,10 @@ int create_lock_file(char* filename) {
   }
 
   close(fd);
+
+  /* Tell consumers about it without them having to go looking */
+  append_to_manifest(filename);
+
   return REG_SUCCESS;
 }
 
@@ -278,11 +586,68 @@ int remove_files(char* base_name) {
     strcpy(filename, base_name);
   }
 
+  /* Start the next run of files with a clean slate */
+  sprintf(filename, "%s%s", base_name, REG_MANIFEST_SUFFIX);
+  remove(filename);
+  drop_file_seq(base_name);
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int wait_for_directory(file_info_type* file_info, const int timeout_ms) {
+#if REG_HAS_INOTIFY
+  struct timeval timeout;
+  fd_set         fds;
+  char           events[4096];
+  int            fd = file_info->watch_fd;
+  int            n;
+
+  if(fd == -2) return REG_FAILURE;
+
+  if(fd == -1) {
+    if((fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) == -1 ||
+       inotify_add_watch(fd, file_info->directory,
+			 IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+      fprintf(stderr, "STEER: wait_for_directory: cannot watch %s (%s), "
+	      "will poll it instead\n", file_info->directory,
+	      strerror(errno));
+      if(fd != -1) close(fd);
+      file_info->watch_fd = -2;
+      return REG_FAILURE;
+    }
+    file_info->watch_fd = fd;
+    return REG_SUCCESS;
+  }
+
+  FD_ZERO(&fds);
+  FD_SET(fd, &fds);
+  timeout.tv_sec  = timeout_ms/1000;
+  timeout.tv_usec = (timeout_ms%1000)*1000;
+
+  if((n = select(fd + 1, &fds, NULL, NULL, &timeout)) == -1) {
+    if(errno == EINTR) return REG_SUCCESS;
+    perror("select");
+    return REG_FAILURE;
+  }
+  if(n == 0) return REG_TIMED_OUT;
+
+  /* We only want to know that something happened, not what */
+  while(read(fd, events, sizeof(events)) > 0);
+
   return REG_SUCCESS;
+#else
+  return REG_FAILURE;
+#endif
 }
 
 /*----------------------------------------------------------------*/
 
+void stop_watching_directory(file_info_type* file_info) {
+  if(file_info->watch_fd >= 0) close(file_info->watch_fd);
+  file_info->watch_fd = -1;
+}
 
 /*----------------------------------------------------------------*/
 
@@ -0,0 +1,462 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+
+/** @internal
+    @file ReG_Steer_Lossy.c
+    @brief Error-bounded lossy encoding of float and double data.
+
+    Three encodings are provided:
+    - REG_LOSSY_TRUNCATE rounds away the mantissa bits that the error
+      bound does not need ("bit grooming").  The data stays the same
+      size but the zeroed bits compress well (see
+      Set_IOType_compression()).
+    - REG_LOSSY_QUANT16 maps each element onto 65536 levels spread
+      evenly between the smallest and largest values in the slice.
+    - REG_LOSSY_HALF converts to IEEE 754 half precision (11
+      significant bits, magnitudes up to 65504).
+
+    Every encoding measures the error it actually introduced.  The
+    last two refuse data that they cannot encode within the bound so
+    that the caller can send it exactly instead.
+
+    @author Robert Haines
+  */
+
+#include "ReG_Steer_Config.h"
+#include "ReG_Steer_types.h"
+#include "ReG_Steer_Lossy.h"
+#include "ReG_Steer_XDR_Codec.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+/** Bytes of offset and scale at the start of a quantised slice */
+#define REG_Q16_HDR_SIZE 16
+/** Largest magnitude that half precision can hold */
+#define REG_HALF_MAX     65504.0
+
+/*----------------------------------------------------------------*/
+
+static double value_at(const int type, const void *in, const size_t i) {
+  return (type == REG_FLOAT) ? (double) ((const float*) in)[i] :
+    ((const double*) in)[i];
+}
+
+/*----------------------------------------------------------------*/
+
+static int is_finite(const double x) {
+  return (x == x) && x <= DBL_MAX && x >= -DBL_MAX;
+}
+
+/*----------------------------------------------------------------*/
+
+/* Finds the range and the largest magnitude of the finite elements
+   and returns the no. that are not finite */
+static size_t scan_values(const int type, const size_t count,
+			  const void *in, double *min, double *max,
+			  double *max_abs) {
+  size_t i, num_bad = 0;
+  double x;
+
+  *min = DBL_MAX;
+  *max = -DBL_MAX;
+  for(i = 0; i < count; i++) {
+    x = value_at(type, in, i);
+    if(!is_finite(x)) {
+      num_bad++;
+      continue;
+    }
+    if(x < *min) *min = x;
+    if(x > *max) *max = x;
+  }
+
+  if(*min > *max) *min = *max = 0.0;
+  *max_abs = (fabs(*min) > fabs(*max)) ? fabs(*min) : fabs(*max);
+
+  return num_bad;
+}
+
+/*----------------------------------------------------------------*/
+
+static void store_uint16(unsigned char *p, const unsigned int v) {
+  p[0] = (unsigned char) ((v >> 8) & 0xFF);
+  p[1] = (unsigned char) (v & 0xFF);
+}
+
+static unsigned int load_uint16(const unsigned char *p) {
+  return ((unsigned int) p[0] << 8) | (unsigned int) p[1];
+}
+
+/*----------------------------------------------------------------*/
+
+/* Rounds a float to the nearest half, ties to even */
+static unsigned int float_to_half(const float f) {
+  uint32_t     x;
+  uint32_t     mant, rem, halfway;
+  unsigned int sign, h;
+  int          exp, shift;
+
+  memcpy(&x, &f, sizeof(x));
+  sign = (unsigned int) ((x >> 16) & 0x8000);
+  mant = x & 0x7FFFFF;
+
+  if(((x >> 23) & 0xFF) == 0xFF) {
+    return sign | 0x7C00 | (mant ? 0x200 : 0);
+  }
+
+  exp = (int) ((x >> 23) & 0xFF) - 127 + 15;
+  if(exp >= 31) return sign | 0x7C00;
+
+  if(exp <= 0) {
+    /* Subnormal in half precision, or too small even for that */
+    if(exp < -10) return sign;
+    mant |= 0x800000;
+    shift = 14 - exp;
+    h = (unsigned int) (mant >> shift);
+  }
+  else {
+    shift = 13;
+    h = ((unsigned int) exp << 10) | (unsigned int) (mant >> 13);
+  }
+
+  /* A carry out of the mantissa correctly bumps the exponent */
+  rem = mant & ((1U << shift) - 1);
+  halfway = 1U << (shift - 1);
+  if(rem > halfway || (rem == halfway && (h & 1))) h++;
+
+  return sign | h;
+}
+
+/*----------------------------------------------------------------*/
+
+static float half_to_float(const unsigned int h) {
+  uint32_t     x;
+  unsigned int exp = (h >> 10) & 0x1F;
+  unsigned int mant = h & 0x3FF;
+  float        f;
+
+  if(exp == 0) {
+    f = (float) ldexp((double) mant, -24);
+    return (h & 0x8000) ? -f : f;
+  }
+
+  x = ((uint32_t) (h & 0x8000) << 16) | ((uint32_t) mant << 13);
+  if(exp == 31) {
+    x |= 0x7F800000;
+  }
+  else {
+    x |= (uint32_t) (exp - 15 + 127) << 23;
+  }
+  memcpy(&f, &x, sizeof(f));
+
+  return f;
+}
+
+/*----------------------------------------------------------------*/
+
+/* No. of mantissa bits that must be kept so that rounding any value
+   of magnitude up to max_abs is out by no more than abs_bound */
+static int mantissa_bits_needed(const double max_abs,
+				const double abs_bound, const int avail) {
+  int    exp;
+  double bits;
+
+  if(max_abs == 0.0) return 0;
+
+  /* Values below 2^exp are out by at most 2^(exp-1-bits) */
+  frexp(max_abs, &exp);
+  bits = ceil((double) exp - 1.0 - log(abs_bound)/log(2.0));
+
+  if(bits < 0.0) return 0;
+  if(bits > (double) avail) return avail;
+  return (int) bits;
+}
+
+/*----------------------------------------------------------------*/
+
+static double groom(const int type, const size_t count, const void *in,
+		    void *out, const int keep) {
+  size_t   i;
+  int      drop;
+  uint32_t u32, mask32;
+  uint64_t u64, mask64;
+  float    f;
+  double   d, err, max_err = 0.0;
+
+  if(type == REG_FLOAT) {
+    drop = 23 - keep;
+    mask32 = ~(uint32_t) 0 << drop;
+    for(i = 0; i < count; i++) {
+      f = ((const float*) in)[i];
+      memcpy(&u32, &f, sizeof(u32));
+      if(drop > 0 && ((u32 >> 23) & 0xFF) != 0xFF) {
+	u32 = (u32 + ((uint32_t) 1 << (drop - 1))) & mask32;
+	/* Don't round the largest values up to infinity */
+	if(((u32 >> 23) & 0xFF) == 0xFF) {
+	  memcpy(&u32, &f, sizeof(u32));
+	  u32 &= mask32;
+	}
+      }
+      memcpy(&(((float*) out)[i]), &u32, sizeof(u32));
+      err = fabs((double) ((float*) out)[i] - (double) f);
+      if(err > max_err) max_err = err;
+    }
+  }
+  else {
+    drop = 52 - keep;
+    mask64 = ~(uint64_t) 0 << drop;
+    for(i = 0; i < count; i++) {
+      d = ((const double*) in)[i];
+      memcpy(&u64, &d, sizeof(u64));
+      if(drop > 0 && ((u64 >> 52) & 0x7FF) != 0x7FF) {
+	u64 = (u64 + ((uint64_t) 1 << (drop - 1))) & mask64;
+	if(((u64 >> 52) & 0x7FF) == 0x7FF) {
+	  memcpy(&u64, &d, sizeof(u64));
+	  u64 &= mask64;
+	}
+      }
+      memcpy(&(((double*) out)[i]), &u64, sizeof(u64));
+      err = fabs(((double*) out)[i] - d);
+      if(err > max_err) max_err = err;
+    }
+  }
+
+  /* Infinities subtract to NaN, which never counts as the maximum */
+  return max_err;
+}
+
+/*----------------------------------------------------------------*/
+
+size_t Lossy_encoded_size(const int mode, const int type,
+			  const size_t count) {
+
+  if(type != REG_FLOAT && type != REG_DBL) return 0;
+
+  switch(mode) {
+  case REG_LOSSY_TRUNCATE:
+    return count*((type == REG_FLOAT) ? sizeof(float) : sizeof(double));
+
+  case REG_LOSSY_QUANT16:
+    return REG_Q16_HDR_SIZE + 2*count;
+
+  case REG_LOSSY_HALF:
+    return 2*count;
+
+  default:
+    return 0;
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+int Lossy_wire_type(const int mode, const int type) {
+
+  switch(mode) {
+  case REG_LOSSY_QUANT16:
+    return (type == REG_FLOAT) ? REG_Q16_FLOAT : REG_Q16_DOUBLE;
+
+  case REG_LOSSY_HALF:
+    return (type == REG_FLOAT) ? REG_HALF_FLOAT : REG_HALF_DOUBLE;
+
+  default:
+    return type;
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+int Lossy_native_type(const int wire_type) {
+
+  switch(wire_type) {
+  case REG_Q16_FLOAT:
+  case REG_HALF_FLOAT:
+    return REG_FLOAT;
+
+  case REG_Q16_DOUBLE:
+  case REG_HALF_DOUBLE:
+    return REG_DBL;
+
+  default:
+    return -1;
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+int Lossy_encode(const int mode, const int type, const int bound_type,
+		 const double bound, const size_t count, const void *in,
+		 void *out, size_t *out_bytes, double *max_err) {
+  unsigned char *pout = (unsigned char*) out;
+  double         min, max, max_abs, abs_bound;
+  double         scale, x, r, err;
+  double         hdr[2];
+  size_t         i, num_bad, nbytes;
+  unsigned int   q;
+
+  if(type != REG_FLOAT && type != REG_DBL) return REG_FAILURE;
+
+  num_bad = scan_values(type, count, in, &min, &max, &max_abs);
+  abs_bound = (bound_type == REG_ERROR_REL) ? bound*max_abs : bound;
+  *max_err = 0.0;
+
+  switch(mode) {
+  case REG_LOSSY_TRUNCATE:
+    *max_err = groom(type, count, in, out,
+		     mantissa_bits_needed(max_abs, abs_bound,
+					  (type == REG_FLOAT) ? 23 : 52));
+    break;
+
+  case REG_LOSSY_QUANT16:
+    if(num_bad > 0) return REG_FAILURE;
+
+    /* Quick check before doing any work - the levels are scale apart */
+    scale = (max - min)/65535.0;
+    if(scale/2.0 > abs_bound) return REG_FAILURE;
+
+    hdr[0] = min;
+    hdr[1] = scale;
+    if(Xdr_encode_array(REG_DBL, 2, hdr, pout, &nbytes) != REG_SUCCESS) {
+      return REG_FAILURE;
+    }
+    pout += REG_Q16_HDR_SIZE;
+
+    for(i = 0; i < count; i++) {
+      x = value_at(type, in, i);
+      q = (scale > 0.0) ? (unsigned int) floor((x - min)/scale + 0.5) : 0;
+      if(q > 65535) q = 65535;
+      store_uint16(pout + 2*i, q);
+
+      /* Measure the error as the consumer will reconstruct it */
+      r = min + (double) q*scale;
+      if(type == REG_FLOAT) r = (double) ((float) r);
+      err = fabs(r - x);
+      if(err > *max_err) *max_err = err;
+    }
+    break;
+
+  case REG_LOSSY_HALF:
+    if(max_abs > REG_HALF_MAX) return REG_FAILURE;
+
+    for(i = 0; i < count; i++) {
+      x = value_at(type, in, i);
+      q = float_to_half((float) x);
+      store_uint16(pout + 2*i, q);
+
+      if(is_finite(x)) {
+	err = fabs((double) half_to_float(q) - x);
+	if(err > *max_err) *max_err = err;
+      }
+    }
+    break;
+
+  default:
+    return REG_FAILURE;
+  }
+
+  /* Reconstructing the values rounds too so check the bound was
+     really met */
+  if(*max_err > abs_bound) return REG_FAILURE;
+
+  *out_bytes = Lossy_encoded_size(mode, type, count);
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Lossy_decode(const int wire_type, const void *in, const size_t nbytes,
+		 const size_t count, void *out) {
+  const unsigned char *pin = (const unsigned char*) in;
+  int                  type = Lossy_native_type(wire_type);
+  double               hdr[2];
+  double               r;
+  float                f;
+  size_t               i;
+
+  if(type == -1) return REG_FAILURE;
+
+  switch(wire_type) {
+  case REG_Q16_FLOAT:
+  case REG_Q16_DOUBLE:
+    if(nbytes != REG_Q16_HDR_SIZE + 2*count) return REG_FAILURE;
+    if(Xdr_decode_array(REG_DBL, 2, pin, hdr) != REG_SUCCESS) {
+      return REG_FAILURE;
+    }
+    pin += REG_Q16_HDR_SIZE;
+
+    for(i = 0; i < count; i++) {
+      r = hdr[0] + (double) load_uint16(pin + 2*i)*hdr[1];
+      if(type == REG_FLOAT) {
+	((float*) out)[i] = (float) r;
+      }
+      else {
+	((double*) out)[i] = r;
+      }
+    }
+    break;
+
+  default:
+    if(nbytes != 2*count) return REG_FAILURE;
+
+    for(i = 0; i < count; i++) {
+      f = half_to_float(load_uint16(pin + 2*i));
+      if(type == REG_FLOAT) {
+	((float*) out)[i] = f;
+      }
+      else {
+	((double*) out)[i] = (double) f;
+      }
+    }
+    break;
+  }
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
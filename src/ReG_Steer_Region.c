@@ -0,0 +1,306 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+
+/** @internal
+    @file ReG_Steer_Region.c
+    @brief Cutting arrays down to the region that a consumer wants.
+
+    Along each axis the wanted elements of the whole array are those
+    at the origin of the region plus a multiple of its stride, up to
+    the end of the region.  Taken together they make up a smaller
+    array and each block of the whole array that is emitted becomes a
+    (smaller still) block of that.
+
+    Extraction walks the block in the order that it is stored and
+    writes the wanted elements out in the same order.  Where every
+    element along the fastest-varying axis is wanted each run is one
+    memcpy; otherwise elements are gathered one at a time, with
+    4- and 8-byte elements moved as whole words.
+
+    Levels of detail are made of regions too, each a lattice of the
+    elements every so many along each axis from a point near the
+    origin of a block, so that every block stands alone.  The
+    consumer puts each one back in place and, once a level is
+    complete, fills the elements still to come from the nearest that
+    have arrived.
+
+    @author Robert Haines
+  */
+
+#include "ReG_Steer_Config.h"
+#include "ReG_Steer_types.h"
+#include "ReG_Steer_Common.h"
+#include "ReG_Steer_Region.h"
+
+#include <string.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    @param a Numerator
+    @param b Denominator, greater than zero
+    @return @p a / @p b rounded up, for @p a of either sign */
+static int ceil_div(const int a, const int b) {
+  return (a > 0) ? (a + b - 1)/b : -((-a)/b);
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    @param tot Extent of the whole array along the axis
+    @param start Origin of the block along the axis
+    @param len Extent of the block along the axis
+    @param r_start Origin of the region along the axis
+    @param r_len Extent of the region along the axis, zero for as far
+    as the array goes
+    @param stride Stride of the region along the axis
+    @param cut_tot On return, the no. of wanted elements in the whole
+    array
+    @param cut_start On return, the no. of wanted elements before the
+    block
+    @param cut_len On return, the no. of wanted elements in the block
+    @param first On return, the position within the block of its
+    first wanted element
+    @return REG_SUCCESS, or REG_FAILURE if none of the block is
+    wanted */
+static int clip_axis(const int tot, const int start, const int len,
+		     const int r_start, const int r_len, const int stride,
+		     int *cut_tot, int *cut_start, int *cut_len,
+		     int *first) {
+  int r_end;
+  int lo, hi;
+
+  /* Where the region stops, within the array */
+  r_end = (r_len > 0 && r_len < tot - r_start) ? r_start + r_len : tot;
+  *cut_tot = (r_end > r_start) ? ceil_div(r_end - r_start, stride) : 0;
+
+  /* The wanted elements from the first at or after the start of the
+     block to the last before its end */
+  lo = ceil_div(start - r_start, stride);
+  if(lo < 0) lo = 0;
+  hi = ceil_div(start + len - r_start, stride);
+  if(hi > *cut_tot) hi = *cut_tot;
+
+  if(hi <= lo) return REG_FAILURE;
+
+  *cut_start = lo;
+  *cut_len = hi - lo;
+  *first = r_start + lo*stride - start;
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Region_clip(const Region_type *region, const Array_type *chunk,
+		Array_type *cut, int *first) {
+
+  if(clip_axis(chunk->totx, chunk->sx, chunk->nx, region->sx, region->nx,
+	       region->dx, &(cut->totx), &(cut->sx), &(cut->nx),
+	       &(first[0])) != REG_SUCCESS ||
+     clip_axis(chunk->toty, chunk->sy, chunk->ny, region->sy, region->ny,
+	       region->dy, &(cut->toty), &(cut->sy), &(cut->ny),
+	       &(first[1])) != REG_SUCCESS ||
+     clip_axis(chunk->totz, chunk->sz, chunk->nz, region->sz, region->nz,
+	       region->dz, &(cut->totz), &(cut->sz), &(cut->nz),
+	       &(first[2])) != REG_SUCCESS) {
+    return REG_FAILURE;
+  }
+
+  cut->is_f90 = chunk->is_f90;
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+/** @internal
+    As Region_extract() if @p insert is REG_FALSE, taking elements
+    from @p block and storing them contiguously in @p packed, or as
+    Region_insert() if it is REG_TRUE, putting them back. */
+static void copy_region(const Array_type *chunk, const int *first,
+			const Array_type *cut, const Region_type *region,
+			const size_t elem_size, char *block, char *packed,
+			const int insert) {
+
+  char       *row;
+  char       *dst;
+  const char *src;
+  size_t      len[3], from[3], count[3], stride[3];
+  size_t      dst_step, src_step;
+  size_t      i, j, k, run;
+
+  /* Put the axes in the order that they vary, fastest first */
+  if(chunk->is_f90) {
+    len[0] = chunk->nx; len[1] = chunk->ny; len[2] = chunk->nz;
+    from[0] = first[0]; from[1] = first[1]; from[2] = first[2];
+    count[0] = cut->nx; count[1] = cut->ny; count[2] = cut->nz;
+    stride[0] = region->dx; stride[1] = region->dy; stride[2] = region->dz;
+  }
+  else {
+    len[0] = chunk->nz; len[1] = chunk->ny; len[2] = chunk->nx;
+    from[0] = first[2]; from[1] = first[1]; from[2] = first[0];
+    count[0] = cut->nz; count[1] = cut->ny; count[2] = cut->nx;
+    stride[0] = region->dz; stride[1] = region->dy; stride[2] = region->dx;
+  }
+
+  run = count[0]*elem_size;
+  dst_step = insert ? stride[0]*elem_size : elem_size;
+  src_step = insert ? elem_size : stride[0]*elem_size;
+
+  for(k = 0; k < count[2]; k++) {
+    for(j = 0; j < count[1]; j++) {
+      row = block + (((from[2] + k*stride[2])*len[1] +
+		      from[1] + j*stride[1])*len[0] + from[0])*elem_size;
+      dst = insert ? row : packed;
+      src = insert ? packed : row;
+
+      if(stride[0] == 1) {
+	memcpy(dst, src, run);
+      }
+      else if(elem_size == sizeof(uint64_t)) {
+	for(i = 0; i < count[0]; i++) {
+	  memcpy(dst + i*dst_step, src + i*src_step, sizeof(uint64_t));
+	}
+      }
+      else if(elem_size == sizeof(uint32_t)) {
+	for(i = 0; i < count[0]; i++) {
+	  memcpy(dst + i*dst_step, src + i*src_step, sizeof(uint32_t));
+	}
+      }
+      else {
+	for(i = 0; i < count[0]; i++) {
+	  memcpy(dst + i*dst_step, src + i*src_step, elem_size);
+	}
+      }
+      packed += run;
+    }
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+void Region_extract(const Array_type *chunk, const int *first,
+		    const Array_type *cut, const Region_type *region,
+		    const size_t elem_size, const void *in, void *out) {
+
+  copy_region(chunk, first, cut, region, elem_size, (char *) in,
+	      (char *) out, REG_FALSE);
+}
+
+/*----------------------------------------------------------------*/
+
+void Region_insert(const Array_type *chunk, const int *first,
+		   const Array_type *cut, const Region_type *region,
+		   const size_t elem_size, const void *in, void *out) {
+
+  copy_region(chunk, first, cut, region, elem_size, (char *) out,
+	      (char *) in, REG_TRUE);
+}
+
+/*----------------------------------------------------------------*/
+
+void Region_fill(const Array_type *chunk, const int spacing,
+		 const size_t elem_size, void *data) {
+
+  char   *pdata = (char *) data;
+  char   *plane;
+  char   *row;
+  size_t  len[3];
+  size_t  s = (size_t) spacing;
+  size_t  i, j, k, row_bytes, plane_bytes;
+
+  if(chunk->is_f90) {
+    len[0] = chunk->nx; len[1] = chunk->ny; len[2] = chunk->nz;
+  }
+  else {
+    len[0] = chunk->nz; len[1] = chunk->ny; len[2] = chunk->nx;
+  }
+  row_bytes = len[0]*elem_size;
+  plane_bytes = len[1]*row_bytes;
+
+  /* Planes, and rows within them, are filled in the order they are
+     stored, so one that is not on the lattice is a copy of one that
+     has already been done */
+  for(k = 0; k < len[2]; k++) {
+    plane = pdata + k*plane_bytes;
+
+    if(k % s) {
+      memcpy(plane, plane - (k % s)*plane_bytes, plane_bytes);
+      continue;
+    }
+
+    for(j = 0; j < len[1]; j++) {
+      row = plane + j*row_bytes;
+
+      if(j % s) {
+	memcpy(row, row - (j % s)*row_bytes, row_bytes);
+      }
+      else if(elem_size == sizeof(uint64_t)) {
+	for(i = 0; i < len[0]; i++) {
+	  if(i % s) memcpy(row + i*sizeof(uint64_t),
+			   row + (i - i % s)*sizeof(uint64_t),
+			   sizeof(uint64_t));
+	}
+      }
+      else if(elem_size == sizeof(uint32_t)) {
+	for(i = 0; i < len[0]; i++) {
+	  if(i % s) memcpy(row + i*sizeof(uint32_t),
+			   row + (i - i % s)*sizeof(uint32_t),
+			   sizeof(uint32_t));
+	}
+      }
+      else {
+	for(i = 0; i < len[0]; i++) {
+	  if(i % s) memcpy(row + i*elem_size, row + (i - i % s)*elem_size,
+			   elem_size);
+	}
+      }
+    }
+  }
+}
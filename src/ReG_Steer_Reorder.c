@@ -0,0 +1,577 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+
+/** @internal
+    @file ReG_Steer_Reorder.c
+    @brief Conversion of N-dimensional arrays between C and F90 ordering.
+
+    Converting between orderings is a transposition: the index that
+    varies most rapidly in the source varies least rapidly in the
+    destination.  Walking either array in order therefore strides
+    through the other and touches a new cache line for every element.
+    Instead the two "fast" dimensions are walked a square tile at a
+    time, small enough that the tile's lines of both arrays stay in
+    L1 cache.  Any other dimensions are simply looped over.
+
+    The unit of work is one row of tiles (a block of the source's
+    fast index at a single position in the other dimensions) and large
+    arrays have these shared out between threads.
+
+    Reorder_decode_nd() uses the same machinery but its tiles read
+    XDR elements, byte-swapping each one as it is stored at its new
+    position, so XDR data is decoded and reordered in a single pass
+    without a temporary copy.
+
+    @author Robert Haines
+  */
+
+#include "ReG_Steer_Config.h"
+#include "ReG_Steer_types.h"
+#include "ReG_Steer_Common.h"
+#include "ReG_Steer_Reorder.h"
+#include "ReG_Steer_XDR_Codec.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#if REG_HAS_PTHREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/* Edge (in elements) of a tile: a tile of either array then spans
+   at most 64 cache lines */
+#define REG_REORDER_TILE_SMALL 64
+#define REG_REORDER_TILE_LARGE 32
+
+/* Don't give a thread fewer elements than this to copy */
+#define REG_REORDER_MIN_PER_THREAD 262144
+
+/* Upper limit on the no. of threads that will be used */
+#define REG_REORDER_MAX_THREADS 64
+
+/** @internal
+    Description of (part of) a reordering.  Dimension a is the one
+    that varies most rapidly in the source and dimension b the one that
+    varies most rapidly in the destination. */
+typedef void (*reorder_tile_fn)(const void*, void*, size_t, size_t,
+				size_t, size_t, size_t);
+
+typedef struct {
+  /** Copies (and converts) one tile */
+  reorder_tile_fn      tile_fn;
+  /** Size of one element of the source and of the destination */
+  size_t               in_elem_size;
+  size_t               elem_size;
+  /** Extent of the block in dimensions a and b */
+  size_t               len_a, len_b;
+  /** Stride of dimension b in the source (that of a is one) */
+  size_t               in_stride_b;
+  /** Stride of dimension a in the destination (that of b is one) */
+  size_t               out_stride_a;
+  /** No. of other dimensions and their extents and strides */
+  int                  nouter;
+  size_t               outer_len[REG_REORDER_MAX_DIMS];
+  size_t               outer_in_stride[REG_REORDER_MAX_DIMS];
+  size_t               outer_out_stride[REG_REORDER_MAX_DIMS];
+  /** Edge of a tile and no. of tiles spanning dimension a */
+  size_t               tile;
+  size_t               ntiles_a;
+  /** Source block and destination (offset to the block's origin) */
+  const unsigned char *in;
+  unsigned char       *out;
+  /** Range of work units [first, last) to do */
+  size_t               first;
+  size_t               last;
+} reorder_job;
+
+/*----------------------------------------------------------------*/
+
+/* Copy one tile of na x nb elements, reading the source with a
+   stride of in_stride_b in b and writing the destination with a
+   stride of out_stride_a in a */
+#define REG_REORDER_TILE_FUNC(name, T)					\
+  static void name(const void *in, void *out, size_t na, size_t nb,	\
+		   size_t in_stride_b, size_t out_stride_a,		\
+		   size_t elem_size) {					\
+    const T *pin = (const T*) in;					\
+    T       *pout = (T*) out;						\
+    size_t   i, j;							\
+									\
+    (void) elem_size;							\
+    for(i = 0; i < na; i++) {						\
+      for(j = 0; j < nb; j++) {						\
+	pout[j] = pin[j*in_stride_b];					\
+      }									\
+      pin++;								\
+      pout += out_stride_a;						\
+    }									\
+  }
+
+REG_REORDER_TILE_FUNC(reorder_tile_1, uint8_t)
+REG_REORDER_TILE_FUNC(reorder_tile_2, uint16_t)
+REG_REORDER_TILE_FUNC(reorder_tile_4, uint32_t)
+REG_REORDER_TILE_FUNC(reorder_tile_8, uint64_t)
+
+/* Any other element size */
+static void reorder_tile_n(const void *in, void *out, size_t na, size_t nb,
+			   size_t in_stride_b, size_t out_stride_a,
+			   size_t elem_size) {
+  const unsigned char *pin = (const unsigned char*) in;
+  unsigned char       *pout = (unsigned char*) out;
+  size_t               i, j;
+
+  for(i = 0; i < na; i++) {
+    for(j = 0; j < nb; j++) {
+      memcpy(pout + j*elem_size, pin + j*in_stride_b*elem_size, elem_size);
+    }
+    pin += elem_size;
+    pout += out_stride_a*elem_size;
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+/* Load a 4 or 8 byte big-endian (XDR) quantity */
+#if !REG_BIG_ENDIAN && (defined(__GNUC__) || defined(__clang__))
+#define REG_BSWAP32(v) __builtin_bswap32(v)
+#define REG_BSWAP64(v) __builtin_bswap64(v)
+#else
+#define REG_BSWAP32(v) ((((v) >> 24) & 0xffu) | (((v) >> 8) & 0xff00u) | \
+			(((v) & 0xff00u) << 8) | ((v) << 24))
+#define REG_BSWAP64(v) (((uint64_t) REG_BSWAP32((uint32_t) (v)) << 32) | \
+			(uint64_t) REG_BSWAP32((uint32_t) ((v) >> 32)))
+#endif
+
+static uint32_t xdr_load32(const unsigned char *p) {
+  uint32_t v;
+
+  memcpy(&v, p, 4);
+#if !REG_BIG_ENDIAN
+  v = REG_BSWAP32(v);
+#endif
+  return v;
+}
+
+static uint64_t xdr_load64(const unsigned char *p) {
+  uint64_t v;
+
+  memcpy(&v, p, 8);
+#if !REG_BIG_ENDIAN
+  v = REG_BSWAP64(v);
+#endif
+  return v;
+}
+
+/*----------------------------------------------------------------*/
+
+/* As reorder_tile_*() but decoding XDR elements on the way.  An XDR
+   int or float is 4 bytes, a double 8 and a long 4 (sign-extended
+   to a native long) */
+static void reorder_xdr_tile_4(const void *in, void *out, size_t na,
+			       size_t nb, size_t in_stride_b,
+			       size_t out_stride_a, size_t elem_size) {
+  const unsigned char *pin = (const unsigned char*) in;
+  uint32_t            *pout = (uint32_t*) out;
+  size_t               i, j;
+
+  (void) elem_size;
+  for(i = 0; i < na; i++) {
+    for(j = 0; j < nb; j++) {
+      pout[j] = xdr_load32(pin + 4*j*in_stride_b);
+    }
+    pin += 4;
+    pout += out_stride_a;
+  }
+}
+
+static void reorder_xdr_tile_8(const void *in, void *out, size_t na,
+			       size_t nb, size_t in_stride_b,
+			       size_t out_stride_a, size_t elem_size) {
+  const unsigned char *pin = (const unsigned char*) in;
+  uint64_t            *pout = (uint64_t*) out;
+  size_t               i, j;
+
+  (void) elem_size;
+  for(i = 0; i < na; i++) {
+    for(j = 0; j < nb; j++) {
+      pout[j] = xdr_load64(pin + 8*j*in_stride_b);
+    }
+    pin += 8;
+    pout += out_stride_a;
+  }
+}
+
+static void reorder_xdr_tile_long(const void *in, void *out, size_t na,
+				  size_t nb, size_t in_stride_b,
+				  size_t out_stride_a, size_t elem_size) {
+  const unsigned char *pin = (const unsigned char*) in;
+  long                *pout = (long*) out;
+  size_t               i, j;
+
+  (void) elem_size;
+  for(i = 0; i < na; i++) {
+    for(j = 0; j < nb; j++) {
+      pout[j] = (long) (int32_t) xdr_load32(pin + 4*j*in_stride_b);
+    }
+    pin += 4;
+    pout += out_stride_a;
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+/* Do the work units in job->first to job->last */
+static void reorder_units(const reorder_job *job) {
+  size_t in_es = job->in_elem_size;
+  size_t es = job->elem_size;
+  size_t unit, m, idx;
+  size_t in_off, out_off;
+  size_t a0, b0, na, nb;
+  int    d;
+
+  for(unit = job->first; unit < job->last; unit++) {
+
+    /* Position in the other dimensions */
+    m = unit / job->ntiles_a;
+    in_off = 0;
+    out_off = 0;
+    for(d = 0; d < job->nouter; d++) {
+      idx = m % job->outer_len[d];
+      m /= job->outer_len[d];
+      in_off += idx*job->outer_in_stride[d];
+      out_off += idx*job->outer_out_stride[d];
+    }
+
+    a0 = (unit % job->ntiles_a)*job->tile;
+    na = job->len_a - a0;
+    if(na > job->tile) na = job->tile;
+    in_off += a0;
+    out_off += a0*job->out_stride_a;
+
+    for(b0 = 0; b0 < job->len_b; b0 += job->tile) {
+      nb = job->len_b - b0;
+      if(nb > job->tile) nb = job->tile;
+
+      job->tile_fn(job->in + (in_off + b0*job->in_stride_b)*in_es,
+		   job->out + (out_off + b0)*es,
+		   na, nb, job->in_stride_b, job->out_stride_a, es);
+    }
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+#if REG_HAS_PTHREADS
+
+static void *reorder_thread(void *arg) {
+  reorder_units((const reorder_job*) arg);
+  return NULL;
+}
+
+/*----------------------------------------------------------------*/
+
+/* No. of threads to share nelem elements in nunits units between */
+static int reorder_num_threads(size_t nelem, size_t nunits) {
+  char  *pchar;
+  long   n = 0;
+
+  if((pchar = getenv("REG_REORDER_THREADS"))) {
+    n = atol(pchar);
+  }
+  if(n < 1) {
+#ifdef _SC_NPROCESSORS_ONLN
+    n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if(n < 1) n = 1;
+  }
+
+  if(n > REG_REORDER_MAX_THREADS) n = REG_REORDER_MAX_THREADS;
+  if((size_t) n > nelem/REG_REORDER_MIN_PER_THREAD) {
+    n = (long) (nelem/REG_REORDER_MIN_PER_THREAD);
+  }
+  if((size_t) n > nunits) n = (long) nunits;
+
+  return (n < 1) ? 1 : (int) n;
+}
+
+#endif /* REG_HAS_PTHREADS */
+
+/*----------------------------------------------------------------*/
+
+/* Work out the strides of each dimension and fill in job.  Returns
+   the no. of elements in the block (zero if there is nothing to do),
+   or -1 if the block doesn't fit. */
+static long reorder_setup(const int ndims, const int *tot_extent,
+			  const int *sub_extent, const int *origin,
+			  const size_t in_elem_size, const size_t elem_size,
+			  const void *in, void *out, const int to_f90,
+			  reorder_job *job) {
+  size_t in_stride[REG_REORDER_MAX_DIMS];
+  size_t out_stride[REG_REORDER_MAX_DIMS];
+  size_t nelem = 1;
+  size_t out_off = 0;
+  int    a, b, d;
+
+  if(ndims < 1 || ndims > REG_REORDER_MAX_DIMS) {
+    fprintf(stderr, "STEER: ERROR: Reorder_nd: %d dimensional arrays "
+	    "not supported\n", ndims);
+    return -1;
+  }
+
+  for(d = 0; d < ndims; d++) {
+    if(sub_extent[d] < 0 || origin[d] < 0 ||
+       origin[d] + sub_extent[d] > tot_extent[d]) {
+      fprintf(stderr, "STEER: ERROR: Reorder_nd: block of extent %d at "
+	      "%d does not fit in extent %d (dimension %d)\n",
+	      sub_extent[d], origin[d], tot_extent[d], d);
+      return -1;
+    }
+    nelem *= (size_t) sub_extent[d];
+  }
+
+  /* Strides of each dimension in the source (contiguous block) and
+     in the destination (whole array) */
+  if(to_f90 == REG_TRUE) {
+    in_stride[ndims - 1] = 1;
+    for(d = ndims - 2; d >= 0; d--) {
+      in_stride[d] = in_stride[d + 1]*(size_t) sub_extent[d + 1];
+    }
+    out_stride[0] = 1;
+    for(d = 1; d < ndims; d++) {
+      out_stride[d] = out_stride[d - 1]*(size_t) tot_extent[d - 1];
+    }
+    a = ndims - 1;
+    b = 0;
+  }
+  else {
+    in_stride[0] = 1;
+    for(d = 1; d < ndims; d++) {
+      in_stride[d] = in_stride[d - 1]*(size_t) sub_extent[d - 1];
+    }
+    out_stride[ndims - 1] = 1;
+    for(d = ndims - 2; d >= 0; d--) {
+      out_stride[d] = out_stride[d + 1]*(size_t) tot_extent[d + 1];
+    }
+    a = 0;
+    b = ndims - 1;
+  }
+
+  for(d = 0; d < ndims; d++) {
+    out_off += (size_t) origin[d]*out_stride[d];
+  }
+
+  /* In 1D a and b are the same dimension - a single tile row that
+     is one element wide in b */
+  job->in_elem_size = in_elem_size;
+  job->elem_size = elem_size;
+  job->len_a = (size_t) sub_extent[a];
+  job->len_b = (ndims == 1) ? 1 : (size_t) sub_extent[b];
+  job->in_stride_b = (ndims == 1) ? 0 : in_stride[b];
+  job->out_stride_a = out_stride[a];
+  job->nouter = 0;
+  for(d = 0; d < ndims; d++) {
+    if(d == a || d == b) continue;
+    job->outer_len[job->nouter] = (size_t) sub_extent[d];
+    job->outer_in_stride[job->nouter] = in_stride[d];
+    job->outer_out_stride[job->nouter] = out_stride[d];
+    job->nouter++;
+  }
+  job->tile = (elem_size > 4) ? REG_REORDER_TILE_LARGE :
+    REG_REORDER_TILE_SMALL;
+  job->ntiles_a = (nelem == 0) ? 0 : (job->len_a + job->tile - 1)/job->tile;
+  job->in = (const unsigned char*) in;
+  job->out = (unsigned char*) out + out_off*elem_size;
+  job->first = 0;
+  job->last = (nelem == 0) ? 0 :
+    job->ntiles_a*(nelem/(job->len_a*job->len_b));
+
+  return (long) nelem;
+}
+
+/*----------------------------------------------------------------*/
+
+/* Do the job, sharing it between threads if it is big enough */
+static void reorder_run(reorder_job *job, size_t nelem) {
+#if REG_HAS_PTHREADS
+  reorder_job jobs[REG_REORDER_MAX_THREADS];
+  pthread_t   threads[REG_REORDER_MAX_THREADS];
+  int         started[REG_REORDER_MAX_THREADS];
+  size_t      nunits = job->last;
+  int         nthreads, t;
+
+  nthreads = reorder_num_threads(nelem, nunits);
+
+  if(nthreads > 1) {
+    for(t = 0; t < nthreads; t++) {
+      jobs[t] = *job;
+      jobs[t].first = (nunits*(size_t) t)/(size_t) nthreads;
+      jobs[t].last = (nunits*(size_t) (t + 1))/(size_t) nthreads;
+    }
+
+    /* This thread does the first share and any whose thread could
+       not be started */
+    for(t = 1; t < nthreads; t++) {
+      started[t] = (pthread_create(&threads[t], NULL, reorder_thread,
+				   &jobs[t]) == 0);
+    }
+    reorder_units(&jobs[0]);
+    for(t = 1; t < nthreads; t++) {
+      if(started[t]) {
+	pthread_join(threads[t], NULL);
+      }
+      else {
+	reorder_units(&jobs[t]);
+      }
+    }
+
+    return;
+  }
+#else
+  (void) nelem;
+#endif /* REG_HAS_PTHREADS */
+
+  reorder_units(job);
+}
+
+/*----------------------------------------------------------------*/
+
+int Reorder_nd(const int ndims, const int *tot_extent,
+	       const int *sub_extent, const int *origin,
+	       const size_t elem_size, const void *in, void *out,
+	       const int to_f90) {
+  reorder_job job;
+  long        nelem;
+
+  nelem = reorder_setup(ndims, tot_extent, sub_extent, origin, elem_size,
+			elem_size, in, out, to_f90, &job);
+  if(nelem < 0) return REG_FAILURE;
+  if(nelem == 0) return REG_SUCCESS;
+
+  /* A 1D array is the same in either ordering */
+  if(ndims == 1) {
+    memcpy(job.out, in, (size_t) nelem*elem_size);
+    return REG_SUCCESS;
+  }
+
+  switch(elem_size) {
+  case 1:  job.tile_fn = reorder_tile_1; break;
+  case 2:  job.tile_fn = reorder_tile_2; break;
+  case 4:  job.tile_fn = reorder_tile_4; break;
+  case 8:  job.tile_fn = reorder_tile_8; break;
+  default: job.tile_fn = reorder_tile_n; break;
+  }
+
+  reorder_run(&job, (size_t) nelem);
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Reorder_decode_nd(const int ndims, const int *tot_extent,
+		      const int *sub_extent, const int *origin,
+		      const int type, const void *in, void *out,
+		      const int to_f90) {
+  reorder_job job;
+  long        nelem;
+  int         elem_size;
+  void       *tmp;
+  int         status, d;
+
+  elem_size = Sizeof_type(type);
+  if(elem_size == 0 || Xdr_sizeof_type(type) == 0) {
+    fprintf(stderr, "STEER: ERROR: Reorder_decode_nd: cannot decode "
+	    "data of type %d\n", type);
+    return REG_FAILURE;
+  }
+
+  /* Without IEEE-sized types fall back to decoding into a temporary
+     and then reordering that */
+  if(sizeof(int) != 4 || sizeof(float) != 4 || sizeof(double) != 8) {
+    nelem = 1;
+    for(d = 0; d < ndims && d < REG_REORDER_MAX_DIMS; d++) {
+      nelem *= sub_extent[d];
+    }
+    if(!(tmp = malloc((size_t) nelem*elem_size + 1))) {
+      fprintf(stderr, "STEER: ERROR: Reorder_decode_nd: failed to malloc "
+	      "temporary buffer\n");
+      return REG_FAILURE;
+    }
+    status = Xdr_decode_array(type, (size_t) nelem, in, tmp);
+    if(status == REG_SUCCESS) {
+      status = Reorder_nd(ndims, tot_extent, sub_extent, origin,
+			  (size_t) elem_size, tmp, out, to_f90);
+    }
+    free(tmp);
+    return status;
+  }
+
+  nelem = reorder_setup(ndims, tot_extent, sub_extent, origin,
+			(size_t) Xdr_sizeof_type(type), (size_t) elem_size,
+			in, out, to_f90, &job);
+  if(nelem < 0) return REG_FAILURE;
+  if(nelem == 0) return REG_SUCCESS;
+
+  if(type == REG_LONG) {
+    job.tile_fn = reorder_xdr_tile_long;
+  }
+  else if(elem_size == 8) {
+    job.tile_fn = reorder_xdr_tile_8;
+  }
+  else {
+    job.tile_fn = reorder_xdr_tile_4;
+  }
+
+  reorder_run(&job, (size_t) nelem);
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
@@ -48,6 +48,31 @@
 /** @internal
     @file ReG_Steer_Samples_Transport_Files.c
     @brief Source file for file-based samples transport.
+
+    After the footer of each data file the emitter writes an index of
+    the slices in it - where each header and its data lie, the type,
+    size, compression and any array (chunk header) details - and then
+    a REG_PACKET_SIZE packet, starting REG_INDEX_TAG, that says where
+    the index is.  A consumer can use it to go straight to any slice
+    in the sample; those that don't know about it stop at the footer.
+
+    If REG_DATA_MMAP is set then data files are memory-mapped.  The
+    emitter sizes each file up front in steps of REG_FILES_MAP_CHUNK
+    (doubling as it goes), copies slices straight into the mapping
+    and cuts the file down to what was written before it creates the
+    lock file.  The consumer maps the whole file read-only, so slices
+    that need no decoding can be handed to Consume_data_slice_ptr()
+    where they lie.
+
+    If REG_DATA_WRITE_QUEUE is set (and the mapping is not used) then
+    data files are written by a background thread so that a slow
+    filesystem doesn't hold up the application.  Emitted bytes are
+    gathered into buffers of REG_FILES_WRITE_CHUNK bytes which are
+    queued for the writer, up to REG_DATA_WRITE_QUEUE bytes in all;
+    beyond that the emitter waits for room.  Emit_stop() queues the
+    closing of the file, and the writer only creates the lock file
+    once the data has been flushed to disk.
+
     @author Robert Haines
   */
 
@@ -59,6 +84,23 @@
 #include "ReG_Steer_Files_Common.h"
 #include "ReG_Steer_Common.h"
 #include "ReG_Steer_Appside_internal.h"
+#include "ReG_Steer_Buffers.h"
+
+#if REG_HAS_MMAP
+#include <sys/mman.h>
+#endif
+
+#if REG_HAS_PTHREADS
+#include <pthread.h>
+#endif
+
+/** @internal Data files are mapped in steps of at least this many
+    bytes */
+#define REG_FILES_MAP_CHUNK 4194304
+
+/** @internal Emitted bytes are handed to the background writer in
+    pieces of at least this many bytes */
+#define REG_FILES_WRITE_CHUNK 1048576
 
 /** Basic library config - declared in ReG_Steer_Common */
 extern Steer_lib_config_type Steer_lib_config;
@@ -66,6 +108,60 @@ extern Steer_lib_config_type Steer_lib_config;
 /* */
 file_info_table_type file_info_table;
 
+/** Whether (REG_TRUE) or not data files are memory-mapped */
+static int files_use_mmap = REG_FALSE;
+
+/** Most bytes that may be queued for the background writer, zero if
+    data files are written by the application's thread */
+static size_t files_queue_max = 0;
+
+#if REG_HAS_PTHREADS
+
+/** @internal Kinds of job for the background writer */
+#define FILES_JOB_WRITE 0
+#define FILES_JOB_CLOSE 1
+
+/** @internal
+    A job for the background writer */
+typedef struct files_job {
+  /** FILES_JOB_WRITE or FILES_JOB_CLOSE */
+  int               kind;
+  /** Index of the IOType */
+  int               index;
+  /** The data file */
+  FILE             *fp;
+  /** Name of the data file (FILES_JOB_CLOSE only) */
+  char              filename[REG_MAX_STRING_LENGTH];
+  /** Bytes to write, from Buffer_get(), the no. of them and the size
+      of @p data (FILES_JOB_WRITE only) */
+  char             *data;
+  size_t            num_bytes;
+  size_t            class_bytes;
+  /** The job queued after this one */
+  struct files_job *next;
+} files_job_type;
+
+/** Guards the queue of jobs and the writer's figures in
+    file_info_table */
+static pthread_mutex_t files_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** Signalled when a job is queued or the writer should quit */
+static pthread_cond_t  files_work = PTHREAD_COND_INITIALIZER;
+/** Signalled when the writer finishes a job */
+static pthread_cond_t  files_room = PTHREAD_COND_INITIALIZER;
+/** The background writer */
+static pthread_t       files_thread;
+/** Whether the writer is running */
+static int             files_writer_running = REG_FALSE;
+/** Whether the writer has been asked to stop */
+static int             files_writer_quit = REG_FALSE;
+/** The queue of jobs, oldest first */
+static files_job_type *files_head = NULL;
+static files_job_type *files_tail = NULL;
+/** No. of bytes of data in the queue */
+static size_t          files_queued_bytes = 0;
+
+#endif /* REG_HAS_PTHREADS */
+
 /* Need access to these tables which are actually declared in
    ReG_Steer_Appside_internal.h */
 extern IOdef_table_type IOTypes_table;
@@ -84,6 +180,7 @@ int Samples_transport_function_map() {
   Emit_data_non_blocking_impl = Emit_data_non_blocking_files;
   Emit_header_impl = Emit_header_files;
   Emit_data_impl = Emit_data_files;
+  Emit_data_batch_impl = Emit_data_batch_files;
   Consume_msg_header_impl = Consume_msg_header_files;
   Emit_msg_header_impl = Emit_msg_header_files;
   Consume_start_data_check_impl = Consume_start_data_check_files;
@@ -94,22 +191,821 @@ int Samples_transport_function_map() {
   Emit_start_impl = Emit_start_files;
   Emit_stop_impl = Emit_stop_files;
   Consume_stop_impl = Consume_stop_files;
+  Wait_for_IOType_impl = Wait_for_IOType_files;
+  Consume_data_map_impl = Consume_data_map_files;
+  Consume_seek_slice_impl = Consume_seek_slice_files;
+
+  return REG_SUCCESS;
+}
+#endif
+
+/*---------------------------------------------------*/
+
+#if REG_HAS_PTHREADS
+
+/** @internal
+    @return The time in seconds
+
+    Get_current_time_seconds() is only active with REG_USE_TIMING, but
+    the duration of writes is always of interest. */
+static double files_now() {
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return (double)(tv.tv_sec) + 1.0e-6*(double)(tv.tv_usec);
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param job The job
+    @return REG_SUCCESS, REG_FAILURE
+
+    Carry out a job for the background writer.  A file is flushed to
+    disk and closed before the lock file that tells consumers it's
+    there is created; if any of it failed to be written it's removed
+    instead. */
+static int files_run_job(files_job_type *job) {
+  file_info_type *info = &(file_info_table.file_info[job->index]);
+
+  if(job->kind == FILES_JOB_WRITE) {
+    if(!info->write_failed &&
+       fwrite(job->data, job->num_bytes, 1, job->fp) != 1) {
+      fprintf(stderr, "STEER: ERROR: files_run_job: failed to write "
+	      "data file: %s\n", strerror(errno));
+      info->write_failed = REG_TRUE;
+    }
+    return info->write_failed ? REG_FAILURE : REG_SUCCESS;
+  }
+
+  if(fflush(job->fp) != 0 ||
+#if REG_HAS_FDATASYNC
+     fdatasync(fileno(job->fp)) != 0
+#else
+     fsync(fileno(job->fp)) != 0
+#endif
+     ) {
+    fprintf(stderr, "STEER: ERROR: files_run_job: failed to flush %s: "
+	    "%s\n", job->filename, strerror(errno));
+    info->write_failed = REG_TRUE;
+  }
+  fclose(job->fp);
+
+  if(info->write_failed) {
+    remove(job->filename);
+    info->write_failed = REG_FALSE;
+    return REG_FAILURE;
+  }
+
+  /* Create lock file for this data file to prevent race
+     conditions */
+  return create_lock_file(job->filename);
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param arg Not used
+
+    The background writer.  Takes jobs from the queue in the order in
+    which they were queued until asked to quit with none left. */
+static void *files_writer(void *arg) {
+  file_info_type *info;
+  files_job_type *job;
+  double          t0, t1;
+
+  pthread_mutex_lock(&files_mutex);
+
+  while(REG_TRUE) {
+    while(!files_head && !files_writer_quit) {
+      pthread_cond_wait(&files_work, &files_mutex);
+    }
+    if(!(job = files_head)) break;
+    files_head = job->next;
+    if(!files_head) files_tail = NULL;
+    pthread_mutex_unlock(&files_mutex);
+
+    t0 = files_now();
+    files_run_job(job);
+    t1 = files_now();
+    if(job->data) Buffer_put(job->data, job->class_bytes);
+
+    pthread_mutex_lock(&files_mutex);
+    info = &(file_info_table.file_info[job->index]);
+    files_queued_bytes -= job->num_bytes;
+    info->queued_bytes -= job->num_bytes;
+    info->num_writes++;
+    info->write_seconds += t1 - t0;
+    if(t1 - t0 > info->max_write_seconds) info->max_write_seconds = t1 - t0;
+    pthread_cond_broadcast(&files_room);
+    free(job);
+  }
+
+  pthread_mutex_unlock(&files_mutex);
+
+  return NULL;
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param job The job, which now belongs to the writer
+
+    Add a job to the back of the writer's queue, first waiting for
+    room if the queue is full.  A job bigger than the whole queue is
+    let in when the queue is empty. */
+static void files_queue_job(files_job_type *job) {
+  file_info_type *info = &(file_info_table.file_info[job->index]);
+  int             stalled = REG_FALSE;
+
+  job->next = NULL;
+
+  pthread_mutex_lock(&files_mutex);
+
+  while(files_queued_bytes > 0 &&
+	files_queued_bytes + job->num_bytes > files_queue_max) {
+    if(!stalled) {
+      info->num_stalls++;
+      stalled = REG_TRUE;
+    }
+    pthread_cond_wait(&files_room, &files_mutex);
+  }
+
+  if(files_tail) {
+    files_tail->next = job;
+  }
+  else {
+    files_head = job;
+  }
+  files_tail = job;
+
+  files_queued_bytes += job->num_bytes;
+  info->queued_bytes += job->num_bytes;
+  if(info->queued_bytes > info->queue_high_water) {
+    info->queue_high_water = info->queued_bytes;
+  }
+
+  pthread_cond_signal(&files_work);
+  pthread_mutex_unlock(&files_mutex);
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param index Index of the IOType
+    @return REG_SUCCESS, REG_FAILURE
+
+    Hand the bytes gathered up for the data file of an IOType to the
+    writer. */
+static int files_queue_stage(const int index) {
+  file_info_type *info = &(file_info_table.file_info[index]);
+  files_job_type *job;
+
+  if(!info->stage || info->stage_bytes == 0) return REG_SUCCESS;
+
+  if(!(job = (files_job_type*) malloc(sizeof(files_job_type)))) {
+    fprintf(stderr, "STEER: ERROR: files_queue_stage: malloc failed\n");
+    return REG_FAILURE;
+  }
+
+  job->kind = FILES_JOB_WRITE;
+  job->index = index;
+  job->fp = info->fp;
+  job->data = info->stage;
+  job->num_bytes = info->stage_bytes;
+  job->class_bytes = info->stage_max;
+
+  info->stage = NULL;
+  info->stage_bytes = 0;
+  info->stage_max = 0;
+
+  files_queue_job(job);
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param index Index of the IOType
+    @param buf Bytes to write
+    @param num_bytes No. of bytes to write
+    @return REG_SUCCESS, REG_FAILURE
+
+    Copy bytes for the data file of an IOType to be written by the
+    writer, queueing them once there are enough. */
+static int files_stage_bytes(const int index, const void *buf,
+			     const size_t num_bytes) {
+  file_info_type *info = &(file_info_table.file_info[index]);
+
+  if(info->stage && info->stage_bytes + num_bytes > info->stage_max &&
+     files_queue_stage(index) != REG_SUCCESS) {
+    return REG_FAILURE;
+  }
+
+  if(!info->stage) {
+    info->stage = (char*) Buffer_get((num_bytes > REG_FILES_WRITE_CHUNK) ?
+				     num_bytes : REG_FILES_WRITE_CHUNK,
+				     &(info->stage_max));
+    if(!info->stage) {
+      fprintf(stderr, "STEER: ERROR: files_stage_bytes: failed to get "
+	      "buffer of %lu bytes\n", (unsigned long) num_bytes);
+      return REG_FAILURE;
+    }
+  }
+
+  memcpy(&(info->stage[info->stage_bytes]), buf, num_bytes);
+  info->stage_bytes += num_bytes;
+  info->write_pos += num_bytes;
+
+  if(info->stage_bytes >= REG_FILES_WRITE_CHUNK) {
+    return files_queue_stage(index);
+  }
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param index Index of the IOType
+    @return REG_SUCCESS, REG_FAILURE
+
+    Hand the data file of an IOType over to the writer to finish off.
+    The file is no longer ours once this returns. */
+static int files_queue_close(const int index) {
+  file_info_type *info = &(file_info_table.file_info[index]);
+  files_job_type *job;
+  int             status;
+
+  status = files_queue_stage(index);
+
+  if(!(job = (files_job_type*) malloc(sizeof(files_job_type)))) {
+    fprintf(stderr, "STEER: ERROR: files_queue_close: malloc failed\n");
+    fclose(info->fp);
+    info->fp = NULL;
+    remove(info->filename);
+    return REG_FAILURE;
+  }
+
+  job->kind = FILES_JOB_CLOSE;
+  job->index = index;
+  job->fp = info->fp;
+  strcpy(job->filename, info->filename);
+  job->data = NULL;
+  job->num_bytes = 0;
+  job->class_bytes = 0;
+
+  info->fp = NULL;
+  info->async_write = REG_FALSE;
+
+  files_queue_job(job);
+
+  return status;
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param index Index of the IOType
+
+    Bring the figures in the IOType table for the writer's work on an
+    IOType up to date. */
+static void files_update_write_stats(const int index) {
+  file_info_type *info = &(file_info_table.file_info[index]);
+  IOdef_entry    *io = &(IOTypes_table.io_def[index]);
+
+  pthread_mutex_lock(&files_mutex);
+  io->write_queue_bytes = (double) info->queued_bytes;
+  io->write_queue_high = (double) info->queue_high_water;
+  io->num_writes = info->num_writes;
+  io->write_seconds = info->write_seconds;
+  io->max_write_seconds = info->max_write_seconds;
+  io->num_write_stalls = info->num_stalls;
+  pthread_mutex_unlock(&files_mutex);
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @return REG_SUCCESS, REG_FAILURE
+
+    Start the background writer. */
+static int files_start_writer() {
+
+  files_writer_quit = REG_FALSE;
+  if(pthread_create(&files_thread, NULL, files_writer, NULL) != 0) {
+    fprintf(stderr, "STEER: WARNING: Initialize_samples_transport: "
+	    "failed to start writer thread - data files will be written "
+	    "directly\n");
+    return REG_FAILURE;
+  }
+  files_writer_running = REG_TRUE;
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    Wait for the background writer to finish everything it has been
+    given and then stop it. */
+static void files_stop_writer() {
+
+  if(!files_writer_running) return;
+
+  pthread_mutex_lock(&files_mutex);
+  files_writer_quit = REG_TRUE;
+  pthread_cond_signal(&files_work);
+  pthread_mutex_unlock(&files_mutex);
+
+  pthread_join(files_thread, NULL);
+  files_writer_running = REG_FALSE;
+}
+
+#endif /* REG_HAS_PTHREADS */
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param index Index of the IOType
+    @param num_bytes No. of bytes that are about to be written
+    @return REG_SUCCESS, REG_FAILURE
+
+    Make sure that the data file being emitted is mapped far enough
+    to take another @p num_bytes bytes, growing the file if need be. */
+static int grow_map_files(const int index, const size_t num_bytes) {
+#if REG_HAS_MMAP
+  file_info_type *info = &(file_info_table.file_info[index]);
+  size_t          new_bytes;
+  void           *ptr;
+
+  if(info->map_pos + num_bytes <= info->map_bytes) return REG_SUCCESS;
+
+  new_bytes = 2*info->map_bytes;
+  if(new_bytes < REG_FILES_MAP_CHUNK) new_bytes = REG_FILES_MAP_CHUNK;
+  while(new_bytes < info->map_pos + num_bytes) new_bytes *= 2;
+
+  if(info->map) munmap(info->map, info->map_bytes);
+  info->map = NULL;
+
+#if REG_HAS_POSIX_FALLOCATE
+  if(posix_fallocate(fileno(info->fp), (off_t) info->map_bytes,
+		     (off_t) (new_bytes - info->map_bytes)) != 0) {
+#else
+  if(ftruncate(fileno(info->fp), (off_t) new_bytes) != 0) {
+#endif
+    fprintf(stderr, "STEER: ERROR: grow_map_files: failed to make %s "
+	    "%lu bytes long\n", info->filename, (unsigned long) new_bytes);
+    info->map_bytes = 0;
+    return REG_FAILURE;
+  }
+
+  ptr = mmap(NULL, new_bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+	     fileno(info->fp), 0);
+  if(ptr == MAP_FAILED) {
+    fprintf(stderr, "STEER: ERROR: grow_map_files: failed to map %s: "
+	    "%s\n", info->filename, strerror(errno));
+    info->map_bytes = 0;
+    return REG_FAILURE;
+  }
+
+  info->map = (char*) ptr;
+  info->map_bytes = new_bytes;
+
+  return REG_SUCCESS;
+#else
+  return REG_FAILURE;
+#endif
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param index Index of the IOType
+    @param buf Bytes to write
+    @param num_bytes No. of bytes to write
+    @return REG_SUCCESS, REG_FAILURE
+
+    Append to the data file being emitted. */
+static int write_file_samples(const int index, const void *buf,
+			      const size_t num_bytes) {
+  file_info_type *info = &(file_info_table.file_info[index]);
+
+  if(!info->fp) return REG_FAILURE;
+  if(num_bytes == 0) return REG_SUCCESS;
+
+#if REG_HAS_PTHREADS
+  if(info->async_write) return files_stage_bytes(index, buf, num_bytes);
+#endif
+
+  if(!files_use_mmap) {
+    return (fwrite(buf, num_bytes, 1, info->fp) == 1) ?
+      REG_SUCCESS : REG_FAILURE;
+  }
+
+  if(grow_map_files(index, num_bytes) != REG_SUCCESS) return REG_FAILURE;
+
+  memcpy(&(info->map[info->map_pos]), buf, num_bytes);
+  info->map_pos += num_bytes;
 
   return REG_SUCCESS;
 }
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param index Index of the IOType
+    @param buf Buffer to read into
+    @param num_bytes No. of bytes to read
+    @return No. of bytes read, which is less than @p num_bytes if the
+    end of the file was reached
+
+    Read on from the data file being consumed. */
+static size_t read_file_samples(const int index, void *buf,
+				const size_t num_bytes) {
+  file_info_type *info = &(file_info_table.file_info[index]);
+  size_t          nbytes = num_bytes;
+
+  if(!info->map) return fread(buf, 1, num_bytes, info->fp);
+
+  if(nbytes > info->map_bytes - info->map_pos) {
+    nbytes = info->map_bytes - info->map_pos;
+  }
+  memcpy(buf, &(info->map[info->map_pos]), nbytes);
+  info->map_pos += nbytes;
+
+  return nbytes;
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param index Index of the IOType
+    @param discard Whether (REG_TRUE) or not to delete the file
+
+    Close the data file of an IOType.  A file that has been emitted
+    through a mapping is cut down to the bytes that were written. */
+static void close_file_samples(const int index, const int discard) {
+  file_info_type *info = &(file_info_table.file_info[index]);
+
+  if(!info->fp) return;
+
+#if REG_HAS_MMAP
+  if(info->map) munmap(info->map, info->map_bytes);
+  if(files_use_mmap && IOTypes_table.io_def[index].direction == REG_IO_OUT &&
+     ftruncate(fileno(info->fp), (off_t) info->map_pos) != 0) {
+    fprintf(stderr, "STEER: ERROR: close_file_samples: failed to cut "
+	    "%s down to %lu bytes\n", info->filename,
+	    (unsigned long) info->map_pos);
+  }
 #endif
+  info->map = NULL;
+  info->map_bytes = 0;
+  info->map_pos = 0;
+
+  fclose(info->fp);
+  info->fp = NULL;
+
+  if(discard) remove(info->filename);
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param index Index of the IOType
+    @return REG_SUCCESS, REG_FAILURE
+
+    Map the whole of the data file being consumed read-only. */
+static int map_file_samples(const int index) {
+#if REG_HAS_MMAP
+  file_info_type *info = &(file_info_table.file_info[index]);
+  struct stat     stbuf;
+  void           *ptr;
+
+  if(fstat(fileno(info->fp), &stbuf) != 0 || stbuf.st_size <= 0) {
+    return REG_FAILURE;
+  }
+
+  ptr = mmap(NULL, (size_t) stbuf.st_size, PROT_READ, MAP_SHARED,
+	     fileno(info->fp), 0);
+  if(ptr == MAP_FAILED) {
+    fprintf(stderr, "STEER: ERROR: map_file_samples: failed to map %s: "
+	    "%s\n", info->filename, strerror(errno));
+    return REG_FAILURE;
+  }
+
+  info->map = (char*) ptr;
+  info->map_bytes = (size_t) stbuf.st_size;
+  info->map_pos = 0;
+
+  return REG_SUCCESS;
+#else
+  return REG_FAILURE;
+#endif
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param index Index of the IOType
+    @return Offset of the next byte to write or read in the data file
+
+    Where we are in the data file of an IOType. */
+static uint64_t tell_file_samples(const int index) {
+  file_info_type *info = &(file_info_table.file_info[index]);
+
+  if(info->map || files_use_mmap) return (uint64_t) info->map_pos;
+  if(info->async_write) return info->write_pos;
+
+  return (uint64_t) ftell(info->fp);
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param index Index of the IOType
+    @param buf The slice header, binary or text
+    @param num_bytes Size of the slice header
+    @param offset Where in the data file the header is being written
+
+    Add the slice whose header is being emitted to the index of the
+    data file.  The index is given up on (@p num_index set to -1) if
+    there is no room for it or the header can't be made sense of. */
+static void index_slice_header(const int index, const char *buf,
+			       const size_t num_bytes,
+			       const uint64_t offset) {
+  file_info_type    *info = &(file_info_table.file_info[index]);
+  Slice_index_entry *entry;
+  Slice_index_entry *new_index;
+  int                new_max;
+
+  info->index_data_next = REG_FALSE;
+  if(info->num_index < 0) return;
+
+  if(info->num_index == info->max_index) {
+    new_max = info->max_index ? 2*info->max_index : 64;
+    if(!(new_index = (Slice_index_entry*)
+	 realloc(info->index, new_max*sizeof(Slice_index_entry)))) {
+      fprintf(stderr, "STEER: WARNING: index_slice_header: failed to "
+	      "allocate memory for the index of %s\n", info->filename);
+      info->num_index = -1;
+      return;
+    }
+    info->index = new_index;
+    info->max_index = new_max;
+  }
+
+  entry = &(info->index[info->num_index]);
+  memset(entry, 0, sizeof(Slice_index_entry));
+  entry->header_offset = offset;
+  entry->data_offset = offset + num_bytes;
+
+  if(Is_binary_slice_header(buf)) {
+    if(Unpack_slice_header(buf, &(entry->type), &(entry->count),
+			   &(entry->num_bytes), &(entry->is_fortran),
+			   &(entry->codec), &(entry->raw_bytes),
+			   &(entry->flags)) != REG_SUCCESS) {
+      info->num_index = -1;
+      return;
+    }
+  }
+  else {
+    /* Data type, no. of objects, no. of bytes and array order each
+       have a packet after the one that starts the header */
+    if(num_bytes < 5*REG_PACKET_SIZE ||
+       sscanf(&(buf[REG_PACKET_SIZE]), "<Data_type>%d</Data_type>",
+	      &(entry->type)) != 1 ||
+       sscanf(&(buf[2*REG_PACKET_SIZE]), "<Num_objects>%d</Num_objects>",
+	      &(entry->count)) != 1 ||
+       sscanf(&(buf[3*REG_PACKET_SIZE]), "<Num_bytes>%d</Num_bytes>",
+	      &(entry->num_bytes)) != 1) {
+      info->num_index = -1;
+      return;
+    }
+    entry->raw_bytes = entry->num_bytes;
+    entry->codec = REG_COMPRESS_NONE;
+    entry->is_fortran = strstr(&(buf[4*REG_PACKET_SIZE]), "FORTRAN") ?
+      REG_TRUE : REG_FALSE;
+  }
+
+  if(entry->type == REG_CHAR) {
+    /* This may be a chunk header describing the next slice */
+    info->index_data_next = (entry->codec == REG_COMPRESS_NONE &&
+			     entry->flags == 0);
+  }
+  else if(info->has_chunk) {
+    entry->has_array = REG_TRUE;
+    entry->array = info->chunk;
+    info->has_chunk = REG_FALSE;
+  }
+
+  info->num_index++;
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param index Index of the IOType
+    @param buf The data of the character slice last indexed
+    @param num_bytes Size of the data
+
+    If the character slice being emitted is a chunk header (see
+    Make_chunk_header()) keep the array that it describes for the
+    index entry of the next slice, unless that slice holds just part
+    of it (see Set_IOType_levels()). */
+static void index_chunk_header(const int index, const char *buf,
+			       const size_t num_bytes) {
+  file_info_type  *info = &(file_info_table.file_info[index]);
+  Chunk_level_type level;
+
+  info->index_data_next = REG_FALSE;
+
+  info->has_chunk = (Unpack_chunk_header(buf, num_bytes, &(info->chunk),
+					 &level) == REG_SUCCESS &&
+		     level.num_levels == 0);
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param index Index of the IOType
+
+    Write the index of slices, and the packet that locates it, to the
+    end of the data file being emitted. */
+static void write_index_files(const int index) {
+  file_info_type *info = &(file_info_table.file_info[index]);
+  char            buf[REG_INDEX_ENTRY_SIZE];
+  char            trailer[REG_PACKET_SIZE];
+  uint64_t        offset;
+  int             i;
+
+  if(!info->fp || info->num_index < 0) return;
+
+  offset = tell_file_samples(index);
+
+  for(i = 0; i < info->num_index; i++) {
+    Pack_index_entry(buf, &(info->index[i]));
+    if(write_file_samples(index, buf, REG_INDEX_ENTRY_SIZE) != REG_SUCCESS)
+      break;
+  }
+
+  Pack_index_trailer(trailer, info->num_index, offset);
+  if(i < info->num_index ||
+     write_file_samples(index, trailer, REG_PACKET_SIZE) != REG_SUCCESS) {
+    fprintf(stderr, "STEER: WARNING: write_index_files: failed to write "
+	    "index of %s\n", info->filename);
+  }
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param index Index of the IOType
+    @return REG_SUCCESS, or REG_FAILURE if the data file being consumed
+    has no index
+
+    Read in the index at the end of the data file being consumed, if
+    that hasn't been done already, without moving from where we are in
+    the file. */
+static int load_index_files(const int index) {
+  file_info_type *info = &(file_info_table.file_info[index]);
+  char            buf[REG_PACKET_SIZE];
+  uint64_t        offset;
+  uint64_t        size;
+  long            pos = 0;
+  int             num_entries;
+  int             i;
+  int             status = REG_FAILURE;
+
+  if(info->index_loaded) return (info->num_index >= 0) ? REG_SUCCESS :
+			   REG_FAILURE;
+  info->index_loaded = REG_TRUE;
+  info->num_index = -1;
+
+  if(info->map) {
+    size = (uint64_t) info->map_bytes;
+    if(size < REG_PACKET_SIZE) return REG_FAILURE;
+    memcpy(buf, &(info->map[size - REG_PACKET_SIZE]), REG_PACKET_SIZE);
+  }
+  else {
+    pos = ftell(info->fp);
+    if(fseek(info->fp, 0, SEEK_END) ||
+       (size = (uint64_t) ftell(info->fp)) < REG_PACKET_SIZE ||
+       fseek(info->fp, (long) (size - REG_PACKET_SIZE), SEEK_SET) ||
+       fread(buf, REG_PACKET_SIZE, 1, info->fp) != 1) {
+      fseek(info->fp, pos, SEEK_SET);
+      return REG_FAILURE;
+    }
+  }
+
+  /* Files from older emitters just stop at the footer */
+  if(Unpack_index_trailer(buf, &num_entries, &offset, NULL) != REG_SUCCESS ||
+     offset + (uint64_t) num_entries*REG_INDEX_ENTRY_SIZE + REG_PACKET_SIZE
+     != size) {
+    if(!info->map) fseek(info->fp, pos, SEEK_SET);
+    return REG_FAILURE;
+  }
+
+  if(num_entries > info->max_index) {
+    free(info->index);
+    info->max_index = 0;
+    if(!(info->index = (Slice_index_entry*)
+	 malloc(num_entries*sizeof(Slice_index_entry)))) {
+      fprintf(stderr, "STEER: ERROR: load_index_files: failed to allocate "
+	      "memory for the index of %s\n", info->filename);
+      fseek(info->fp, pos, SEEK_SET);
+      return REG_FAILURE;
+    }
+    info->max_index = num_entries;
+  }
+
+  if(info->map) {
+    for(i = 0; i < num_entries; i++) {
+      Unpack_index_entry(&(info->map[offset + i*REG_INDEX_ENTRY_SIZE]),
+			 &(info->index[i]));
+    }
+    status = REG_SUCCESS;
+  }
+  else if(fseek(info->fp, (long) offset, SEEK_SET) == 0) {
+    for(i = 0; i < num_entries; i++) {
+      if(fread(buf, REG_INDEX_ENTRY_SIZE, 1, info->fp) != 1) break;
+      Unpack_index_entry(buf, &(info->index[i]));
+    }
+    if(i == num_entries) status = REG_SUCCESS;
+  }
+  if(!info->map) fseek(info->fp, pos, SEEK_SET);
+
+  if(status == REG_SUCCESS) info->num_index = num_entries;
+
+  return status;
+}
 
 /*---------------------------------------------------*/
 
 int Initialize_samples_transport_files() {
+  char *pchar;
+
   strncpy(Steer_lib_config.Samples_transport_string, "Files", 6);
 
+  if((pchar = getenv("REG_DATA_MMAP")) && atoi(pchar) > 0) {
+#if REG_HAS_MMAP
+    files_use_mmap = REG_TRUE;
+#else
+    fprintf(stderr, "STEER: WARNING: Initialize_samples_transport: "
+	    "memory-mapped data files are not supported on this "
+	    "platform\n");
+#endif
+  }
+
+  if((pchar = getenv("REG_DATA_WRITE_QUEUE")) && atof(pchar) > 0.0) {
+#if REG_HAS_PTHREADS
+    if(files_use_mmap) {
+      fprintf(stderr, "STEER: WARNING: Initialize_samples_transport: "
+	      "REG_DATA_WRITE_QUEUE is ignored for memory-mapped data "
+	      "files\n");
+    }
+    else if(files_start_writer() == REG_SUCCESS) {
+      files_queue_max = (size_t) atof(pchar);
+    }
+#else
+    fprintf(stderr, "STEER: WARNING: Initialize_samples_transport: "
+	    "writing data files in the background is not supported on "
+	    "this platform\n");
+#endif
+  }
+
   return file_info_table_init(&file_info_table, IOTypes_table.max_entries);
 }
 
 /*---------------------------------------------------*/
 
 int Finalize_samples_transport_files() {
+  int i;
+
+#if REG_HAS_PTHREADS
+  /* Every data file that has been stopped gets to disk, and gets its
+     lock file, before we go */
+  files_stop_writer();
+  files_queue_max = 0;
+
+  for(i = 0; i < file_info_table.max_entries; i++) {
+    if(file_info_table.file_info[i].stage) {
+      Buffer_put(file_info_table.file_info[i].stage,
+		 file_info_table.file_info[i].stage_max);
+      file_info_table.file_info[i].stage = NULL;
+      file_info_table.file_info[i].stage_bytes = 0;
+    }
+  }
+#endif
+
+  for(i = 0; i < file_info_table.max_entries; i++) {
+    stop_watching_directory(&(file_info_table.file_info[i]));
+    free(file_info_table.file_info[i].index);
+    file_info_table.file_info[i].index = NULL;
+    file_info_table.file_info[i].max_index = 0;
+  }
+
   return REG_SUCCESS;
 }
 
@@ -153,23 +1049,46 @@ int Emit_start_files(int index, int seqnum) {
   pchar += strlen(file_info_table.file_info[index].filename);
 
   sprintf(pchar, "_%d", seqnum);
+
+  /* A mapping can only be written through a file open for update */
   if( !(file_info_table.file_info[index].fp =
-	fopen(file_info_table.file_info[index].filename, "w")) ){
+	fopen(file_info_table.file_info[index].filename,
+	      files_use_mmap ? "w+" : "w")) ){
 
     fprintf(stderr, "STEER: Emit_start: failed to open file %s\n",
 	    file_info_table.file_info[index].filename);
     return REG_FAILURE;
   }
+
+  file_info_table.file_info[index].num_index = 0;
+  file_info_table.file_info[index].index_data_next = REG_FALSE;
+  file_info_table.file_info[index].has_chunk = REG_FALSE;
+  file_info_table.file_info[index].async_write = (files_queue_max > 0);
+  file_info_table.file_info[index].write_pos = 0;
+
   return REG_SUCCESS;
 }
 
 /*---------------------------------------------------*/
 
 int Emit_stop_files(int index) {
-  if(file_info_table.file_info[index].fp){
-    fclose(file_info_table.file_info[index].fp);
-    file_info_table.file_info[index].fp = NULL;
+#if REG_HAS_PTHREADS
+  int status;
+#endif
+
+  write_index_files(index);
+
+#if REG_HAS_PTHREADS
+  if(file_info_table.file_info[index].async_write) {
+    /* The writer creates the lock file once the data is on disk */
+    status = files_queue_close(index);
+    files_update_write_stats(index);
+    return status;
   }
+#endif
+
+  close_file_samples(index, REG_FALSE);
+
   /* Create lock file for this data file to prevent race
      conditions */
   create_lock_file(file_info_table.file_info[index].filename);
@@ -181,17 +1100,21 @@ int Emit_stop_files(int index) {
 
 int Consume_stop_files(int index) {
   /* Close any file associated with this channel */
-  if(file_info_table.file_info[index].fp){
-    fclose(file_info_table.file_info[index].fp);
-    file_info_table.file_info[index].fp = NULL;
-    remove(file_info_table.file_info[index].filename);
-  }
+  close_file_samples(index, REG_TRUE);
 
   return REG_SUCCESS;
 }
 
 /*---------------------------------------------------*/
 
+int Wait_for_IOType_files(const int index, const int timeout_ms) {
+  /* Data files and acknowledgements all turn up in the same place */
+  return wait_for_directory(&(file_info_table.file_info[index]),
+			    timeout_ms);
+}
+
+/*---------------------------------------------------*/
+
 int Initialize_IOType_transport_files(const int direction, const int index) {
   char *pchar;
   int   len;
@@ -256,16 +1179,12 @@ int Consume_data_read_files(const int index,
   if(IOTypes_table.io_def[index].use_xdr ||
      IOTypes_table.io_def[index].convert_array_order == REG_TRUE) {
 
-    nbytes = fread((void *)IOTypes_table.io_def[index].buffer,
-		   1,
-		   (size_t)num_bytes_to_read,
-		   file_info_table.file_info[index].fp);
+    nbytes = read_file_samples(index,
+			       IOTypes_table.io_def[index].buffer,
+			       (size_t)num_bytes_to_read);
   }
   else {
-    nbytes = fread(pData,
-		   1,
-		   (size_t)num_bytes_to_read,
-		   file_info_table.file_info[index].fp);
+    nbytes = read_file_samples(index, pData, (size_t)num_bytes_to_read);
   }
 #ifdef REG_DEBUG
   fprintf(stderr, "STEER: Consume_data_read_file: read %d bytes\n",
@@ -279,9 +1198,63 @@ int Consume_data_read_files(const int index,
     /* Reset use_xdr flag set as only valid on a per-slice basis */
     IOTypes_table.io_def[index].use_xdr = REG_FALSE;
 
-    fclose(file_info_table.file_info[index].fp);
-    file_info_table.file_info[index].fp = NULL;
-    remove(file_info_table.file_info[index].filename);
+    close_file_samples(index, REG_TRUE);
+    return REG_FAILURE;
+  }
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Consume_data_map_files(const int index,
+			   const size_t num_bytes,
+			   void** pData) {
+  file_info_type *info = &(file_info_table.file_info[index]);
+
+  if(!info->map) return REG_FAILURE;
+
+  if(num_bytes > info->map_bytes - info->map_pos) {
+    fprintf(stderr, "STEER: ERROR: Consume_data_map_files: file ends "
+	    "before the data of the slice\n");
+    close_file_samples(index, REG_TRUE);
+    return REG_FAILURE;
+  }
+
+  *pData = &(info->map[info->map_pos]);
+  info->map_pos += num_bytes;
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Consume_seek_slice_files(const int index,
+			     const int slice,
+			     int* num_slices) {
+  file_info_type *info = &(file_info_table.file_info[index]);
+  uint64_t        offset;
+
+  if(!info->fp || load_index_files(index) != REG_SUCCESS) {
+    return REG_FAILURE;
+  }
+
+  *num_slices = info->num_index;
+  if(slice < 0) return REG_SUCCESS;
+
+  if(slice >= info->num_index) {
+    fprintf(stderr, "STEER: ERROR: Consume_seek_slice_files: no slice %d "
+	    "in %s, which has %d\n", slice, info->filename,
+	    info->num_index);
+    return REG_FAILURE;
+  }
+
+  offset = info->index[slice].header_offset;
+  if(info->map) {
+    if(offset > (uint64_t) info->map_bytes) return REG_FAILURE;
+    info->map_pos = (size_t) offset;
+  }
+  else if(fseek(info->fp, (long) offset, SEEK_SET)) {
     return REG_FAILURE;
   }
 
@@ -292,6 +1265,7 @@ int Consume_data_read_files(const int index,
 
 int Emit_ack_files(const int index) {
   FILE*  fp;
+  char   ack_msg[REG_ACK_MAX_SIZE + 1];
 
   /* In the short term, use the label (with spaces replaced by
      '_'s) as the filename.  'filename' is set in
@@ -300,7 +1274,12 @@ int Emit_ack_files(const int index) {
   sprintf(Steer_lib_config.scratch_buffer, "%s_ACK",
 	  file_info_table.file_info[index].filename);
 
+  /* The contents of the ack file tell the emitter which slice
+     header versions and data formats we understand and what part
+     of each array we want */
+  Get_ack_msg(&(IOTypes_table.io_def[index]), ack_msg);
   if((fp = fopen(Steer_lib_config.scratch_buffer, "w"))) {
+    fputs(ack_msg, fp);
     fclose(fp);
     return REG_SUCCESS;
   }
@@ -312,9 +1291,14 @@ int Emit_ack_files(const int index) {
 
 int Consume_ack_files(const int index) {
   FILE*  fp;
+  char   buf[REG_ACK_MAX_SIZE + 1];
+  size_t nbytes;
 
-  if(IOTypes_table.io_def[index].ack_needed == REG_FALSE)
+  /* No ack to look at so fall back to text slice headers and XDR */
+  if(IOTypes_table.io_def[index].ack_needed == REG_FALSE) {
+    Set_peer_capabilities(&(IOTypes_table.io_def[index]), NULL);
     return REG_SUCCESS;
+  }
 
   /* In the short term, use the label (with spaces replaced by
      '_'s) as the filename.  This routine is called before filename
@@ -325,6 +1309,11 @@ int Consume_ack_files(const int index) {
 	  file_info_table.file_info[index].filename);
 
   if((fp = fopen(Steer_lib_config.scratch_buffer, "r"))) {
+    /* An empty ack file comes from a consumer that only
+       understands text slice headers and XDR */
+    nbytes = fread(buf, 1, REG_ACK_MAX_SIZE, fp);
+    buf[nbytes] = '\0';
+    Set_peer_capabilities(&(IOTypes_table.io_def[index]), buf);
     fclose(fp);
     remove(Steer_lib_config.scratch_buffer);
 
@@ -365,16 +1354,33 @@ int Emit_data_non_blocking_files(const int index, const int size,
 int Emit_data_files(const int	index,
 		    const size_t	num_bytes_to_send,
 		    void*        pData) {
-  int n_written;
+  if(file_info_table.file_info[index].index_data_next) {
+    index_chunk_header(index, (const char*) pData, num_bytes_to_send);
+  }
 
-  if(file_info_table.file_info[index].fp) {
-    n_written = (int) fwrite(pData, (int)num_bytes_to_send, 1,
-			     file_info_table.file_info[index].fp);
+  return write_file_samples(index, pData, num_bytes_to_send);
+}
 
-    if(n_written == 1)
-      return REG_SUCCESS;
+/*---------------------------------------------------*/
+
+int Emit_data_batch_files(const int     index,
+			  const int     num_bufs,
+			  void**        bufs,
+			  const size_t* num_bytes) {
+  int i;
+
+  if(!file_info_table.file_info[index].fp) return REG_FAILURE;
+
+  /* Each slice header is followed by its data */
+  for(i = 0; i < num_bufs; i++) {
+    if(((i % 2) ? Emit_data_files(index, num_bytes[i], bufs[i]) :
+	Emit_msg_header_files(index, num_bytes[i], bufs[i]))
+       != REG_SUCCESS) {
+      return REG_FAILURE;
+    }
   }
-  return REG_FAILURE;
+
+  return REG_SUCCESS;
 }
 
 /*---------------------------------------------------*/
@@ -394,11 +1400,12 @@ int Emit_msg_header_files(const int    index,
 			  const size_t num_bytes_to_send,
 			  void*        pData) {
 
-  if(fwrite(pData, sizeof(char), num_bytes_to_send,
-	    file_info_table.file_info[index].fp) == num_bytes_to_send) {
-    return REG_SUCCESS;
+  if(file_info_table.file_info[index].fp) {
+    index_slice_header(index, (const char*) pData, num_bytes_to_send,
+		       tell_file_samples(index));
   }
-  return REG_FAILURE;
+
+  return write_file_samples(index, pData, num_bytes_to_send);
 }
 
 /*----------------------------------------------------------------*/
@@ -415,13 +1422,35 @@ int Consume_msg_header_files(int  index,
     return REG_FAILURE;
   }
 
-  if(fread(buffer, 1, REG_PACKET_SIZE, file_info_table.file_info[index].fp)
-     != (size_t)REG_PACKET_SIZE) {
+  /* Read enough to tell a binary slice header from the first
+     packet of a text one */
+  if(read_file_samples(index, buffer, REG_SLICE_HDR_SIZE)
+     != (size_t)REG_SLICE_HDR_SIZE) {
 
     fprintf(stderr, "STEER: Consume_iotype_msg_header: fread failed for header\n");
-    fclose(file_info_table.file_info[index].fp);
-    file_info_table.file_info[index].fp = NULL;
-    remove(file_info_table.file_info[index].filename);
+    close_file_samples(index, REG_TRUE);
+    return REG_FAILURE;
+  }
+
+  if(Is_binary_slice_header(buffer)) {
+    if(Unpack_slice_header(buffer, DataType, Count, NumBytes,
+			   IsFortranArray,
+			   &(IOTypes_table.io_def[index].slice_codec),
+			   &(IOTypes_table.io_def[index].slice_raw_bytes),
+			   &(IOTypes_table.io_def[index].slice_flags))
+       != REG_SUCCESS) {
+      close_file_samples(index, REG_TRUE);
+      return REG_FAILURE;
+    }
+    return REG_SUCCESS;
+  }
+
+  if(read_file_samples(index, &(buffer[REG_SLICE_HDR_SIZE]),
+		       REG_PACKET_SIZE - REG_SLICE_HDR_SIZE)
+     != (size_t)(REG_PACKET_SIZE - REG_SLICE_HDR_SIZE)) {
+
+    fprintf(stderr, "STEER: Consume_iotype_msg_header: fread failed for header\n");
+    close_file_samples(index, REG_TRUE);
     return REG_FAILURE;
   }
 
@@ -438,21 +1467,17 @@ int Consume_msg_header_files(int  index,
   else if(strncmp(buffer, BEGIN_SLICE_HEADER, strlen(BEGIN_SLICE_HEADER))) {
 
     fprintf(stderr, "STEER: Consume_iotype_msg_header: incorrect header on slice\n");
-    fclose(file_info_table.file_info[index].fp);
-    file_info_table.file_info[index].fp = NULL;
-    remove(file_info_table.file_info[index].filename);
+    close_file_samples(index, REG_TRUE);
     return REG_FAILURE;
   }
 
   /*--- Type of objects in message ---*/
 
-  if(fread(buffer, 1, REG_PACKET_SIZE, file_info_table.file_info[index].fp)
+  if(read_file_samples(index, buffer, REG_PACKET_SIZE)
      != (size_t)REG_PACKET_SIZE) {
 
     fprintf(stderr, "STEER: Consume_iotype_msg_header: fread failed for object type\n");
-    fclose(file_info_table.file_info[index].fp);
-    file_info_table.file_info[index].fp = NULL;
-    remove(file_info_table.file_info[index].filename);
+    close_file_samples(index, REG_TRUE);
     return REG_FAILURE;
   }
 
@@ -462,9 +1487,7 @@ int Consume_msg_header_files(int  index,
 #endif
 
   if(!strstr(buffer, "<Data_type>")) {
-    fclose(file_info_table.file_info[index].fp);
-    file_info_table.file_info[index].fp = NULL;
-    remove(file_info_table.file_info[index].filename);
+    close_file_samples(index, REG_TRUE);
     return REG_FAILURE;
   }
 
@@ -472,12 +1495,10 @@ int Consume_msg_header_files(int  index,
 
   /*--- No. of objects in message ---*/
 
-  if(fread(buffer, 1, REG_PACKET_SIZE, file_info_table.file_info[index].fp)
+  if(read_file_samples(index, buffer, REG_PACKET_SIZE)
      != (size_t)REG_PACKET_SIZE) {
 
-    fclose(file_info_table.file_info[index].fp);
-    file_info_table.file_info[index].fp = NULL;
-    remove(file_info_table.file_info[index].filename);
+    close_file_samples(index, REG_TRUE);
     return REG_FAILURE;
   }
 
@@ -487,29 +1508,23 @@ int Consume_msg_header_files(int  index,
 #endif
 
   if(!strstr(buffer, "<Num_objects>")) {
-    fclose(file_info_table.file_info[index].fp);
-    file_info_table.file_info[index].fp = NULL;
-    remove(file_info_table.file_info[index].filename);
+    close_file_samples(index, REG_TRUE);
     return REG_FAILURE;
   }
 
   if(sscanf(buffer, "<Num_objects>%d</Num_objects>", Count) != 1) {
     fprintf(stderr, "STEER: Consume_iotype_msg_header: failed to read Num_objects\n");
-    fclose(file_info_table.file_info[index].fp);
-    file_info_table.file_info[index].fp = NULL;
-    remove(file_info_table.file_info[index].filename);
+    close_file_samples(index, REG_TRUE);
     return REG_FAILURE;
   }
 
   /*--- No. of bytes in message ---*/
 
-  if(fread(buffer, 1, REG_PACKET_SIZE, file_info_table.file_info[index].fp)
+  if(read_file_samples(index, buffer, REG_PACKET_SIZE)
      != (size_t)REG_PACKET_SIZE) {
 
     fprintf(stderr, "STEER: Consume_iotype_msg_header: fread failed for num bytes\n");
-    fclose(file_info_table.file_info[index].fp);
-    file_info_table.file_info[index].fp = NULL;
-    remove(file_info_table.file_info[index].filename);
+    close_file_samples(index, REG_TRUE);
     return REG_FAILURE;
   }
 
@@ -519,29 +1534,23 @@ int Consume_msg_header_files(int  index,
 #endif
 
   if(!strstr(buffer, "<Num_bytes>")) {
-    fclose(file_info_table.file_info[index].fp);
-    file_info_table.file_info[index].fp = NULL;
-    remove(file_info_table.file_info[index].filename);
+    close_file_samples(index, REG_TRUE);
     return REG_FAILURE;
   }
 
   if(sscanf(buffer, "<Num_bytes>%d</Num_bytes>", NumBytes) != 1) {
     fprintf(stderr, "STEER: Consume_iotype_msg_header: failed to read Num_bytes\n");
-    fclose(file_info_table.file_info[index].fp);
-    file_info_table.file_info[index].fp = NULL;
-    remove(file_info_table.file_info[index].filename);
+    close_file_samples(index, REG_TRUE);
     return REG_FAILURE;
   }
 
   /*--- Array ordering in message ---*/
 
-  if(fread(buffer, 1, REG_PACKET_SIZE, file_info_table.file_info[index].fp)
+  if(read_file_samples(index, buffer, REG_PACKET_SIZE)
      != (size_t)REG_PACKET_SIZE) {
 
     fprintf(stderr, "STEER: Consume_iotype_msg_header: fread failed for array ordering\n");
-    fclose(file_info_table.file_info[index].fp);
-    file_info_table.file_info[index].fp = NULL;
-    remove(file_info_table.file_info[index].filename);
+    close_file_samples(index, REG_TRUE);
     return REG_FAILURE;
   }
 
@@ -551,9 +1560,7 @@ int Consume_msg_header_files(int  index,
 #endif
 
   if(!strstr(buffer, "<Array_order>")) {
-    fclose(file_info_table.file_info[index].fp);
-    file_info_table.file_info[index].fp = NULL;
-    remove(file_info_table.file_info[index].filename);
+    close_file_samples(index, REG_TRUE);
     return REG_FAILURE;
   }
 
@@ -568,13 +1575,11 @@ int Consume_msg_header_files(int  index,
 
   /*--- End of header ---*/
 
-  if(fread(buffer, 1, REG_PACKET_SIZE, file_info_table.file_info[index].fp)
+  if(read_file_samples(index, buffer, REG_PACKET_SIZE)
      != (size_t)REG_PACKET_SIZE) {
 
     fprintf(stderr, "STEER: Consume_iotype_msg_header: fread failed for header end\n");
-    fclose(file_info_table.file_info[index].fp);
-    file_info_table.file_info[index].fp = NULL;
-    remove(file_info_table.file_info[index].filename);
+    close_file_samples(index, REG_TRUE);
     return REG_FAILURE;
   }
 
@@ -586,9 +1591,7 @@ int Consume_msg_header_files(int  index,
   if(strncmp(buffer, END_SLICE_HEADER, strlen(END_SLICE_HEADER))) {
     fprintf(stderr, "STEER: Consume_msg_header: failed to find "
 	    "end of header\n");
-    fclose(file_info_table.file_info[index].fp);
-    file_info_table.file_info[index].fp = NULL;
-    remove(file_info_table.file_info[index].filename);
+    close_file_samples(index, REG_TRUE);
     return REG_FAILURE;
   }
 
@@ -618,61 +1621,40 @@ int Get_IOType_address_files(int index, char** pbuf, int* bytes_left) {
 int Consume_start_data_check_files(const int index) {
 
   int    i;
-  int    nfiles;
   char  *pchar;
-  char** filenames;
+  char  *filename;
   char buffer[REG_MAX_STRING_LENGTH];
-  char* tags[2];
+  char lock_name[REG_MAX_STRING_LENGTH + 5];
 
   /* In the short term, use the label (with spaces replaced by
      '_'s) as the filename */
-  tags[0] = (char*) malloc(strlen(IOTypes_table.io_def[index].label) * sizeof(char));
-  strcpy(tags[0], IOTypes_table.io_def[index].label);
+  filename = file_info_table.file_info[index].filename;
+  if(strlen(file_info_table.file_info[index].directory) +
+     strlen(IOTypes_table.io_def[index].label) >= REG_MAX_STRING_LENGTH) {
+    return REG_FAILURE;
+  }
+  sprintf(filename, "%s", file_info_table.file_info[index].directory);
+  pchar = filename + strlen(filename);
+  strcpy(pchar, IOTypes_table.io_def[index].label);
 
   /* Remove trailing white space */
-  i = strlen(tags[0]);
-  while(tags[0][--i] == ' ');
-
-  /* Terminate string and correct length of string (since final
-     character we looked at wasn't actually blank) */
-  tags[0][++i] = '\0';
+  i = strlen(pchar);
+  while(i > 0 && pchar[i - 1] == ' ') i--;
+  pchar[i] = '\0';
 
   /* Replace any spaces with '_' */
-  pchar = (char*) strchr(tags[0], ' ');
-  while( pchar && ((pchar - tags[0] + 1) < i) ) {
-    *pchar = '_';
-    pchar = (char*) strchr(++pchar,' ');
+  while((pchar = strchr(pchar, ' '))) {
+    *pchar++ = '_';
   }
 
-  tags[1] = ".lock";
-
-  filenames = NULL;
-  if(Get_file_list(file_info_table.file_info[index].directory, 2, tags,
-		   &nfiles, &filenames) != REG_SUCCESS || nfiles == 0) {
+  if(find_next_file(filename) != REG_SUCCESS) {
     return REG_FAILURE;
   }
 
-  sprintf(file_info_table.file_info[index].filename, "%s%s",
-	  file_info_table.file_info[index].directory, filenames[0]);
-
-  for(i=0; i<nfiles; i++){
-    free(filenames[i]);
-  }
-  free(filenames);
-  free(tags[0]);
-
   /* Remove the lock file to take ownership of the data file */
-  remove(file_info_table.file_info[index].filename);
-
-  /* Remove the '.lock' from the filename */
-  pchar = (char*) strstr(file_info_table.file_info[index].filename, ".lock");
+  sprintf(lock_name, "%s.lock", filename);
+  remove(lock_name);
 
-  if(!pchar) {
-    fprintf(stderr, "STEER: Consume_start_data_check_file: failed to strip .lock!\n");
-    return REG_FAILURE;
-  }
-
-  *pchar = '\0';
   if(!(file_info_table.file_info[index].fp =
 	fopen(file_info_table.file_info[index].filename, "r"))) {
 
@@ -681,15 +1663,20 @@ int Consume_start_data_check_files(const int index) {
     return REG_FAILURE;
   }
 
+  /* The index is only read if it is asked for */
+  file_info_table.file_info[index].index_loaded = REG_FALSE;
+  file_info_table.file_info[index].num_index = 0;
+
+  /* Fall back to reading the file if it can't be mapped */
+  if(files_use_mmap) map_file_samples(index);
+
   /* Read header */
-  if(fread((void *)buffer,
-	   (size_t)1,
-	   REG_PACKET_SIZE,
-	   file_info_table.file_info[index].fp) != (size_t)REG_PACKET_SIZE) {
+  if(read_file_samples(index, buffer, REG_PACKET_SIZE)
+     != (size_t)REG_PACKET_SIZE) {
     fprintf(stderr, "STEER: Consume_start_data_check_file: failed to read "
 	    "header from file: %s\n",
 	    file_info_table.file_info[index].filename);
-    remove(file_info_table.file_info[index].filename);
+    close_file_samples(index, REG_TRUE);
     return REG_FAILURE;
   }
 
@@ -697,7 +1684,7 @@ int Consume_start_data_check_files(const int index) {
     fprintf(stderr, "STEER: Consume_start_data_check_file: wrong "
 	    "header from file: %s\n",
 	    file_info_table.file_info[index].filename);
-    remove(file_info_table.file_info[index].filename);
+    close_file_samples(index, REG_TRUE);
     return REG_FAILURE;
   }
 
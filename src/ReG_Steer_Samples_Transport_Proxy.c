@@ -94,6 +94,7 @@ int Samples_transport_function_map() {
   Emit_data_non_blocking_impl = Emit_data_non_blocking_proxy;
   Emit_header_impl = Emit_header_proxy;
   Emit_data_impl = Emit_data_proxy;
+  Emit_data_batch_impl = Emit_data_batch_proxy;
   Consume_msg_header_impl = Consume_msg_header_proxy;
   Emit_msg_header_impl = Emit_msg_header_proxy;
   Consume_start_data_check_impl = Consume_start_data_check_proxy;
@@ -104,6 +105,9 @@ int Samples_transport_function_map() {
   Emit_start_impl = Emit_start_proxy;
   Emit_stop_impl = Emit_stop_proxy;
   Consume_stop_impl = Consume_stop_proxy;
+  Wait_for_IOType_impl = Wait_for_IOType_proxy;
+  Consume_data_map_impl = Consume_data_map_proxy;
+  Consume_seek_slice_impl = Consume_seek_slice_proxy;
 
   return REG_SUCCESS;
 }
@@ -288,12 +292,8 @@ int Get_communication_status_proxy(const int index) {
 
 int Emit_data_proxy(const int index, const size_t size, void* buffer) {
 
-  int   bytes_left;
+  socket_info_type* sock_info = &(socket_info_table.socket_info[index]);
   int   result;
-  char* pchar;
-  int   connector = socket_info_table.socket_info[index].connector_handle;
-  char *label = IOTypes_table.io_def[index].label;
-  char  header[128];
 
   if(size < 0) {
     fprintf(stderr, "STEER: Emit_data: requested to write < 0 bytes!\n");
@@ -304,51 +304,20 @@ int Emit_data_proxy(const int index, const size_t size, void* buffer) {
     return REG_SUCCESS;
   }
 
-#ifdef REG_DEBUG
-  fprintf(stderr, "STEER: Emit_data: writing...\n");
-#endif
-
-  sprintf(header, "#%s\n%d\n%d\n", label, 1, (int) size);
-  bytes_left = strlen(header);
-  pchar = header;
-
-  while(bytes_left > 0) {
-    result = send_no_signal(connector, pchar, bytes_left, 0);
-    if(result == REG_SOCKETS_ERROR) {
-      perror("send");
-      return REG_FAILURE;
-    }
-    else {
-      bytes_left -= result;
-      pchar += result;
-    }
-  }
-
-  bytes_left = size;
-  pchar = (char*) buffer;
-
-  while(bytes_left > 0) {
-    result = send_no_signal(connector, pchar, bytes_left, 0);
-    if(result == REG_SOCKETS_ERROR) {
-      perror("send");
-      return REG_FAILURE;
-    }
-    else {
-      bytes_left -= result;
-      pchar += result;
-    }
+  /* Part-way through a sample, small messages are held back until
+     there is a large one to go with them.  This saves a round trip
+     to the proxy as well as a send */
+  if(sock_info->gathering &&
+     gather_data(sock_info, buffer, size) == REG_SUCCESS) {
+    return REG_SUCCESS;
   }
 
-  if(bytes_left > 0) {
 #ifdef REG_DEBUG
-    fprintf(stderr, "STEER: Emit_data: timed-out trying to "
-	    "write data\n");
+  fprintf(stderr, "STEER: Emit_data: writing...\n");
 #endif
-    return REG_TIMED_OUT;
-  }
 
-  /* Check that the IOProxy had a destination for the data ARPDBG */
-  result = Consume_proxy_destination_ack(index);
+  result = send_proxy_message(index, IOTypes_table.io_def[index].label,
+			      1, &buffer, &size);
 
 #ifdef REG_DEBUG
   if(result == REG_SUCCESS){
@@ -361,30 +330,48 @@ int Emit_data_proxy(const int index, const size_t size, void* buffer) {
 
 /*---------------------------------------------------*/
 
+int Emit_data_batch_proxy(const int     index,
+			  const int     num_bufs,
+			  void**        bufs,
+			  const size_t* num_bytes) {
+
+  socket_info_type* sock_info = &(socket_info_table.socket_info[index]);
+  size_t total = 0;
+  int    i;
+
+  for(i = 0; i < num_bufs; i++) {
+    total += num_bytes[i];
+  }
+
+  /* A small batch can wait for the rest of the sample */
+  if(sock_info->gathering &&
+     total <= (size_t) (REG_GATHER_BUFSIZE - sock_info->gather_bytes)) {
+    for(i = 0; i < num_bufs; i++) {
+      if(gather_data(sock_info, bufs[i], num_bytes[i]) != REG_SUCCESS) {
+	return REG_FAILURE;
+      }
+    }
+    return REG_SUCCESS;
+  }
+
+  return send_proxy_message(index, IOTypes_table.io_def[index].label,
+			    num_bufs, bufs, num_bytes);
+}
+
+/*---------------------------------------------------*/
+
 int Emit_data_non_blocking_proxy(const int index, const int size,
 				 void* buffer) {
 
-  struct timeval timeout;
   int connector = socket_info_table.socket_info[index].connector_handle;
-  fd_set sock;
-
-  timeout.tv_sec  = 0;
-  timeout.tv_usec = 0;
-
-  FD_ZERO(&sock);
-  FD_SET(connector, &sock);
 
-  if(select(connector + 1, NULL, &sock, NULL, &timeout) == -1) {
-    perror("select");
+  /* Don't write to a consumer that has gone - the reactor has already
+     looked at this socket so this doesn't usually cost a system call */
+  if(reactor_events(connector) & REG_REACTOR_HUP) {
     return REG_FAILURE;
   }
 
-  /* are we free to write? */
-  if(FD_ISSET(connector, &sock)) {
-    return Emit_data_proxy(index, size, buffer);
-  }
-
-  return REG_FAILURE;
+  return Emit_data_proxy(index, size, buffer);
 }
 
 /*---------------------------------------------------*/
@@ -395,6 +382,7 @@ int Consume_proxy_destination_ack(const int index) {
   int  connector = socket_info_table.socket_info[index].connector_handle;
   char buffer[2];
 
+  socket_info_table.socket_info[index].num_syscalls++;
   result = recv_wait_all(connector, buffer, (size_t) 2, 0);
   if(result == -1){
     fprintf(stderr, "STEER: Consume_proxy_destination_ack: check for proxy OK failed\n");
@@ -450,6 +438,10 @@ int Emit_header_proxy(const int index) {
 #ifdef REG_DEBUG
       fprintf(stderr, "STEER: Emit_header: Sent %d bytes\n", REG_PACKET_SIZE);
 #endif
+      /* The header goes straight out so that we know now whether the
+	 proxy has somewhere to send the sample but the rest of it can
+	 be gathered */
+      start_gather_samples(index);
       return REG_SUCCESS;
     }
     else if(status == REG_FAILURE) {
@@ -464,7 +456,11 @@ int Emit_header_proxy(const int index) {
 #ifdef REG_DEBUG
 	fprintf(stderr, "STEER: Emit_header: Sending >>%s<<\n", buffer);
 #endif
-	return Emit_data_proxy(index, REG_PACKET_SIZE, (void*) buffer);
+	if(Emit_data_proxy(index, REG_PACKET_SIZE,
+			   (void*) buffer) == REG_SUCCESS) {
+	  start_gather_samples(index);
+	  return REG_SUCCESS;
+	}
       }
     }
 #ifdef REG_DEBUG
@@ -491,58 +487,22 @@ int Emit_header_proxy(const int index) {
 int Emit_ack_proxy(const int index){
 
   /* Send a 16-byte acknowledgement message */
-  char *ack_msg = "<ACK/>          ";
-  const int size = 16;
-  int   bytes_left;
+  char  ack_msg[REG_ACK_SIZE + 1];
+  char  label[REG_MAX_STRING_LENGTH];
+  void *pack;
+  const size_t size = REG_ACK_SIZE;
   int   result;
-  int   connector = socket_info_table.socket_info[index].connector_handle;
-  char  header[REG_MAX_STRING_LENGTH];
-  char *label = IOTypes_table.io_def[index].proxySourceLabel;
-  char* pchar;
-
-  snprintf(header, REG_MAX_STRING_LENGTH, "#%s_REG_ACK\n%d\n%d\n",
-	   label, 1, size);
-
-  printf("ARPDBG: emitting ack: %s\n", header);
-  bytes_left = strlen(header);
-  pchar = header;
-
-  while(bytes_left > 0) {
-    result = send_no_signal(connector, pchar, bytes_left, 0);
-    if(result == REG_SOCKETS_ERROR) {
-      perror("send");
-      return REG_FAILURE;
-    }
-    else {
-      bytes_left -= result;
-      pchar += result;
-    }
-  }
-
-  bytes_left = size;
-  pchar = ack_msg;
 
-  while(bytes_left > 0) {
-    result = send_no_signal(connector, pchar, bytes_left, 0);
-    if(result == REG_SOCKETS_ERROR) {
-      perror("send");
-      return REG_FAILURE;
-    }
-    else {
-      bytes_left -= result;
-      pchar += result;
-    }
-  }
+  /* The proxy passes on no more than the usual 16 bytes so never
+     asks for a region */
+  Get_ack_msg(NULL, ack_msg);
+  snprintf(label, REG_MAX_STRING_LENGTH, "%s_REG_ACK",
+	   IOTypes_table.io_def[index].proxySourceLabel);
 
-  if(bytes_left > 0) {
-#ifdef REG_DEBUG
-    fprintf(stderr, "STEER: Emit_ack: timed-out trying to write data\n");
-#endif
-    return REG_TIMED_OUT;
-  }
+  printf("ARPDBG: emitting ack: %s\n", label);
 
-  /* Check that the IOProxy had a destination for the data ARPDBG */
-  result = Consume_proxy_destination_ack(index);
+  pack = (void*) ack_msg;
+  result = send_proxy_message(index, label, 1, &pack, &size);
   if(result == REG_SUCCESS)printf("ARPDBG: emitted ack OK\n");
 
   return result;
@@ -567,6 +527,44 @@ int Emit_msg_header_proxy(const int index,
 
 /*--------------------- Others ----------------------*/
 
+int send_proxy_message(const int index, const char* label,
+		       const int num_bufs, void** bufs,
+		       const size_t* num_bytes) {
+
+  socket_info_type* sock_info = &(socket_info_table.socket_info[index]);
+  char   header[REG_MAX_STRING_LENGTH];
+  size_t total = sock_info->gather_bytes;
+  int    nbytes;
+  int    i;
+
+  /* The proxy needs to know how much is coming so this has to
+     include anything that has been gathered */
+  for(i = 0; i < num_bufs; i++) {
+    total += num_bytes[i];
+  }
+  nbytes = snprintf(header, REG_MAX_STRING_LENGTH, "#%s\n%d\n%d\n", label,
+		    1, (int) total);
+
+  /* The proxy replies to every message so never hold any back */
+  if(send_gathered(sock_info, header, nbytes, num_bufs, bufs, num_bytes,
+		   REG_FALSE) != REG_SUCCESS) {
+    return REG_FAILURE;
+  }
+
+  /* Check that the IOProxy had a destination for the data ARPDBG */
+  return Consume_proxy_destination_ack(index);
+}
+
+/*---------------------------------------------------*/
+
+int flush_gather_samples(const int index) {
+  return send_proxy_message(index, IOTypes_table.io_def[index].label,
+			    0, NULL, NULL);
+}
+
+/*---------------------------------------------------*/
+
+
 int create_connector_samples(const int index) {
 
   int i;
@@ -0,0 +1,1110 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+
+/** @internal
+    @file ReG_Steer_Samples_Transport_Shm.c
+    @brief Source file for shared-memory samples transport.
+
+    For an emitter and consumer on the same machine. Samples go
+    through a lock-free ring in a POSIX shared memory segment rather
+    than through the loopback network stack, so there is one copy in
+    and one copy out and a system call only when the other end is
+    asleep waiting for us.
+    @author Robert Haines
+  */
+
+#define  REG_MODULE shm
+
+#include "ReG_Steer_Config.h"
+#include "ReG_Steer_types.h"
+#include "ReG_Steer_Samples_Transport_API.h"
+#include "ReG_Steer_Samples_Transport_Shm.h"
+#include "ReG_Steer_Common.h"
+#include "ReG_Steer_Appside_internal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if REG_HAS_FUTEX
+#include <limits.h>
+#include <time.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+/** Basic library config - declared in ReG_Steer_Common */
+extern Steer_lib_config_type Steer_lib_config;
+
+/* */
+shm_info_table_type shm_info_table;
+
+/* Need access to these tables which are actually declared in
+   ReG_Steer_Appside_internal.h */
+extern IOdef_table_type IOTypes_table;
+
+static void ring_copy_out(shm_info_type *info, const uint32_t pos,
+			  void *dest, const uint32_t len);
+static int process_alive(const uint32_t pid);
+static void ring_wait(volatile uint32_t *word, const uint32_t old,
+		      volatile uint32_t *waiting, const int timeout_ms);
+static int ring_wake(volatile uint32_t *word, volatile uint32_t *waiting);
+
+/*---------------------------------------------------*/
+
+#if !REG_DYNAMIC_MOD_LOADING
+int Samples_transport_function_map() {
+  Initialize_samples_transport_impl = Initialize_samples_transport_shm;
+  Finalize_samples_transport_impl = Finalize_samples_transport_shm;
+  Initialize_IOType_transport_impl = Initialize_IOType_transport_shm;
+  Finalize_IOType_transport_impl = Finalize_IOType_transport_shm;
+  Enable_IOType_impl = Enable_IOType_shm;
+  Disable_IOType_impl = Disable_IOType_shm;
+  Get_communication_status_impl = Get_communication_status_shm;
+  Emit_data_non_blocking_impl = Emit_data_non_blocking_shm;
+  Emit_header_impl = Emit_header_shm;
+  Emit_data_impl = Emit_data_shm;
+  Emit_data_batch_impl = Emit_data_batch_shm;
+  Consume_msg_header_impl = Consume_msg_header_shm;
+  Emit_msg_header_impl = Emit_msg_header_shm;
+  Consume_start_data_check_impl = Consume_start_data_check_shm;
+  Consume_data_read_impl = Consume_data_read_shm;
+  Emit_ack_impl = Emit_ack_shm;
+  Consume_ack_impl = Consume_ack_shm;
+  Get_IOType_address_impl = Get_IOType_address_shm;
+  Emit_start_impl = Emit_start_shm;
+  Emit_stop_impl = Emit_stop_shm;
+  Consume_stop_impl = Consume_stop_shm;
+  Wait_for_IOType_impl = Wait_for_IOType_shm;
+  Consume_data_map_impl = Consume_data_map_shm;
+  Consume_seek_slice_impl = Consume_seek_slice_shm;
+
+  return REG_SUCCESS;
+}
+#endif
+
+/*---------------------------------------------------*/
+
+int Initialize_samples_transport_shm() {
+  strncpy(Steer_lib_config.Samples_transport_string, "Shm", 4);
+
+  return shm_info_table_init(&shm_info_table, IOTypes_table.max_entries);
+}
+
+/*---------------------------------------------------*/
+
+int Finalize_samples_transport_shm() {
+  /* This is called before the IOTypes are finalized so let go of
+     the segments now */
+  Finalize_IOType_transport_shm();
+
+  free(shm_info_table.shm_info);
+  shm_info_table.shm_info = NULL;
+  shm_info_table.max_entries = 0;
+  shm_info_table.num_used = 0;
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+int Initialize_IOType_transport_shm(const int direction, const int index) {
+  shm_info_type *new_info;
+  int            new_max;
+
+  /* The table of IOTypes grows as they are registered so we must too */
+  if(index >= shm_info_table.max_entries) {
+    new_max = shm_info_table.max_entries + REG_INITIAL_NUM_IOTYPES;
+    if(new_max <= index) new_max = index + 1;
+
+    new_info = (shm_info_type*) realloc(shm_info_table.shm_info,
+					new_max*sizeof(shm_info_type));
+    if(!new_info) {
+      fprintf(stderr, "STEER: ERROR: Initialize_IOType_transport_shm: failed "
+	      "to grow table of shared memory info\n");
+      return REG_FAILURE;
+    }
+    shm_info_table.shm_info = new_info;
+    shm_info_table.max_entries = new_max;
+  }
+
+  memset(&(shm_info_table.shm_info[index]), 0, sizeof(shm_info_type));
+  if(shm_name_samples(index) != REG_SUCCESS) return REG_FAILURE;
+  if(index >= shm_info_table.num_used) shm_info_table.num_used = index + 1;
+
+  if(direction == REG_IO_OUT) {
+
+    /* Don't create segment yet if this flag is set */
+    if(IOTypes_table.enable_on_registration == REG_FALSE) return REG_SUCCESS;
+
+    if(create_segment_samples(index) != REG_SUCCESS) return REG_FAILURE;
+
+    fprintf(stderr, "STEER: Initialize_IOType_transport: Created "
+	    "shared memory segment %s, index %d, label %s\n",
+	    shm_info_table.shm_info[index].name,
+	    index, IOTypes_table.io_def[index].label);
+  }
+  else if(direction == REG_IO_IN) {
+
+    /* Keep a count of how many input channels have been registered and
+       where this channel is in that list */
+    IOTypes_table.io_def[index].input_index = ++(IOTypes_table.num_inputs);
+
+    /* The emitter may not be running yet so we attach when we first
+       look for data */
+  }
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+void Finalize_IOType_transport_shm() {
+  int index;
+
+  for(index = 0; index < shm_info_table.num_used; index++) {
+    release_segment_samples(index);
+  }
+}
+
+/*---------------------------------------------------*/
+
+int Enable_IOType_shm(const int index) {
+  /* check index is valid */
+  if(index < 0 || index >= IOTypes_table.num_registered) return REG_FAILURE;
+
+  if(IOTypes_table.io_def[index].direction == REG_IO_OUT &&
+     !shm_info_table.shm_info[index].ring) {
+    return create_segment_samples(index);
+  }
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+int Disable_IOType_shm(const int index) {
+  /* check index is valid */
+  if(index < 0 || index >= IOTypes_table.num_registered) {
+    fprintf(stderr, "STEER: Disable_IOType: index out of range\n");
+    return REG_FAILURE;
+  }
+
+  release_segment_samples(index);
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+int Get_communication_status_shm(const int index) {
+  return check_peer_samples(index);
+}
+
+/*---------------------------------------------------*/
+
+int Emit_data_non_blocking_shm(const int index, const int size,
+			       void* buffer) {
+  size_t num_bytes = (size_t) size;
+
+  if(check_peer_samples(index) != REG_SUCCESS) return REG_FAILURE;
+
+  return ring_write_samples(index, 1, &buffer, &num_bytes, REG_FALSE);
+}
+
+/*---------------------------------------------------*/
+
+int Emit_header_shm(const int index) {
+  char buffer[REG_PACKET_SIZE];
+
+  /* check that a consumer is there to read it */
+  if(check_peer_samples(index) != REG_SUCCESS) return REG_FAILURE;
+
+  snprintf(buffer, REG_PACKET_SIZE, REG_PACKET_FORMAT, REG_DATA_HEADER);
+
+#ifdef REG_DEBUG
+  fprintf(stderr, "STEER: Emit_header: Sending >>%s<<\n", buffer);
+#endif
+
+  return Emit_data_shm(index, REG_PACKET_SIZE, (void*) buffer);
+}
+
+/*---------------------------------------------------*/
+
+int Emit_data_shm(const int    index,
+		  const size_t num_bytes_to_send,
+		  void*        pData) {
+
+  return ring_write_samples(index, 1, &pData, &num_bytes_to_send, REG_TRUE);
+}
+
+/*---------------------------------------------------*/
+
+int Emit_data_batch_shm(const int     index,
+			const int     num_bufs,
+			void**        bufs,
+			const size_t* num_bytes) {
+
+  return ring_write_samples(index, num_bufs, bufs, num_bytes, REG_TRUE);
+}
+
+/*---------------------------------------------------*/
+
+int Emit_msg_header_shm(const int    index,
+			const size_t num_bytes_to_send,
+			void*        pData) {
+
+  return Emit_data_shm(index, num_bytes_to_send, pData);
+}
+
+/*---------------------------------------------------*/
+
+int Emit_ack_shm(const int index) {
+  shm_ring_header_type *ring = shm_info_table.shm_info[index].ring;
+
+  if(!ring) return REG_FAILURE;
+
+  /* The emitter only looks at the message once the sequence no. has
+     moved on */
+  Get_ack_msg(&(IOTypes_table.io_def[index]), ring->ack_msg);
+  __sync_synchronize();
+  ring->ack_seq++;
+  ring_wake(&(ring->ack_seq), &(ring->producer_waiting));
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+int Consume_ack_shm(const int index) {
+  shm_info_type        *info = &(shm_info_table.shm_info[index]);
+  shm_ring_header_type *ring = info->ring;
+  char                  buf[REG_ACK_MAX_SIZE + 1];
+  uint32_t              seq;
+  int                   status;
+
+  /* Picks up a newly-attached consumer, which has not sent us an ack */
+  status = check_peer_samples(index);
+
+  /* If no acknowledgement is currently required then we don't yet
+     know what this consumer understands */
+  if(IOTypes_table.io_def[index].ack_needed == REG_FALSE) {
+    Set_peer_capabilities(&(IOTypes_table.io_def[index]), NULL);
+    return REG_SUCCESS;
+  }
+
+  /* Consumer has gone so don't wait for it next time */
+  if(status != REG_SUCCESS) {
+    IOTypes_table.io_def[index].ack_needed = REG_FALSE;
+    return REG_FAILURE;
+  }
+
+  seq = ring->ack_seq;
+  __sync_synchronize();
+  if(seq == info->ack_seq) return REG_FAILURE;
+
+  memcpy(buf, ring->ack_msg, REG_ACK_MAX_SIZE);
+  buf[REG_ACK_MAX_SIZE] = '\0';
+  info->ack_seq = seq;
+  Set_peer_capabilities(&(IOTypes_table.io_def[index]), buf);
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+int Get_IOType_address_shm(int index, char** pbuf, int* bytes_left) {
+  /* Consumers find the segment from the label so there is nothing
+     to advertise */
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+int Emit_start_shm(int index, int seqnum) {
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+int Emit_stop_shm(int index) {
+  IOTypes_table.io_def[index].num_emit_syscalls +=
+    shm_info_table.shm_info[index].num_syscalls;
+  shm_info_table.shm_info[index].num_syscalls = 0;
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+int Consume_stop_shm(int index) {
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+int Consume_data_map_shm(const int index, const size_t num_bytes,
+			 void** pData) {
+  /* The ring is reused as soon as we move past the data */
+  return REG_FAILURE;
+}
+
+/*---------------------------------------------------*/
+
+int Consume_seek_slice_shm(const int index, const int slice,
+			   int* num_slices) {
+  /* Nor can we go back to data in the ring that has been read */
+  return REG_FAILURE;
+}
+
+/*---------------------------------------------------*/
+
+int Wait_for_IOType_shm(const int index, const int timeout_ms) {
+  shm_info_type        *info = &(shm_info_table.shm_info[index]);
+  shm_ring_header_type *ring = info->ring;
+  int                   wait_ms = timeout_ms;
+  uint32_t              old;
+
+  if(!ring) return REG_FAILURE;
+
+  /* Don't sleep for so long that we miss the other end going away */
+  if(wait_ms > REG_SHM_WAIT_MS) wait_ms = REG_SHM_WAIT_MS;
+
+  if(IOTypes_table.io_def[index].direction == REG_IO_OUT) {
+    if(!process_alive(ring->consumer_pid)) {
+      /* Wait for a consumer to attach */
+      old = info->consumer_gen;
+      ring_wait(&(ring->consumer_gen), old, &(ring->producer_waiting),
+		wait_ms);
+      return (ring->consumer_gen != old) ? REG_SUCCESS : REG_TIMED_OUT;
+    }
+
+    /* Otherwise only an acknowledgement can be holding us up */
+    if(IOTypes_table.io_def[index].ack_needed == REG_FALSE) {
+      return REG_FAILURE;
+    }
+    old = info->ack_seq;
+    ring_wait(&(ring->ack_seq), old, &(ring->producer_waiting), wait_ms);
+    return (ring->ack_seq != old) ? REG_SUCCESS : REG_TIMED_OUT;
+  }
+
+  /* Wait for the emitter to write some more - the start of a sample
+     might only be partly there */
+  old = ring->head;
+  ring_wait(&(ring->head), old, &(ring->consumer_waiting), wait_ms);
+  return (ring->head != old) ? REG_SUCCESS : REG_TIMED_OUT;
+}
+
+/*---------------------------------------------------*/
+
+int Consume_start_data_check_shm(const int index) {
+  shm_info_type        *info = &(shm_info_table.shm_info[index]);
+  shm_ring_header_type *ring;
+  char                  packet[REG_PACKET_SIZE];
+  char                 *pchar;
+  uint32_t              head, tail, skip;
+  size_t                hdr_len = strlen(REG_DATA_HEADER);
+  int                   found = REG_FALSE;
+
+  /* Let go of an emitter that has gone away once we have read
+     everything that it left for us */
+  if(info->ring && check_peer_samples(index) != REG_SUCCESS &&
+     info->ring->head == info->ring->tail) {
+    release_segment_samples(index);
+  }
+
+  if(!info->ring && attach_segment_samples(index) != REG_SUCCESS) {
+    return REG_FAILURE;
+  }
+  ring = info->ring;
+
+  /* Skip anything in front of the start tag - a sample that our
+     predecessor didn't finish reading, for example */
+  tail = ring->tail;
+  while(!found) {
+    head = ring->head;
+    __sync_synchronize();
+    if(head - tail < REG_PACKET_SIZE) break;
+
+    ring_copy_out(info, tail, packet, REG_PACKET_SIZE);
+
+    if(!strncmp(packet, REG_DATA_HEADER, hdr_len)) {
+      found = REG_TRUE;
+      skip = REG_PACKET_SIZE;
+    }
+    else if((pchar = (char*) memchr(&(packet[1]), '<',
+				    REG_PACKET_SIZE - 1))) {
+      /* Keep everything from the next possible tag onwards */
+      skip = (uint32_t) (pchar - packet);
+    }
+    else {
+      skip = REG_PACKET_SIZE;
+    }
+
+    tail += skip;
+    __sync_synchronize();
+    ring->tail = tail;
+    ring_wake(&(ring->tail), &(ring->producer_waiting));
+  }
+
+  if(!found) return REG_FAILURE;
+
+#ifdef REG_DEBUG
+  fprintf(stderr, "STEER: Consume_start_data_check: found start tag in "
+	  "segment %s\n", info->name);
+#endif
+
+  if(IOTypes_table.io_def[index].buffer_max_bytes < REG_IO_BUFSIZE &&
+     Realloc_iotype_buffer(index, REG_IO_BUFSIZE) != REG_SUCCESS) {
+    fprintf(stderr, "STEER: ERROR: Consume_start_data_check: failed "
+	    "to get IO buffer\n");
+    return REG_FAILURE;
+  }
+
+  IOTypes_table.io_def[index].consuming = REG_TRUE;
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+int Consume_data_read_shm(const int index,
+			  const int datatype,
+			  const int num_bytes_to_read,
+			  void*     pData) {
+  void *dest = pData;
+
+  if(!shm_info_table.shm_info[index].ring) {
+    fprintf(stderr, "STEER: ERROR: Consume_data_read_shm: segment is not "
+	    "mapped\n");
+    return REG_FAILURE;
+  }
+
+  if(IOTypes_table.io_def[index].use_xdr ||
+     IOTypes_table.io_def[index].convert_array_order == REG_TRUE) {
+    dest = IOTypes_table.io_def[index].buffer;
+  }
+
+  if(ring_read_samples(index, dest, (size_t) num_bytes_to_read)
+     != REG_SUCCESS) {
+    /* Reset use_xdr flag set as only valid on a per-slice basis */
+    IOTypes_table.io_def[index].use_xdr = REG_FALSE;
+    return REG_FAILURE;
+  }
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param index Index of the IOType
+    @param buffer Buffer of REG_PACKET_SIZE bytes to read into
+    @param tag Tag that the packet must contain
+
+    Read the next packet of a text slice header and check that it is
+    the one we expect */
+static int read_header_packet(const int   index,
+			      char*       buffer,
+			      const char* tag) {
+
+  if(ring_read_samples(index, buffer, REG_PACKET_SIZE) != REG_SUCCESS) {
+    fprintf(stderr, "STEER: Consume_msg_header: read failed for %s\n", tag);
+    return REG_FAILURE;
+  }
+  buffer[REG_PACKET_SIZE - 1] = '\0';
+
+#ifdef REG_DEBUG
+  fprintf(stderr, "STEER: Consume_msg_header: read >%s< from segment\n",
+	  buffer);
+#endif
+
+  if(!strstr(buffer, tag)) {
+    fprintf(stderr, "STEER: Consume_msg_header: expected %s\n", tag);
+    return REG_FAILURE;
+  }
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+int Consume_msg_header_shm(int  index,
+			   int* DataType,
+			   int* Count,
+			   int* NumBytes,
+			   int* IsFortranArray) {
+  char buffer[REG_PACKET_SIZE];
+
+  if(!shm_info_table.shm_info[index].ring) return REG_FAILURE;
+
+  /* Read enough to tell a binary slice header from the first
+     packet of a text one */
+  if(ring_read_samples(index, buffer, REG_SLICE_HDR_SIZE) != REG_SUCCESS) {
+    fprintf(stderr, "STEER: Consume_msg_header: read failed for header\n");
+    return REG_FAILURE;
+  }
+
+  if(Is_binary_slice_header(buffer)) {
+    return Unpack_slice_header(buffer, DataType, Count, NumBytes,
+			       IsFortranArray,
+			       &(IOTypes_table.io_def[index].slice_codec),
+			       &(IOTypes_table.io_def[index].slice_raw_bytes),
+			       &(IOTypes_table.io_def[index].slice_flags));
+  }
+
+  if(ring_read_samples(index, &(buffer[REG_SLICE_HDR_SIZE]),
+		       REG_PACKET_SIZE - REG_SLICE_HDR_SIZE) != REG_SUCCESS) {
+    fprintf(stderr, "STEER: Consume_msg_header: read failed for header\n");
+    return REG_FAILURE;
+  }
+
+  /* Check for end of data */
+  if(!strncmp(buffer, REG_DATA_FOOTER, strlen(REG_DATA_FOOTER))) {
+    return REG_EOD;
+  }
+  else if(strncmp(buffer, BEGIN_SLICE_HEADER, strlen(BEGIN_SLICE_HEADER))) {
+    fprintf(stderr, "STEER: Consume_msg_header: incorrect header on slice\n");
+    return REG_FAILURE;
+  }
+
+  /*--- Type of objects in message ---*/
+
+  if(read_header_packet(index, buffer, "<Data_type>") != REG_SUCCESS) {
+    return REG_FAILURE;
+  }
+  sscanf(buffer, "<Data_type>%d</Data_type>", DataType);
+
+  /*--- No. of objects in message ---*/
+
+  if(read_header_packet(index, buffer, "<Num_objects>") != REG_SUCCESS ||
+     sscanf(buffer, "<Num_objects>%d</Num_objects>", Count) != 1) {
+    return REG_FAILURE;
+  }
+
+  /*--- No. of bytes in message ---*/
+
+  if(read_header_packet(index, buffer, "<Num_bytes>") != REG_SUCCESS ||
+     sscanf(buffer, "<Num_bytes>%d</Num_bytes>", NumBytes) != 1) {
+    return REG_FAILURE;
+  }
+
+  /*--- Array ordering in message ---*/
+
+  if(read_header_packet(index, buffer, "<Array_order>") != REG_SUCCESS) {
+    return REG_FAILURE;
+  }
+  *IsFortranArray = strstr(buffer, "FORTRAN") ? REG_TRUE : REG_FALSE;
+
+  /*--- End of header ---*/
+
+  return read_header_packet(index, buffer, END_SLICE_HEADER);
+}
+
+/*--------------------- Others ----------------------*/
+
+int shm_info_table_init(shm_info_table_type* table,
+			const int max_entries) {
+
+  table->max_entries = max_entries;
+  table->num_used = 0;
+  table->shm_info = (shm_info_type*)
+    calloc(max_entries, sizeof(shm_info_type));
+
+  if(table->shm_info == NULL) {
+    fprintf(stderr, "STEER: shm_info_table_init: failed to allocate memory "
+	    "for shared memory info table\n");
+    return REG_FAILURE;
+  }
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+int shm_name_samples(const int index) {
+  shm_info_type *info = &(shm_info_table.shm_info[index]);
+  char          *prefix;
+  char          *pchar;
+  int            len;
+
+  if(!(prefix = getenv("REG_SHM_PREFIX"))) prefix = REG_SHM_DEFAULT_PREFIX;
+
+  len = snprintf(info->name, REG_MAX_STRING_LENGTH, "/%s%s", prefix,
+		 IOTypes_table.io_def[index].label);
+  if(len >= REG_MAX_STRING_LENGTH) {
+    fprintf(stderr, "STEER: ERROR: shm_name_samples: segment name for "
+	    "IOType %s exceeds %d characters\n",
+	    IOTypes_table.io_def[index].label, REG_MAX_STRING_LENGTH);
+    return REG_FAILURE;
+  }
+
+  /* Remove trailing white space and make the rest safe for a name */
+  trimWhiteSpace(info->name);
+  for(pchar = &(info->name[1]); *pchar; pchar++) {
+    if(*pchar == ' ' || *pchar == '/') *pchar = '_';
+  }
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @return The size of ring to use - REG_SHM_BUFSIZE if it is set,
+    rounded up to a power of two */
+static uint32_t ring_size() {
+  char     *pchar;
+  long      req = REG_SHM_DEFAULT_BUFSIZE;
+  uint32_t  size;
+
+  if((pchar = getenv("REG_SHM_BUFSIZE")) && atol(pchar) > 0) {
+    req = atol(pchar);
+  }
+
+  /* Big enough for a whole text slice header and small enough that
+     the free-running counters can't be confused */
+  if(req < 4096) req = 4096;
+  if(req > (1L << 30)) req = 1L << 30;
+
+  for(size = 4096; size < (uint32_t) req; size <<= 1);
+
+  return size;
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param pid Process id to check
+    @return REG_TRUE if there is such a process */
+static int process_alive(const uint32_t pid) {
+  if(pid == 0) return REG_FALSE;
+
+  /* EPERM means that it's there but isn't ours */
+  return (kill((pid_t) pid, 0) == 0 || errno != ESRCH) ? REG_TRUE : REG_FALSE;
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param word Counter that the other end moves on
+    @param old Value of @p word that we don't want
+    @param waiting Flag to tell the other end that we need waking
+    @param timeout_ms Longest time to sleep (milliseconds)
+
+    Sleep until @p word changes or for @p timeout_ms, whichever is
+    sooner. The flag is raised before @p word is checked for the last
+    time so the other end cannot move it on and miss us going to
+    sleep. */
+static void ring_wait(volatile uint32_t *word, const uint32_t old,
+		      volatile uint32_t *waiting, const int timeout_ms) {
+#if REG_HAS_FUTEX
+  struct timespec timeout;
+
+  timeout.tv_sec = timeout_ms/1000;
+  timeout.tv_nsec = (timeout_ms%1000) * 1000000L;
+#endif
+
+  *waiting = 1;
+  __sync_synchronize();
+
+  if(*word == old) {
+#if REG_HAS_FUTEX
+    syscall(SYS_futex, word, FUTEX_WAIT, old, &timeout, NULL, 0);
+#else
+    usleep(1000);
+#endif
+  }
+
+  *waiting = 0;
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param word Counter that we have just moved on
+    @param waiting Flag raised by the other end if it is asleep
+    @return No. of system calls made
+
+    Wake the other end if it is waiting for @p word to change. */
+static int ring_wake(volatile uint32_t *word, volatile uint32_t *waiting) {
+  __sync_synchronize();
+
+  if(!*waiting) return 0;
+
+#if REG_HAS_FUTEX
+  syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param info Shared memory info of the IOType
+    @param pos Position in the ring (free-running) to start at
+    @param src Data to copy
+    @param len No. of bytes to copy
+
+    Copy into the ring, wrapping round at the end. */
+static void ring_copy_in(shm_info_type *info, const uint32_t pos,
+			 const void *src, const uint32_t len) {
+  uint32_t off = pos & (info->ring->size - 1);
+  uint32_t first = info->ring->size - off;
+
+  if(first > len) first = len;
+  memcpy(&(info->data[off]), src, first);
+  memcpy(info->data, (const char*) src + first, len - first);
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param info Shared memory info of the IOType
+    @param pos Position in the ring (free-running) to start at
+    @param dest Where to copy to
+    @param len No. of bytes to copy
+
+    Copy out of the ring, wrapping round at the end. Doesn't give the
+    space back to the emitter. */
+static void ring_copy_out(shm_info_type *info, const uint32_t pos,
+			  void *dest, const uint32_t len) {
+  uint32_t off = pos & (info->ring->size - 1);
+  uint32_t first = info->ring->size - off;
+
+  if(first > len) first = len;
+  memcpy(dest, &(info->data[off]), first);
+  memcpy((char*) dest + first, info->data, len - first);
+}
+
+/*---------------------------------------------------*/
+
+int create_segment_samples(const int index) {
+  shm_info_type *info = &(shm_info_table.shm_info[index]);
+  uint32_t       size = ring_size();
+  void          *addr;
+  int            fd;
+
+  /* Anything already there is left over from an earlier run */
+  shm_unlink(info->name);
+
+  if((fd = shm_open(info->name, O_CREAT | O_EXCL | O_RDWR,
+		    S_IRUSR | S_IWUSR)) == -1) {
+    fprintf(stderr, "STEER: ERROR: create_segment_samples: failed to "
+	    "create shared memory segment %s: %s\n", info->name,
+	    strerror(errno));
+    return REG_FAILURE;
+  }
+
+  info->map_bytes = sizeof(shm_ring_header_type) + size;
+  if(ftruncate(fd, (off_t) info->map_bytes) == -1 ||
+     (addr = mmap(NULL, info->map_bytes, PROT_READ | PROT_WRITE,
+		  MAP_SHARED, fd, 0)) == MAP_FAILED) {
+    fprintf(stderr, "STEER: ERROR: create_segment_samples: failed to "
+	    "map shared memory segment %s: %s\n", info->name,
+	    strerror(errno));
+    close(fd);
+    shm_unlink(info->name);
+    return REG_FAILURE;
+  }
+  close(fd);
+
+  info->ring = (shm_ring_header_type*) addr;
+  info->data = (char*) addr + sizeof(shm_ring_header_type);
+  info->owner = REG_TRUE;
+  info->consumer_gen = 0;
+  info->ack_seq = 0;
+
+  /* A freshly-truncated segment is zeroed so only the non-zero
+     fields need setting, the magic no. last of all */
+  info->ring->version = REG_SHM_VERSION;
+  info->ring->size = size;
+  info->ring->producer_pid = (uint32_t) getpid();
+  __sync_synchronize();
+  info->ring->magic = REG_SHM_MAGIC;
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+int attach_segment_samples(const int index) {
+  shm_info_type        *info = &(shm_info_table.shm_info[index]);
+  shm_ring_header_type *ring;
+  struct stat           st;
+  void                 *addr;
+  int                   fd;
+
+  /* Not an error - the emitter might not have started yet */
+  if((fd = shm_open(info->name, O_RDWR, 0)) == -1) return REG_FAILURE;
+
+  if(fstat(fd, &st) == -1 ||
+     (size_t) st.st_size <= sizeof(shm_ring_header_type) ||
+     (addr = mmap(NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE,
+		  MAP_SHARED, fd, 0)) == MAP_FAILED) {
+    close(fd);
+    return REG_FAILURE;
+  }
+  close(fd);
+
+  ring = (shm_ring_header_type*) addr;
+  __sync_synchronize();
+  if(ring->magic != REG_SHM_MAGIC || ring->version != REG_SHM_VERSION ||
+     sizeof(shm_ring_header_type) + ring->size > (size_t) st.st_size ||
+     ring->closed || !process_alive(ring->producer_pid)) {
+    munmap(addr, (size_t) st.st_size);
+    return REG_FAILURE;
+  }
+
+  if(ring->consumer_pid != (uint32_t) getpid() &&
+     process_alive(ring->consumer_pid)) {
+    fprintf(stderr, "STEER: ERROR: attach_segment_samples: shared memory "
+	    "segment %s already has a consumer (pid %u)\n", info->name,
+	    (unsigned int) ring->consumer_pid);
+    munmap(addr, (size_t) st.st_size);
+    return REG_FAILURE;
+  }
+
+  info->ring = ring;
+  info->data = (char*) addr + sizeof(shm_ring_header_type);
+  info->map_bytes = (size_t) st.st_size;
+  info->owner = REG_FALSE;
+
+  /* Start from whatever the emitter writes next and then tell it
+     that we're here - it looks at consumer_pid first */
+  ring->tail = ring->head;
+  __sync_synchronize();
+  ring->consumer_gen++;
+  __sync_synchronize();
+  ring->consumer_pid = (uint32_t) getpid();
+  ring_wake(&(ring->consumer_gen), &(ring->producer_waiting));
+
+  /* Anything we held for decoding deltas came from someone else */
+  IOTypes_table.io_def[index].delta_key_needed = REG_TRUE;
+
+#ifdef REG_DEBUG
+  fprintf(stderr, "STEER: attach_segment_samples: attached to %s\n",
+	  info->name);
+#endif
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+void release_segment_samples(const int index) {
+  shm_info_type        *info = &(shm_info_table.shm_info[index]);
+  shm_ring_header_type *ring = info->ring;
+
+  if(!ring) return;
+
+  if(info->owner) {
+    /* Wake a waiting consumer so that it sees we've gone */
+    ring->closed = 1;
+    ring_wake(&(ring->head), &(ring->consumer_waiting));
+    munmap((void*) ring, info->map_bytes);
+    shm_unlink(info->name);
+  }
+  else {
+    if(ring->consumer_pid == (uint32_t) getpid()) ring->consumer_pid = 0;
+    ring_wake(&(ring->tail), &(ring->producer_waiting));
+    munmap((void*) ring, info->map_bytes);
+  }
+
+  info->ring = NULL;
+  info->data = NULL;
+  info->map_bytes = 0;
+}
+
+/*---------------------------------------------------*/
+
+int check_peer_samples(const int index) {
+  shm_info_type        *info = &(shm_info_table.shm_info[index]);
+  shm_ring_header_type *ring = info->ring;
+  IOdef_entry          *io = &(IOTypes_table.io_def[index]);
+  uint32_t              pid, gen;
+
+  if(!ring) return REG_FAILURE;
+
+  if(!info->owner) {
+    if(ring->closed || !process_alive(ring->producer_pid)) {
+      return REG_FAILURE;
+    }
+    return REG_SUCCESS;
+  }
+
+  pid = ring->consumer_pid;
+  __sync_synchronize();
+  if(!process_alive(pid)) return REG_FAILURE;
+
+  /* New consumer so renegotiate the slice header version and data
+     format - it hasn't sent us an ack yet */
+  gen = ring->consumer_gen;
+  if(gen != info->consumer_gen) {
+    info->consumer_gen = gen;
+    info->ack_seq = ring->ack_seq;
+    io->ack_needed = REG_FALSE;
+    Set_peer_capabilities(io, NULL);
+  }
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+int ring_write_samples(const int index, const int num_bufs,
+		       void** bufs, const size_t* num_bytes,
+		       const int block) {
+  shm_info_type        *info = &(shm_info_table.shm_info[index]);
+  shm_ring_header_type *ring = info->ring;
+  uint32_t              head, tail, space, len;
+  size_t                total = 0;
+  size_t                left;
+  char                 *pbuf;
+  int                   i;
+
+  if(!ring || ring->consumer_pid == 0) return REG_FAILURE;
+
+  head = ring->head;
+
+  if(!block) {
+    for(i = 0; i < num_bufs; i++) total += num_bytes[i];
+    if(total > ring->size - (head - ring->tail)) return REG_FAILURE;
+  }
+
+  for(i = 0; i < num_bufs; i++) {
+    pbuf = (char*) bufs[i];
+    left = num_bytes[i];
+
+    while(left > 0) {
+      tail = ring->tail;
+      __sync_synchronize();
+      space = ring->size - (head - tail);
+
+      if(space == 0) {
+	/* Let the consumer have what we've got so far and wait for it
+	   to make room */
+	__sync_synchronize();
+	ring->head = head;
+	info->num_syscalls += ring_wake(&(ring->head),
+					&(ring->consumer_waiting));
+
+	if(!process_alive(ring->consumer_pid)) {
+	  fprintf(stderr, "STEER: Emit_data: consumer has gone away\n");
+	  return REG_FAILURE;
+	}
+	ring_wait(&(ring->tail), tail, &(ring->producer_waiting),
+		  REG_SHM_WAIT_MS);
+	info->num_syscalls++;
+	continue;
+      }
+
+      len = (left < space) ? (uint32_t) left : space;
+      ring_copy_in(info, head, pbuf, len);
+
+      head += len;
+      pbuf += len;
+      left -= len;
+    }
+  }
+
+  /* Publish the data and only then wake the consumer */
+  __sync_synchronize();
+  ring->head = head;
+  info->num_syscalls += ring_wake(&(ring->head), &(ring->consumer_waiting));
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+int ring_read_samples(const int index, void* buf, const size_t num_bytes) {
+  shm_info_type        *info = &(shm_info_table.shm_info[index]);
+  shm_ring_header_type *ring = info->ring;
+  uint32_t              head, tail, avail, len;
+  size_t                left = num_bytes;
+  char                 *pbuf = (char*) buf;
+
+  if(!ring) return REG_FAILURE;
+
+  tail = ring->tail;
+
+  while(left > 0) {
+    head = ring->head;
+    __sync_synchronize();
+    avail = head - tail;
+
+    if(avail == 0) {
+      if(ring->closed || !process_alive(ring->producer_pid)) {
+	fprintf(stderr, "STEER: INFO: Consume_data_read: hung up!\n");
+	return REG_FAILURE;
+      }
+      ring_wait(&(ring->head), head, &(ring->consumer_waiting),
+		REG_SHM_WAIT_MS);
+      continue;
+    }
+
+    len = (left < avail) ? (uint32_t) left : avail;
+    ring_copy_out(info, tail, pbuf, len);
+
+    tail += len;
+    pbuf += len;
+    left -= len;
+
+    /* Finished with these bytes so give them back to the emitter */
+    __sync_synchronize();
+    ring->tail = tail;
+    ring_wake(&(ring->tail), &(ring->producer_waiting));
+  }
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
@@ -93,6 +93,7 @@ int Samples_transport_function_map() {
   Emit_data_non_blocking_impl = Emit_data_non_blocking_sockets;
   Emit_header_impl = Emit_header_sockets;
   Emit_data_impl = Emit_data_sockets;
+  Emit_data_batch_impl = Emit_data_batch_sockets;
   Consume_msg_header_impl = Consume_msg_header_sockets;
   Emit_msg_header_impl = Emit_msg_header_sockets;
   Consume_start_data_check_impl = Consume_start_data_check_sockets;
@@ -103,6 +104,9 @@ int Samples_transport_function_map() {
   Emit_start_impl = Emit_start_sockets;
   Emit_stop_impl = Emit_stop_sockets;
   Consume_stop_impl = Consume_stop_sockets;
+  Wait_for_IOType_impl = Wait_for_IOType_sockets;
+  Consume_data_map_impl = Consume_data_map_sockets;
+  Consume_seek_slice_impl = Consume_seek_slice_sockets;
 
   return REG_SUCCESS;
 }
@@ -293,41 +297,51 @@ int Get_communication_status_sockets(const int index) {
 int Emit_data_non_blocking_sockets(const int index, const int size,
 				   void* buffer) {
 
-  struct timeval timeout;
-  int connector = socket_info_table.socket_info[index].connector_handle;
-  fd_set sock;
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
+  int num_active = 0;
+  int i = 0;
 
-  timeout.tv_sec  = 0;
-  timeout.tv_usec = 0;
-
-  FD_ZERO(&sock);
-  FD_SET(connector, &sock);
-
-  if(select(connector + 1, NULL, &sock, NULL, &timeout) == -1) {
-    perror("select");
-    return REG_FAILURE;
+  /* Don't write to a consumer that has gone - the reactor has already
+     looked at this socket so this doesn't usually cost a system call */
+  if(!sock_info->sinks) {
+    if(reactor_events(sock_info->connector_handle) & REG_REACTOR_HUP) {
+      return REG_FAILURE;
+    }
   }
-
-  /* are we free to write? */
-  if(FD_ISSET(connector, &sock)) {
-    return Emit_data_sockets(index, size, buffer);
+  else {
+    while(i < sock_info->num_sinks) {
+      if(sock_info->sinks[i].active == REG_FALSE) {
+	i++;
+	continue;
+      }
+      if(reactor_events(sock_info->sinks[i].handle) & REG_REACTOR_HUP) {
+	drop_sink_samples(index, i);
+	continue;
+      }
+      num_active++;
+      i++;
+    }
+    if(num_active == 0) return REG_FAILURE;
   }
 
-  return REG_FAILURE;
+  return Emit_data_sockets(index, size, buffer);
 }
 
 /*---------------------------------------------------*/
 
 int Emit_header_sockets(const int index) {
 
-  char buffer[REG_PACKET_SIZE];
-  int status;
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
 
-  /* check if socket connection has been made */
-  if(socket_info_table.socket_info[index].comms_status !=
-     REG_COMMS_STATUS_CONNECTED) {
+  /* check if socket connection has been made, or if there is room
+     for another consumer whether anyone else is trying to connect */
+  if(sock_info->comms_status != REG_COMMS_STATUS_CONNECTED) {
     attempt_listener_connect_samples(index);
   }
+  else if(sock_info->num_sinks <
+	  IOTypes_table.io_def[index].max_consumers) {
+    poll_socket_samples(index);
+  }
 
   /* now are we connected? */
   if(socket_info_table.socket_info[index].comms_status ==
@@ -336,45 +350,31 @@ int Emit_header_sockets(const int index) {
     fprintf(stderr, "STEER: Emit_header: socket status is connected, index = %d\n", index );
 #endif
 
-    /* send header */
-    snprintf(buffer, REG_PACKET_SIZE, REG_PACKET_FORMAT, REG_DATA_HEADER);
-
+    /* send header - each consumer is sent its own (it says whether
+       parallel streams are in use) and it is held back to go out
+       with the first slice */
+    start_gather_samples(index);
+    if(start_sinks_samples(index) == REG_SUCCESS) {
 #ifdef REG_DEBUG
-    fprintf(stderr, "STEER: Emit_header: Sending >>%s<<\n", buffer);
-#endif
-    status = Emit_data_non_blocking_sockets(index, REG_PACKET_SIZE,
-					 (void*) buffer);
-
-    if(status == REG_SUCCESS) {
-#ifdef REG_DEBUG
-      fprintf(stderr, "STEER: Emit_header: Sent %d bytes\n", REG_PACKET_SIZE);
+      fprintf(stderr, "STEER: Emit_header: Sending >>%s<<\n",
+	      sock_info->sinks[0].header);
 #endif
       return REG_SUCCESS;
     }
-    else if(status == REG_FAILURE) {
-#ifdef REG_DEBUG
-      fprintf(stderr, "STEER: Emit_header: Write failed - "
-	      "immediate retry connect\n");
-#endif
-      retry_accept_connect_samples(index);
 
-      if(socket_info_table.socket_info[index].comms_status ==
-	 REG_COMMS_STATUS_CONNECTED) {
 #ifdef REG_DEBUG
-	fprintf(stderr, "STEER: Emit_header: Sending >>%s<<\n", buffer);
+    fprintf(stderr, "STEER: Emit_header: Write failed - "
+	    "immediate retry connect\n");
 #endif
-	if(Emit_data_sockets(index, REG_PACKET_SIZE,
-			  (void*) buffer) == REG_SUCCESS) {
-	  return REG_SUCCESS;
-	}
+    retry_accept_connect_samples(index);
+
+    if(socket_info_table.socket_info[index].comms_status ==
+       REG_COMMS_STATUS_CONNECTED) {
+      start_gather_samples(index);
+      if(start_sinks_samples(index) == REG_SUCCESS) {
+	return REG_SUCCESS;
       }
     }
-#ifdef REG_DEBUG
-    else{
-      fprintf(stderr, "STEER: Emit_header: attempt to write to "
-	      "socket timed out\n");
-    }
-#endif
   }
 #ifdef REG_DEBUG
   else {
@@ -391,10 +391,7 @@ int Emit_data_sockets(const int    index,
 		      const size_t num_bytes_to_send,
 		      void*        pData)
 {
-  int bytes_left;
-  int result;
-  char* pchar;
-  int connector = socket_info_table.socket_info[index].connector_handle;
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
 
   if(num_bytes_to_send < 0) {
     fprintf(stderr, "STEER: Emit_data: requested to write < 0 bytes!\n");
@@ -405,29 +402,23 @@ int Emit_data_sockets(const int    index,
     return REG_SUCCESS;
   }
 
-  bytes_left = num_bytes_to_send;
-  pchar = (char*) pData;
-
+  /* Part-way through a sample, small messages are held back until
+     there is a large one to go with them */
+  if(sock_info->gathering &&
+     gather_data(sock_info, pData, num_bytes_to_send) == REG_SUCCESS) {
 #ifdef REG_DEBUG
-  fprintf(stderr, "STEER: Emit_data: writing...\n");
+    fprintf(stderr, "STEER: Emit_data: gathered %d bytes...\n",
+	    (int) num_bytes_to_send);
 #endif
-  while(bytes_left > 0) {
-    result = send_no_signal(connector, pchar, bytes_left, 0);
-    if(result == REG_SOCKETS_ERROR) {
-      perror("send");
-      return REG_FAILURE;
-    }
-    else {
-      bytes_left -= result;
-      pchar += result;
-    }
+    return REG_SUCCESS;
   }
 
-  if(bytes_left > 0) {
 #ifdef REG_DEBUG
-    fprintf(stderr, "STEER: Emit_data: timed-out trying to write data\n");
+  fprintf(stderr, "STEER: Emit_data: writing...\n");
 #endif
-    return REG_TIMED_OUT;
+  if(send_sinks_samples(index, 1, &pData, &num_bytes_to_send,
+			 sock_info->gathering) != REG_SUCCESS) {
+    return REG_FAILURE;
   }
 
 #ifdef REG_DEBUG
@@ -440,11 +431,45 @@ int Emit_data_sockets(const int    index,
 
 /*---------------------------------------------------*/
 
+int Emit_data_batch_sockets(const int     index,
+			    const int     num_bufs,
+			    void**        bufs,
+			    const size_t* num_bytes) {
+
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
+  size_t total = 0;
+  int    i;
+
+  for(i = 0; i < num_bufs; i++) {
+    total += num_bytes[i];
+  }
+
+  /* A small batch can wait for the rest of the sample */
+  if(sock_info->gathering &&
+     total <= (size_t) (REG_GATHER_BUFSIZE - sock_info->gather_bytes)) {
+    for(i = 0; i < num_bufs; i++) {
+      if(gather_data(sock_info, bufs[i], num_bytes[i]) != REG_SUCCESS) {
+	return REG_FAILURE;
+      }
+    }
+    return REG_SUCCESS;
+  }
+
+  return send_sinks_samples(index, num_bufs, bufs, num_bytes,
+			    sock_info->gathering);
+}
+
+/*---------------------------------------------------*/
+
 int Emit_ack_sockets(const int index){
 
-  /* Send a 16-byte acknowledgement message */
-  char *ack_msg = "<ACK/>          ";
-  return Emit_data_sockets(index, strlen(ack_msg), (void*)ack_msg);
+  /* Send a 16-byte acknowledgement message, followed by the region
+     that we want if the emitter can cut arrays down */
+  char ack_msg[REG_ACK_MAX_SIZE + 1];
+  int  len;
+
+  len = Get_ack_msg(&(IOTypes_table.io_def[index]), ack_msg);
+  return Emit_data_sockets(index, len, (void*)ack_msg);
 }
 
 /*---------------------------------------------------*/
@@ -483,6 +508,233 @@ int Emit_msg_header_sockets(const int index,
 
 /*--------------------- Others ----------------------*/
 
+int flush_gather_samples(const int index) {
+  return send_sinks_samples(index, 0, NULL, NULL, REG_FALSE);
+}
+
+/*---------------------------------------------------*/
+
+int start_sinks_samples(const int index) {
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
+  IOdef_entry      *io = &(IOTypes_table.io_def[index]);
+  sink_info_type   *sink;
+  char              text[REG_PACKET_SIZE];
+  int               num_active = 0;
+  int               num_striped = 0;
+  int               i = 0;
+
+  if(io->num_streams > 1) accept_stripes_samples(index);
+
+  /* Don't write to a consumer that has gone - the reactor has already
+     looked at this socket so this doesn't usually cost a system call */
+  while(i < sock_info->num_sinks) {
+    sink = &(sock_info->sinks[i]);
+    if(sink->active == REG_FALSE) {
+      i++;
+      continue;
+    }
+    if(reactor_events(sink->handle) & REG_REACTOR_HUP) {
+      drop_sink_samples(index, i);
+      continue;
+    }
+    num_active++;
+    if(sink->stripes.num > 0 &&
+       sink->stripes.num_connected == sink->stripes.num) {
+      num_striped++;
+    }
+    i++;
+  }
+  if(num_active == 0) return REG_FAILURE;
+
+  /* The data of large slices only goes over parallel streams if
+     every consumer being sent this sample has them */
+  io->stripe_slices = (io->num_streams > 1 && num_striped == num_active &&
+		       io->slice_hdr_version >= REG_SLICE_HDR_DELTA_VERSION);
+
+  for(i = 0; i < sock_info->num_sinks; i++) {
+    sink = &(sock_info->sinks[i]);
+    if(sink->active == REG_FALSE) continue;
+
+    /* Offer parallel streams, and say how much has gone over them so
+       that a consumer that didn't finish reading a sample can catch
+       up */
+    if(io->num_streams > 1 && sock_info->stripe_listener != -1) {
+      snprintf(text, REG_PACKET_SIZE,
+	       "%s <Stripes port=%d n=%d use=%d at=%llu/>", REG_DATA_HEADER,
+	       sock_info->stripe_port, io->num_streams,
+	       io->stripe_slices ? sink->stripes.num : 0,
+	       (unsigned long long) sink->stripes.total);
+    }
+    else {
+      snprintf(text, REG_PACKET_SIZE, "%s", REG_DATA_HEADER);
+    }
+    snprintf(sink->header, REG_PACKET_SIZE, REG_PACKET_FORMAT, text);
+    sink->header_pending = REG_TRUE;
+
+    /* Consumers that can find their way through a sample by the
+       lengths of its frames are sent it in frames */
+    sink->framed = (sink->slice_hdr_version >= REG_SLICE_HDR_FRAME_VERSION);
+  }
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param index Index of the IOType to which socket belongs
+    @param handle Handle of a parallel stream whose first packet has
+    arrived in full
+    @return REG_SUCCESS, REG_FAILURE
+
+    Reads the packet with which a parallel stream starts, saying which
+    consumer it belongs to and where it goes in the set, and adds the
+    stream to that consumer's set */
+static int join_stripe_samples(const int index, const int handle) {
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
+  stripe_info_type *stripes;
+  char              hello[REG_PACKET_SIZE + 1];
+  char              host[NI_MAXHOST];
+  char              sink_host[NI_MAXHOST];
+  int               port, sink_port;
+  int               stripe, num;
+  int               j;
+
+  memset(hello, '\0', REG_PACKET_SIZE + 1);
+  if(recv_wait_all(handle, hello, REG_PACKET_SIZE, 0) != REG_PACKET_SIZE ||
+     sscanf(hello, "<ReG_stripe port=%d index=%d of=%d/>",
+	    &port, &stripe, &num) != 3 ||
+     num < 2 || num > REG_MAX_STREAMS || stripe < 0 || stripe >= num ||
+     get_socket_address(handle, REG_TRUE, host, &j) != REG_SUCCESS) {
+    fprintf(stderr, "STEER: ERROR: accept_stripes: bad parallel "
+	    "stream connection\n");
+    return REG_FAILURE;
+  }
+
+  stripes = NULL;
+  for(j = 0; j < sock_info->num_sinks; j++) {
+    if(get_socket_address(sock_info->sinks[j].handle, REG_TRUE,
+			  sink_host, &sink_port) == REG_SUCCESS &&
+       sink_port == port && !strcmp(host, sink_host)) {
+      stripes = &(sock_info->sinks[j].stripes);
+      break;
+    }
+  }
+  if(!stripes) {
+    fprintf(stderr, "STEER: ERROR: accept_stripes: parallel stream "
+	    "from %s belongs to no consumer\n", host);
+    return REG_FAILURE;
+  }
+
+  /* A new set replaces any that the consumer had before */
+  if(stripes->num != num || stripes->handles[stripe] != -1) {
+    close_stripes(stripes);
+    stripes->num = num;
+    for(j = 0; j < num; j++) {
+      stripes->handles[j] = -1;
+    }
+  }
+  stripes->handles[stripe] = handle;
+  stripes->num_connected++;
+  limit_sink_send_samples(index, handle);
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+void accept_stripes_samples(const int index) {
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
+  stripe_info_type *stripes;
+  char              buf[REG_PACKET_SIZE];
+  ssize_t           nbytes;
+  int               handle;
+  int               status;
+  int               i, j;
+
+  /* Somewhere for consumers to connect their streams to, from the
+     same range of ports as the main listener */
+  if(sock_info->stripe_listener == -1) {
+    sock_info->stripe_listener = listen_in_range(sock_info->tcp_interface,
+						 sock_info->min_port_in,
+						 sock_info->max_port_in,
+						 &(sock_info->stripe_port));
+    if(sock_info->stripe_listener == REG_SOCKETS_ERROR) {
+      fprintf(stderr, "STEER: ERROR: accept_stripes: failed to listen "
+	      "for parallel streams\n");
+      sock_info->stripe_listener = -1;
+      return;
+    }
+#ifdef REG_DEBUG
+    fprintf(stderr, "STEER: accept_stripes: listening for parallel "
+	    "streams on port %d\n", sock_info->stripe_port);
+#endif
+  }
+
+  /* Give up on streams that a consumer has closed */
+  for(i = 0; i < sock_info->num_sinks; i++) {
+    stripes = &(sock_info->sinks[i].stripes);
+    for(j = 0; j < stripes->num; j++) {
+      if(stripes->handles[j] != -1 &&
+	 (reactor_events(stripes->handles[j]) & REG_REACTOR_HUP)) {
+	close_stripes(stripes);
+	break;
+      }
+    }
+  }
+
+  /* Accept new ones while there is room to keep them until they say
+     who they are */
+  for(i = 0; i < REG_MAX_STREAMS; i++) {
+    if(sock_info->stripe_pending[i] != -1) continue;
+    if(!(reactor_events(sock_info->stripe_listener) & REG_REACTOR_READ)) {
+      break;
+    }
+
+    handle = accept(sock_info->stripe_listener, NULL, NULL);
+    if(handle == REG_SOCKETS_ERROR) {
+      perror("accept");
+      break;
+    }
+    sock_info->stripe_pending[i] = handle;
+    sock_info->stripe_pending_since[i] = time(NULL);
+  }
+
+  /* Each stream starts with a packet saying which consumer it belongs
+     to.  Only read it once it has all arrived so that a slow or bogus
+     connection doesn't hold up the sample */
+  for(i = 0; i < REG_MAX_STREAMS; i++) {
+    if((handle = sock_info->stripe_pending[i]) == -1) continue;
+
+    status = REG_NOT_READY;
+    if(reactor_events(handle) & REG_REACTOR_READ) {
+      nbytes = recv_non_block(handle, buf, REG_PACKET_SIZE, MSG_PEEK);
+      if(nbytes == REG_PACKET_SIZE) {
+	status = join_stripe_samples(index, handle);
+      }
+      else if(nbytes == 0 || (nbytes < 0 && errno != EAGAIN)) {
+	status = REG_FAILURE;
+      }
+    }
+    if(status == REG_NOT_READY &&
+       time(NULL) - sock_info->stripe_pending_since[i] >
+       REG_CONSUMER_SEND_TIMEOUT) {
+      fprintf(stderr, "STEER: ERROR: accept_stripes: parallel stream "
+	      "did not say which consumer it belongs to\n");
+      status = REG_FAILURE;
+    }
+
+    if(status == REG_NOT_READY) continue;
+    if(status != REG_SUCCESS) {
+      reactor_remove(handle);
+      closesocket(handle);
+    }
+    sock_info->stripe_pending[i] = -1;
+  }
+}
+
+/*---------------------------------------------------*/
+
 int create_connector_samples(const int index) {
 
   int i;
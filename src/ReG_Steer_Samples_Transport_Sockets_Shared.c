@@ -60,6 +60,240 @@
 
 /*---------------------- API ------------------------*/
 
+/** @internal
+    @param sock_info Socket information of the IOType
+    @param buf The REG_FRAME_HDR_SIZE bytes of a frame header
+    @return REG_SUCCESS or REG_FAILURE if @p buf is not a frame header
+
+    Start reading the frame that @p buf is the header of. */
+static int start_frame_samples(socket_info_type *sock_info, const char *buf)
+{
+  uint64_t     num_bytes;
+  unsigned int seqnum;
+  unsigned int checksum;
+  int          flags;
+
+  if(unpack_frame_header(buf, &flags, &seqnum, &num_bytes,
+			 &checksum) != REG_SUCCESS) {
+    return REG_FAILURE;
+  }
+
+  sock_info->frame_flags = flags;
+  sock_info->frame_seq = seqnum;
+  sock_info->frame_left = num_bytes;
+  sock_info->frame_check = checksum;
+  sock_info->frame_sum = frame_checksum(0, NULL, 0);
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param index Index of the IOType
+    @param buf Buffer to read into
+    @param len No. of bytes to read
+    @return @p len, zero if the emitter has hung up or -1 if
+    something went wrong
+
+    Blocking read of the next @p len bytes of the sample being
+    consumed.  If it came in frames then their headers are stepped
+    over and checksums checked on the way. */
+static ssize_t recv_sample_samples(const int index, void *buf,
+				   const size_t len)
+{
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
+  char              header[REG_FRAME_HDR_SIZE];
+  char             *pbuf = (char*) buf;
+  unsigned int      seqnum;
+  size_t            got = 0;
+  size_t            want;
+  ssize_t           nbytes;
+
+  if(sock_info->framed == REG_FALSE) {
+    return recv_wait_all(sock_info->connector_handle, buf, len, 0);
+  }
+
+  /* The rest of this sample isn't coming */
+  if(sock_info->frame_restart == REG_TRUE) return -1;
+
+  while(got < len) {
+    if(sock_info->frame_left == 0) {
+      seqnum = sock_info->frame_seq;
+      if(sock_info->frame_flags & REG_FRAME_FLAG_END) {
+	fprintf(stderr, "STEER: ERROR: recv_sample: tried to read past "
+		"the end of sample %u\n", seqnum);
+	return -1;
+      }
+
+      if((nbytes = recv_wait_all(sock_info->connector_handle, header,
+				 REG_FRAME_HDR_SIZE, 0)) !=
+	 REG_FRAME_HDR_SIZE) {
+	return (nbytes < 0) ? nbytes : 0;
+      }
+
+      if(start_frame_samples(sock_info, header) != REG_SUCCESS) {
+	fprintf(stderr, "STEER: ERROR: recv_sample: lost track of the "
+		"frames of sample %u\n", seqnum);
+	sock_info->framed = REG_FALSE;
+	return -1;
+      }
+
+      if(sock_info->frame_flags & REG_FRAME_FLAG_START) {
+	/* The emitter gave up on the sample part-way through and this
+	   is the start of the next one */
+	fprintf(stderr, "STEER: ERROR: recv_sample: sample %u was cut "
+		"short\n", seqnum);
+	sock_info->frame_restart = REG_TRUE;
+	return -1;
+      }
+      continue;
+    }
+
+    want = len - got;
+    if((uint64_t) want > sock_info->frame_left) {
+      want = (size_t) sock_info->frame_left;
+    }
+
+    if((nbytes = recv_wait_all(sock_info->connector_handle, &(pbuf[got]),
+			       want, 0)) != (ssize_t) want) {
+      return (nbytes < 0) ? nbytes : 0;
+    }
+    if(sock_info->frame_flags & REG_FRAME_FLAG_CHECKSUM) {
+      sock_info->frame_sum = frame_checksum(sock_info->frame_sum,
+					    &(pbuf[got]), want);
+    }
+    got += want;
+    sock_info->frame_left -= (uint64_t) want;
+
+    if(sock_info->frame_left == 0 &&
+       (sock_info->frame_flags & REG_FRAME_FLAG_CHECKSUM) &&
+       sock_info->frame_sum != sock_info->frame_check) {
+      fprintf(stderr, "STEER: ERROR: recv_sample: checksum of a frame "
+	      "of sample %u does not match\n", sock_info->frame_seq);
+      sock_info->frame_bad = REG_TRUE;
+      return -1;
+    }
+  }
+
+  return (ssize_t) got;
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param buf Bytes to search
+    @param len No. of bytes in @p buf
+    @return Offset of the first place after the start of @p buf that
+    a frame header or a data header could start, or @p len if there
+    is none
+
+    A data header or frame header cut off by the end of @p buf counts
+    as one that could start there. */
+static size_t find_sample_start(const char *buf, const size_t len)
+{
+  const char *tags[2] = {REG_FRAME_HDR_MAGIC, REG_DATA_HEADER};
+  size_t      tag_len;
+  size_t      i;
+  int         j;
+
+  for(i = 1; i < len; i++) {
+    for(j = 0; j < 2; j++) {
+      tag_len = strlen(tags[j]);
+      if(tag_len > len - i) tag_len = len - i;
+      if(!memcmp(&(buf[i]), tags[j], tag_len)) return i;
+    }
+  }
+
+  return len;
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param index Index of the IOType
+    @return REG_SUCCESS once the next bytes to be read are the data
+    header of a sample, REG_NOT_READY if we have to wait for more,
+    REG_FAILURE if the connection has failed
+
+    Without blocking, find the start of the next sample.  Whatever is
+    left of a sample that came in frames (and of any that its emitter
+    gave up on) is skipped by the lengths of its frames.  Otherwise,
+    or if we have lost track of the frames, bytes are thrown away
+    until there is a frame header or a data header. */
+static int next_sample_samples(const int index)
+{
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
+  char              buf[REG_PACKET_SIZE];
+  char              junk[REG_GATHER_BUFSIZE];
+  size_t            len;
+  ssize_t           nbytes;
+
+  /* We've already read the first frame of this one */
+  if(sock_info->frame_restart == REG_TRUE) {
+    sock_info->frame_restart = REG_FALSE;
+    return REG_SUCCESS;
+  }
+
+  while(1) {
+    if(sock_info->framed == REG_TRUE && sock_info->frame_left > 0) {
+      len = ((uint64_t) sizeof(junk) < sock_info->frame_left) ?
+	sizeof(junk) : (size_t) sock_info->frame_left;
+    }
+    else {
+      /* Look before we leap - nothing is read until we know what it
+	 is */
+      if((nbytes = recv_non_block(sock_info->connector_handle, buf,
+				  REG_PACKET_SIZE, MSG_PEEK)) <= 0) {
+	return (nbytes < 0 && errno == EAGAIN) ? REG_NOT_READY :
+	  REG_FAILURE;
+      }
+
+      /* Enough to tell what it is? */
+      if(nbytes < REG_FRAME_HDR_SIZE) return REG_NOT_READY;
+
+      if(start_frame_samples(sock_info, buf) == REG_SUCCESS) {
+	if(recv_wait_all(sock_info->connector_handle, buf,
+			 REG_FRAME_HDR_SIZE, 0) != REG_FRAME_HDR_SIZE) {
+	  return REG_FAILURE;
+	}
+	sock_info->framed = REG_TRUE;
+	if(sock_info->frame_flags & REG_FRAME_FLAG_START) return REG_SUCCESS;
+
+#ifdef REG_DEBUG
+	fprintf(stderr, "STEER: next_sample: skipping frame of %lu bytes "
+		"of sample %u\n", (unsigned long) sock_info->frame_left,
+		sock_info->frame_seq);
+#endif
+	continue;
+      }
+
+      if(!strncmp(buf, REG_DATA_HEADER, strlen(REG_DATA_HEADER))) {
+	sock_info->framed = REG_FALSE;
+	return REG_SUCCESS;
+      }
+
+      if(sock_info->framed == REG_TRUE) {
+	fprintf(stderr, "STEER: ERROR: next_sample: lost track of frames "
+		"after sample %u, looking for the next sample\n",
+		sock_info->frame_seq);
+	sock_info->framed = REG_FALSE;
+      }
+      len = find_sample_start(buf, (size_t) nbytes);
+    }
+
+    if((nbytes = recv_non_block(sock_info->connector_handle, junk,
+				len, 0)) <= 0) {
+      return (nbytes < 0 && errno == EAGAIN) ? REG_NOT_READY : REG_FAILURE;
+    }
+    if(sock_info->framed == REG_TRUE) {
+      sock_info->frame_left -= (uint64_t) nbytes;
+    }
+  }
+}
+
+/*---------------------------------------------------*/
+
 REG_DEFINE_FUNC(int, Consume_msg_header, (int index, int* datatype, int* count, int* num_bytes, int* is_fortran_array))
 {
 
@@ -76,9 +310,35 @@ REG_DEFINE_FUNC(int, Consume_msg_header, (int index, int* datatype, int* count,
   fprintf(stderr, "STEER: Consume_msg_header: calling recv...\n");
 #endif
 
-  /* Blocks until REG_PACKET_SIZE bytes received */
-  if((nbytes = recv_wait_all(sock_info->connector_handle, buffer,
-			     REG_PACKET_SIZE, 0)) <= 0) {
+  /* Blocks until REG_SLICE_HDR_SIZE bytes received - enough to tell
+     a binary slice header from the first packet of a text one */
+  if((nbytes = recv_sample_samples(index, buffer,
+				   REG_SLICE_HDR_SIZE)) <= 0) {
+    if(nbytes < 0) {
+      /* error */
+      perror("recv");
+    }
+#ifdef REG_DEBUG
+    else {
+      /* closed connection */
+      fprintf(stderr, "STEER: Consume_msg_header: hung up!\n");
+    }
+#endif
+
+    return REG_FAILURE;
+  }
+
+  if(Is_binary_slice_header(buffer)) {
+    return Unpack_slice_header(buffer, datatype, count, num_bytes,
+			       is_fortran_array,
+			       &(IOTypes_table.io_def[index].slice_codec),
+			       &(IOTypes_table.io_def[index].slice_raw_bytes),
+			       &(IOTypes_table.io_def[index].slice_flags));
+  }
+
+  /* Text header so get the rest of the first packet */
+  if((nbytes = recv_sample_samples(index, &(buffer[REG_SLICE_HDR_SIZE]),
+				   REG_PACKET_SIZE - REG_SLICE_HDR_SIZE)) <= 0) {
     if(nbytes < 0) {
       /* error */
       perror("recv");
@@ -110,8 +370,8 @@ REG_DEFINE_FUNC(int, Consume_msg_header, (int index, int* datatype, int* count,
   }
 
   /*--- Type of objects in message ---*/
-  if((nbytes = recv_wait_all(sock_info->connector_handle, buffer,
-			     REG_PACKET_SIZE, 0)) <= 0) {
+  if((nbytes = recv_sample_samples(index, buffer,
+				   REG_PACKET_SIZE)) <= 0) {
     if(nbytes == 0) {
       /* closed connection */
       fprintf(stderr, "STEER: Consume_msg_header: hung up!\n");
@@ -136,8 +396,8 @@ REG_DEFINE_FUNC(int, Consume_msg_header, (int index, int* datatype, int* count,
   sscanf(buffer, "<Data_type>%d</Data_type>", datatype);
 
   /*--- No. of objects in message ---*/
-  if((nbytes = recv_wait_all(sock_info->connector_handle, buffer,
-			     REG_PACKET_SIZE, 0)) <= 0) {
+  if((nbytes = recv_sample_samples(index, buffer,
+				   REG_PACKET_SIZE)) <= 0) {
     if(nbytes == 0) {
       /* closed connection */
       fprintf(stderr, "STEER: Consume_msg_header: hung up!\n");
@@ -166,8 +426,8 @@ REG_DEFINE_FUNC(int, Consume_msg_header, (int index, int* datatype, int* count,
   }
 
   /*--- No. of bytes in message ---*/
-  if((nbytes = recv_wait_all(sock_info->connector_handle, buffer,
-			     REG_PACKET_SIZE, 0)) <= 0) {
+  if((nbytes = recv_sample_samples(index, buffer,
+				   REG_PACKET_SIZE)) <= 0) {
     if(nbytes == 0) {
       /* closed connection */
       fprintf(stderr, "STEER: Consume_msg_header: hung up!\n");
@@ -196,8 +456,8 @@ REG_DEFINE_FUNC(int, Consume_msg_header, (int index, int* datatype, int* count,
   }
 
   /*--- Array ordering in message ---*/
-  if((nbytes = recv_wait_all(sock_info->connector_handle, buffer,
-			     REG_PACKET_SIZE, 0)) <= 0) {
+  if((nbytes = recv_sample_samples(index, buffer,
+				   REG_PACKET_SIZE)) <= 0) {
     if(nbytes == 0) {
       /* closed connection */
       fprintf(stderr, "STEER: Consume_msg_header: hung up!\n");
@@ -229,8 +489,8 @@ REG_DEFINE_FUNC(int, Consume_msg_header, (int index, int* datatype, int* count,
   }
 
   /*--- End of header ---*/
-  if((nbytes = recv_wait_all(sock_info->connector_handle, buffer,
-			     REG_PACKET_SIZE, 0)) <= 0) {
+  if((nbytes = recv_sample_samples(index, buffer,
+				   REG_PACKET_SIZE)) <= 0) {
     if(nbytes == 0) {
       /* closed connection */
       fprintf(stderr, "STEER: Consume_msg_header: hung up!\n");
@@ -261,10 +521,9 @@ REG_DEFINE_FUNC(int, Consume_msg_header, (int index, int* datatype, int* count,
 
 REG_DEFINE_FUNC(int, Consume_start_data_check, (const int index))
 {
-  char buffer[REG_PACKET_SIZE];
-  char* pstart;
-  int nbytes = 0;
-  int nbytes1 = 0;
+  char buffer[REG_PACKET_SIZE + 1];
+  int nbytes;
+  int status;
   int attempt_reconnect;
 
   socket_info_type  *sock_info;
@@ -289,124 +548,89 @@ REG_DEFINE_FUNC(int, Consume_start_data_check, (const int index))
 	  "is connected, index = %d\n", index);
 #endif
 
-  /* Drain socket until start tag found */
+  /* Find the start of the next sample */
   attempt_reconnect = 1;
-  memset(buffer, '\0', 1);
-
-#ifdef REG_DEBUG
-  fprintf(stderr, "STEER: Consume_start_data_check_socket: searching for start tag\n");
-#endif
 
-  while(!(pstart = strstr(buffer, REG_DATA_HEADER))) {
+  while((status = next_sample_samples(index)) != REG_SUCCESS) {
 
-    if((nbytes = recv_non_block(sock_info->connector_handle,
-				buffer, REG_PACKET_SIZE, 0)) <= 0) {
+    /* Call was OK but there's no sample to read yet... */
+    if(status == REG_NOT_READY) return REG_FAILURE;
 
-      if(nbytes < 0) {
-	if(errno == EAGAIN) {
-	  /* Call would have blocked because no data to read */
 #ifdef REG_DEBUG
-	  fprintf(stderr, "\n");
-#endif
-	  /* Call was OK but there's no data to read... */
-	  return REG_FAILURE;
-	}
-	else {
-	  /* Some error occurred */
-#ifdef REG_DEBUG
-	  fprintf(stderr, "\n");
-#endif
-	  perror("STEER: recv");
-	}
-      }
-#ifdef REG_DEBUG
-      else {
-	/* recv returned 0 bytes => closed connection */
-	fprintf(stderr, "STEER: Consume_start_data_check: hung up!\n");
-      }
+    fprintf(stderr, "STEER: Consume_start_data_check: hung up!\n");
 #endif
 
-      /* We're in the middle of a while loop here so don't keep trying
-	 to reconnect ad infinitum */
-      if(!attempt_reconnect) {
-	return REG_FAILURE;
-      }
+    /* Don't keep trying to reconnect ad infinitum */
+    if(!attempt_reconnect) {
+      return REG_FAILURE;
+    }
 
 #ifdef REG_DEBUG
-      fprintf(stderr, "\nSTEER: Consume_start_data_check: recv failed - "
-	      "try immediate reconnect for index %d\n", index);
+    fprintf(stderr, "\nSTEER: Consume_start_data_check: recv failed - "
+	    "try immediate reconnect for index %d\n", index);
 #endif
 
-      retry_connect_samples(index);
-
-      /* check if socket reconnection has been made and check for
-	 data if it has */
-      if (socket_info_table.socket_info[index].comms_status
-	  != REG_COMMS_STATUS_CONNECTED) {
-	return REG_FAILURE;
-      }
+    retry_connect_samples(index);
 
-      attempt_reconnect = 0;
-      memset(buffer, '\0', 1);
+    /* check if socket reconnection has been made and check for
+       data if it has */
+    if (socket_info_table.socket_info[index].comms_status
+	!= REG_COMMS_STATUS_CONNECTED) {
+      return REG_FAILURE;
     }
 
-#ifdef REG_DEBUG
-    fprintf(stderr, "!");
-#endif
-  } /* !while */
+    attempt_reconnect = 0;
+  }
+  sock_info->frame_bad = REG_FALSE;
 
-#ifdef REG_DEBUG
-  fprintf(stderr, "\n");
-#endif
+  /* Need to read the full packet marking the beginning of the
+     sample - and keep it as it says whether the emitter is using our
+     parallel streams */
+  if((nbytes = recv_sample_samples(index, buffer,
+				   REG_PACKET_SIZE)) != REG_PACKET_SIZE) {
+    if(nbytes == 0) {
+      /* closed connection */
+      fprintf(stderr, "STEER: Consume_start_data_check: hung up!\n");
+    }
+    else if(nbytes < 0) {
+      /* error */
+      perror("recv");
+    }
 
-  if(nbytes > 0) {
+    fprintf(stderr, "STEER: ERROR: Consume_start_data_check: failed "
+	    "to read header\n");
+    return REG_FAILURE;
+  }
+  buffer[REG_PACKET_SIZE] = '\0';
 
 #ifdef REG_DEBUG
-    fprintf(stderr, "STEER: Consume_start_data_check: read >>%s<< "
-	    "from socket\n", buffer);
+  fprintf(stderr, "STEER: Consume_start_data_check: read >>%s<< "
+	  "from socket\n", buffer);
 #endif
 
-    /* Need to make sure we've read the full packet marking the
-       beginning of the next data slice */
-    nbytes1 = (int) (pstart - buffer) + (REG_PACKET_SIZE - nbytes);
-
-    if(nbytes1 > 0) {
-
-      if((nbytes = recv(sock_info->connector_handle, buffer,
-			nbytes1, 0)) <= 0) {
-	if(nbytes == 0) {
-	  /* closed connection */
-	  fprintf(stderr, "STEER: Consume_start_data_check: hung up!\n");
-	}
-	else {
-	  /* error */
-	  perror("recv");
-	}
-
-	if(nbytes != nbytes1) {
-	  fprintf(stderr, "STEER: ERROR: Consume_start_data_check: failed "
-		  "to read remaining %d bytes of header\n", (int) nbytes1);
-	  return REG_FAILURE;
-	}
-      }
-    }
+  if(strncmp(buffer, REG_DATA_HEADER, strlen(REG_DATA_HEADER))) {
+    fprintf(stderr, "STEER: ERROR: Consume_start_data_check: sample "
+	    "does not start with a data header\n");
+    return REG_FAILURE;
+  }
 
-    IOTypes_table.io_def[index].buffer_max_bytes = REG_IO_BUFSIZE;
-    IOTypes_table.io_def[index].buffer = (void*) malloc(REG_IO_BUFSIZE);
-    if(!IOTypes_table.io_def[index].buffer) {
-      IOTypes_table.io_def[index].buffer_max_bytes = 0;
-      fprintf(stderr, "STEER: ERROR: Consume_start_data_check: malloc "
-	      "of IO buffer failed\n");
-      return REG_FAILURE;
-    }
+  if(start_stripes_samples(index, buffer) != REG_SUCCESS) {
+    return REG_FAILURE;
+  }
 
-    /* added following one line for modularization
-       moved from ReG_Steer_Appside.c Consume_start_data_check
-     */
-    IOTypes_table.io_def[index].consuming = REG_TRUE;
-    return REG_SUCCESS;
+  /* The buffer is kept from one sample to the next */
+  if(IOTypes_table.io_def[index].buffer_max_bytes < REG_IO_BUFSIZE &&
+     Realloc_iotype_buffer(index, REG_IO_BUFSIZE) != REG_SUCCESS) {
+    fprintf(stderr, "STEER: ERROR: Consume_start_data_check: failed "
+	    "to get IO buffer\n");
+    return REG_FAILURE;
   }
-  return REG_FAILURE;
+
+  /* added following one line for modularization
+     moved from ReG_Steer_Appside.c Consume_start_data_check
+  */
+  IOTypes_table.io_def[index].consuming = REG_TRUE;
+  return REG_SUCCESS;
 }
 
 /*---------------------------------------------------*/
@@ -433,14 +657,29 @@ REG_DEFINE_FUNC(int, Consume_data_read, (const int index, const int datatype, co
 
   sock_info = &(socket_info_table.socket_info[index]);
 
+  /* The data of a large slice may come over our parallel streams */
+  if(IOTypes_table.io_def[index].slice_flags & REG_SLICE_FLAG_STRIPED) {
+    if(recv_striped(&(sock_info->stripes),
+		    (IOTypes_table.io_def[index].use_xdr ||
+		     IOTypes_table.io_def[index].convert_array_order == REG_TRUE) ?
+		    IOTypes_table.io_def[index].buffer : pData,
+		    num_bytes_to_read) == REG_SUCCESS) {
+      return REG_SUCCESS;
+    }
+
+    fprintf(stderr, "STEER: ERROR: Consume_data_read: failed to read "
+	    "%d bytes from parallel streams\n", (int) num_bytes_to_read);
+    close_stripes(&(sock_info->stripes));
+    IOTypes_table.io_def[index].use_xdr = REG_FALSE;
+    return REG_FAILURE;
+  }
+
   if(IOTypes_table.io_def[index].use_xdr || IOTypes_table.io_def[index].convert_array_order == REG_TRUE) {
-    nbytes = recv_wait_all(sock_info->connector_handle,
-			   IOTypes_table.io_def[index].buffer,
-			   num_bytes_to_read, 0);
+    nbytes = recv_sample_samples(index, IOTypes_table.io_def[index].buffer,
+				 num_bytes_to_read);
   }
   else {
-    nbytes = recv_wait_all(sock_info->connector_handle, pData,
-			   num_bytes_to_read, 0);
+    nbytes = recv_sample_samples(index, pData, num_bytes_to_read);
   }
 
 #ifdef REG_DEBUG
@@ -473,71 +712,163 @@ REG_DEFINE_FUNC(int, Consume_data_read, (const int index, const int datatype, co
 
 /*---------------------------------------------------*/
 
-REG_DEFINE_FUNC(int, Consume_ack, (const int index))
+/** @internal
+    @param handle Handle of the socket to read from
+    @param buf Buffer holding the @p nbytes read so far, with room for
+    2*REG_ACK_SIZE + REG_ACK_MAX_SIZE + 1 bytes
+    @param ack The acknowledgement tag within @p buf
+    @param nbytes No. of bytes in @p buf
+    @return REG_SUCCESS or REG_FAILURE if the rest of the
+    acknowledgement could not be read
+
+    Reads the rest of an acknowledgement whose tag has been found:
+    the version tag and, if that ends "+>", the region that follows
+    or, if it ends "*>", the region and credit that follow.
+    The consumer sends each acknowledgement in one go so this only
+    waits if it has been split up on the way. */
+static int read_ack_rest(const int handle, char *buf, char *ack,
+			 int nbytes)
 {
-
-  char *ack_msg = "<ACK/>";
-  char  buf[32];
   char *pchar;
-  int   nbytes;
+  int   want;
 
-  /* If no acknowledgement is currently required (e.g. this is the
-     first time Emit_start has been called) then return success */
-  if(IOTypes_table.io_def[index].ack_needed == REG_FALSE){
+  want = (int)(ack - buf) + REG_ACK_SIZE - nbytes;
+  if(want > 0) {
+    if(recv_wait_all(handle, (void*)&(buf[nbytes]), want, 0) != want) {
+      return REG_FAILURE;
+    }
+    nbytes += want;
+  }
+
+  if(!(pchar = strstr(ack, "<V")) || !(pchar = strchr(pchar, '>')) ||
+     (pchar[-1] != '+' && pchar[-1] != '*')) {
     return REG_SUCCESS;
   }
 
-  /* Buffer is twice as long as ack message to allow us to deal with
-     getting a truncated message */
-  memset(buf, '\0', 32);
+  want = (int)(ack - buf) + REG_ACK_SIZE + REG_ACK_REGION_SIZE - nbytes;
+  if(pchar[-1] == '*') want += REG_ACK_CREDIT_SIZE;
+  if(want > 0 &&
+     recv_wait_all(handle, (void*)&(buf[nbytes]), want, 0) != want) {
+    return REG_FAILURE;
+  }
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param handle Handle of the socket to read from
+    @param buf Buffer to read into, at least
+    2*REG_ACK_SIZE + REG_ACK_MAX_SIZE + 1 bytes
+    @param ack On successful return, points to the acknowledgement
+    within @p buf
+    @return REG_SUCCESS, REG_NOT_READY if there is no (complete)
+    acknowledgement yet, REG_FAILURE if there won't be one
+
+    Reads an acknowledgement without blocking. */
+static int read_ack_samples(const int handle, char *buf, char **ack)
+{
+  char *ack_msg = REG_ACK_TAG;
+  char *pchar;
+  int   nbytes;
+
+  /* Buffer is longer than the ack message to allow us to deal with
+     getting a truncated message and any region that follows it */
+  memset(buf, '\0', 2*REG_ACK_SIZE + REG_ACK_MAX_SIZE + 1);
 
   /* Search for an ACK tag */
-  if((nbytes = recv_non_block(socket_info_table.socket_info[index].connector_handle,
-			      (void*)buf, 16, 0)) == 16) {
+  if((nbytes = recv_non_block(handle, (void*)buf, 16, 0)) == 16) {
     pchar = strchr(buf, '<');
 
     if(pchar){
       if(strstr(pchar, ack_msg)){
-	return REG_SUCCESS;
+	*ack = pchar;
+	return read_ack_rest(handle, buf, pchar, 16);
       }
       else{
 	if( (&(buf[15])- pchar + 1) > strlen(ack_msg) ){
 
 	  /* We found the opening angle bracket but the rest of the tag
 	     is missing so we fail */
-	  return REG_FAILURE;
+	  return REG_NOT_READY;
 	}
 	else{
 	  /* Looks like our ack msg drops off end of buffer so get another
 	     16 bytes */
-	  if(recv_non_block(socket_info_table.socket_info[index].connector_handle,
-			    (void*)&(buf[16]), 16, 0) == 16) {
+	  if(recv_non_block(handle, (void*)&(buf[16]), 16, 0) == 16) {
 
-	    if( strstr(buf, ack_msg) ) return REG_SUCCESS;
+	    if( (pchar = strstr(buf, ack_msg)) ) {
+	      *ack = pchar;
+	      return read_ack_rest(handle, buf, pchar, 32);
+	    }
 	  }
 	}
       }
     }
   }
 
-  if(nbytes < 0) {
-    if(errno == EAGAIN) {
-      /* Call would have blocked because no data to read
-       * Call was OK but there's no data to read... */
+  if(nbytes < 0 && errno == EAGAIN) {
+    /* Call would have blocked because no data to read
+     * Call was OK but there's no data to read... */
 #ifdef REG_DEBUG_FULL
-      fprintf(stderr, "STEER: Consume_ack: no data on socket to "
-	      "read for ack\n");
+    fprintf(stderr, "STEER: Consume_ack: no data on socket to "
+	    "read for ack\n");
 #endif
-      return REG_FAILURE;
-    }
-    else {
-      /* Some error occurred */
-      IOTypes_table.io_def[index].ack_needed = REG_FALSE;
-    }
+    return REG_NOT_READY;
   }
-  else {
-    /* recv returned 0 bytes => closed connection */
-    IOTypes_table.io_def[index].ack_needed = REG_FALSE;
+
+  /* Some error occurred or recv returned 0 bytes => closed
+     connection */
+  return REG_FAILURE;
+}
+
+/*---------------------------------------------------*/
+
+REG_DEFINE_FUNC(int, Consume_ack, (const int index))
+{
+
+  IOdef_entry *io = &(IOTypes_table.io_def[index]);
+  char         buf[2*REG_ACK_SIZE + REG_ACK_MAX_SIZE + 1];
+  char        *pchar;
+  int          num_acks = 0;
+  int          status;
+
+  /* A lone consumer's samples queue up in the connection so it can
+     let us send some ahead of it.  Several consumers are sent samples
+     one at a time */
+  io->credit_capable = (socket_info_table.socket_info[index].num_sinks
+			<= 1) ? REG_TRUE : REG_FALSE;
+
+  /* Each of several consumers acknowledges samples separately */
+  if(socket_info_table.socket_info[index].sinks) {
+    return consume_sink_acks_samples(index);
+  }
+
+  /* If no acknowledgement is currently required (e.g. this is the
+     first time Emit_start has been called) then return success.  We
+     haven't heard from this consumer so don't assume that it
+     understands binary slice headers or native data. */
+  if(io->ack_needed == REG_FALSE){
+    Set_peer_capabilities(io, NULL);
+    return REG_SUCCESS;
+  }
+
+  /* The consumer may have acknowledged several samples since we last
+     looked - each acknowledgement says how many */
+  while((status = read_ack_samples(socket_info_table.socket_info[index].connector_handle,
+				   buf, &pchar)) == REG_SUCCESS) {
+    Set_peer_capabilities(io, pchar);
+    num_acks++;
+  }
+
+  /* Give up on a consumer that has gone, unless it acknowledged
+     something first - then we'll find out next time round */
+  if(status == REG_FAILURE && num_acks == 0) {
+    io->ack_needed = REG_FALSE;
+  }
+  else if(io->samples_in_flight < io->window) {
+    return REG_SUCCESS;
   }
 
 #ifdef REG_DEBUG_FULL
@@ -550,6 +881,17 @@ REG_DEFINE_FUNC(int, Consume_ack, (const int index))
 
 REG_DEFINE_FUNC(int, Emit_start, (int index, int seqnum))
 {
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
+
+  /* Throw away anything left over from a sample that was never
+     finished */
+  sock_info->gathering = REG_FALSE;
+  sock_info->gather_bytes = 0;
+
+  /* Goes in the frames of the sample so that a consumer can tell
+     them from those of one that it didn't finish reading */
+  sock_info->frame_seq = (unsigned int) seqnum;
+
   return REG_SUCCESS;
 }
 
@@ -557,14 +899,127 @@ REG_DEFINE_FUNC(int, Emit_start, (int index, int seqnum))
 
 REG_DEFINE_FUNC(int, Emit_stop, (int index))
 {
-  return REG_SUCCESS;
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
+  int status = REG_SUCCESS;
+
+  if(sock_info->gathering == REG_TRUE) {
+    sock_info->gathering = REG_FALSE;
+
+    /* Send whatever is left (usually the footer) and make sure that
+       the last segment of the sample goes.  Consumers that take
+       frames are told that it is the last even if nothing is left */
+    if(sock_info->gather_bytes > 0 || sock_info->sinks) {
+      sock_info->frame_end = REG_TRUE;
+      status = flush_gather_samples(index);
+      sock_info->frame_end = REG_FALSE;
+    }
+    if(!sock_info->sinks) set_tcpcork(sock_info, REG_FALSE);
+  }
+
+  if(sock_info->sinks) finish_sinks_samples(index);
+
+  IOTypes_table.io_def[index].num_emit_syscalls += sock_info->num_syscalls;
+  sock_info->num_syscalls = 0;
+
+  return status;
 }
 
 /*---------------------------------------------------*/
 
 REG_DEFINE_FUNC(int, Consume_stop, (int index))
 {
-  return REG_SUCCESS;
+  /* Let the application know that what it read can't be trusted */
+  return (socket_info_table.socket_info[index].frame_bad == REG_TRUE) ?
+    REG_FAILURE : REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+REG_DEFINE_FUNC(int, Consume_data_map, (const int index, const size_t num_bytes, void** pData))
+{
+  (void) index;
+  (void) num_bytes;
+  (void) pData;
+
+  /* Data off a socket always has to be copied somewhere */
+  return REG_FAILURE;
+}
+
+/*---------------------------------------------------*/
+
+REG_DEFINE_FUNC(int, Consume_seek_slice, (const int index, const int slice, int* num_slices))
+{
+  (void) index;
+  (void) slice;
+  (void) num_slices;
+
+  /* A stream can only be read in order */
+  return REG_FAILURE;
+}
+
+/*---------------------------------------------------*/
+
+REG_DEFINE_FUNC(int, Wait_for_IOType, (const int index, const int timeout_ms))
+{
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
+  IOdef_entry      *io = &(IOTypes_table.io_def[index]);
+  int               few[2];
+  int              *handles;
+  int               num = 0;
+  int               busy = REG_FALSE;
+  int               lowat = REG_FALSE;
+  int               status;
+  int               i;
+
+  /* There's room for every consumer once there are any */
+  handles = sock_info->wait_handles ? sock_info->wait_handles : few;
+
+  if(io->direction == REG_IO_OUT) {
+    /* Someone connecting... */
+    if(sock_info->listener_status == REG_COMMS_STATUS_LISTENING &&
+       (sock_info->comms_status != REG_COMMS_STATUS_CONNECTED ||
+	sock_info->num_sinks < io->max_consumers)) {
+      handles[num++] = sock_info->listener_handle;
+    }
+
+    /* ...or an acknowledgement of the last sample.  If there is a
+       consumer that we aren't waiting for then it's something else
+       that's holding us up */
+    if(sock_info->sinks) {
+      for(i = 0; i < sock_info->num_sinks; i++) {
+	if(sock_info->sinks[i].ack_needed == REG_TRUE) {
+	  handles[num++] = sock_info->sinks[i].handle;
+	}
+	else {
+	  busy = REG_TRUE;
+	}
+      }
+    }
+    else if(sock_info->comms_status == REG_COMMS_STATUS_CONNECTED) {
+      if(io->ack_needed == REG_TRUE) {
+	handles[num++] = sock_info->connector_handle;
+      }
+      else {
+	busy = REG_TRUE;
+      }
+    }
+  }
+  else if(sock_info->comms_status == REG_COMMS_STATUS_CONNECTED) {
+    /* The start of a sample - until we're connected there's nothing
+       to wait on as the emitter may not be listening yet.  Consume_start
+       can't tell what it has until there is a frame header's worth, so
+       don't wake for less */
+    handles[num++] = sock_info->connector_handle;
+    lowat = (set_recv_lowat(sock_info->connector_handle,
+			    REG_FRAME_HDR_SIZE) == 0);
+  }
+
+  status = busy ? REG_FAILURE :
+    wait_for_sockets(handles, num, timeout_ms);
+
+  if(lowat) set_recv_lowat(sock_info->connector_handle, 1);
+
+  return status;
 }
 
 #undef REG_MODULE
@@ -677,10 +1132,28 @@ int create_listener_samples(const int index) {
 /*---------------------------------------------------*/
 
 void cleanup_listener_connection_samples(const int index) {
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
+  int               i;
+
   if(socket_info_table.socket_info[index].listener_status == REG_COMMS_STATUS_LISTENING) {
     close_listener_handle_samples(index);
   }
 
+  for(i = 0; i < REG_MAX_STREAMS; i++) {
+    if(sock_info->stripe_pending[i] != -1) {
+      reactor_remove(sock_info->stripe_pending[i]);
+      closesocket(sock_info->stripe_pending[i]);
+      sock_info->stripe_pending[i] = -1;
+    }
+  }
+
+  if(sock_info->stripe_listener != -1) {
+    reactor_remove(sock_info->stripe_listener);
+    closesocket(sock_info->stripe_listener);
+    sock_info->stripe_listener = -1;
+    sock_info->stripe_port = 0;
+  }
+
   if(socket_info_table.socket_info[index].comms_status == REG_COMMS_STATUS_CONNECTED) {
     close_connector_handle_samples(index);
   }
@@ -702,6 +1175,7 @@ void cleanup_connector_connection_samples(const int index) {
 /*---------------------------------------------------*/
 
 void close_listener_handle_samples(const int index) {
+  reactor_remove(socket_info_table.socket_info[index].listener_handle);
   if(closesocket(socket_info_table.socket_info[index].listener_handle) == REG_SOCKETS_ERROR) {
     perror("close");
     socket_info_table.socket_info[index].listener_status = REG_COMMS_STATUS_FAILURE;
@@ -717,6 +1191,26 @@ void close_listener_handle_samples(const int index) {
 /*---------------------------------------------------*/
 
 void close_connector_handle_samples(const int index) {
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
+
+  /* Several consumers are each closed in turn */
+  if(sock_info->num_sinks > 0) {
+    while(sock_info->num_sinks > 0) {
+      drop_sink_samples(index, sock_info->num_sinks - 1);
+    }
+    return;
+  }
+
+  /* Our parallel streams go with the main connection */
+  close_stripes(&(sock_info->stripes));
+
+  /* ...and so does keeping track of frames */
+  sock_info->framed = REG_FALSE;
+  sock_info->frame_flags = 0;
+  sock_info->frame_left = 0;
+  sock_info->frame_restart = REG_FALSE;
+
+  reactor_remove(socket_info_table.socket_info[index].connector_handle);
   if(closesocket(socket_info_table.socket_info[index].connector_handle) == REG_SOCKETS_ERROR) {
     perror("close");
     socket_info_table.socket_info[index].comms_status = REG_COMMS_STATUS_FAILURE;
@@ -812,6 +1306,10 @@ void retry_connect_samples(const int index) {
   socket_info_type *socket_info;
   socket_info = &(socket_info_table.socket_info[index]);
 
+  /* Whatever we next get from the emitter can't be a delta against
+     what we had before */
+  IOTypes_table.io_def[index].delta_key_needed = REG_TRUE;
+
   /* close the failed connector and retry to connect */
   if(socket_info->comms_status == REG_COMMS_STATUS_CONNECTED) {
     /* Reset connector port (to force us to go and look for it
@@ -833,39 +1331,22 @@ void retry_connect_samples(const int index) {
 
 void poll_socket_samples(const int index) {
 
-  struct timeval timeout;
-  fd_set sockets;	/* the set of sockets to check */
-  int fd_max;		/* the max socket number */
-
   int listener = socket_info_table.socket_info[index].listener_handle;
   int connector = socket_info_table.socket_info[index].connector_handle;
   int direction = IOTypes_table.io_def[index].direction;
 
-  timeout.tv_sec  = 0;
-  timeout.tv_usec = 0;
-
   /* just return if we have no handles */
   if((listener == -1) && (connector == -1)) return;
 
-  /* clear the socket set and add required handles */
-  FD_ZERO(&sockets);
   if(direction == REG_IO_OUT) {
     /* SERVER */
     if(socket_info_table.socket_info[index].listener_status == REG_COMMS_STATUS_LISTENING) {
-      FD_SET(listener, &sockets);
-      fd_max = listener;
 
-      /* poll using select() */
 #ifdef REG_DEBUG
       fprintf(stderr, "STEER: poll_socket: polling for accept\n");
 #endif
-      if(select(fd_max + 1, &sockets, NULL, NULL, &timeout) == -1) {
-	perror("select");
-	return;
-      }
-
       /* see if anything needs doing */
-      if(FD_ISSET(listener, &sockets)) {
+      if(reactor_events(listener) & REG_REACTOR_READ) {
 	/* new connection */
 	struct sockaddr_in theirAddr;
 #if defined(__sgi)
@@ -880,8 +1361,14 @@ void poll_socket_samples(const int index) {
 	  perror("accept");
 	  return;
 	}
-	socket_info_table.socket_info[index].connector_handle = new_fd;
-	socket_info_table.socket_info[index].comms_status=REG_COMMS_STATUS_CONNECTED;
+	/* Samples are gathered into as few sends as possible so don't
+	   let Nagle's algorithm hold back the end of one */
+	if(set_tcpnodelay(new_fd) == REG_SOCKETS_ERROR) {
+	  perror("setsockopt");
+	}
+	if(add_sink_samples(index, new_fd) != REG_SUCCESS) {
+	  closesocket(new_fd);
+	}
       }
     }
   }
@@ -894,3 +1381,619 @@ void poll_socket_samples(const int index) {
 }
 
 /*---------------------------------------------------*/
+
+void start_gather_samples(const int index) {
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
+
+  sock_info->gather_bytes = 0;
+  sock_info->gathering = REG_TRUE;
+  sock_info->corked = REG_FALSE;
+}
+
+/*---------------------------------------------------*/
+
+void limit_sink_send_samples(const int index, const int handle) {
+  IOdef_entry *io = &(IOTypes_table.io_def[index]);
+
+  /* Don't let one consumer that has stopped reading hold up all of
+     the others for ever */
+  if(io->max_consumers > 1 &&
+     set_send_timeout(handle, REG_CONSUMER_SEND_TIMEOUT) ==
+     REG_SOCKETS_ERROR) {
+    perror("setsockopt");
+  }
+}
+
+/*---------------------------------------------------*/
+
+int add_sink_samples(const int index, const int handle) {
+  socket_info_type    *sock_info = &(socket_info_table.socket_info[index]);
+  IOdef_entry         *io = &(IOTypes_table.io_def[index]);
+  sink_info_type      *sink;
+  Consumer_stats_type *stats;
+  void                *ptr;
+
+  if(sock_info->num_sinks == sock_info->max_sinks) {
+    ptr = realloc(sock_info->sinks,
+		  (sock_info->max_sinks + 1)*sizeof(sink_info_type));
+    if(!ptr) {
+      fprintf(stderr, "STEER: ERROR: add_sink: failed to allocate "
+	      "memory for consumer\n");
+      return REG_FAILURE;
+    }
+    sock_info->sinks = (sink_info_type*) ptr;
+
+    ptr = realloc(io->consumers,
+		  (sock_info->max_sinks + 1)*sizeof(Consumer_stats_type));
+    if(!ptr) {
+      fprintf(stderr, "STEER: ERROR: add_sink: failed to allocate "
+	      "memory for consumer stats\n");
+      return REG_FAILURE;
+    }
+    io->consumers = (Consumer_stats_type*) ptr;
+
+    /* Wait_for_IOType() waits on every consumer and the listener */
+    ptr = realloc(sock_info->wait_handles,
+		  (sock_info->max_sinks + 2)*sizeof(int));
+    if(!ptr) {
+      fprintf(stderr, "STEER: ERROR: add_sink: failed to allocate "
+	      "memory for consumer handles\n");
+      return REG_FAILURE;
+    }
+    sock_info->wait_handles = (int*) ptr;
+    sock_info->max_sinks++;
+  }
+
+  sink = &(sock_info->sinks[sock_info->num_sinks]);
+  sink->handle = handle;
+  sink->corked = REG_FALSE;
+  sink->ack_needed = REG_FALSE;
+  sink->missed = REG_FALSE;
+  sink->stripes.num = 0;
+  sink->stripes.num_connected = 0;
+  sink->stripes.total = 0;
+  sink->header_pending = REG_FALSE;
+  sink->framed = REG_FALSE;
+
+  /* We haven't heard from this consumer so don't assume that it
+     understands binary slice headers or native data.  It can join a
+     sample that has already started if that is in a form it
+     understands */
+  sink->slice_hdr_version = REG_SLICE_HDR_TEXT;
+  sink->use_native = REG_FALSE;
+  sink->active = (io->slice_hdr_version == REG_SLICE_HDR_TEXT &&
+		  io->use_native == REG_FALSE);
+  io->delta_key_needed = REG_TRUE;
+
+  /* Nothing sent to a lone consumer is waiting to be acknowledged */
+  if(sock_info->num_sinks == 0) {
+    io->samples_in_flight = 0;
+    io->window = 1;
+  }
+
+  limit_sink_send_samples(index, handle);
+
+  stats = &(io->consumers[sock_info->num_sinks]);
+  Get_current_time_seconds(&(stats->connect_time));
+  stats->num_bytes = 0.0;
+  stats->num_samples = 0;
+  stats->num_skipped = 0;
+
+  sock_info->num_sinks++;
+  io->num_consumers = sock_info->num_sinks;
+
+  sock_info->connector_handle = sock_info->sinks[0].handle;
+  sock_info->comms_status = REG_COMMS_STATUS_CONNECTED;
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+void drop_sink_samples(const int index, const int sink) {
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
+  IOdef_entry      *io = &(IOTypes_table.io_def[index]);
+  int               handle = sock_info->sinks[sink].handle;
+
+  close_stripes(&(sock_info->sinks[sink].stripes));
+  reactor_remove(handle);
+  if(closesocket(handle) == REG_SOCKETS_ERROR) {
+    perror("close");
+  }
+#ifdef REG_DEBUG
+  fprintf(stderr, "STEER: drop_sink: closed consumer %d of IOType "
+	  "index %d\n", sink, index);
+#endif
+
+  /* Keep the rest in the order that they connected */
+  sock_info->num_sinks--;
+  memmove(&(sock_info->sinks[sink]), &(sock_info->sinks[sink + 1]),
+	  (sock_info->num_sinks - sink)*sizeof(sink_info_type));
+  memmove(&(io->consumers[sink]), &(io->consumers[sink + 1]),
+	  (sock_info->num_sinks - sink)*sizeof(Consumer_stats_type));
+  io->num_consumers = sock_info->num_sinks;
+
+  if(sock_info->num_sinks > 0) {
+    sock_info->connector_handle = sock_info->sinks[0].handle;
+  }
+  else {
+    sock_info->connector_handle = -1;
+    sock_info->comms_status = REG_COMMS_STATUS_NULL;
+  }
+}
+
+/*---------------------------------------------------*/
+
+int consume_sink_acks_samples(const int index) {
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
+  IOdef_entry      *io = &(IOTypes_table.io_def[index]);
+  sink_info_type   *sink;
+  char              buf[2*REG_ACK_SIZE + REG_ACK_MAX_SIZE + 1];
+  char             *pchar;
+  int               version = REG_SLICE_HDR_VERSION;
+  int               native = REG_TRUE;
+  int               num_ready = 0;
+  int               status;
+  int               i = 0;
+
+  while(i < sock_info->num_sinks) {
+    sink = &(sock_info->sinks[i]);
+    sink->active = REG_FALSE;
+
+    if(sink->ack_needed == REG_TRUE) {
+      status = read_ack_samples(sink->handle, buf, &pchar);
+      if(status == REG_SUCCESS) {
+	Set_peer_capabilities(io, pchar);
+
+	/* A lone consumer may have acknowledged several samples since
+	   we last looked - each acknowledgement says how many */
+	while(io->credit_capable &&
+	      read_ack_samples(sink->handle, buf, &pchar) == REG_SUCCESS) {
+	  Set_peer_capabilities(io, pchar);
+	}
+	sink->slice_hdr_version = io->slice_hdr_version;
+	sink->use_native = io->use_native;
+      }
+      else if(status == REG_FAILURE) {
+	/* Not going to hear from it (if it has gone, sending to it
+	   will find out) so assume the worst */
+	sink->slice_hdr_version = REG_SLICE_HDR_TEXT;
+	sink->use_native = REG_FALSE;
+	io->samples_in_flight = 0;
+      }
+
+      /* It may have given us credit to send more before it has
+	 caught up */
+      if(io->credit_capable && io->samples_in_flight > 0) {
+	status = (io->samples_in_flight < io->window) ?
+	  REG_SUCCESS : REG_NOT_READY;
+      }
+      else if(status != REG_NOT_READY) {
+	sink->ack_needed = REG_FALSE;
+      }
+
+      if(status == REG_NOT_READY && io->use_ack == REG_TRUE) {
+	/* Still busy with the last sample so this one goes without
+	   it rather than wait */
+	i++;
+	continue;
+      }
+    }
+
+    /* It can't be sent deltas against a sample that it missed */
+    if(sink->missed == REG_TRUE) {
+      io->delta_key_needed = REG_TRUE;
+      sink->missed = REG_FALSE;
+    }
+
+    /* Send this sample in a form that all who get it understand */
+    if(sink->slice_hdr_version < version) {
+      version = sink->slice_hdr_version;
+    }
+    if(sink->use_native == REG_FALSE) native = REG_FALSE;
+
+    sink->active = REG_TRUE;
+    num_ready++;
+    i++;
+  }
+
+  /* With no consumers at all the next to connect will be new */
+  if(sock_info->num_sinks == 0) {
+    Set_peer_capabilities(io, NULL);
+    return REG_SUCCESS;
+  }
+
+  if(num_ready == 0) {
+#ifdef REG_DEBUG_FULL
+    fprintf(stderr, "STEER: INFO: Consume_ack: no ack received\n");
+#endif
+    return REG_FAILURE;
+  }
+
+  io->slice_hdr_version = version;
+  io->use_native = native;
+
+  /* Consumers sharing a sample can't each have their own part of
+     the arrays in it */
+  if(sock_info->num_sinks > 1 && io->use_region) {
+    io->use_region = REG_FALSE;
+    io->delta_key_needed = REG_TRUE;
+  }
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param sock_info Socket information of the IOType
+    @param sink The consumer being sent to
+    @param prefix Buffer of REG_FRAME_HDR_SIZE + REG_PACKET_SIZE bytes
+    to put the frame header (and the data header, if it is still to
+    go) in
+    @param nbufs No. of buffers to go in the frame after anything
+    gathered
+    @param lens Array of the lengths of the buffers in bytes
+    @param sums Checksums of what was gathered and then of each of
+    the buffers, or NULL if the frame is to go without one
+    @param last If REG_TRUE, this is the last frame of the sample
+    @return No. of bytes put in @p prefix
+
+    Works out the header of the next frame of a sample to a consumer
+    that takes frames.  A frame is everything that goes over the
+    main connection in one go so its length is known before it is
+    sent, even though that of the sample is not. */
+static size_t frame_prefix_samples(socket_info_type *sock_info,
+				   sink_info_type *sink, char *prefix,
+				   const int nbufs, const size_t* lens,
+				   const unsigned int* sums, const int last) {
+  uint64_t     num_bytes = (uint64_t) sock_info->gather_bytes;
+  unsigned int sum = frame_checksum(0, NULL, 0);
+  int          flags = 0;
+  int          i;
+
+  if(sink->header_pending == REG_TRUE) {
+    memcpy(&(prefix[REG_FRAME_HDR_SIZE]), sink->header, REG_PACKET_SIZE);
+    flags |= REG_FRAME_FLAG_START;
+    num_bytes += REG_PACKET_SIZE;
+    if(sums) sum = frame_checksum(sum, sink->header, REG_PACKET_SIZE);
+  }
+  if(last) flags |= REG_FRAME_FLAG_END;
+
+  if(sums) {
+    flags |= REG_FRAME_FLAG_CHECKSUM;
+    if(sock_info->gather_bytes > 0) {
+      sum = frame_checksum_combine(sum, sums[0],
+				   (uint64_t) sock_info->gather_bytes);
+    }
+    for(i = 0; i < nbufs; i++) {
+      sum = frame_checksum_combine(sum, sums[i + 1], (uint64_t) lens[i]);
+    }
+  }
+
+  for(i = 0; i < nbufs; i++) {
+    num_bytes += (uint64_t) lens[i];
+  }
+
+  /* Nothing to say */
+  if(num_bytes == 0 && !last) return 0;
+
+  pack_frame_header(prefix, flags, sock_info->frame_seq, num_bytes, sum);
+
+  return REG_FRAME_HDR_SIZE +
+    ((flags & REG_FRAME_FLAG_START) ? REG_PACKET_SIZE : 0);
+}
+
+/*---------------------------------------------------*/
+
+/** @internal
+    @param index Index of the IOType
+    @param sink The consumer to send to, whose handle must be the
+    connector handle of the IOType
+    @param nbufs No. of buffers to send after anything gathered
+    @param bufs Array of @p nbufs pointers to the buffers
+    @param lens Array of the lengths of the buffers in bytes
+    @param sums Checksums of what was gathered and then of each of
+    @p bufs, or NULL if frames go without them
+    @param more If REG_TRUE, more data will follow shortly
+    @return REG_SUCCESS, REG_FAILURE
+
+    Send the data header (if it hasn't gone yet), whatever has been
+    gathered and then @p bufs to one consumer.  If this sample is
+    using parallel streams then large buffers (the data of large
+    slices) go over those and everything else over the main
+    connection, in order.  A consumer that takes frames gets each
+    run of bytes over the main connection as a frame. */
+static int send_sink_samples(const int index, sink_info_type *sink,
+			     const int nbufs, void** bufs,
+			     const size_t* lens, const unsigned int* sums,
+			     const int more) {
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
+  IOdef_entry      *io = &(IOTypes_table.io_def[index]);
+  char              frame[REG_FRAME_HDR_SIZE + REG_PACKET_SIZE];
+  void             *prefix = NULL;
+  size_t            prefix_len = 0;
+  int               first = 0;
+  int               i;
+
+  if(sink->header_pending == REG_TRUE) {
+    prefix = (void*) sink->header;
+    prefix_len = REG_PACKET_SIZE;
+  }
+
+  for(i = 0; io->stripe_slices && i < nbufs; i++) {
+    if(lens[i] < REG_STRIPE_MIN_BYTES) continue;
+
+    if(sink->framed == REG_TRUE) {
+      prefix = (void*) frame;
+      prefix_len = frame_prefix_samples(sock_info, sink, frame, i - first,
+					&(lens[first]),
+					sums ? &(sums[first]) : NULL,
+					REG_FALSE);
+    }
+
+    /* The consumer has to have the slice header before it can
+       read the data so don't hold any of it back */
+    if(send_gathered(sock_info, prefix, prefix_len, i - first,
+		     &(bufs[first]), &(lens[first]),
+		     REG_FALSE) != REG_SUCCESS) {
+      return REG_FAILURE;
+    }
+    set_tcpcork(sock_info, REG_FALSE);
+    sink->header_pending = REG_FALSE;
+    prefix = NULL;
+    prefix_len = 0;
+
+    if(send_striped(&(sink->stripes), bufs[i], lens[i]) != REG_SUCCESS) {
+      fprintf(stderr, "STEER: ERROR: send_sinks: failed to send %lu "
+	      "bytes over parallel streams\n", (unsigned long) lens[i]);
+      return REG_FAILURE;
+    }
+    first = i + 1;
+  }
+
+  if(sink->framed == REG_TRUE) {
+    prefix = (void*) frame;
+    prefix_len = frame_prefix_samples(sock_info, sink, frame, nbufs - first,
+				      &(lens[first]),
+				      sums ? &(sums[first]) : NULL,
+				      sock_info->frame_end);
+  }
+
+  if(send_gathered(sock_info, prefix, prefix_len, nbufs - first,
+		   &(bufs[first]), &(lens[first]), more) != REG_SUCCESS) {
+    return REG_FAILURE;
+  }
+  sink->header_pending = REG_FALSE;
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+int send_sinks_samples(const int index, const int nbufs, void** bufs,
+		       const size_t* lens, const int more) {
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
+  IOdef_entry      *io = &(IOTypes_table.io_def[index]);
+  sink_info_type   *sink;
+  unsigned int      sums_stack[REG_GATHER_MAX_PARTS];
+  unsigned int     *sums = NULL;
+  int               gathered = sock_info->gather_bytes;
+  double            total = (double) gathered;
+  int               num_sent = 0;
+  int               i = 0;
+
+  if(!sock_info->sinks) {
+    return send_gathered(sock_info, NULL, 0, nbufs, bufs, lens, more);
+  }
+
+  for(i = 0; i < nbufs; i++) {
+    total += (double) lens[i];
+  }
+
+  /* Every consumer that takes frames is sent the same bytes, so the
+     checksums of the pieces are only worked out once */
+  for(i = 0; io->frame_checksum && i < sock_info->num_sinks; i++) {
+    if(sock_info->sinks[i].active && sock_info->sinks[i].framed) break;
+  }
+  if(io->frame_checksum && i < sock_info->num_sinks) {
+    sums = sums_stack;
+    if(nbufs + 1 > REG_GATHER_MAX_PARTS &&
+       !(sums = (unsigned int*) malloc((nbufs + 1)*sizeof(unsigned int)))) {
+      fprintf(stderr, "STEER: ERROR: send_sinks: failed to allocate "
+	      "memory for %d checksums\n", nbufs + 1);
+      sock_info->gather_bytes = 0;
+      return REG_FAILURE;
+    }
+
+    sums[0] = frame_checksum(frame_checksum(0, NULL, 0),
+			     sock_info->gather_buf, (size_t) gathered);
+    for(i = 0; i < nbufs; i++) {
+      /* What goes over parallel streams isn't in a frame */
+      sums[i + 1] = (io->stripe_slices && lens[i] >= REG_STRIPE_MIN_BYTES) ?
+	0 : frame_checksum(frame_checksum(0, NULL, 0), bufs[i], lens[i]);
+    }
+  }
+
+  i = 0;
+  while(i < sock_info->num_sinks) {
+    sink = &(sock_info->sinks[i]);
+    if(sink->active == REG_FALSE) {
+      i++;
+      continue;
+    }
+
+    /* Each consumer is sent the same bytes, gathered ones included */
+    sock_info->connector_handle = sink->handle;
+    sock_info->corked = sink->corked;
+    sock_info->gather_bytes = gathered;
+    if(sink->header_pending) io->consumers[i].num_bytes += REG_PACKET_SIZE;
+    if(send_sink_samples(index, sink, nbufs, bufs, lens,
+			 sink->framed ? sums : NULL, more) != REG_SUCCESS) {
+      drop_sink_samples(index, i);
+      continue;
+    }
+    sink->corked = sock_info->corked;
+    io->consumers[i].num_bytes += total;
+    num_sent++;
+    i++;
+  }
+
+  sock_info->gather_bytes = 0;
+  if(sock_info->num_sinks > 0) {
+    sock_info->connector_handle = sock_info->sinks[0].handle;
+    sock_info->corked = sock_info->sinks[0].corked;
+  }
+  if(sums && sums != sums_stack) free(sums);
+
+  return (num_sent > 0) ? REG_SUCCESS : REG_FAILURE;
+}
+
+/*---------------------------------------------------*/
+
+void finish_sinks_samples(const int index) {
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
+  IOdef_entry      *io = &(IOTypes_table.io_def[index]);
+  sink_info_type   *sink;
+  int               i;
+
+  for(i = 0; i < sock_info->num_sinks; i++) {
+    sink = &(sock_info->sinks[i]);
+
+    if(sink->active == REG_TRUE) {
+      /* Make sure that the last segment of the sample goes */
+      sock_info->connector_handle = sink->handle;
+      sock_info->corked = sink->corked;
+      set_tcpcork(sock_info, REG_FALSE);
+      sink->corked = sock_info->corked;
+
+      sink->active = REG_FALSE;
+      sink->ack_needed = REG_TRUE;
+      io->consumers[i].num_samples++;
+    }
+    else if(sink->ack_needed == REG_TRUE) {
+      sink->missed = REG_TRUE;
+      io->consumers[i].num_skipped++;
+    }
+  }
+
+  if(sock_info->num_sinks > 0) {
+    sock_info->connector_handle = sock_info->sinks[0].handle;
+    sock_info->corked = sock_info->sinks[0].corked;
+  }
+}
+
+/*---------------------------------------------------*/
+
+int start_stripes_samples(const int index, const char* header) {
+  socket_info_type   *sock_info = &(socket_info_table.socket_info[index]);
+  IOdef_entry        *io = &(IOTypes_table.io_def[index]);
+  stripe_info_type   *stripes = &(sock_info->stripes);
+  const char         *pchar;
+  unsigned long long  at;
+  int                 port, num, use;
+  int                 i;
+
+  /* Not offered or we don't want them */
+  if(io->num_streams < 2 || !(pchar = strstr(header, "<Stripes ")) ||
+     sscanf(pchar, "<Stripes port=%d n=%d use=%d at=%llu/>",
+	    &port, &num, &use, &at) != 4) {
+    close_stripes(stripes);
+    return REG_SUCCESS;
+  }
+
+  /* The emitter isn't using them (yet).  If it has given up on the
+     ones we have then start again */
+  if(use == 0) {
+    for(i = 0; i < stripes->num; i++) {
+      if(stripes->handles[i] != -1 &&
+	 (reactor_events(stripes->handles[i]) & REG_REACTOR_HUP)) {
+	close_stripes(stripes);
+	break;
+      }
+    }
+    if(stripes->num == 0) {
+      connect_stripes_samples(index, port, (num < io->num_streams) ?
+			      num : io->num_streams);
+    }
+    return REG_SUCCESS;
+  }
+
+  /* Slices of this sample that should come over parallel streams
+     can't be read if we don't agree with the emitter about them */
+  if(use != stripes->num || stripes->num_connected != stripes->num ||
+     at < stripes->total) {
+    fprintf(stderr, "STEER: ERROR: start_stripes: lost track of "
+	    "parallel streams\n");
+    close_stripes(stripes);
+    return REG_SUCCESS;
+  }
+
+  /* Throw away what was sent for samples that we didn't read to the
+     end */
+  if(at > stripes->total &&
+     recv_striped(stripes, NULL, (size_t) (at - stripes->total)) !=
+     REG_SUCCESS) {
+    close_stripes(stripes);
+  }
+
+  return REG_SUCCESS;
+}
+
+/*---------------------------------------------------*/
+
+int connect_stripes_samples(const int index, const int port,
+			    const int num) {
+  socket_info_type *sock_info = &(socket_info_table.socket_info[index]);
+  stripe_info_type *stripes = &(sock_info->stripes);
+  char              hello[REG_PACKET_SIZE + 1];
+  char              text[REG_PACKET_SIZE];
+  int               local_port;
+  int               handle;
+  int               i;
+
+  if(num < 2 || num > REG_MAX_STREAMS) return REG_FAILURE;
+
+  /* The emitter knows which consumer the streams belong to by the
+     address of our main connection */
+  if(get_socket_address(sock_info->connector_handle, REG_FALSE, NULL,
+			&local_port) != REG_SUCCESS) {
+    return REG_FAILURE;
+  }
+
+  close_stripes(stripes);
+  stripes->num = num;
+  for(i = 0; i < num; i++) {
+    stripes->handles[i] = -1;
+  }
+
+  for(i = 0; i < num; i++) {
+    handle = connect_from_range(sock_info->tcp_interface,
+				sock_info->min_port_out,
+				sock_info->max_port_out,
+				sock_info->connector_hostname, port);
+    if(handle == REG_SOCKETS_ERROR) {
+      close_stripes(stripes);
+      return REG_FAILURE;
+    }
+    stripes->handles[i] = handle;
+    stripes->num_connected++;
+
+    snprintf(text, REG_PACKET_SIZE, "<ReG_stripe port=%d index=%d of=%d/>",
+	     local_port, i, num);
+    snprintf(hello, REG_PACKET_SIZE + 1, REG_PACKET_FORMAT, text);
+    if(send_no_signal(handle, hello, REG_PACKET_SIZE, 0) !=
+       REG_PACKET_SIZE) {
+      perror("send");
+      close_stripes(stripes);
+      return REG_FAILURE;
+    }
+  }
+
+#ifdef REG_DEBUG
+  fprintf(stderr, "STEER: connect_stripes: connected %d parallel "
+	  "streams to %s:%d\n", num, sock_info->connector_hostname, port);
+#endif
+
+  return REG_SUCCESS;
+}
@@ -55,6 +55,52 @@
 #include "ReG_Steer_Sockets_Common.h"
 #include "ReG_Steer_Common.h"
 
+#include <limits.h>
+#include <zlib.h>
+
+#if REG_HAS_PTHREADS
+#include <pthread.h>
+#endif
+
+#if REG_HAS_EPOLL
+#include <sys/epoll.h>
+#include <time.h>
+
+/** @internal
+    What the reactor knows about a socket */
+typedef struct {
+  /** Whether (REG_TRUE) or not the socket is in the epoll set */
+  int watched;
+  /** Readiness found by poll no. @p seen */
+  int events;
+  /** Poll that last found the socket ready */
+  int seen;
+  /** Poll in force when the socket was last asked about */
+  int asked;
+} reactor_fd_type;
+
+/** @internal
+    The epoll set that watches every socket in the library, indexed
+    by file descriptor */
+static struct {
+  int                 epfd;
+  int                 num_polls;
+  /** When (CLOCK_MONOTONIC) the last poll was made */
+  struct timespec     polled_at;
+  int                 num_watched;
+  int                 max_fds;
+  reactor_fd_type*    fds;
+  int                 max_ready;
+  struct epoll_event* ready;
+} reactor = {-1, 0, {0, 0}, 0, 0, NULL, 0, NULL};
+
+#if REG_HAS_PTHREADS
+/** Guards the reactor, which the asynchronous emit thread uses as
+    well as the main thread */
+static pthread_mutex_t reactor_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+#endif
+
 /*--------------------------------------------------------------------*/
 
 int socket_info_table_init(socket_info_table_type* table,
@@ -80,6 +126,7 @@ int socket_info_init(socket_info_type* socket_info) {
 
   char* pchar = NULL;
   int   min, max;
+  int   i;
   char host[REG_MAX_STRING_LENGTH];
 
   /* lazy initial port ranges, but they do for now */
@@ -136,6 +183,40 @@ int socket_info_init(socket_info_type* socket_info) {
 
   socket_info->comms_status = REG_COMMS_STATUS_NULL;
 
+  /* gather buffer is allocated when first needed */
+  socket_info->gather_buf = NULL;
+  socket_info->gather_bytes = 0;
+  socket_info->gathering = REG_FALSE;
+  socket_info->corked = REG_FALSE;
+  socket_info->num_syscalls = 0;
+
+  /* consumers are added as they connect */
+  socket_info->sinks = NULL;
+  socket_info->num_sinks = 0;
+  socket_info->max_sinks = 0;
+  socket_info->wait_handles = NULL;
+
+  /* parallel streams are only set up if asked for */
+  socket_info->stripe_listener = -1;
+  socket_info->stripe_port = 0;
+  for(i = 0; i < REG_MAX_STREAMS; i++) {
+    socket_info->stripe_pending[i] = -1;
+  }
+  socket_info->stripes.num = 0;
+  socket_info->stripes.num_connected = 0;
+  socket_info->stripes.total = 0;
+
+  /* whether samples come in frames is found out as they arrive */
+  socket_info->frame_seq = 0;
+  socket_info->frame_end = REG_FALSE;
+  socket_info->framed = REG_FALSE;
+  socket_info->frame_flags = 0;
+  socket_info->frame_left = 0;
+  socket_info->frame_check = 0;
+  socket_info->frame_sum = 0;
+  socket_info->frame_bad = REG_FALSE;
+  socket_info->frame_restart = REG_FALSE;
+
   return REG_SUCCESS;
 }
 
@@ -150,6 +231,23 @@ void socket_info_cleanup(socket_info_type* socket_info) {
 
   if(socket_info->connector_hostname)
     free(socket_info->connector_hostname);
+
+  if(socket_info->gather_buf) {
+    free(socket_info->gather_buf);
+    socket_info->gather_buf = NULL;
+  }
+
+  if(socket_info->sinks) {
+    free(socket_info->sinks);
+    socket_info->sinks = NULL;
+    socket_info->num_sinks = 0;
+    socket_info->max_sinks = 0;
+  }
+
+  if(socket_info->wait_handles) {
+    free(socket_info->wait_handles);
+    socket_info->wait_handles = NULL;
+  }
 }
 
 /*--------------------------------------------------------------------*/
@@ -282,6 +380,213 @@ ssize_t send_no_signal(int s, const void* buf, size_t len, int flags) {
 
 /*--------------------------------------------------------------------*/
 
+int gather_data(socket_info_type* socket_info, const void* buf, size_t len) {
+
+  if(!socket_info->gather_buf) {
+    socket_info->gather_buf = (char*) malloc(REG_GATHER_BUFSIZE);
+    if(!socket_info->gather_buf) {
+      fprintf(stderr, "STEER: ERROR: gather_data: failed to allocate "
+	      "memory for gather buffer\n");
+      return REG_FAILURE;
+    }
+    socket_info->gather_bytes = 0;
+  }
+
+  if(len > (size_t) (REG_GATHER_BUFSIZE - socket_info->gather_bytes)) {
+    return REG_FAILURE;
+  }
+
+  memcpy(&(socket_info->gather_buf[socket_info->gather_bytes]), buf, len);
+  socket_info->gather_bytes += (int) len;
+
+  return REG_SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+#ifdef _MSC_VER
+/* Send all of a buffer, one call to send() at a time */
+static int send_all(socket_info_type* socket_info,
+		    const char* buf, size_t len) {
+  ssize_t result;
+
+  while(buf && len > 0) {
+    result = send_no_signal(socket_info->connector_handle, buf, len, 0);
+    socket_info->num_syscalls++;
+    if(result == REG_SOCKETS_ERROR) {
+      perror("send");
+      return REG_FAILURE;
+    }
+    buf += result;
+    len -= result;
+  }
+
+  return REG_SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+#endif
+
+int send_gathered(socket_info_type* socket_info,
+		  const void* prefix, size_t prefix_len,
+		  const int nbufs, void** bufs, const size_t* lens,
+		  int more) {
+
+  int           connector = socket_info->connector_handle;
+  int           gathered = socket_info->gather_bytes;
+  int           nparts = 0;
+  int           nsent;
+  int           i;
+#ifndef _MSC_VER
+  ssize_t       result;
+  static int    max_iov = 0;
+  struct iovec  iov_stack[REG_GATHER_MAX_PARTS];
+  struct iovec *iov = iov_stack;
+  struct iovec *piov;
+  struct msghdr msg;
+  int           flags = 0;
+  int           status = REG_SUCCESS;
+
+  if(nbufs + 2 > REG_GATHER_MAX_PARTS) {
+    iov = (struct iovec*) malloc((nbufs + 2)*sizeof(struct iovec));
+    if(!iov) {
+      fprintf(stderr, "STEER: ERROR: send_gathered: failed to allocate "
+	      "memory for %d iovecs\n", nbufs + 2);
+      socket_info->gather_bytes = 0;
+      return REG_FAILURE;
+    }
+  }
+
+  if(prefix && prefix_len > 0) {
+    iov[nparts].iov_base = (void*) prefix;
+    iov[nparts++].iov_len = prefix_len;
+  }
+  if(gathered > 0) {
+    iov[nparts].iov_base = socket_info->gather_buf;
+    iov[nparts++].iov_len = (size_t) gathered;
+  }
+  for(i = 0; i < nbufs; i++) {
+    if(bufs[i] && lens[i] > 0) {
+      iov[nparts].iov_base = bufs[i];
+      iov[nparts++].iov_len = lens[i];
+    }
+  }
+#endif
+
+  /* Whatever happens, what was gathered is gone */
+  socket_info->gather_bytes = 0;
+
+#if REG_HAS_MSG_MORE
+  if(more) socket_info->corked = REG_TRUE;
+#else
+  if(more) set_tcpcork(socket_info, REG_TRUE);
+#endif
+
+#ifndef _MSC_VER
+  if(max_iov == 0) {
+    max_iov = (int) sysconf(_SC_IOV_MAX);
+    if(max_iov <= 0) max_iov = REG_GATHER_MAX_PARTS;
+  }
+
+#if REG_HAS_MSG_NOSIGNAL
+  flags = MSG_NOSIGNAL;
+#endif
+#if REG_HAS_MSG_MORE
+  if(more) flags |= MSG_MORE;
+#endif
+
+  nsent = nparts;
+  piov = iov;
+  while(nparts > 0) {
+    memset(&msg, 0, sizeof(struct msghdr));
+    msg.msg_iov = piov;
+    msg.msg_iovlen = (nparts < max_iov) ? nparts : max_iov;
+
+    result = sendmsg(connector, &msg, flags);
+    socket_info->num_syscalls++;
+    if(result == REG_SOCKETS_ERROR) {
+      perror("sendmsg");
+      status = REG_FAILURE;
+      break;
+    }
+
+    /* Step over whatever was sent */
+    while(nparts > 0 && (size_t) result >= piov->iov_len) {
+      result -= piov->iov_len;
+      piov++;
+      nparts--;
+    }
+    if(nparts > 0) {
+      piov->iov_base = (char*) piov->iov_base + result;
+      piov->iov_len -= result;
+    }
+  }
+
+  if(iov != iov_stack) free(iov);
+  if(status != REG_SUCCESS) return status;
+#else
+  /* No sendmsg() in MSVC so send each part in turn */
+  if(send_all(socket_info, (const char*) prefix, prefix_len) != REG_SUCCESS ||
+     send_all(socket_info, socket_info->gather_buf,
+	      (size_t) gathered) != REG_SUCCESS) {
+    return REG_FAILURE;
+  }
+  for(i = 0; i < nbufs; i++) {
+    if(send_all(socket_info, (const char*) bufs[i],
+		lens[i]) != REG_SUCCESS) {
+      return REG_FAILURE;
+    }
+  }
+  nsent = 1;
+#endif
+
+#if REG_HAS_MSG_MORE
+  /* A send without MSG_MORE pushes out anything held back */
+  if(!more && nsent > 0) socket_info->corked = REG_FALSE;
+#else
+  if(!more) set_tcpcork(socket_info, REG_FALSE);
+#endif
+
+  return REG_SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+int set_tcpcork(socket_info_type* socket_info, int on) {
+#if REG_HAS_MSG_MORE || defined(TCP_CORK) || defined(TCP_NOPUSH)
+  int flag = on ? 1 : 0;
+  int result;
+
+  if(socket_info->corked == flag) return REG_SUCCESS;
+  socket_info->corked = flag;
+
+#if REG_HAS_MSG_MORE
+  /* Sends flagged with MSG_MORE do the corking and (re)setting
+     TCP_NODELAY pushes out whatever they left behind */
+  if(on) return REG_SUCCESS;
+  socket_info->num_syscalls++;
+  result = set_tcpnodelay(socket_info->connector_handle);
+#elif defined(TCP_CORK)
+  socket_info->num_syscalls++;
+  result = setsockopt(socket_info->connector_handle, IPPROTO_TCP, TCP_CORK,
+		      &flag, sizeof(int));
+#else
+  socket_info->num_syscalls++;
+  result = setsockopt(socket_info->connector_handle, IPPROTO_TCP, TCP_NOPUSH,
+		      &flag, sizeof(int));
+#endif
+
+  if(result == REG_SOCKETS_ERROR) {
+    perror("setsockopt");
+    return REG_FAILURE;
+  }
+#endif
+
+  return REG_SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
 ssize_t recv_wait_all(int s, void *buf, size_t len, int flags) {
 #if REG_HAS_MSG_WAITALL && !defined(_MSC_VER)
   return recv(s, buf, len, flags | MSG_WAITALL);
@@ -314,6 +619,736 @@ int set_tcpnodelay(int s) {
 
 /*--------------------------------------------------------------------*/
 
+int set_send_timeout(int s, int seconds) {
+#ifdef _MSC_VER
+  DWORD timeout = (DWORD) (1000*seconds);
+
+  return setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, (char*) &timeout,
+		    sizeof(DWORD));
+#else
+  struct timeval timeout;
+
+  timeout.tv_sec = seconds;
+  timeout.tv_usec = 0;
+  return setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+		    sizeof(struct timeval));
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+
+int set_recv_lowat(int s, int bytes) {
+  return setsockopt(s, SOL_SOCKET, SO_RCVLOWAT, (char*) &bytes,
+		    sizeof(int));
+}
+
+/*--------------------------------------------------------------------*/
+
+int get_socket_address(int s, int peer, char* host, int* port) {
+  struct sockaddr_storage addr;
+  socklen_t addrlen = sizeof(addr);
+  char      hostbuf[NI_MAXHOST];
+  char      serv[NI_MAXSERV];
+  int       status;
+
+  if(peer) {
+    status = getpeername(s, (struct sockaddr*) &addr, &addrlen);
+  }
+  else {
+    status = getsockname(s, (struct sockaddr*) &addr, &addrlen);
+  }
+  if(status == REG_SOCKETS_ERROR) {
+    perror("getsockname");
+    return REG_FAILURE;
+  }
+
+  status = getnameinfo((struct sockaddr*) &addr, addrlen,
+		       host ? host : hostbuf, NI_MAXHOST, serv, NI_MAXSERV,
+		       NI_NUMERICHOST | NI_NUMERICSERV);
+  if(status != 0) {
+    fprintf(stderr, "STEER: getnameinfo: %s\n", gai_strerror(status));
+    return REG_FAILURE;
+  }
+
+  *port = atoi(serv);
+  return REG_SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+int listen_in_range(const char* interface, int min_port, int max_port,
+		    int* port) {
+  struct addrinfo  hints;
+  struct addrinfo* result;
+  struct addrinfo* rp;
+  char             port_str[8];
+  int              listener = REG_SOCKETS_ERROR;
+  int              status;
+  int              i;
+
+  memset(&hints, 0, sizeof(struct addrinfo));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_NUMERICHOST;
+  hints.ai_protocol = IPPROTO_TCP;
+
+  for(i = min_port; i <= max_port; i++) {
+    sprintf(port_str, "%d", i);
+    status = getaddrinfo(interface, port_str, &hints, &result);
+    if(status != 0) {
+      fprintf(stderr, "STEER: getaddrinfo: %s\n", gai_strerror(status));
+      return REG_SOCKETS_ERROR;
+    }
+
+    for(rp = result; rp != NULL; rp = rp->ai_next) {
+      listener = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+      if(listener == REG_SOCKETS_ERROR)
+	continue;
+
+      if(bind(listener, rp->ai_addr, rp->ai_addrlen) == 0 &&
+	 listen(listener, REG_MAX_STREAMS) == 0) {
+	break; /* success */
+      }
+
+      /* couldn't use that port, close listener and start again */
+      closesocket(listener);
+      listener = REG_SOCKETS_ERROR;
+    }
+
+    freeaddrinfo(result);
+
+    if(listener != REG_SOCKETS_ERROR) {
+      /* Port zero means the system chose one */
+      if(get_socket_address(listener, REG_FALSE, NULL,
+			    port) != REG_SUCCESS) {
+	closesocket(listener);
+	return REG_SOCKETS_ERROR;
+      }
+      return listener;
+    }
+  }
+
+  return REG_SOCKETS_ERROR;
+}
+
+/*--------------------------------------------------------------------*/
+
+int connect_from_range(const char* interface, int min_port, int max_port,
+		       const char* hostname, int port) {
+  struct addrinfo  hints;
+  struct addrinfo* result;
+  struct addrinfo* rp;
+  char             port_str[8];
+  int              connector = REG_SOCKETS_ERROR;
+  int              status;
+  int              i;
+
+  memset(&hints, 0, sizeof(struct addrinfo));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = AI_NUMERICHOST;
+  hints.ai_protocol = IPPROTO_TCP;
+
+  /* bind even though we are connecting out so that we can punch out
+     of firewalls */
+  for(i = min_port; i <= max_port; i++) {
+    sprintf(port_str, "%d", i);
+    status = getaddrinfo(interface, port_str, &hints, &result);
+    if(status != 0) {
+      fprintf(stderr, "STEER: getaddrinfo: %s\n", gai_strerror(status));
+      return REG_SOCKETS_ERROR;
+    }
+
+    for(rp = result; rp != NULL; rp = rp->ai_next) {
+      connector = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+      if(connector == REG_SOCKETS_ERROR)
+	continue;
+
+      if(bind(connector, rp->ai_addr, rp->ai_addrlen) == 0) {
+	break; /* success */
+      }
+
+      closesocket(connector);
+      connector = REG_SOCKETS_ERROR;
+    }
+
+    freeaddrinfo(result);
+
+    if(connector != REG_SOCKETS_ERROR) break;
+  }
+
+  if(connector == REG_SOCKETS_ERROR) return REG_SOCKETS_ERROR;
+
+  hints.ai_flags = 0;
+  sprintf(port_str, "%d", port);
+  status = getaddrinfo(hostname, port_str, &hints, &result);
+  if(status != 0) {
+    fprintf(stderr, "STEER: getaddrinfo: %s\n", gai_strerror(status));
+    closesocket(connector);
+    return REG_SOCKETS_ERROR;
+  }
+
+  for(rp = result; rp != NULL; rp = rp->ai_next) {
+    if(connect(connector, rp->ai_addr, rp->ai_addrlen) != REG_SOCKETS_ERROR)
+      break; /* connected - success */
+  }
+  freeaddrinfo(result);
+
+  if(rp == NULL) {
+    fprintf(stderr, "STEER: connect_from_range: could not connect to "
+	    "%s:%d\n", hostname, port);
+    closesocket(connector);
+    return REG_SOCKETS_ERROR;
+  }
+
+  return connector;
+}
+
+/*--------------------------------------------------------------------*/
+
+/** @internal
+    The part of a striped transfer that one stream carries */
+typedef struct {
+  /** Handle of the stream's socket */
+  int    handle;
+  /** Whether (REG_TRUE) we are sending or receiving */
+  int    sending;
+  /** The whole of the data being transferred (NULL to throw away
+      what is received) */
+  char*  buf;
+  /** Length of @p buf in bytes */
+  size_t len;
+  /** First piece of @p buf that this stream carries, counting from
+      the start of the round of pieces in which @p buf starts */
+  size_t first;
+  /** No. of streams, so that this stream carries every num'th piece */
+  size_t num;
+  /** Where in the round of pieces @p buf starts */
+  size_t pos;
+  /** REG_SUCCESS or REG_FAILURE once the transfer is done */
+  int    status;
+} stripe_job_type;
+
+/** @internal
+    @param job The part of the transfer to do
+
+    Send or receive every piece of a striped transfer that goes over
+    one stream. */
+static void stripe_job_run(stripe_job_type* job) {
+  char    discard[4096];
+  char*   ptr;
+  size_t  piece, start, end, want;
+  ssize_t nbytes;
+
+  job->status = REG_SUCCESS;
+
+  /* Piece p of a round covers bytes p*C - pos to (p + 1)*C - pos of
+     the buffer, and the pieces go to the streams in turn */
+  for(piece = job->first;
+      piece*REG_STRIPE_CHUNK_SIZE < job->pos + job->len;
+      piece += job->num) {
+    start = piece*REG_STRIPE_CHUNK_SIZE;
+    start = (start > job->pos) ? start - job->pos : 0;
+    end = (piece + 1)*REG_STRIPE_CHUNK_SIZE - job->pos;
+    if(end > job->len) end = job->len;
+
+    while(start < end) {
+      want = end - start;
+      if(job->sending) {
+	nbytes = send_no_signal(job->handle, &(job->buf[start]), want, 0);
+      }
+      else {
+	if(job->buf) {
+	  ptr = &(job->buf[start]);
+	}
+	else {
+	  ptr = discard;
+	  if(want > sizeof(discard)) want = sizeof(discard);
+	}
+	nbytes = recv_wait_all(job->handle, ptr, want, 0);
+      }
+
+      if(nbytes <= 0) {
+	if(nbytes < 0) perror(job->sending ? "send" : "recv");
+	job->status = REG_FAILURE;
+	return;
+      }
+      start += (size_t) nbytes;
+    }
+  }
+}
+
+#if REG_HAS_PTHREADS
+/** @internal
+    Thread entry point for stripe_job_run(). */
+static void* stripe_thread(void* arg) {
+  stripe_job_run((stripe_job_type*) arg);
+  return NULL;
+}
+#endif
+
+/** @internal
+    @param stripes The parallel streams, all connected
+    @param buf The data to send, or buffer in which to receive it
+    @param len No. of bytes to transfer
+    @param sending REG_TRUE to send, REG_FALSE to receive
+    @return REG_SUCCESS, REG_FAILURE
+
+    Does the work of send_striped() and recv_striped(). Stream 0 is
+    done in the calling thread and each of the others that has
+    something to carry in a thread of its own, or in the calling
+    thread afterwards if that thread cannot be started. */
+static int stripe_transfer(stripe_info_type* stripes, void* buf,
+			   size_t len, int sending) {
+  stripe_job_type jobs[REG_MAX_STREAMS];
+#if REG_HAS_PTHREADS
+  pthread_t       threads[REG_MAX_STREAMS];
+  int             started[REG_MAX_STREAMS];
+#endif
+  size_t          round;
+  size_t          pos;
+  int             status = REG_SUCCESS;
+  int             t;
+
+  if(stripes->num < 1 || stripes->num_connected != stripes->num) {
+    fprintf(stderr, "STEER: ERROR: stripe_transfer: parallel streams "
+	    "are not connected\n");
+    return REG_FAILURE;
+  }
+  if(len == 0) return REG_SUCCESS;
+
+  round = (size_t) stripes->num*REG_STRIPE_CHUNK_SIZE;
+  pos = (size_t) (stripes->total % round);
+
+  for(t = 0; t < stripes->num; t++) {
+    jobs[t].handle = stripes->handles[t];
+    jobs[t].sending = sending;
+    jobs[t].buf = (char*) buf;
+    jobs[t].len = len;
+    jobs[t].num = (size_t) stripes->num;
+    jobs[t].pos = pos;
+
+    /* This stream's piece of the current round may be behind us */
+    jobs[t].first = (size_t) t;
+    if((jobs[t].first + 1)*REG_STRIPE_CHUNK_SIZE <= pos) {
+      jobs[t].first += jobs[t].num;
+    }
+  }
+
+#if REG_HAS_PTHREADS
+  for(t = 1; t < stripes->num; t++) {
+    started[t] = REG_FALSE;
+    if(jobs[t].first*REG_STRIPE_CHUNK_SIZE < pos + len) {
+      started[t] = (pthread_create(&threads[t], NULL, stripe_thread,
+				   &(jobs[t])) == 0);
+    }
+  }
+#endif
+
+  stripe_job_run(&(jobs[0]));
+
+  for(t = 1; t < stripes->num; t++) {
+#if REG_HAS_PTHREADS
+    if(started[t]) {
+      pthread_join(threads[t], NULL);
+      continue;
+    }
+#endif
+    stripe_job_run(&(jobs[t]));
+  }
+
+  for(t = 0; t < stripes->num; t++) {
+    if(jobs[t].status != REG_SUCCESS) status = REG_FAILURE;
+  }
+
+  if(status == REG_SUCCESS) stripes->total += len;
+
+  return status;
+}
+
+/*--------------------------------------------------------------------*/
+
+int send_striped(stripe_info_type* stripes, const void* buf, size_t len) {
+  return stripe_transfer(stripes, (void*) buf, len, REG_TRUE);
+}
+
+/*--------------------------------------------------------------------*/
+
+int recv_striped(stripe_info_type* stripes, void* buf, size_t len) {
+  return stripe_transfer(stripes, buf, len, REG_FALSE);
+}
+
+/*--------------------------------------------------------------------*/
+
+void close_stripes(stripe_info_type* stripes) {
+  int i;
+
+  for(i = 0; i < stripes->num; i++) {
+    if(stripes->handles[i] == -1) continue;
+
+    reactor_remove(stripes->handles[i]);
+    if(closesocket(stripes->handles[i]) == REG_SOCKETS_ERROR) {
+      perror("close");
+    }
+    stripes->handles[i] = -1;
+  }
+
+  stripes->num = 0;
+  stripes->num_connected = 0;
+  stripes->total = 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/** @internal
+    @param s File descriptor of the socket to ask about
+
+    The old way - a zero-timeout select() on one socket. */
+static int select_events(int s) {
+  struct timeval timeout;
+  fd_set sockets;
+
+  timeout.tv_sec  = 0;
+  timeout.tv_usec = 0;
+
+#ifndef _MSC_VER
+  if(s >= FD_SETSIZE) {
+    fprintf(stderr, "STEER: select_events: socket %d is too big for "
+	    "select()\n", s);
+    return 0;
+  }
+#endif
+
+  FD_ZERO(&sockets);
+  FD_SET(s, &sockets);
+
+  if(select(s + 1, &sockets, NULL, NULL, &timeout) == -1) {
+    perror("select");
+    return 0;
+  }
+
+  return FD_ISSET(s, &sockets) ? REG_REACTOR_READ : 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+#if REG_HAS_EPOLL
+/** @internal
+    @param s File descriptor of the socket to watch
+
+    Add a socket to the epoll set, creating the set the first time. */
+static int reactor_watch(int s) {
+  struct epoll_event ev;
+  reactor_fd_type*    new_fds;
+  struct epoll_event* new_ready;
+  int                 new_max;
+
+  if(reactor.epfd == -1 &&
+     (reactor.epfd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+    perror("epoll_create1");
+    return REG_FAILURE;
+  }
+
+  if(s >= reactor.max_fds) {
+    new_max = 2*s + 16;
+    new_fds = (reactor_fd_type*) realloc(reactor.fds,
+					 new_max*sizeof(reactor_fd_type));
+    if(!new_fds) return REG_FAILURE;
+    memset(&(new_fds[reactor.max_fds]), 0,
+	   (new_max - reactor.max_fds)*sizeof(reactor_fd_type));
+    reactor.fds = new_fds;
+    reactor.max_fds = new_max;
+  }
+
+  /* Room for every socket to be ready at once so that one call
+     finds them all */
+  if(reactor.num_watched >= reactor.max_ready) {
+    new_max = 2*reactor.max_ready + 16;
+    new_ready = (struct epoll_event*)
+      realloc(reactor.ready, new_max*sizeof(struct epoll_event));
+    if(!new_ready) return REG_FAILURE;
+    reactor.ready = new_ready;
+    reactor.max_ready = new_max;
+  }
+
+  memset(&ev, 0, sizeof(ev));
+  ev.events = EPOLLIN | EPOLLRDHUP;
+  ev.data.fd = s;
+  if(epoll_ctl(reactor.epfd, EPOLL_CTL_ADD, s, &ev) == -1 &&
+     errno != EEXIST) {
+    perror("epoll_ctl");
+    return REG_FAILURE;
+  }
+
+  reactor.fds[s].watched = REG_TRUE;
+  reactor.fds[s].events = 0;
+  reactor.fds[s].seen = -1;
+  reactor.fds[s].asked = -1;
+  reactor.num_watched++;
+
+  return REG_SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+/** @internal
+    Find every watched socket that is ready with one epoll_wait(). */
+static int reactor_poll() {
+  reactor_fd_type* fd_info;
+  int              i, n;
+  unsigned int     e;
+
+  if((n = epoll_wait(reactor.epfd, reactor.ready, reactor.max_ready, 0))
+     == -1) {
+    if(errno != EINTR) perror("epoll_wait");
+    return REG_FAILURE;
+  }
+
+  reactor.num_polls++;
+  clock_gettime(CLOCK_MONOTONIC, &(reactor.polled_at));
+  for(i = 0; i < n; i++) {
+    fd_info = &(reactor.fds[reactor.ready[i].data.fd]);
+    e = reactor.ready[i].events;
+
+    /* Like select(), report a hang up as something to read */
+    fd_info->events = 0;
+    if(e & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+      fd_info->events |= REG_REACTOR_READ;
+    }
+    if(e & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+      fd_info->events |= REG_REACTOR_HUP;
+    }
+    fd_info->seen = reactor.num_polls;
+  }
+
+  return REG_SUCCESS;
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
+int reactor_events(int s) {
+#if REG_HAS_EPOLL
+  reactor_fd_type* fd_info;
+  struct timespec  now;
+  long             age_us;
+  int              poll_now = REG_FALSE;
+  int              status = REG_SUCCESS;
+  int              result = 0;
+
+  if(s < 0) return 0;
+
+#if REG_HAS_PTHREADS
+  pthread_mutex_lock(&reactor_mutex);
+#endif
+
+  /* A new socket can't have been in the last poll */
+  if(s >= reactor.max_fds || !reactor.fds[s].watched) {
+    status = reactor_watch(s);
+    poll_now = REG_TRUE;
+  }
+
+  if(status == REG_SUCCESS) {
+    fd_info = &(reactor.fds[s]);
+
+    /* Asked twice since the last poll so we've been round everything
+       once - time to look again. The last poll may also simply be
+       too old to trust, however recently this socket was asked about */
+    if(!poll_now && fd_info->asked != reactor.num_polls) {
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      age_us = (long) (now.tv_sec - reactor.polled_at.tv_sec)*1000000L +
+	(now.tv_nsec - reactor.polled_at.tv_nsec)/1000L;
+      poll_now = (age_us > REG_REACTOR_MAX_AGE);
+    }
+    if(poll_now || fd_info->asked == reactor.num_polls) {
+      status = reactor_poll();
+    }
+  }
+
+  if(status == REG_SUCCESS) {
+    fd_info->asked = reactor.num_polls;
+    result = (fd_info->seen == reactor.num_polls) ? fd_info->events : 0;
+  }
+
+#if REG_HAS_PTHREADS
+  pthread_mutex_unlock(&reactor_mutex);
+#endif
+
+  return (status == REG_SUCCESS) ? result : select_events(s);
+#else
+  if(s < 0) return 0;
+
+  return select_events(s);
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+
+void reactor_remove(int s) {
+#if REG_HAS_EPOLL
+  struct epoll_event ev;
+
+  if(s < 0) return;
+
+#if REG_HAS_PTHREADS
+  pthread_mutex_lock(&reactor_mutex);
+#endif
+
+  if(s < reactor.max_fds && reactor.fds[s].watched) {
+    /* Older kernels want a non-NULL event even though it is
+       ignored */
+    memset(&ev, 0, sizeof(ev));
+    epoll_ctl(reactor.epfd, EPOLL_CTL_DEL, s, &ev);
+
+    memset(&(reactor.fds[s]), 0, sizeof(reactor_fd_type));
+    reactor.num_watched--;
+  }
+
+#if REG_HAS_PTHREADS
+  pthread_mutex_unlock(&reactor_mutex);
+#endif
+#endif
+}
+
+/*--------------------------------------------------------------------*/
+
+int wait_for_sockets(const int* handles, const int num,
+		     const int timeout_ms) {
+  struct timeval timeout;
+  fd_set sockets;
+  int    max_s = -1;
+  int    i, n;
+
+  FD_ZERO(&sockets);
+  for(i = 0; i < num; i++) {
+    if(handles[i] < 0) continue;
+#ifndef _MSC_VER
+    if(handles[i] >= FD_SETSIZE) {
+      fprintf(stderr, "STEER: wait_for_sockets: socket %d is too big for "
+	      "select()\n", handles[i]);
+      return REG_FAILURE;
+    }
+#endif
+    FD_SET(handles[i], &sockets);
+    if(handles[i] > max_s) max_s = handles[i];
+  }
+
+  /* Nothing to wait on */
+  if(max_s == -1) return REG_FAILURE;
+
+  timeout.tv_sec  = timeout_ms/1000;
+  timeout.tv_usec = (timeout_ms%1000)*1000;
+
+  if((n = select(max_s + 1, &sockets, NULL, NULL, &timeout)) == -1) {
+    /* A signal is as good a reason as any to go and look again */
+    if(errno == EINTR) return REG_SUCCESS;
+    perror("select");
+    return REG_FAILURE;
+  }
+
+  return (n > 0) ? REG_SUCCESS : REG_TIMED_OUT;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Layout of a frame header (all multi-byte fields big-endian):
+ *   0 -  3 REG_FRAME_HDR_MAGIC
+ *   4      version
+ *   5      flags, REG_FRAME_FLAG_*
+ *   6 -  7 zero
+ *   8 - 11 sequence no. of the sample
+ *  12 - 19 no. of bytes in the frame after the header
+ *  20 - 23 Adler-32 checksum of those bytes (if REG_FRAME_FLAG_CHECKSUM,
+ *          otherwise zero) */
+
+static void pack_frame_uint32(char* buf, unsigned int val) {
+  unsigned char* p = (unsigned char*) buf;
+
+  p[0] = (unsigned char) ((val >> 24) & 0xFF);
+  p[1] = (unsigned char) ((val >> 16) & 0xFF);
+  p[2] = (unsigned char) ((val >> 8) & 0xFF);
+  p[3] = (unsigned char) (val & 0xFF);
+}
+
+static unsigned int unpack_frame_uint32(const char* buf) {
+  const unsigned char* p = (const unsigned char*) buf;
+
+  return ((unsigned int) p[0] << 24) | ((unsigned int) p[1] << 16) |
+    ((unsigned int) p[2] << 8) | (unsigned int) p[3];
+}
+
+void pack_frame_header(char* buf, int flags, unsigned int seqnum,
+		       uint64_t num_bytes, unsigned int checksum) {
+
+  memset(buf, 0, REG_FRAME_HDR_SIZE);
+  memcpy(buf, REG_FRAME_HDR_MAGIC, 4);
+  buf[4] = (char) REG_FRAME_HDR_VERSION;
+  buf[5] = (char) flags;
+  pack_frame_uint32(&(buf[8]), seqnum);
+  pack_frame_uint32(&(buf[12]), (unsigned int) (num_bytes >> 32));
+  pack_frame_uint32(&(buf[16]), (unsigned int) (num_bytes & 0xFFFFFFFF));
+  if(flags & REG_FRAME_FLAG_CHECKSUM) {
+    pack_frame_uint32(&(buf[20]), checksum);
+  }
+}
+
+/*--------------------------------------------------------------------*/
+
+int unpack_frame_header(const char* buf, int* flags, unsigned int* seqnum,
+			uint64_t* num_bytes, unsigned int* checksum) {
+  int all_flags = REG_FRAME_FLAG_START | REG_FRAME_FLAG_END |
+    REG_FRAME_FLAG_CHECKSUM;
+
+  /* Be fussy - when looking for the start of a sample this is all
+     that tells a frame header from data that happens to start with
+     the magic number */
+  if(memcmp(buf, REG_FRAME_HDR_MAGIC, 4) ||
+     buf[4] != (char) REG_FRAME_HDR_VERSION ||
+     (buf[5] & ~all_flags) || buf[6] || buf[7]) {
+    return REG_FAILURE;
+  }
+
+  *flags = (int) ((unsigned char) buf[5]);
+  *seqnum = unpack_frame_uint32(&(buf[8]));
+  *num_bytes = ((uint64_t) unpack_frame_uint32(&(buf[12])) << 32) |
+    (uint64_t) unpack_frame_uint32(&(buf[16]));
+  *checksum = unpack_frame_uint32(&(buf[20]));
+
+  if(!(*flags & REG_FRAME_FLAG_CHECKSUM) && *checksum) return REG_FAILURE;
+
+  return REG_SUCCESS;
+}
+
+/*--------------------------------------------------------------------*/
+
+unsigned int frame_checksum(unsigned int sum, const void* buf, size_t len) {
+  const Bytef* p = (const Bytef*) buf;
+  uLong        adler = (uLong) sum;
+  size_t       n;
+
+  if(!buf) return (unsigned int) adler32(0L, Z_NULL, 0);
+
+  /* zlib takes at most UINT_MAX bytes at a time */
+  while(len > 0) {
+    n = (len < (size_t) UINT_MAX) ? len : (size_t) UINT_MAX;
+    adler = adler32(adler, p, (uInt) n);
+    p += n;
+    len -= n;
+  }
+
+  return (unsigned int) adler;
+}
+
+/*--------------------------------------------------------------------*/
+
+unsigned int frame_checksum_combine(unsigned int sum1, unsigned int sum2,
+				    uint64_t len2) {
+  return (unsigned int) adler32_combine((uLong) sum1, (uLong) sum2,
+					(z_off_t) len2);
+}
+
+/*--------------------------------------------------------------------*/
+
 #ifdef _MSC_VER
 int initialize_winsock2() {
   WORD version;
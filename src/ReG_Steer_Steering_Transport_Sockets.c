@@ -805,37 +805,19 @@ int create_steering_listener(socket_info_type* socket_info) {
 
 void poll_steering_socket(socket_info_type* socket_info) {
 
-  struct timeval timeout;
-  fd_set sockets;	/* the set of sockets to check */
-  int fd_max;		/* the max socket number */
-
   int listener = socket_info->listener_handle;
   int connector = socket_info->connector_handle;
 
-  timeout.tv_sec  = 0;
-  timeout.tv_usec = 0;
-
   /* just return if we have no handles */
   if((listener == -1) && (connector == -1)) return;
 
-  /* clear the socket set and add required handles */
-  FD_ZERO(&sockets);
-
   if(socket_info->listener_status == REG_COMMS_STATUS_LISTENING) {
-    FD_SET(listener, &sockets);
-    fd_max = listener;
 
-    /* poll using select() */
 #ifdef REG_DEBUG
     fprintf(stderr, "poll_steering_socket: polling for accept\n");
 #endif
-    if(select(fd_max + 1, &sockets, NULL, NULL, &timeout) == -1) {
-      perror("select");
-      return;
-    }
-
     /* see if anything needs doing */
-    if(FD_ISSET(listener, &sockets)) {
+    if(reactor_events(listener) & REG_REACTOR_READ) {
       /* new connection */
       struct sockaddr_in theirAddr;
 #if defined(__sgi)
@@ -965,25 +947,9 @@ int consume_steering_msg(socket_info_type* socket_info, char* data) {
 
 int poll_steering_msg(socket_info_type* socket_info, int handle) {
 
-  struct timeval timeout;
-  fd_set sockets;	/* the set of sockets to check */
-  int fd_max;		/* the max socket number */
-
-  timeout.tv_sec  = 0;
-  timeout.tv_usec = 0;
-
   if(handle == -1) return REG_FAILURE;
 
-  FD_ZERO(&sockets);
-  FD_SET(handle, &sockets);
-  fd_max = handle;
-
-  if(select(fd_max + 1, &sockets, NULL, NULL, &timeout) == -1) {
-    perror("select");
-    return REG_FAILURE;
-  }
-
-  if(FD_ISSET(handle, &sockets)) {
+  if(reactor_events(handle) & REG_REACTOR_READ) {
 #ifdef REG_DEBUG
     fprintf(stderr, "socket ready...\n");
 #endif
@@ -1001,6 +967,7 @@ int poll_steering_msg(socket_info_type* socket_info, int handle) {
 /*-------------------------------------------------------*/
 
 void close_steering_listener(socket_info_type* socket_info) {
+  reactor_remove(socket_info->listener_handle);
   if(closesocket(socket_info->listener_handle) == REG_SOCKETS_ERROR) {
     perror("close");
     socket_info->listener_status = REG_COMMS_STATUS_FAILURE;
@@ -1016,6 +983,7 @@ void close_steering_listener(socket_info_type* socket_info) {
 /*-------------------------------------------------------*/
 
 void close_steering_connector(socket_info_type* socket_info) {
+  reactor_remove(socket_info->connector_handle);
   if(closesocket(socket_info->connector_handle) == REG_SOCKETS_ERROR) {
     perror("close");
     socket_info->comms_status = REG_COMMS_STATUS_FAILURE;
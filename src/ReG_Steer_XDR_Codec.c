@@ -0,0 +1,587 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+
+/** @internal
+    @file ReG_Steer_XDR_Codec.c
+    @brief Bulk XDR encoding and decoding of numeric arrays.
+
+    XDR stores 32- and 64-bit quantities in big-endian byte order, so
+    on IEEE-754 platforms encoding and decoding int, float and double
+    data is simply a matter of reversing the bytes of each element.
+    This is done for a whole array at a time: with AVX2 (selected at
+    run time) or SSE2 on x86 and with a portable loop elsewhere.
+
+    An XDR long is 32 bits.  As with xdr_long(), encoding fails if a
+    long value will not fit and decoding sign-extends.
+
+    @author Robert Haines
+  */
+
+#include "ReG_Steer_Config.h"
+#include "ReG_Steer_types.h"
+#include "ReG_Steer_XDR_Codec.h"
+
+#if !REG_BIG_ENDIAN && (defined(__SSE2__) || defined(_M_X64))
+#define REG_XDR_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if !REG_BIG_ENDIAN && (defined(__x86_64__) || defined(__i386__)) && \
+  (defined(__clang__) || (defined(__GNUC__) && \
+  (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define REG_XDR_AVX2 1
+#include <immintrin.h>
+#endif
+
+/*----------------------------------------------------------------*/
+
+/* Whether the bulk routines can be used on this platform.  If not
+   we fall back to xdr_vector() */
+static int bulk_codec_ok() {
+  return (sizeof(int) == 4 && sizeof(float) == 4 && sizeof(double) == 8);
+}
+
+/*----------------------------------------------------------------*/
+
+static void swap32_scalar(const unsigned char *in, unsigned char *out,
+			  size_t n) {
+  unsigned char b0, b1, b2, b3;
+  size_t i;
+
+  for(i = 0; i < n; i++) {
+    b0 = in[0]; b1 = in[1]; b2 = in[2]; b3 = in[3];
+    out[0] = b3; out[1] = b2; out[2] = b1; out[3] = b0;
+    in += 4;
+    out += 4;
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+static void swap64_scalar(const unsigned char *in, unsigned char *out,
+			  size_t n) {
+  unsigned char b[8];
+  size_t i;
+
+  for(i = 0; i < n; i++) {
+    b[0] = in[0]; b[1] = in[1]; b[2] = in[2]; b[3] = in[3];
+    b[4] = in[4]; b[5] = in[5]; b[6] = in[6]; b[7] = in[7];
+    out[0] = b[7]; out[1] = b[6]; out[2] = b[5]; out[3] = b[4];
+    out[4] = b[3]; out[5] = b[2]; out[6] = b[1]; out[7] = b[0];
+    in += 8;
+    out += 8;
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+/* Narrow n native longs to 4-byte XDR ones.  Returns the no. of
+   elements done, which is less than n if a value will not fit */
+static size_t narrow_long_scalar(const long *in, unsigned char *out,
+				 size_t n) {
+  unsigned int u;
+  size_t i;
+
+  for(i = 0; i < n; i++) {
+    if((long) ((int) in[i]) != in[i]) break;
+    u = (unsigned int) in[i];
+    out[0] = (unsigned char) (u >> 24); out[1] = (unsigned char) (u >> 16);
+    out[2] = (unsigned char) (u >> 8);  out[3] = (unsigned char) u;
+    out += 4;
+  }
+
+  return i;
+}
+
+/*----------------------------------------------------------------*/
+
+/* Widen elements lo to n-1 of an array of 4-byte XDR longs to native
+   ones, working backwards so that in and out may be the same */
+static void widen_long_scalar(const unsigned char *in, long *out,
+			      size_t lo, size_t n) {
+  const unsigned char *p;
+  size_t i;
+
+  for(i = n; i > lo; i--) {
+    p = in + 4*(i-1);
+    out[i-1] = (long) (int) (((unsigned int) p[0] << 24) |
+			     ((unsigned int) p[1] << 16) |
+			     ((unsigned int) p[2] << 8) | (unsigned int) p[3]);
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+#if REG_XDR_SSE2
+/* SSE2 has no byte shuffle so swap the bytes within each 16-bit
+   word with shifts and then reorder the words */
+
+static size_t swap32_sse2(const unsigned char *in, unsigned char *out,
+			  size_t n) {
+  __m128i x;
+  size_t i;
+
+  for(i = 0; i + 4 <= n; i += 4) {
+    x = _mm_loadu_si128((const __m128i*) (in + 4*i));
+    x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+    x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+    x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+    _mm_storeu_si128((__m128i*) (out + 4*i), x);
+  }
+
+  return i;
+}
+
+static size_t swap64_sse2(const unsigned char *in, unsigned char *out,
+			  size_t n) {
+  __m128i x;
+  size_t i;
+
+  for(i = 0; i + 2 <= n; i += 2) {
+    x = _mm_loadu_si128((const __m128i*) (in + 8*i));
+    x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+    x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(0, 1, 2, 3));
+    x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(0, 1, 2, 3));
+    _mm_storeu_si128((__m128i*) (out + 8*i), x);
+  }
+
+  return i;
+}
+
+/* 8-byte longs only.  A long fits in an XDR one if its high half is
+   the sign extension of its low half; stop at the first block that
+   holds one that doesn't and let the scalar code report it */
+static size_t narrow_long_sse2(const long *in, unsigned char *out,
+			       size_t n) {
+  __m128i a, b, x;
+  int ok;
+  size_t i;
+
+  for(i = 0; i + 4 <= n; i += 4) {
+    a = _mm_loadu_si128((const __m128i*) (in + i));
+    b = _mm_loadu_si128((const __m128i*) (in + i + 2));
+    ok = _mm_movemask_epi8(_mm_cmpeq_epi32(a,
+	   _mm_shuffle_epi32(_mm_srai_epi32(a, 31), _MM_SHUFFLE(2, 2, 0, 0))));
+    ok &= _mm_movemask_epi8(_mm_cmpeq_epi32(b,
+	   _mm_shuffle_epi32(_mm_srai_epi32(b, 31), _MM_SHUFFLE(2, 2, 0, 0))));
+    if((ok & 0xF0F0) != 0xF0F0) break;
+
+    x = _mm_unpacklo_epi64(_mm_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 2, 0)),
+			   _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 2, 0)));
+    x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+    x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+    x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+    _mm_storeu_si128((__m128i*) (out + 4*i), x);
+  }
+
+  return i;
+}
+
+/* 8-byte longs only.  Widens elements 0 to n-1, working backwards,
+   where n is a multiple of 4 */
+static void widen_long_sse2(const unsigned char *in, long *out, size_t n) {
+  __m128i x, sign;
+  size_t i;
+
+  for(i = n; i > 0; i -= 4) {
+    x = _mm_loadu_si128((const __m128i*) (in + 4*(i-4)));
+    x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+    x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+    x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+    sign = _mm_srai_epi32(x, 31);
+    _mm_storeu_si128((__m128i*) (out + i - 4), _mm_unpacklo_epi32(x, sign));
+    _mm_storeu_si128((__m128i*) (out + i - 2), _mm_unpackhi_epi32(x, sign));
+  }
+}
+#endif /* REG_XDR_SSE2 */
+
+/*----------------------------------------------------------------*/
+
+#if REG_XDR_AVX2
+static int have_avx2() {
+  static int avx2 = -1;
+
+  if(avx2 < 0) {
+    __builtin_cpu_init();
+    avx2 = __builtin_cpu_supports("avx2") ? 1 : 0;
+  }
+
+  return avx2;
+}
+
+__attribute__((target("avx2")))
+static size_t swap32_avx2(const unsigned char *in, unsigned char *out,
+			  size_t n) {
+  const __m256i mask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4,
+					11, 10, 9, 8, 15, 14, 13, 12,
+					3, 2, 1, 0, 7, 6, 5, 4,
+					11, 10, 9, 8, 15, 14, 13, 12);
+  __m256i x;
+  size_t i;
+
+  for(i = 0; i + 8 <= n; i += 8) {
+    x = _mm256_loadu_si256((const __m256i*) (in + 4*i));
+    _mm256_storeu_si256((__m256i*) (out + 4*i),
+			_mm256_shuffle_epi8(x, mask));
+  }
+
+  return i;
+}
+
+__attribute__((target("avx2")))
+static size_t swap64_avx2(const unsigned char *in, unsigned char *out,
+			  size_t n) {
+  const __m256i mask = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0,
+					15, 14, 13, 12, 11, 10, 9, 8,
+					7, 6, 5, 4, 3, 2, 1, 0,
+					15, 14, 13, 12, 11, 10, 9, 8);
+  __m256i x;
+  size_t i;
+
+  for(i = 0; i + 4 <= n; i += 4) {
+    x = _mm256_loadu_si256((const __m256i*) (in + 8*i));
+    _mm256_storeu_si256((__m256i*) (out + 8*i),
+			_mm256_shuffle_epi8(x, mask));
+  }
+
+  return i;
+}
+
+/* 8-byte longs only.  One byte shuffle both narrows and swaps each
+   pair of longs in a 128-bit lane; stop at the first block holding a
+   value that will not fit, as narrow_long_sse2() does */
+__attribute__((target("avx2")))
+static size_t narrow_long_avx2(const long *in, unsigned char *out,
+			       size_t n) {
+  const __m256i mask = _mm256_setr_epi8(3, 2, 1, 0, 11, 10, 9, 8,
+					-1, -1, -1, -1, -1, -1, -1, -1,
+					3, 2, 1, 0, 11, 10, 9, 8,
+					-1, -1, -1, -1, -1, -1, -1, -1);
+  __m256i x, sign;
+  size_t i;
+
+  for(i = 0; i + 4 <= n; i += 4) {
+    x = _mm256_loadu_si256((const __m256i*) (in + i));
+    sign = _mm256_shuffle_epi32(_mm256_srai_epi32(x, 31),
+				_MM_SHUFFLE(2, 2, 0, 0));
+    if(((unsigned int) _mm256_movemask_epi8(_mm256_cmpeq_epi32(x, sign)) &
+	0xF0F0F0F0u) != 0xF0F0F0F0u) break;
+
+    x = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(x, mask),
+				 _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128((__m128i*) (out + 4*i), _mm256_castsi256_si128(x));
+  }
+
+  return i;
+}
+
+/* 8-byte longs only.  Widens elements 0 to n-1, working backwards,
+   where n is a multiple of 4 */
+__attribute__((target("avx2")))
+static void widen_long_avx2(const unsigned char *in, long *out, size_t n) {
+  const __m128i mask = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4,
+				     11, 10, 9, 8, 15, 14, 13, 12);
+  __m128i x;
+  size_t i;
+
+  for(i = n; i > 0; i -= 4) {
+    x = _mm_loadu_si128((const __m128i*) (in + 4*(i-4)));
+    _mm256_storeu_si256((__m256i*) (out + i - 4),
+			_mm256_cvtepi32_epi64(_mm_shuffle_epi8(x, mask)));
+  }
+}
+#endif /* REG_XDR_AVX2 */
+
+/*----------------------------------------------------------------*/
+
+/* Convert n 4-byte elements between native and XDR byte order.
+   Works in place (in == out) as well. */
+static void swap32(const void *in, void *out, size_t n) {
+  const unsigned char *pin = (const unsigned char*) in;
+  unsigned char *pout = (unsigned char*) out;
+#if !REG_BIG_ENDIAN
+  size_t done = 0;
+#endif
+
+#if REG_BIG_ENDIAN
+  if(in != out) memmove(pout, pin, 4*n);
+#else
+#if REG_XDR_AVX2
+  if(have_avx2()) done = swap32_avx2(pin, pout, n);
+#endif
+#if REG_XDR_SSE2
+  done += swap32_sse2(pin + 4*done, pout + 4*done, n - done);
+#endif
+
+  swap32_scalar(pin + 4*done, pout + 4*done, n - done);
+#endif
+}
+
+/*----------------------------------------------------------------*/
+
+/* Convert n 8-byte elements between native and XDR byte order */
+static void swap64(const void *in, void *out, size_t n) {
+  const unsigned char *pin = (const unsigned char*) in;
+  unsigned char *pout = (unsigned char*) out;
+#if !REG_BIG_ENDIAN
+  size_t done = 0;
+#endif
+
+#if REG_BIG_ENDIAN
+  if(in != out) memmove(pout, pin, 8*n);
+#else
+#if REG_XDR_AVX2
+  if(have_avx2()) done = swap64_avx2(pin, pout, n);
+#endif
+#if REG_XDR_SSE2
+  done += swap64_sse2(pin + 8*done, pout + 8*done, n - done);
+#endif
+
+  swap64_scalar(pin + 8*done, pout + 8*done, n - done);
+#endif
+}
+
+/*----------------------------------------------------------------*/
+
+int Xdr_sizeof_type(const int type) {
+
+  switch(type) {
+  case REG_INT:
+  case REG_LONG:
+  case REG_FLOAT:
+    return 4;
+
+  case REG_DBL:
+    return 8;
+
+  default:
+    return 0;
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+int Xdr_type_from_native(const int type) {
+
+  switch(type) {
+  case REG_INT:
+    return REG_XDR_INT;
+
+  case REG_LONG:
+    return REG_XDR_LONG;
+
+  case REG_FLOAT:
+    return REG_XDR_FLOAT;
+
+  case REG_DBL:
+    return REG_XDR_DOUBLE;
+
+  default:
+    return -1;
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+/* Fall back to the system XDR routines */
+static int xdr_vector_code(const int type, const size_t count,
+			   const void *in, void *out, size_t *nbytes,
+			   enum xdr_op op) {
+  XDR          xdrs;
+  unsigned int elsize;
+  xdrproc_t    proc;
+  void        *buf;
+  void        *data;
+  int          status;
+
+  switch(type) {
+  case REG_INT:
+    elsize = sizeof(int);
+    proc = (xdrproc_t)xdr_int;
+    break;
+
+  case REG_LONG:
+    elsize = sizeof(long);
+    proc = (xdrproc_t)xdr_long;
+    break;
+
+  case REG_FLOAT:
+    elsize = sizeof(float);
+    proc = (xdrproc_t)xdr_float;
+    break;
+
+  case REG_DBL:
+    elsize = sizeof(double);
+    proc = (xdrproc_t)xdr_double;
+    break;
+
+  default:
+    return REG_FAILURE;
+  }
+
+  buf = (op == XDR_ENCODE) ? out : (void*) in;
+  data = (op == XDR_ENCODE) ? (void*) in : out;
+
+  xdrmem_create(&xdrs, buf, count*(size_t) Xdr_sizeof_type(type), op);
+  status = xdr_vector(&xdrs, (char*) data, (unsigned int) count,
+		      elsize, proc);
+  if(nbytes) *nbytes = (size_t) xdr_getpos(&xdrs);
+  xdr_destroy(&xdrs);
+
+  return (status == 1) ? REG_SUCCESS : REG_FAILURE;
+}
+
+/*----------------------------------------------------------------*/
+
+int Xdr_encode_array(const int type, const size_t count,
+		     const void *in, void *out, size_t *nbytes) {
+  const long *pl;
+  size_t      done = 0;
+
+  if(!bulk_codec_ok()) {
+    return xdr_vector_code(type, count, in, out, nbytes, XDR_ENCODE);
+  }
+
+  switch(type) {
+  case REG_INT:
+  case REG_FLOAT:
+    swap32(in, out, count);
+    break;
+
+  case REG_DBL:
+    swap64(in, out, count);
+    break;
+
+  case REG_LONG:
+    if(sizeof(long) == 4) {
+      swap32(in, out, count);
+      break;
+    }
+
+    /* Narrow to 32 bits and swap in one pass */
+    pl = (const long*) in;
+#if REG_XDR_AVX2
+    if(have_avx2()) done = narrow_long_avx2(pl, (unsigned char*) out, count);
+#endif
+#if REG_XDR_SSE2
+    done += narrow_long_sse2(pl + done, (unsigned char*) out + 4*done,
+			     count - done);
+#endif
+    done += narrow_long_scalar(pl + done, (unsigned char*) out + 4*done,
+			       count - done);
+    if(done < count) {
+      fprintf(stderr, "STEER: ERROR: Xdr_encode_array: long value "
+	      "%ld is too large for XDR\n", pl[done]);
+      return REG_FAILURE;
+    }
+    break;
+
+  default:
+    fprintf(stderr, "STEER: ERROR: Xdr_encode_array: unsupported "
+	    "type %d\n", type);
+    return REG_FAILURE;
+  }
+
+  *nbytes = count*(size_t) Xdr_sizeof_type(type);
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+int Xdr_decode_array(const int type, const size_t count,
+		     const void *in, void *out) {
+  size_t n = 0;
+
+  if(!bulk_codec_ok()) {
+    return xdr_vector_code(type, count, in, out, NULL, XDR_DECODE);
+  }
+
+  switch(type) {
+  case REG_INT:
+  case REG_FLOAT:
+    swap32(in, out, count);
+    break;
+
+  case REG_DBL:
+    swap64(in, out, count);
+    break;
+
+  case REG_LONG:
+    if(sizeof(long) == 4) {
+      swap32(in, out, count);
+      break;
+    }
+
+    /* Swap and widen in one pass.  Work backwards so that this can be
+       done in place even though a native long is bigger than an XDR
+       one: the odd elements at the end first, then whole blocks */
+#if REG_XDR_SSE2
+    n = count & ~((size_t) 3);
+#endif
+    widen_long_scalar((const unsigned char*) in, (long*) out, n, count);
+#if REG_XDR_AVX2
+    if(have_avx2()) {
+      widen_long_avx2((const unsigned char*) in, (long*) out, n);
+      n = 0;
+    }
+#endif
+#if REG_XDR_SSE2
+    widen_long_sse2((const unsigned char*) in, (long*) out, n);
+#endif
+    break;
+
+  default:
+    fprintf(stderr, "STEER: ERROR: Xdr_decode_array: unsupported "
+	    "type %d\n", type);
+    return REG_FAILURE;
+  }
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
@@ -0,0 +1,334 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+/** @internal
+    @file progressive_bench.c
+    @brief Benchmark of the time taken for a consumer to have a
+    picture of each sample.
+
+    Forks a consumer and then emits samples to it, each a time stamp
+    followed by an N*N*N array of doubles in blocks of B planes (the
+    whole array by default), each block after a chunk header.  With
+    more than one level the IOType sends each block a level of detail
+    at a time (see Set_IOType_levels()).  The consumer reports how
+    long after the time stamp it had a first picture of the whole
+    array - every block at its coarsest level, or in full with just
+    one level - and how long it took to have all of the sample, and
+    checks that every block arrives intact.  Transport set up is as
+    for sample_emit_bench.
+
+    Compare a run with one level against one with several: the first
+    picture comes once the coarsest level is through and filled in,
+    a small fraction of the array, while the whole sample takes
+    longer than with one level as each part is gathered, put back in
+    place and filled in.  With many small blocks the first picture
+    waits for the last block to be emitted, and is later than with
+    one level.
+
+    Usage: progressive_bench [no. of samples] [no. of levels] [N] [B]
+
+    @author Robert Haines
+  */
+
+#include "ReG_Steer_Config.h"
+#include "ReG_Steer_Appside.h"
+
+#include <sys/wait.h>
+
+/*----------------------------------------------------------------*/
+
+static double wall_time() {
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return (double)(tv.tv_sec) + 1.0e-6*(double)(tv.tv_usec);
+}
+
+/*----------------------------------------------------------------*/
+
+static int compare_doubles(const void *a, const void *b) {
+  double da = *((const double*) a);
+  double db = *((const double*) b);
+
+  return (da > db) - (da < db);
+}
+
+/*----------------------------------------------------------------*/
+
+/* Give each end its own steering directory */
+static int set_steer_directory(const char *tag) {
+  static char dir[REG_MAX_STRING_LENGTH];
+
+  snprintf(dir, REG_MAX_STRING_LENGTH, "/tmp/reg_bench_%s_XXXXXX", tag);
+  if(!mkdtemp(dir)) {
+    perror("mkdtemp");
+    return REG_FAILURE;
+  }
+  strcat(dir, "/");
+  setenv("REG_STEER_DIRECTORY", dir, 1);
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+static int consume(int nsamples, int nlevels, int edge, int planes,
+		   const double *field) {
+  int     cmds[1] = {REG_STR_STOP};
+  int     iotype, handle;
+  int     type, count;
+  int     level, num_levels, last;
+  int     nblocks = edge/planes;
+  int     nseen, nbad = 0;
+  int     i, n = 0;
+  size_t  block = (size_t) planes*edge*edge;
+  double  stamp, t, t_first;
+  double *first, *whole;
+  double *data;
+  char    header[REG_CHUNK_HDR_SIZE];
+
+  first = (double*) malloc(nsamples*sizeof(double));
+  whole = (double*) malloc(nsamples*sizeof(double));
+  data = (double*) malloc(block*sizeof(double));
+  if(!first || !whole || !data ||
+     set_steer_directory("consumer") != REG_SUCCESS) {
+    return 1;
+  }
+
+  Steering_enable(REG_TRUE);
+  if(Steering_initialize("progressive_bench consumer", 1,
+			 cmds) != REG_SUCCESS) {
+    return 1;
+  }
+  Register_IOType("bench_data", REG_IO_IN, 1, &iotype);
+
+  for(i = 0; i < nsamples; i++) {
+    if(Consume_start_blocking(iotype, &handle, 60.0) != REG_SUCCESS ||
+       Consume_data_slice_header(handle, &type, &count) != REG_SUCCESS ||
+       type != REG_DBL || count != 1 ||
+       Consume_data_slice(handle, type, count, &stamp) != REG_SUCCESS) {
+      fprintf(stderr, "consumer: failed to get sample %d\n", i);
+      break;
+    }
+
+    /* Every part of a block is read into the same buffer, and chunk
+       headers somewhere else */
+    t_first = 0.0;
+    nseen = 0;
+    last = -1;
+    while(Consume_data_slice_header(handle, &type, &count) == REG_SUCCESS) {
+      if(type == REG_CHAR) {
+	if(count >= REG_CHUNK_HDR_SIZE ||
+	   Consume_data_slice(handle, type, count, header) != REG_SUCCESS) {
+	  break;
+	}
+	continue;
+      }
+      if((size_t) count > block ||
+	 Consume_data_slice(handle, type, count, data) != REG_SUCCESS) {
+	break;
+      }
+      if(type != REG_DBL ||
+	 Get_IOType_level(handle, &level, &num_levels) != REG_SUCCESS) {
+	continue;
+      }
+
+      /* Each block shows up first at its coarsest level, or whole,
+	 and is complete once it is at level 0 */
+      if(num_levels == 0 || (level != last && level == num_levels - 1)) {
+	if(++nseen == nblocks) t_first = wall_time();
+      }
+      if((num_levels == 0 || (level != last && level == 0)) &&
+	 nseen <= nblocks &&
+	 memcmp(data, &(field[(nseen - 1)*block]), block*sizeof(double))) {
+	nbad++;
+      }
+      last = level;
+    }
+    t = wall_time();
+    if(t_first == 0.0) t_first = t;
+    Consume_stop(&handle);
+
+    /* The first sample waits for the two ends to connect */
+    if(i > 0) {
+      first[n] = t_first - stamp;
+      whole[n] = t - stamp;
+      n++;
+    }
+  }
+
+  if(n > 0) {
+    qsort(first, n, sizeof(double), compare_doubles);
+    qsort(whole, n, sizeof(double), compare_doubles);
+    printf("%d samples of %d^3 doubles in %d block(s), %d level(s)\n", n,
+	   edge, nblocks, nlevels);
+    printf("median first picture ms:  %.2f\n", 1.0e3*first[n/2]);
+    printf("median whole sample ms:   %.2f\n", 1.0e3*whole[n/2]);
+    printf("max first picture ms:     %.2f\n", 1.0e3*first[n - 1]);
+  }
+  if(nbad > 0) {
+    fprintf(stderr, "consumer: %d block(s) did not arrive intact\n", nbad);
+  }
+
+  Steering_finalize();
+  free(first);
+  free(whole);
+  free(data);
+
+  return (n == nsamples - 1 && nbad == 0) ? 0 : 1;
+}
+
+/*----------------------------------------------------------------*/
+
+int main(int argc, char **argv) {
+  int     cmds[1] = {REG_STR_STOP};
+  int     nsamples = (argc > 1) ? atoi(argv[1]) : 20;
+  int     nlevels  = (argc > 2) ? atoi(argv[2]) : 1;
+  int     edge     = (argc > 3) ? atoi(argv[3]) : 128;
+  int     planes   = (argc > 4) ? atoi(argv[4]) : edge;
+  int     iotype, handle;
+  int     min_port, max_port;
+  int     i, j, x, status;
+  int     sync[2];
+  char    port[16];
+  char    header[REG_CHUNK_HDR_SIZE];
+  char   *pchar;
+  double  stamp;
+  double *field;
+  size_t  plane;
+  pid_t   pid;
+
+  if(nsamples < 2 || nlevels < 1 || nlevels > REG_MAX_LEVELS ||
+     planes < 1 || edge < planes || edge % planes) {
+    fprintf(stderr, "Usage: %s [no. of samples] [no. of levels (1-%d)] "
+	    "[N] [B, a factor of N]\n", argv[0], REG_MAX_LEVELS);
+    return 1;
+  }
+
+  /* A smooth field, as a simulation might produce */
+  plane = (size_t) edge*edge;
+  field = (double*) malloc(plane*edge*sizeof(double));
+  if(!field) {
+    fprintf(stderr, "Failed to allocate field\n");
+    return 1;
+  }
+  for(j = 0; j < edge*edge*edge; j++) {
+    field[j] = sin(0.1*(j/(edge*edge))) + cos(0.1*((j/edge)%edge)) +
+      0.01*(j%edge);
+  }
+
+  /* Keep everything on this machine */
+  setenv("GLOBUS_TCP_PORT_RANGE", "40100,40110", 0);
+  setenv("REG_TCP_INTERFACE", "127.0.0.1", 0);
+  setenv("REG_IO_ADDRESS", "127.0.0.1", 0);
+  setenv("REG_CONNECTOR_HOSTNAME", "127.0.0.1", 0);
+  pchar = getenv("GLOBUS_TCP_PORT_RANGE");
+  if(sscanf(pchar, "%d,%d", &min_port, &max_port) != 2) {
+    fprintf(stderr, "Invalid GLOBUS_TCP_PORT_RANGE: %s\n", pchar);
+    return 1;
+  }
+  snprintf(port, 16, "%d", min_port + 1);
+  setenv("REG_CONNECTOR_PORT", port, 0);
+
+  /* The consumer waits until the emitter is listening */
+  if(pipe(sync) != 0) {
+    perror("pipe");
+    return 1;
+  }
+
+  pid = fork();
+  if(pid < 0) {
+    perror("fork");
+    return 1;
+  }
+  if(pid == 0) {
+    char go;
+
+    close(sync[1]);
+    if(read(sync[0], &go, 1) != 1) return 1;
+    return consume(nsamples, nlevels, edge, planes, field);
+  }
+  close(sync[0]);
+
+  if(set_steer_directory("emitter") != REG_SUCCESS) return 1;
+
+  Steering_enable(REG_TRUE);
+  if(Steering_initialize("progressive_bench", 1, cmds) != REG_SUCCESS) {
+    return 1;
+  }
+  Register_IOType("bench_data", REG_IO_OUT, 1, &iotype);
+  if(Set_IOType_levels(iotype, nlevels) != REG_SUCCESS) return 1;
+  if(write(sync[1], "g", 1) != 1) {
+    perror("write");
+    return 1;
+  }
+
+  for(i = 0; i < nsamples; i++) {
+    if(Emit_start_blocking(iotype, i, &handle, 60.0) != REG_SUCCESS) {
+      fprintf(stderr, "emitter: failed to start sample %d\n", i);
+      break;
+    }
+    stamp = wall_time();
+    Emit_data_slice(handle, REG_DBL, 1, &stamp);
+    for(x = 0; x < edge; x += planes) {
+      Make_chunk_header(header, iotype, edge, edge, edge, x, 0, 0,
+			planes, edge, edge);
+      Emit_data_slice(handle, REG_CHAR, (int) strlen(header), header);
+      Emit_data_slice(handle, REG_DBL, (int) (planes*plane),
+		      &(field[x*plane]));
+    }
+    Emit_stop(&handle);
+  }
+
+  waitpid(pid, &status, 0);
+  printf("consumer:                 %s\n",
+	 (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? "ok" : "FAILED");
+
+  Steering_finalize();
+  free(field);
+
+  return 0;
+}
@@ -0,0 +1,328 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+
+/** @internal
+    @file reorder_bench.c
+    @brief Micro-benchmark of the array reordering engine.
+
+    Converts a 3D block of each supported type between C and F90
+    ordering with both the simple loop nest that Reorder_array() used
+    to be and the blocked engine, checks that the results are
+    identical and reports the throughput of each.  The engine is also
+    checked against a naive implementation for 1 to
+    REG_REORDER_MAX_DIMS dimensions.
+
+    Then XDR-encoded blocks of the numeric types are decoded and
+    reordered both in two passes (decode into a temporary then
+    reorder), as a consumer does with a whole slice, and in the
+    single, fused pass that it uses for a slice read in chunks.
+
+    Usage: reorder_bench [nx] [ny] [nz] [no. of repeats]
+
+    Set REG_REORDER_THREADS to control the no. of threads used.
+
+    @author Robert Haines
+  */
+
+#include "ReG_Steer_Config.h"
+#include "ReG_Steer_types.h"
+#include "ReG_Steer_Appside.h"
+#include "ReG_Steer_Common.h"
+#include "ReG_Steer_XDR_Codec.h"
+#include "ReG_Steer_Reorder.h"
+
+/*----------------------------------------------------------------*/
+
+/* Get_current_time_seconds() depends on REG_USE_TIMING so time
+   things ourselves */
+static double wall_time() {
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return (double)(tv.tv_sec) + 1.0e-6*(double)(tv.tv_usec);
+}
+
+/*----------------------------------------------------------------*/
+
+/* The loop nest that Reorder_array() used, for any type */
+#define LOOP_NEST(T)							\
+  {									\
+    T *po = (T*) out;							\
+    T *pi = (T*) in;							\
+    if(to_f90 != REG_TRUE) {						\
+      nslab = tot[2]*tot[1];						\
+      nrow = tot[2];							\
+      for(k = org[2]; k < (size_t) (sub[2] + org[2]); k++)		\
+	for(j = org[1]; j < (size_t) (sub[1] + org[1]); j++)		\
+	  for(i = org[0]; i < (size_t) (sub[0] + org[0]); i++)		\
+	    po[i*nslab + j*nrow + k] = *(pi++);				\
+    }									\
+    else {								\
+      nslab = tot[0]*tot[1];						\
+      nrow = tot[0];							\
+      for(i = org[0]; i < (size_t) (sub[0] + org[0]); i++)		\
+	for(j = org[1]; j < (size_t) (sub[1] + org[1]); j++)		\
+	  for(k = org[2]; k < (size_t) (sub[2] + org[2]); k++)		\
+	    po[k*nslab + j*nrow + i] = *(pi++);				\
+    }									\
+  }
+
+static void loop_nest(int *tot, int *sub, int *org, int type,
+		      void *in, void *out, int to_f90) {
+  size_t i, j, k, nslab, nrow;
+
+  switch(type) {
+  case REG_INT:   LOOP_NEST(int);    break;
+  case REG_LONG:  LOOP_NEST(long);   break;
+  case REG_FLOAT: LOOP_NEST(float);  break;
+  case REG_DBL:   LOOP_NEST(double); break;
+  default:        LOOP_NEST(char);   break;
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+/* Element by element reordering of any no. of dimensions */
+static void naive_nd(int ndims, int *tot, int *sub, int *org, size_t es,
+		     char *in, char *out, int to_f90) {
+  int    idx[REG_REORDER_MAX_DIMS];
+  size_t n, nelem = 1, pos, src;
+  int    d;
+
+  for(d = 0; d < ndims; d++) nelem *= sub[d];
+
+  for(n = 0; n < nelem; n++) {
+    /* Index of n'th element of the source */
+    src = n;
+    if(to_f90 == REG_TRUE) {
+      for(d = ndims - 1; d >= 0; d--) {
+	idx[d] = src % sub[d];
+	src /= sub[d];
+      }
+      pos = 0;
+      for(d = ndims - 1; d >= 0; d--) pos = pos*tot[d] + idx[d] + org[d];
+    }
+    else {
+      for(d = 0; d < ndims; d++) {
+	idx[d] = src % sub[d];
+	src /= sub[d];
+      }
+      pos = 0;
+      for(d = 0; d < ndims; d++) pos = pos*tot[d] + idx[d] + org[d];
+    }
+    memcpy(out + pos*es, in + n*es, es);
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+/* Check the engine against naive_nd() for each no. of dimensions */
+static int check_nd() {
+  const int sizes[REG_REORDER_MAX_DIMS] = {37, 5, 70, 3, 9};
+  int       tot[REG_REORDER_MAX_DIMS], sub[REG_REORDER_MAX_DIMS];
+  int       org[REG_REORDER_MAX_DIMS];
+  size_t    n, ntot, nsub;
+  char     *in, *ref, *out;
+  int       ndims, d, to_f90, status = 0;
+
+  for(ndims = 1; ndims <= REG_REORDER_MAX_DIMS; ndims++) {
+    ntot = nsub = 1;
+    for(d = 0; d < ndims; d++) {
+      sub[d] = sizes[d];
+      org[d] = d % 2;
+      tot[d] = sub[d] + 2;
+      ntot *= tot[d];
+      nsub *= sub[d];
+    }
+
+    in = (char*) malloc(nsub*sizeof(double));
+    ref = (char*) malloc(ntot*sizeof(double));
+    out = (char*) malloc(ntot*sizeof(double));
+    for(n = 0; n < nsub*sizeof(double); n++) in[n] = (char) (n*7 + 3);
+
+    for(to_f90 = 0; to_f90 < 2; to_f90++) {
+      memset(ref, 0, ntot*sizeof(double));
+      memset(out, 0, ntot*sizeof(double));
+      naive_nd(ndims, tot, sub, org, sizeof(double), in, ref, to_f90);
+      Reorder_array(ndims, tot, sub, org, REG_DBL, in, out, to_f90);
+      if(memcmp(ref, out, ntot*sizeof(double))) {
+	printf("%dD reorder (to_f90 = %d) does not match\n", ndims, to_f90);
+	status = 1;
+      }
+    }
+
+    free(in);
+    free(ref);
+    free(out);
+  }
+
+  return status;
+}
+
+/*----------------------------------------------------------------*/
+
+int main(int argc, char **argv) {
+  const int   types[5] = {REG_INT, REG_LONG, REG_FLOAT, REG_DBL, REG_CHAR};
+  const char *names[5] = {"REG_INT", "REG_LONG", "REG_FLOAT", "REG_DBL",
+			  "REG_CHAR"};
+  int         tot[3], sub[3] = {256, 256, 256}, org[3] = {1, 2, 0};
+  int         repeats = 5;
+  int         i, t, to_f90, match, status = 0;
+  size_t      n, nsub, ntot, nbytes;
+  double      t0, t_loop, t_engine;
+  char       *in, *out_loop, *out_engine, *xdr, *tmp;
+
+  for(i = 0; i < 3 && argc > i + 1; i++) sub[i] = atoi(argv[i + 1]);
+  if(argc > 4) repeats = atoi(argv[4]);
+  if(sub[0] < 1 || sub[1] < 1 || sub[2] < 1 || repeats < 1) {
+    fprintf(stderr, "Usage: %s [nx] [ny] [nz] [no. of repeats]\n",
+	    argv[0]);
+    return 1;
+  }
+
+  /* Place the block inside a slightly bigger array */
+  tot[0] = sub[0] + 3;
+  tot[1] = sub[1] + 2;
+  tot[2] = sub[2] + 1;
+  nsub = (size_t) sub[0]*sub[1]*sub[2];
+  ntot = (size_t) tot[0]*tot[1]*tot[2];
+
+  in = (char*) malloc(nsub*sizeof(double));
+  out_loop = (char*) malloc(ntot*sizeof(double));
+  out_engine = (char*) malloc(ntot*sizeof(double));
+  xdr = (char*) malloc(nsub*REG_MAX_SIZEOF_XDR_TYPE);
+  tmp = (char*) malloc(nsub*sizeof(double));
+  if(!in || !out_loop || !out_engine || !xdr || !tmp) {
+    fprintf(stderr, "Failed to allocate buffers\n");
+    return 1;
+  }
+  for(n = 0; n < nsub*sizeof(double); n++) in[n] = (char) (n*13 + 1);
+
+  status = check_nd();
+
+  printf("%d x %d x %d block, %d repeats (throughput in GB/s of "
+	 "native data)\n", sub[0], sub[1], sub[2], repeats);
+  printf("%-10s %-8s %12s %12s %8s %8s\n", "type", "to", "loop nest",
+	 "engine", "speedup", "match");
+
+  for(t = 0; t < 5; t++) {
+    nbytes = nsub*Sizeof_type(types[t]);
+
+    for(to_f90 = 0; to_f90 < 2; to_f90++) {
+      memset(out_loop, 0, ntot*sizeof(double));
+      memset(out_engine, 0, ntot*sizeof(double));
+
+      t0 = wall_time();
+      for(i = 0; i < repeats; i++)
+	loop_nest(tot, sub, org, types[t], in, out_loop, to_f90);
+      t_loop = wall_time() - t0;
+
+      t0 = wall_time();
+      for(i = 0; i < repeats; i++)
+	Reorder_array(3, tot, sub, org, types[t], in, out_engine, to_f90);
+      t_engine = wall_time() - t0;
+
+      match = !memcmp(out_loop, out_engine, ntot*Sizeof_type(types[t]));
+      if(!match) status = 1;
+
+      printf("%-10s %-8s %12.2f %12.2f %8.1f %8s\n", names[t],
+	     to_f90 ? "F90" : "C", repeats*nbytes/(1.0e9*t_loop),
+	     repeats*nbytes/(1.0e9*t_engine), t_loop/t_engine,
+	     match ? "yes" : "NO");
+    }
+  }
+
+  printf("\nXDR decode and reorder (throughput in GB/s of native data)\n");
+  printf("%-10s %-8s %12s %12s %8s %8s\n", "type", "to", "two pass",
+	 "fused", "speedup", "match");
+
+  for(t = 0; t < 4; t++) {
+    nbytes = nsub*Sizeof_type(types[t]);
+    /* Longs must fit in an XDR long */
+    if(types[t] == REG_LONG) {
+      for(n = 0; n < nsub; n++) ((long*) tmp)[n] = (long) ((int) (n*40503u));
+      Xdr_encode_array(types[t], nsub, tmp, xdr, &n);
+    }
+    else {
+      Xdr_encode_array(types[t], nsub, in, xdr, &n);
+    }
+
+    for(to_f90 = 0; to_f90 < 2; to_f90++) {
+      memset(out_loop, 0, ntot*sizeof(double));
+      memset(out_engine, 0, ntot*sizeof(double));
+
+      t0 = wall_time();
+      for(i = 0; i < repeats; i++) {
+	Xdr_decode_array(types[t], nsub, xdr, tmp);
+	Reorder_array(3, tot, sub, org, types[t], tmp, out_loop, to_f90);
+      }
+      t_loop = wall_time() - t0;
+
+      t0 = wall_time();
+      for(i = 0; i < repeats; i++)
+	Reorder_decode_nd(3, tot, sub, org, types[t], xdr, out_engine,
+			  to_f90);
+      t_engine = wall_time() - t0;
+
+      match = !memcmp(out_loop, out_engine, ntot*Sizeof_type(types[t]));
+      if(!match) status = 1;
+
+      printf("%-10s %-8s %12.2f %12.2f %8.1f %8s\n", names[t],
+	     to_f90 ? "F90" : "C", repeats*nbytes/(1.0e9*t_loop),
+	     repeats*nbytes/(1.0e9*t_engine), t_loop/t_engine,
+	     match ? "yes" : "NO");
+    }
+  }
+
+  free(in);
+  free(out_loop);
+  free(out_engine);
+  free(xdr);
+  free(tmp);
+
+  return status;
+}
@@ -0,0 +1,307 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+/** @internal
+    @file sample_emit_bench.c
+    @brief Benchmark of sample emission over the samples transport.
+
+    Forks a consumer and then emits samples to it, each made up of a
+    number of slices of doubles.  Reports the rate at which samples
+    were emitted and the no. of system calls the transport made per
+    sample.  The emitter spins waiting for the consumer and each
+    acknowledgement rather than sleeping as Emit_start_blocking()
+    does.  With the sockets
+    transport both ends run on the loopback
+    interface using ports from GLOBUS_TCP_PORT_RANGE (40100-40110 if
+    that is not set) - the consumer assumes that the emitter's data
+    socket is the second port in the range.
+
+    With "async" the IOType is emitted asynchronously (blocking when
+    both snapshot buffers are busy so that every sample still arrives)
+    and the time that the emitting loop spends inside the emit calls is
+    reported separately.  A simulated compute phase of the given no.
+    of milliseconds between samples shows how much of the emission is
+    hidden behind the application's own work.
+
+    With more than one stream, both ends ask for that many parallel
+    streams (see Set_IOType_streams()) so slices of at least
+    REG_STRIPE_MIN_BYTES are split between them.  Every element of
+    every slice is checked on arrival.  With "checksum" the samples'
+    frames carry checksums (see Set_IOType_checksum()) which the
+    consumer checks too.
+
+    Usage: sample_emit_bench [no. of samples] [slices per sample]
+                             [doubles per slice] [sync|async]
+                             [compute ms per sample] [streams]
+                             [checksum|none]
+
+    @author Robert Haines
+  */
+
+#include "ReG_Steer_Config.h"
+#include "ReG_Steer_Appside.h"
+
+#include <sys/wait.h>
+
+/*----------------------------------------------------------------*/
+
+/* Get_current_time_seconds() depends on REG_USE_TIMING so time
+   things ourselves */
+static double wall_time() {
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return (double)(tv.tv_sec) + 1.0e-6*(double)(tv.tv_usec);
+}
+
+/*----------------------------------------------------------------*/
+
+/* Stand in for a timestep of the application */
+static void compute(double ms) {
+  double t0 = wall_time();
+
+  while(1000.0*(wall_time() - t0) < ms);
+}
+
+/*----------------------------------------------------------------*/
+
+/* Give each end its own steering directory */
+static int set_steer_directory(const char *tag) {
+  static char dir[REG_MAX_STRING_LENGTH];
+
+  snprintf(dir, REG_MAX_STRING_LENGTH, "/tmp/reg_bench_%s_XXXXXX", tag);
+  if(!mkdtemp(dir)) {
+    perror("mkdtemp");
+    return REG_FAILURE;
+  }
+  strcat(dir, "/");
+  setenv("REG_STEER_DIRECTORY", dir, 1);
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+static int consume(int nsamples, int nslices, int len, int nstreams) {
+  int     cmds[1] = {REG_STR_STOP};
+  int     iotype, handle;
+  int     type, count;
+  int     i, j, n, bad = 0;
+  double *data;
+
+  data = (double*) malloc(len*sizeof(double));
+  if(!data || set_steer_directory("consumer") != REG_SUCCESS) return 1;
+
+  Steering_enable(REG_TRUE);
+  if(Steering_initialize("sample_emit_bench consumer", 1,
+			 cmds) != REG_SUCCESS) {
+    return 1;
+  }
+  Register_IOType("bench_data", REG_IO_IN, 1, &iotype);
+  if(Set_IOType_streams(iotype, nstreams) != REG_SUCCESS) return 1;
+
+  for(i = 0; i < nsamples; i++) {
+    if(Consume_start_blocking(iotype, &handle, 60.0) != REG_SUCCESS) {
+      fprintf(stderr, "consumer: timed out waiting for sample %d\n", i);
+      bad++;
+      break;
+    }
+    n = 0;
+    while(Consume_data_slice_header(handle, &type, &count) == REG_SUCCESS) {
+      n++;
+      if(type != REG_DBL || count != len) {
+	bad++;
+	break;
+      }
+      Consume_data_slice(handle, type, count, data);
+      for(j = 0; j < len; j++) {
+	if(data[j] != (double) (i + j)) {
+	  bad++;
+	  break;
+	}
+      }
+    }
+    if(n != nslices) bad++;
+    if(Consume_stop(&handle) != REG_SUCCESS) bad++;
+  }
+
+  Steering_finalize();
+  free(data);
+
+  return bad;
+}
+
+/*----------------------------------------------------------------*/
+
+int main(int argc, char **argv) {
+  int     cmds[1] = {REG_STR_STOP};
+  int     nsamples = (argc > 1) ? atoi(argv[1]) : 1000;
+  int     nslices  = (argc > 2) ? atoi(argv[2]) : 8;
+  int     len      = (argc > 3) ? atoi(argv[3]) : 64;
+  int     async    = (argc > 4) ? !strcmp(argv[4], "async") : 0;
+  double  work_ms  = (argc > 5) ? atof(argv[5]) : 0.0;
+  int     nstreams = (argc > 6) ? atoi(argv[6]) : 1;
+  int     checksum = (argc > 7) ? !strcmp(argv[7], "checksum") : 0;
+  int     iotype, handle;
+  int     min_port, max_port;
+  int     num_samples, num_syscalls;
+  int     i, j, status;
+  int     sync[2];
+  char    port[16];
+  char   *pchar;
+  double *data;
+  double  t0, t1, t_emit = 0.0;
+  double  held_bytes, high_water;
+  pid_t   pid;
+
+  if(nsamples < 1 || nslices < 1 || len < 1 || nstreams < 1 ||
+     nstreams > REG_MAX_STREAMS) {
+    fprintf(stderr, "Usage: %s [no. of samples] [slices per sample] "
+	    "[doubles per slice] [sync|async] [compute ms per sample] "
+	    "[streams] [checksum|none]\n", argv[0]);
+    return 1;
+  }
+
+  /* Keep everything on this machine */
+  setenv("GLOBUS_TCP_PORT_RANGE", "40100,40110", 0);
+  setenv("REG_TCP_INTERFACE", "127.0.0.1", 0);
+  setenv("REG_IO_ADDRESS", "127.0.0.1", 0);
+  setenv("REG_CONNECTOR_HOSTNAME", "127.0.0.1", 0);
+  pchar = getenv("GLOBUS_TCP_PORT_RANGE");
+  if(sscanf(pchar, "%d,%d", &min_port, &max_port) != 2) {
+    fprintf(stderr, "Invalid GLOBUS_TCP_PORT_RANGE: %s\n", pchar);
+    return 1;
+  }
+  snprintf(port, 16, "%d", min_port + 1);
+  setenv("REG_CONNECTOR_PORT", port, 0);
+
+  /* The consumer waits until the emitter is listening */
+  if(pipe(sync) != 0) {
+    perror("pipe");
+    return 1;
+  }
+
+  pid = fork();
+  if(pid < 0) {
+    perror("fork");
+    return 1;
+  }
+  if(pid == 0) {
+    char go;
+
+    close(sync[1]);
+    if(read(sync[0], &go, 1) != 1) return 1;
+    return consume(nsamples, nslices, len, nstreams) ? 1 : 0;
+  }
+  close(sync[0]);
+
+  data = (double*) malloc(len*sizeof(double));
+  if(!data || set_steer_directory("emitter") != REG_SUCCESS) return 1;
+
+  Steering_enable(REG_TRUE);
+  if(Steering_initialize("sample_emit_bench", 1, cmds) != REG_SUCCESS) {
+    return 1;
+  }
+  Register_IOType("bench_data", REG_IO_OUT, 1, &iotype);
+  if(Set_IOType_streams(iotype, nstreams) != REG_SUCCESS ||
+     Set_IOType_checksum(iotype, checksum) != REG_SUCCESS) {
+    return 1;
+  }
+  if(async && Enable_IOType_async(iotype, REG_ASYNC_BLOCK) != REG_SUCCESS) {
+    return 1;
+  }
+  if(write(sync[1], "g", 1) != 1) {
+    perror("write");
+    return 1;
+  }
+
+  t0 = wall_time();
+  for(i = 0; i < nsamples; i++) {
+    compute(work_ms);
+    for(j = 0; j < len; j++) data[j] = (double) (i + j);
+
+    t1 = wall_time();
+    while((status = Emit_start(iotype, i, &handle)) != REG_SUCCESS &&
+	  wall_time() - t1 < 60.0);
+    if(status != REG_SUCCESS) {
+      fprintf(stderr, "emitter: failed to start sample %d\n", i);
+      break;
+    }
+    for(j = 0; j < nslices; j++) {
+      Emit_data_slice(handle, REG_DBL, len, data);
+    }
+    Emit_stop(&handle);
+    t_emit += wall_time() - t1;
+  }
+
+  /* Wait for the I/O thread to send everything */
+  if(async) Disable_IOType_async(iotype);
+  t1 = wall_time();
+
+  Get_IOType_emit_stats(iotype, &num_samples, &num_syscalls);
+  Get_IOType_buffer_stats(iotype, &held_bytes, &high_water);
+  waitpid(pid, &status, 0);
+
+  printf("%d samples of %d x %d doubles over %d stream%s in %.3f s\n",
+	 num_samples, nslices, len, nstreams, (nstreams > 1) ? "s" : "",
+	 t1 - t0);
+  if(num_samples > 0) {
+    printf("samples/s:          %.1f\n", num_samples/(t1 - t0));
+    printf("MB/s:               %.1f\n", (double) num_samples*nslices*len*
+	   sizeof(double)/(1024.0*1024.0*(t1 - t0)));
+    printf("syscalls/sample:    %.2f\n", (double) num_syscalls/num_samples);
+    printf("emit ms/sample:     %.3f (%s)\n", 1000.0*t_emit/nsamples,
+	   async ? "async" : "sync");
+    printf("buffer high water:  %.0f KB\n", high_water/1024.0);
+  }
+  printf("consumer:           %s\n",
+	 (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? "ok" : "FAILED");
+
+  Steering_finalize();
+  free(data);
+
+  return 0;
+}
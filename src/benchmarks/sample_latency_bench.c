@@ -0,0 +1,288 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+/** @internal
+    @file sample_latency_bench.c
+    @brief Benchmark of the time taken for a sample to be noticed.
+
+    Forks a consumer and then emits small samples to it at intervals,
+    each carrying the time at which its data was emitted.  The
+    consumer reports how long after that Consume_start() succeeded
+    for it.
+
+    With "event" both ends use Emit_start_blocking() and
+    Consume_start_blocking(), which sleep until the transport has
+    something for them.  With "poll" they retry Emit_start() and
+    Consume_start() every 10 ms instead, which is what the blocking
+    calls used to do.  The consumer's CPU time shows what each costs
+    while there is nothing to do.  Transport set up is as for
+    sample_emit_bench.
+
+    Usage: sample_latency_bench [no. of samples] [event|poll]
+                                [ms between samples]
+
+    @author Robert Haines
+  */
+
+#include "ReG_Steer_Config.h"
+#include "ReG_Steer_Appside.h"
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+/* How often the old blocking calls polled (microseconds) */
+#define POLL_INTERVAL 10000
+
+/*----------------------------------------------------------------*/
+
+static double wall_time() {
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return (double)(tv.tv_sec) + 1.0e-6*(double)(tv.tv_usec);
+}
+
+/*----------------------------------------------------------------*/
+
+static double cpu_time() {
+  struct rusage ru;
+
+  getrusage(RUSAGE_SELF, &ru);
+  return (double)(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) +
+    1.0e-6*(double)(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec);
+}
+
+/*----------------------------------------------------------------*/
+
+static int compare_doubles(const void *a, const void *b) {
+  double da = *((const double*) a);
+  double db = *((const double*) b);
+
+  return (da > db) - (da < db);
+}
+
+/*----------------------------------------------------------------*/
+
+/* Give each end its own steering directory */
+static int set_steer_directory(const char *tag) {
+  static char dir[REG_MAX_STRING_LENGTH];
+
+  snprintf(dir, REG_MAX_STRING_LENGTH, "/tmp/reg_bench_%s_XXXXXX", tag);
+  if(!mkdtemp(dir)) {
+    perror("mkdtemp");
+    return REG_FAILURE;
+  }
+  strcat(dir, "/");
+  setenv("REG_STEER_DIRECTORY", dir, 1);
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+static int consume(int nsamples, int poll) {
+  int     cmds[1] = {REG_STR_STOP};
+  int     iotype, handle;
+  int     type, count;
+  int     i, n = 0;
+  double  stamp, t, t0, cpu0, total = 0.0;
+  double *latency;
+
+  latency = (double*) malloc(nsamples*sizeof(double));
+  if(!latency || set_steer_directory("consumer") != REG_SUCCESS) return 1;
+
+  Steering_enable(REG_TRUE);
+  if(Steering_initialize("sample_latency_bench consumer", 1,
+			 cmds) != REG_SUCCESS) {
+    return 1;
+  }
+  Register_IOType("bench_data", REG_IO_IN, 1, &iotype);
+
+  t0 = wall_time();
+  cpu0 = cpu_time();
+  for(i = 0; i < nsamples; i++) {
+    if(poll) {
+      while(Consume_start(iotype, &handle) != REG_SUCCESS &&
+	    wall_time() - t0 < 60.0) {
+	usleep(POLL_INTERVAL);
+      }
+    }
+    else if(Consume_start_blocking(iotype, &handle, 60.0) != REG_SUCCESS) {
+      handle = REG_IODEF_HANDLE_NOTSET;
+    }
+    t = wall_time();
+
+    if(Consume_data_slice_header(handle, &type, &count) != REG_SUCCESS ||
+       type != REG_DBL || count != 1 ||
+       Consume_data_slice(handle, type, count, &stamp) != REG_SUCCESS) {
+      fprintf(stderr, "consumer: failed to get sample %d\n", i);
+      break;
+    }
+    Consume_stop(&handle);
+
+    /* The first sample waits for the two ends to connect */
+    if(i > 0) {
+      latency[n] = t - stamp;
+      total += latency[n];
+      n++;
+    }
+  }
+  cpu0 = cpu_time() - cpu0;
+
+  if(n > 0) {
+    qsort(latency, n, sizeof(double), compare_doubles);
+    printf("%d samples (%s)\n", n, poll ? "poll" : "event");
+    printf("mean latency us:    %.1f\n", 1.0e6*total/n);
+    printf("median latency us:  %.1f\n", 1.0e6*latency[n/2]);
+    printf("99%% latency us:     %.1f\n", 1.0e6*latency[(99*n)/100]);
+    printf("max latency us:     %.1f\n", 1.0e6*latency[n - 1]);
+    printf("consumer CPU s:     %.3f of %.3f\n", cpu0, wall_time() - t0);
+  }
+
+  Steering_finalize();
+  free(latency);
+
+  return (n == nsamples - 1) ? 0 : 1;
+}
+
+/*----------------------------------------------------------------*/
+
+int main(int argc, char **argv) {
+  int     cmds[1] = {REG_STR_STOP};
+  int     nsamples = (argc > 1) ? atoi(argv[1]) : 200;
+  int     poll     = (argc > 2) ? !strcmp(argv[2], "poll") : 0;
+  double  gap_ms   = (argc > 3) ? atof(argv[3]) : 20.0;
+  int     iotype, handle;
+  int     min_port, max_port;
+  int     i, status;
+  int     sync[2];
+  char    port[16];
+  char   *pchar;
+  double  stamp, t0;
+  pid_t   pid;
+
+  if(nsamples < 2 || gap_ms < 0.0) {
+    fprintf(stderr, "Usage: %s [no. of samples] [event|poll] "
+	    "[ms between samples]\n", argv[0]);
+    return 1;
+  }
+
+  /* Keep everything on this machine */
+  setenv("GLOBUS_TCP_PORT_RANGE", "40100,40110", 0);
+  setenv("REG_TCP_INTERFACE", "127.0.0.1", 0);
+  setenv("REG_IO_ADDRESS", "127.0.0.1", 0);
+  setenv("REG_CONNECTOR_HOSTNAME", "127.0.0.1", 0);
+  pchar = getenv("GLOBUS_TCP_PORT_RANGE");
+  if(sscanf(pchar, "%d,%d", &min_port, &max_port) != 2) {
+    fprintf(stderr, "Invalid GLOBUS_TCP_PORT_RANGE: %s\n", pchar);
+    return 1;
+  }
+  snprintf(port, 16, "%d", min_port + 1);
+  setenv("REG_CONNECTOR_PORT", port, 0);
+
+  /* The consumer waits until the emitter is listening */
+  if(pipe(sync) != 0) {
+    perror("pipe");
+    return 1;
+  }
+
+  pid = fork();
+  if(pid < 0) {
+    perror("fork");
+    return 1;
+  }
+  if(pid == 0) {
+    char go;
+
+    close(sync[1]);
+    if(read(sync[0], &go, 1) != 1) return 1;
+    return consume(nsamples, poll);
+  }
+  close(sync[0]);
+
+  if(set_steer_directory("emitter") != REG_SUCCESS) return 1;
+
+  Steering_enable(REG_TRUE);
+  if(Steering_initialize("sample_latency_bench", 1, cmds) != REG_SUCCESS) {
+    return 1;
+  }
+  Register_IOType("bench_data", REG_IO_OUT, 1, &iotype);
+  if(write(sync[1], "g", 1) != 1) {
+    perror("write");
+    return 1;
+  }
+
+  for(i = 0; i < nsamples; i++) {
+    /* Give the consumer time to start waiting */
+    if(i > 0) usleep((useconds_t) (1000.0*gap_ms));
+
+    if(poll) {
+      t0 = wall_time();
+      while((status = Emit_start(iotype, i, &handle)) != REG_SUCCESS &&
+	    wall_time() - t0 < 60.0) {
+	usleep(POLL_INTERVAL);
+      }
+    }
+    else {
+      status = Emit_start_blocking(iotype, i, &handle, 60.0);
+    }
+    if(status != REG_SUCCESS) {
+      fprintf(stderr, "emitter: failed to start sample %d\n", i);
+      break;
+    }
+    stamp = wall_time();
+    Emit_data_slice(handle, REG_DBL, 1, &stamp);
+    Emit_stop(&handle);
+  }
+
+  waitpid(pid, &status, 0);
+  printf("consumer:           %s\n",
+	 (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? "ok" : "FAILED");
+
+  Steering_finalize();
+
+  return 0;
+}
@@ -0,0 +1,260 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+/** @internal
+    @file window_bench.c
+    @brief Benchmark of sending samples ahead of acknowledgements.
+
+    Forks a consumer and then emits samples to it as fast as it will
+    take them.  Both ends spend the same time on each sample on
+    average (sleeping, in place of computing it or looking at it) but
+    the consumer only looks at every so many samples, like a viewer
+    that redraws now and then.  With a window of one sample, where
+    the emitter waits for each sample to be acknowledged before it
+    sends the next, the emitter stands idle while the consumer looks
+    and the consumer has nothing to read while the emitter computes.
+    With a larger window (see Set_IOType_window()) the samples queue
+    up in between.  Reports samples per second and how long the
+    emitter spent waiting to start samples.  Transport set up is as
+    for sample_emit_bench.
+
+    Usage: window_bench [no. of samples] [window] [KB per sample]
+                        [ms spent on each sample at each end]
+                        [samples between the consumer's looks]
+
+    @author Robert Haines
+  */
+
+#include "ReG_Steer_Config.h"
+#include "ReG_Steer_Appside.h"
+
+#include <sys/wait.h>
+
+/*----------------------------------------------------------------*/
+
+static double wall_time() {
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return (double)(tv.tv_sec) + 1.0e-6*(double)(tv.tv_usec);
+}
+
+/*----------------------------------------------------------------*/
+
+/* Give each end its own steering directory */
+static int set_steer_directory(const char *tag) {
+  static char dir[REG_MAX_STRING_LENGTH];
+
+  snprintf(dir, REG_MAX_STRING_LENGTH, "/tmp/reg_bench_%s_XXXXXX", tag);
+  if(!mkdtemp(dir)) {
+    perror("mkdtemp");
+    return REG_FAILURE;
+  }
+  strcat(dir, "/");
+  setenv("REG_STEER_DIRECTORY", dir, 1);
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+static int consume(int nsamples, int window, int count, double work_ms,
+		   int every) {
+  int     cmds[1] = {REG_STR_STOP};
+  int     iotype, handle;
+  int     type, n;
+  int     i;
+  double *data;
+
+  data = (double*) malloc(count*sizeof(double));
+  if(!data || set_steer_directory("consumer") != REG_SUCCESS) return 1;
+
+  Steering_enable(REG_TRUE);
+  if(Steering_initialize("window_bench consumer", 1, cmds) != REG_SUCCESS) {
+    return 1;
+  }
+  Register_IOType("bench_data", REG_IO_IN, 1, &iotype);
+  if(Set_IOType_window(iotype, window) != REG_SUCCESS) return 1;
+
+  for(i = 0; i < nsamples; i++) {
+    if(Consume_start_blocking(iotype, &handle, 60.0) != REG_SUCCESS ||
+       Consume_data_slice_header(handle, &type, &n) != REG_SUCCESS ||
+       type != REG_DBL || n != count ||
+       Consume_data_slice(handle, type, n, data) != REG_SUCCESS ||
+       data[0] != (double) i) {
+      fprintf(stderr, "consumer: failed to get sample %d\n", i);
+      break;
+    }
+    Consume_stop(&handle);
+
+    /* Look at the last few */
+    if((i + 1) % every == 0) usleep((useconds_t) (1000.0*every*work_ms));
+  }
+
+  Steering_finalize();
+  free(data);
+
+  return (i == nsamples) ? 0 : 1;
+}
+
+/*----------------------------------------------------------------*/
+
+int main(int argc, char **argv) {
+  int     cmds[1] = {REG_STR_STOP};
+  int     nsamples = (argc > 1) ? atoi(argv[1]) : 200;
+  int     window   = (argc > 2) ? atoi(argv[2]) : 1;
+  int     kbytes   = (argc > 3) ? atoi(argv[3]) : 256;
+  double  work_ms  = (argc > 4) ? atof(argv[4]) : 2.0;
+  int     every    = (argc > 5) ? atoi(argv[5]) : 4;
+  int     iotype, handle;
+  int     min_port, max_port;
+  int     count;
+  int     i, status;
+  int     sync[2];
+  char    port[16];
+  char   *pchar;
+  double *data;
+  double  t0, t1, waited = 0.0;
+  pid_t   pid;
+
+  if(nsamples < 2 || window < 1 || window > REG_MAX_WINDOW ||
+     kbytes < 1 || work_ms < 0.0 || every < 1) {
+    fprintf(stderr, "Usage: %s [no. of samples] [window, 1 to %d] "
+	    "[KB per sample] [ms spent on each sample at each end] "
+	    "[samples between the consumer's looks]\n", argv[0],
+	    REG_MAX_WINDOW);
+    return 1;
+  }
+  count = (1024*kbytes)/(int)sizeof(double);
+
+  /* Keep everything on this machine */
+  setenv("GLOBUS_TCP_PORT_RANGE", "40100,40110", 0);
+  setenv("REG_TCP_INTERFACE", "127.0.0.1", 0);
+  setenv("REG_IO_ADDRESS", "127.0.0.1", 0);
+  setenv("REG_CONNECTOR_HOSTNAME", "127.0.0.1", 0);
+  pchar = getenv("GLOBUS_TCP_PORT_RANGE");
+  if(sscanf(pchar, "%d,%d", &min_port, &max_port) != 2) {
+    fprintf(stderr, "Invalid GLOBUS_TCP_PORT_RANGE: %s\n", pchar);
+    return 1;
+  }
+  snprintf(port, 16, "%d", min_port + 1);
+  setenv("REG_CONNECTOR_PORT", port, 0);
+
+  /* The consumer waits until the emitter is listening */
+  if(pipe(sync) != 0) {
+    perror("pipe");
+    return 1;
+  }
+
+  pid = fork();
+  if(pid < 0) {
+    perror("fork");
+    return 1;
+  }
+  if(pid == 0) {
+    char go;
+
+    close(sync[1]);
+    if(read(sync[0], &go, 1) != 1) return 1;
+    return consume(nsamples, window, count, work_ms, every);
+  }
+  close(sync[0]);
+
+  data = (double*) malloc(count*sizeof(double));
+  if(!data || set_steer_directory("emitter") != REG_SUCCESS) return 1;
+  for(i = 0; i < count; i++) data[i] = 0.5*(double) i;
+
+  Steering_enable(REG_TRUE);
+  if(Steering_initialize("window_bench", 1, cmds) != REG_SUCCESS) {
+    return 1;
+  }
+  Register_IOType("bench_data", REG_IO_OUT, 1, &iotype);
+  if(write(sync[1], "g", 1) != 1) {
+    perror("write");
+    return 1;
+  }
+
+  /* The first sample waits for the two ends to connect so the clock
+     starts once it has gone */
+  t0 = 0.0;
+  for(i = 0; i < nsamples; i++) {
+    /* Compute it */
+    usleep((useconds_t) (1000.0*work_ms));
+
+    t1 = wall_time();
+    if(Emit_start_blocking(iotype, i, &handle, 60.0) != REG_SUCCESS) {
+      fprintf(stderr, "emitter: failed to start sample %d\n", i);
+      break;
+    }
+    if(i > 0) {
+      waited += wall_time() - t1;
+    }
+    else {
+      t0 = wall_time();
+    }
+
+    data[0] = (double) i;
+    Emit_data_slice(handle, REG_DBL, count, data);
+    Emit_stop(&handle);
+  }
+
+  waitpid(pid, &status, 0);
+  t1 = wall_time();
+
+  printf("%d samples of %d KB, window %d, %.1f ms per sample at "
+	 "each end, consumer looks every %d\n", nsamples, kbytes, window,
+	 work_ms, every);
+  printf("samples/s:          %.1f\n", (double)(nsamples - 1)/(t1 - t0));
+  printf("emitter waited ms:  %.1f per sample\n",
+	 1000.0*waited/(double)(nsamples - 1));
+  printf("consumer:           %s\n",
+	 (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? "ok" : "FAILED");
+
+  Steering_finalize();
+  free(data);
+
+  return 0;
+}
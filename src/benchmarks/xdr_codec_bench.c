@@ -0,0 +1,249 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+
+/** @internal
+    @file xdr_codec_bench.c
+    @brief Micro-benchmark of the bulk XDR codec.
+
+    Encodes and decodes arrays of each supported type with both
+    xdr_vector() and the bulk codec, checks that the encoded bytes
+    are identical and reports the throughput of each.
+
+    Usage: xdr_codec_bench [no. of elements] [no. of repeats]
+
+    @author Robert Haines
+  */
+
+#include "ReG_Steer_Config.h"
+#include "ReG_Steer_types.h"
+#include "ReG_Steer_Common.h"
+#include "ReG_Steer_XDR_Codec.h"
+
+/*----------------------------------------------------------------*/
+
+/* Get_current_time_seconds() depends on REG_USE_TIMING so time
+   things ourselves */
+static double wall_time() {
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return (double)(tv.tv_sec) + 1.0e-6*(double)(tv.tv_usec);
+}
+
+/*----------------------------------------------------------------*/
+
+static int xdr_vector_encode(int type, size_t count, void *in, char *out) {
+  XDR          xdrs;
+  unsigned int elsize;
+  xdrproc_t    proc;
+
+  switch(type) {
+  case REG_INT:
+    elsize = sizeof(int);
+    proc = (xdrproc_t)xdr_int;
+    break;
+  case REG_LONG:
+    elsize = sizeof(long);
+    proc = (xdrproc_t)xdr_long;
+    break;
+  case REG_FLOAT:
+    elsize = sizeof(float);
+    proc = (xdrproc_t)xdr_float;
+    break;
+  default:
+    elsize = sizeof(double);
+    proc = (xdrproc_t)xdr_double;
+    break;
+  }
+
+  xdrmem_create(&xdrs, out, count*Xdr_sizeof_type(type), XDR_ENCODE);
+  xdr_vector(&xdrs, (char*) in, (unsigned int) count, elsize, proc);
+  xdr_destroy(&xdrs);
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+static int xdr_vector_decode(int type, size_t count, char *in, void *out) {
+  XDR          xdrs;
+  unsigned int elsize;
+  xdrproc_t    proc;
+
+  switch(type) {
+  case REG_INT:
+    elsize = sizeof(int);
+    proc = (xdrproc_t)xdr_int;
+    break;
+  case REG_LONG:
+    elsize = sizeof(long);
+    proc = (xdrproc_t)xdr_long;
+    break;
+  case REG_FLOAT:
+    elsize = sizeof(float);
+    proc = (xdrproc_t)xdr_float;
+    break;
+  default:
+    elsize = sizeof(double);
+    proc = (xdrproc_t)xdr_double;
+    break;
+  }
+
+  xdrmem_create(&xdrs, in, count*Xdr_sizeof_type(type), XDR_DECODE);
+  xdr_vector(&xdrs, (char*) out, (unsigned int) count, elsize, proc);
+  xdr_destroy(&xdrs);
+
+  return REG_SUCCESS;
+}
+
+/*----------------------------------------------------------------*/
+
+static void fill(int type, size_t count, void *data) {
+  size_t i;
+
+  for(i = 0; i < count; i++) {
+    switch(type) {
+    case REG_INT:
+      ((int*) data)[i] = (int) (i * 2654435761u) - 12345;
+      break;
+    case REG_LONG:
+      ((long*) data)[i] = (long) ((int) (i * 40503u)) - 7;
+      break;
+    case REG_FLOAT:
+      ((float*) data)[i] = (float) i * 0.37f - 1.0e5f;
+      break;
+    default:
+      ((double*) data)[i] = (double) i * 1.0e-3 - 3.14159;
+      break;
+    }
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+int main(int argc, char **argv) {
+  const int   types[4] = {REG_INT, REG_LONG, REG_FLOAT, REG_DBL};
+  const char *names[4] = {"REG_INT", "REG_LONG", "REG_FLOAT", "REG_DBL"};
+  size_t      count = 1 << 22;
+  int         repeats = 10;
+  int         i, t, status = 0;
+  size_t      nbytes, xdr_bytes;
+  double      t0, t1, t_vec_enc, t_bulk_enc, t_vec_dec, t_bulk_dec;
+  void       *data, *data_out;
+  char       *enc_vec, *enc_bulk;
+
+  if(argc > 1) count = (size_t) atol(argv[1]);
+  if(argc > 2) repeats = atoi(argv[2]);
+  if(count < 1 || repeats < 1) {
+    fprintf(stderr, "Usage: %s [no. of elements] [no. of repeats]\n",
+	    argv[0]);
+    return 1;
+  }
+
+  data = malloc(count*sizeof(double));
+  data_out = malloc(count*sizeof(double));
+  enc_vec = (char*) malloc(count*REG_MAX_SIZEOF_XDR_TYPE);
+  enc_bulk = (char*) malloc(count*REG_MAX_SIZEOF_XDR_TYPE);
+  if(!data || !data_out || !enc_vec || !enc_bulk) {
+    fprintf(stderr, "Failed to allocate buffers\n");
+    return 1;
+  }
+
+  printf("%lu elements, %d repeats (throughput in MB/s of native data)\n",
+	 (unsigned long) count, repeats);
+  printf("%-10s %12s %12s %12s %12s %8s\n", "type", "xdr_vector enc",
+	 "bulk enc", "xdr_vector dec", "bulk dec", "match");
+
+  for(t = 0; t < 4; t++) {
+    fill(types[t], count, data);
+    xdr_bytes = count*Xdr_sizeof_type(types[t]);
+    nbytes = count*Sizeof_type(types[t]);
+
+    t0 = wall_time();
+    for(i = 0; i < repeats; i++)
+      xdr_vector_encode(types[t], count, data, enc_vec);
+    t1 = wall_time();
+    t_vec_enc = t1 - t0;
+
+    t0 = wall_time();
+    for(i = 0; i < repeats; i++)
+      Xdr_encode_array(types[t], count, data, enc_bulk, &xdr_bytes);
+    t1 = wall_time();
+    t_bulk_enc = t1 - t0;
+
+    t0 = wall_time();
+    for(i = 0; i < repeats; i++)
+      xdr_vector_decode(types[t], count, enc_vec, data_out);
+    t1 = wall_time();
+    t_vec_dec = t1 - t0;
+
+    t0 = wall_time();
+    for(i = 0; i < repeats; i++)
+      Xdr_decode_array(types[t], count, enc_bulk, data_out);
+    t1 = wall_time();
+    t_bulk_dec = t1 - t0;
+
+    /* Encoded bytes must match those from the system routines and
+       must decode back to the original values */
+    if(memcmp(enc_vec, enc_bulk, xdr_bytes) ||
+       memcmp(data, data_out, nbytes)) {
+      status = 1;
+    }
+
+    printf("%-10s %12.1f %12.1f %12.1f %12.1f %8s\n", names[t],
+	   repeats*nbytes/(1.0e6*t_vec_enc), repeats*nbytes/(1.0e6*t_bulk_enc),
+	   repeats*nbytes/(1.0e6*t_vec_dec), repeats*nbytes/(1.0e6*t_bulk_dec),
+	   status ? "NO" : "yes");
+  }
+
+  free(data);
+  free(data_out);
+  free(enc_vec);
+  free(enc_bulk);
+
+  return status;
+}
@@ -124,4 +124,24 @@
   INTEGER (KIND=REG_SP_KIND), PARAMETER :: REG_IO_OUT   = 1
   INTEGER (KIND=REG_SP_KIND), PARAMETER :: REG_IO_INOUT = 2
 
+! What Emit_start does for an asynchronous IOType when its buffers are busy
+
+  INTEGER (KIND=REG_SP_KIND), PARAMETER :: REG_ASYNC_BLOCK     = 0
+  INTEGER (KIND=REG_SP_KIND), PARAMETER :: REG_ASYNC_DROP      = 1
+  INTEGER (KIND=REG_SP_KIND), PARAMETER :: REG_ASYNC_OVERWRITE = 2
+
+! Codecs for compressing the data slices of an IOType
+
+  INTEGER (KIND=REG_SP_KIND), PARAMETER :: REG_COMPRESS_NONE = 0
+  INTEGER (KIND=REG_SP_KIND), PARAMETER :: REG_COMPRESS_ZLIB = 1
+
+! Lossy encodings of float and double slices and their error bounds
+
+  INTEGER (KIND=REG_SP_KIND), PARAMETER :: REG_LOSSY_NONE     = 0
+  INTEGER (KIND=REG_SP_KIND), PARAMETER :: REG_LOSSY_TRUNCATE = 1
+  INTEGER (KIND=REG_SP_KIND), PARAMETER :: REG_LOSSY_QUANT16  = 2
+  INTEGER (KIND=REG_SP_KIND), PARAMETER :: REG_LOSSY_HALF     = 3
+  INTEGER (KIND=REG_SP_KIND), PARAMETER :: REG_ERROR_ABS      = 0
+  INTEGER (KIND=REG_SP_KIND), PARAMETER :: REG_ERROR_REL      = 1
+
 end module reg_steer_module
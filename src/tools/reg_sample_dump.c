@@ -0,0 +1,424 @@
+/*
+  The RealityGrid Steering Library
+
+  Copyright (c) 2002-2010, University of Manchester, United Kingdom.
+  All rights reserved.
+
+  This software is produced by Research Computing Services, University
+  of Manchester as part of the RealityGrid project and associated
+  follow on projects, funded by the EPSRC under grants GR/R67699/01,
+  GR/R67699/02, GR/T27488/01, EP/C536452/1, EP/D500028/1,
+  EP/F00561X/1.
+
+  LICENCE TERMS
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+    * Redistributions of source code must retain the above copyright
+       notice, this list of conditions and the following disclaimer.
+
+    * Redistributions in binary form must reproduce the above
+      copyright notice, this list of conditions and the following
+      disclaimer in the documentation and/or other materials provided
+      with the distribution.
+
+    * Neither the name of The University of Manchester nor the names
+      of its contributors may be used to endorse or promote products
+      derived from this software without specific prior written
+      permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  POSSIBILITY OF SUCH DAMAGE.
+
+  Author: Robert Haines
+ */
+
+
+/** @internal
+    @file reg_sample_dump.c
+    @brief Lists the slices held in the data files written by the
+    files samples transport.
+
+    Reads the index at the end of each file and prints where each
+    slice lies, its type and size and, for slices that are a block
+    of a larger array, where the block fits in the array.  Given a
+    slice number it also prints the first values in that slice,
+    decompressing and decoding them as required.  Files with no
+    index (written by older versions of the library, or by an
+    emitter that was killed part way through) are reported as such.
+
+    Usage: reg_sample_dump [-s slice] [-n no. of values] file...
+
+    @author Robert Haines
+  */
+
+#include "ReG_Steer_Config.h"
+#include "ReG_Steer_types.h"
+#include "ReG_Steer_Common.h"
+#include "ReG_Steer_Compress.h"
+#include "ReG_Steer_Lossy.h"
+#include "ReG_Steer_XDR_Codec.h"
+
+/*----------------------------------------------------------------*/
+
+static const char *type_name(const int type) {
+
+  switch(type) {
+  case REG_INT:         return "INT";
+  case REG_FLOAT:       return "FLOAT";
+  case REG_DBL:         return "DOUBLE";
+  case REG_CHAR:        return "CHAR";
+  case REG_XDR_INT:     return "XDR_INT";
+  case REG_XDR_FLOAT:   return "XDR_FLOAT";
+  case REG_XDR_DOUBLE:  return "XDR_DOUBLE";
+  case REG_BIN:         return "BIN";
+  case REG_LONG:        return "LONG";
+  case REG_XDR_LONG:    return "XDR_LONG";
+  case REG_Q16_FLOAT:   return "Q16_FLOAT";
+  case REG_Q16_DOUBLE:  return "Q16_DOUBLE";
+  case REG_HALF_FLOAT:  return "HALF_FLOAT";
+  case REG_HALF_DOUBLE: return "HALF_DOUBLE";
+  default:              return "UNKNOWN";
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+static const char *flags_name(const int flags, char *buf) {
+
+  buf[0] = '\0';
+  if(flags & REG_SLICE_FLAG_KEY) strcat(buf, "key,");
+  if(flags & REG_SLICE_FLAG_DELTA) strcat(buf, "delta,");
+  if(flags & REG_SLICE_FLAG_STRIPED) strcat(buf, "striped,");
+  if(flags & REG_SLICE_FLAG_REGIONS) strcat(buf, "regions,");
+  if(flags & REG_SLICE_FLAG_CREDITS) strcat(buf, "credits,");
+
+  if(buf[0]) {
+    buf[strlen(buf) - 1] = '\0';
+  }
+  else {
+    strcpy(buf, "-");
+  }
+
+  return buf;
+}
+
+/*----------------------------------------------------------------*/
+
+/* Reads the index from the end of a data file.  Returns the no. of
+   entries in it or -1 if the file doesn't have one. */
+static int read_index(FILE *fp, const char *filename,
+		      Slice_index_entry **index, char *format) {
+  char     trailer[REG_PACKET_SIZE];
+  char    *entries;
+  long     size;
+  uint64_t offset;
+  int      num_entries;
+  int      i;
+
+  if(fseek(fp, 0, SEEK_END) || (size = ftell(fp)) < 2*REG_PACKET_SIZE ||
+     fseek(fp, size - REG_PACKET_SIZE, SEEK_SET) ||
+     fread(trailer, 1, REG_PACKET_SIZE, fp) != REG_PACKET_SIZE ||
+     Unpack_index_trailer(trailer, &num_entries, &offset,
+			  format) != REG_SUCCESS) {
+    return -1;
+  }
+
+  if(offset + (uint64_t)num_entries*REG_INDEX_ENTRY_SIZE +
+     REG_PACKET_SIZE != (uint64_t)size) {
+    fprintf(stderr, "%s: index does not match the size of the file\n",
+	    filename);
+    return -1;
+  }
+
+  *index = (Slice_index_entry*) malloc((num_entries + 1)*
+				       sizeof(Slice_index_entry));
+  entries = (char*) malloc(num_entries*REG_INDEX_ENTRY_SIZE + 1);
+  if(!(*index) || !entries) {
+    fprintf(stderr, "%s: malloc failed\n", filename);
+    free(*index);
+    free(entries);
+    return -1;
+  }
+
+  if(fseek(fp, (long)offset, SEEK_SET) ||
+     fread(entries, REG_INDEX_ENTRY_SIZE, num_entries, fp) !=
+     (size_t)num_entries) {
+    fprintf(stderr, "%s: failed to read index\n", filename);
+    free(*index);
+    free(entries);
+    return -1;
+  }
+
+  for(i = 0; i < num_entries; i++) {
+    Unpack_index_entry(&(entries[i*REG_INDEX_ENTRY_SIZE]), &((*index)[i]));
+  }
+  free(entries);
+
+  return num_entries;
+}
+
+/*----------------------------------------------------------------*/
+
+static void list_slices(const Slice_index_entry *index,
+			const int num_entries) {
+  const Slice_index_entry *entry;
+  const Array_type        *array;
+  char                     flags[48];
+  int                      i;
+
+  printf("%6s %12s %-11s %10s %10s %10s %-5s %-13s %s\n", "slice",
+	 "offset", "type", "count", "bytes", "raw bytes", "codec",
+	 "flags", "array");
+
+  for(i = 0; i < num_entries; i++) {
+    entry = &(index[i]);
+    printf("%6d %12.0f %-11s %10d %10d %10d %-5s %-13s ", i,
+	   (double)entry->header_offset, type_name(entry->type),
+	   entry->count, entry->num_bytes, entry->raw_bytes,
+	   entry->codec == REG_COMPRESS_ZLIB ? "zlib" :
+	   (entry->codec == REG_COMPRESS_NONE ? "none" : "?"),
+	   flags_name(entry->flags, flags));
+
+    if(entry->has_array) {
+      array = &(entry->array);
+      printf("%dx%dx%d at (%d,%d,%d) of %dx%dx%d, %s order\n",
+	     array->nx, array->ny, array->nz, array->sx, array->sy,
+	     array->sz, array->totx, array->toty, array->totz,
+	     entry->is_fortran ? "F90" : "C");
+    }
+    else {
+      printf("-\n");
+    }
+  }
+}
+
+/*----------------------------------------------------------------*/
+
+static void print_values(const int type, const void *data, const int count,
+			 const int max_values) {
+  int n = (count < max_values) ? count : max_values;
+  int i;
+
+  for(i = 0; i < n; i++) {
+    switch(type) {
+    case REG_INT:
+      printf("%8d  %d\n", i, ((const int*)data)[i]);
+      break;
+    case REG_LONG:
+      printf("%8d  %ld\n", i, ((const long*)data)[i]);
+      break;
+    case REG_FLOAT:
+      printf("%8d  %.9g\n", i, (double)((const float*)data)[i]);
+      break;
+    case REG_DBL:
+      printf("%8d  %.17g\n", i, ((const double*)data)[i]);
+      break;
+    default:
+      printf("%8d  0x%02x\n", i, (unsigned)((const unsigned char*)data)[i]);
+      break;
+    }
+  }
+
+  if(n < count) printf("     ...  (%d more)\n", count - n);
+}
+
+/*----------------------------------------------------------------*/
+
+/* Prints the first @p max_values values in a slice.  Numeric data in
+   native format can only be shown if it was written on a machine
+   that stores numbers the same way as this one. */
+static int dump_slice(FILE *fp, const char *filename,
+		      const Slice_index_entry *entry, const char *format,
+		      const char *native, const int max_values) {
+  char  *data = NULL;
+  char  *raw = NULL;
+  char  *decoded = NULL;
+  char  *values;
+  int    type;
+  int    status = REG_FAILURE;
+
+  if(entry->flags & REG_SLICE_FLAG_DELTA) {
+    fprintf(stderr, "%s: slice holds the difference from the same slice "
+	    "in an earlier sample so cannot be shown on its own\n", filename);
+    return REG_FAILURE;
+  }
+
+  if(!(data = (char*) malloc(entry->num_bytes + 1))) {
+    fprintf(stderr, "%s: malloc failed\n", filename);
+    return REG_FAILURE;
+  }
+
+  if(fseek(fp, (long)entry->data_offset, SEEK_SET) ||
+     fread(data, 1, entry->num_bytes, fp) != (size_t)entry->num_bytes) {
+    fprintf(stderr, "%s: failed to read slice data\n", filename);
+    goto done;
+  }
+  values = data;
+
+  if(entry->codec != REG_COMPRESS_NONE) {
+    if(!Compress_codec_supported(entry->codec)) {
+      fprintf(stderr, "%s: slice is compressed with a codec (%d) this "
+	      "library was built without\n", filename, entry->codec);
+      goto done;
+    }
+    if(!(raw = (char*) malloc(entry->raw_bytes + 1)) ||
+       Decompress_data(entry->codec, data, entry->num_bytes, raw,
+		       entry->raw_bytes) != REG_SUCCESS) {
+      fprintf(stderr, "%s: failed to decompress slice\n", filename);
+      goto done;
+    }
+    values = raw;
+  }
+
+  switch(entry->type) {
+  case REG_CHAR:
+    printf("\"%.*s\"\n", entry->count, values);
+    status = REG_SUCCESS;
+    goto done;
+
+  case REG_XDR_INT:
+  case REG_XDR_LONG:
+  case REG_XDR_FLOAT:
+  case REG_XDR_DOUBLE:
+    type = (entry->type == REG_XDR_INT) ? REG_INT :
+      (entry->type == REG_XDR_LONG) ? REG_LONG :
+      (entry->type == REG_XDR_FLOAT) ? REG_FLOAT : REG_DBL;
+    if(!(decoded = (char*) malloc(entry->count*Sizeof_type(type) + 1)) ||
+       Xdr_decode_array(type, entry->count, values,
+			decoded) != REG_SUCCESS) {
+      fprintf(stderr, "%s: failed to decode XDR data\n", filename);
+      goto done;
+    }
+    values = decoded;
+    break;
+
+  case REG_Q16_FLOAT:
+  case REG_Q16_DOUBLE:
+  case REG_HALF_FLOAT:
+  case REG_HALF_DOUBLE:
+    type = Lossy_native_type(entry->type);
+    if(!(decoded = (char*) malloc(entry->count*Sizeof_type(type) + 1)) ||
+       Lossy_decode(entry->type, values, (entry->codec == REG_COMPRESS_NONE) ?
+		    entry->num_bytes : entry->raw_bytes, entry->count,
+		    decoded) != REG_SUCCESS) {
+      fprintf(stderr, "%s: failed to decode lossy data\n", filename);
+      goto done;
+    }
+    values = decoded;
+    break;
+
+  case REG_INT:
+  case REG_LONG:
+  case REG_FLOAT:
+  case REG_DBL:
+    if(strcmp(format, native)) {
+      fprintf(stderr, "%s: slice is in the native format of another "
+	      "machine (%s, this one is %s)\n", filename, format, native);
+      goto done;
+    }
+    type = entry->type;
+    break;
+
+  default:
+    type = REG_BIN;
+    break;
+  }
+
+  print_values(type, values, (type == REG_BIN) ? entry->raw_bytes :
+	       entry->count, max_values);
+  status = REG_SUCCESS;
+
+ done:
+  free(data);
+  free(raw);
+  free(decoded);
+  return status;
+}
+
+/*----------------------------------------------------------------*/
+
+int main(int argc, char **argv) {
+  Slice_index_entry *index;
+  FILE  *fp;
+  char   trailer[REG_PACKET_SIZE];
+  char   native[16];
+  char   format[16];
+  uint64_t offset;
+  int    slice = -1;
+  int    max_values = 10;
+  int    num_entries;
+  int    status = 0;
+  int    i;
+
+  for(i = 1; i < argc && argv[i][0] == '-'; i++) {
+    if(!strcmp(argv[i], "-s") && i+1 < argc) {
+      slice = atoi(argv[++i]);
+    }
+    else if(!strcmp(argv[i], "-n") && i+1 < argc) {
+      max_values = atoi(argv[++i]);
+    }
+    else {
+      break;
+    }
+  }
+
+  if(i >= argc || slice < -1 || max_values < 0) {
+    fprintf(stderr, "Usage: %s [-s slice] [-n no. of values] file...\n",
+	    argv[0]);
+    return 1;
+  }
+
+  /* What a file written here would record as its format */
+  Pack_index_trailer(trailer, 0, 0);
+  Unpack_index_trailer(trailer, &num_entries, &offset, native);
+
+  for(; i < argc; i++) {
+    if(!(fp = fopen(argv[i], "rb"))) {
+      fprintf(stderr, "%s: failed to open file\n", argv[i]);
+      status = 1;
+      continue;
+    }
+
+    index = NULL;
+    if((num_entries = read_index(fp, argv[i], &index, format)) < 0) {
+      printf("%s: no index\n", argv[i]);
+      status = 1;
+    }
+    else if(slice < 0) {
+      printf("%s: %d slice(s), numeric data stored as %s\n", argv[i],
+	     num_entries, format);
+      list_slices(index, num_entries);
+    }
+    else if(slice >= num_entries) {
+      fprintf(stderr, "%s: no slice %d (file has %d)\n", argv[i], slice,
+	      num_entries);
+      status = 1;
+    }
+    else {
+      printf("%s: slice %d, %d x %s\n", argv[i], slice,
+	     index[slice].count, type_name(index[slice].type));
+      if(dump_slice(fp, argv[i], &(index[slice]), format, native,
+		    max_values) != REG_SUCCESS) {
+	status = 1;
+      }
+    }
+
+    free(index);
+    fclose(fp);
+  }
+
+  return status;
+}